@@ -0,0 +1,210 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host benchmark of the pcap writers
+ *
+ * Writes the same stream of packets once the way pcap_capture_packet() does
+ * (two fwrite and one fflush per packet, mode "direct") and once through a
+ * pcap_ring_t filled by a producer thread and emptied by a writer thread in
+ * whole blocks (mode "ring"). Prints one CSV line per mode and payload size:
+ *
+ *   PCAP,mode,payload,records,drops,writes,duration_us,records_per_s,mbit_s
+ *
+ * Without -d the producer waits for free space, so both modes write every
+ * packet. With -d the producer never waits, as on the device, and the ring
+ * counts the packets it had to drop.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "pcap_ring.h"
+
+#define BENCH_MAX_PAYLOAD 1514
+
+typedef struct {
+    pcap_ring_t ring;
+    uint32_t records;
+    uint32_t payload;
+    uint32_t flush_bytes;
+    bool drop;
+    volatile bool done;
+} bench_t;
+
+static const uint32_t payloads[] = {64, 512, 1514};
+static uint8_t packet[BENCH_MAX_PAYLOAD];
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+/* Same file header as pcap_write_header() for PCAP_LINK_TYPE_ETHERNET */
+static bool write_file_header(FILE *file)
+{
+    const uint32_t header[6] = {0xA1B2C3D4, 0x00040002, 0, 0, 0x0000FFFF, 1};
+    return fwrite(header, sizeof(header), 1, file) == 1;
+}
+
+static void print_result(const char *mode, uint32_t payload, uint32_t records, uint32_t drops, uint32_t writes, uint64_t duration)
+{
+    double seconds = (duration > 0) ? (double)duration / 1e6 : 1e-6;
+    printf("PCAP,%s,%u,%u,%u,%u,%llu,%.0f,%.1f\n", mode, payload, records, drops, writes, (unsigned long long)duration,
+           records / seconds, (double)records * payload * 8.0 / seconds / 1e6);
+}
+
+static bool bench_direct(const char *path, uint32_t records, uint32_t payload)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file || !write_file_header(file)) {
+        perror(path);
+        return false;
+    }
+    uint64_t start = now_us();
+    for (uint32_t i = 0; i < records; i++) {
+        const uint32_t header[4] = {i / 1000, (i % 1000) * 1000, payload, payload};
+        packet[0] = (uint8_t)i;
+        fwrite(header, sizeof(header), 1, file);
+        fwrite(packet, payload, 1, file);
+        fflush(file);
+    }
+    uint64_t duration = now_us() - start;
+    fclose(file);
+    print_result("direct", payload, records, 0, records * 2, duration);
+    return true;
+}
+
+static void *producer(void *arg)
+{
+    bench_t *bench = arg;
+    for (uint32_t i = 0; i < bench->records; i++) {
+        packet[0] = (uint8_t)i;
+        /* Waiting for space is the host's choice, the device drops instead (-d) */
+        while (!bench->drop && (bench->ring.size - pcap_ring_pending(&bench->ring) < PCAP_RING_RECORD_HEADER_SIZE + bench->payload)) {
+            sched_yield();
+        }
+        pcap_ring_append(&bench->ring, packet, bench->payload, i / 1000, (i % 1000) * 1000);
+    }
+    __atomic_store_n(&bench->done, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/* Writer loop of the capture task: blocks above the threshold, everything once the producer is done.
+ * The yield stands in for the task notification the device sends when the threshold is crossed. */
+static void *writer(void *arg)
+{
+    bench_t *bench = arg;
+    while (!__atomic_load_n(&bench->done, __ATOMIC_ACQUIRE)) {
+        if (pcap_ring_pending(&bench->ring) >= bench->flush_bytes) {
+            pcap_ring_write(&bench->ring, false);
+        } else {
+            sched_yield();
+        }
+    }
+    pcap_ring_sync(&bench->ring);
+    return NULL;
+}
+
+static bool bench_ring(const char *path, uint8_t *memory, size_t size, size_t block_size, bench_t *bench)
+{
+    pthread_t threads[2];
+    pcap_ring_stats_t stats;
+    FILE *file = fopen(path, "wb");
+    if (!file || !write_file_header(file)) {
+        perror(path);
+        return false;
+    }
+    if (!pcap_ring_init(&bench->ring, memory, size, file, block_size)) {
+        fprintf(stderr, "invalid ring size %zu or block size %zu\n", size, block_size);
+        fclose(file);
+        return false;
+    }
+    bench->done = false;
+
+    uint64_t start = now_us();
+    pthread_create(&threads[1], NULL, writer, bench);
+    pthread_create(&threads[0], NULL, producer, bench);
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+    uint64_t duration = now_us() - start;
+
+    pcap_ring_get_stats(&bench->ring, &stats);
+    fclose(file);
+    print_result("ring", bench->payload, stats.records, stats.drops, stats.writes, duration);
+    if (stats.write_errors) {
+        fprintf(stderr, "%u write errors\n", stats.write_errors);
+    }
+    return true;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-n records] [-r ring_size] [-b block_size] [-f flush_bytes] [-o file] [-d]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = "pcap_ring_bench.pcap";
+    size_t size = 32768;
+    size_t block_size = 4096;
+    bench_t bench = {.records = 100000, .flush_bytes = 16384};
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:b:f:o:dh")) != -1) {
+        switch (opt) {
+        case 'n':
+            bench.records = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            size = strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            block_size = strtoul(optarg, NULL, 0);
+            break;
+        case 'f':
+            bench.flush_bytes = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'o':
+            path = optarg;
+            break;
+        case 'd':
+            bench.drop = true;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (bench.flush_bytes > size) {
+        bench.flush_bytes = (uint32_t)size;
+    }
+
+    uint8_t *memory = malloc(size);
+    if (!memory) {
+        fprintf(stderr, "%s\n", strerror(errno));
+        return 1;
+    }
+    memset(packet, 0xA5, sizeof(packet));
+
+    for (size_t i = 0; i < sizeof(payloads) / sizeof(payloads[0]); i++) {
+        bench.payload = payloads[i];
+        if (!bench_direct(path, bench.records, payloads[i]) || !bench_ring(path, memory, size, block_size, &bench)) {
+            free(memory);
+            return 1;
+        }
+    }
+    unlink(path);
+    free(memory);
+    return 0;
+}
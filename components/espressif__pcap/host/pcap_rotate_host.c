@@ -0,0 +1,261 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host check of the rolling capture
+ *
+ * Streams packets through a pcap_ring_t into a pcap_rotate_t the way the
+ * capture task of the sniffer does (block writes above the flush threshold,
+ * next file whenever the current one is full), into a directory standing in
+ * for the SPIFFS partition (default 0xE8000 bytes, see partitions.csv).
+ * Afterwards the capture is restarted once, as after a reboot, and the files
+ * are checked:
+ *
+ *   - at most file_count files, none bigger than the file size
+ *   - all files together fit into the partition
+ *   - every file parses as pcap and the packets are contiguous up to the newest one
+ *
+ * The write rate of every tenth of the packets is printed, it must not drop
+ * while the partition fills up:
+ *
+ *   ROTATE,part,packets,files,duration_us,records_per_s
+ *   ROTATE_CHECK,files,bytes,oldest_packet,newest_packet,ok
+ */
+
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "pcap_ring.h"
+#include "pcap_rotate.h"
+
+#define HOST_RING_SIZE 32768
+#define HOST_BLOCK_SIZE 4096
+#define HOST_FLUSH_BYTES 16384
+#define HOST_MAX_PAYLOAD 1514
+#define HOST_PARTS 10
+
+typedef struct {
+    pcap_ring_t ring;
+    pcap_rotate_t rotate;
+    uint32_t file_size;
+} host_capture_t;
+
+static uint8_t memory[HOST_RING_SIZE];
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+/* Writer of the capture task: starts the next file whenever the current one is full */
+static bool capture_write(host_capture_t *capture, bool all)
+{
+    while (true) {
+        (void)pcap_ring_write(&capture->ring, all);
+        if (!pcap_ring_file_full(&capture->ring)) {
+            return true;
+        }
+        if (!pcap_rotate_next(&capture->rotate) ||
+            !pcap_ring_set_file(&capture->ring, pcap_rotate_file(&capture->rotate), capture->file_size)) {
+            return false;
+        }
+    }
+}
+
+static bool capture_open(host_capture_t *capture, const pcap_rotate_config_t *config)
+{
+    return pcap_rotate_open(&capture->rotate, config) &&
+           pcap_ring_init(&capture->ring, memory, sizeof(memory), pcap_rotate_file(&capture->rotate), HOST_BLOCK_SIZE) &&
+           pcap_ring_set_file(&capture->ring, pcap_rotate_file(&capture->rotate), capture->file_size);
+}
+
+static bool capture_close(host_capture_t *capture)
+{
+    bool success = capture_write(capture, true) && pcap_ring_sync(&capture->ring);
+    pcap_rotate_close(&capture->rotate);
+    return success;
+}
+
+/* Packet n carries its number in the first 4 bytes, the rest is filled with its low byte */
+static uint32_t make_packet(uint32_t n, uint8_t *packet)
+{
+    uint32_t length = 60 + (n * 7919u) % (HOST_MAX_PAYLOAD - 60 + 1);
+    memset(packet, (uint8_t)n, length);
+    memcpy(packet, &n, sizeof(n));
+    return length;
+}
+
+static bool stream(host_capture_t *capture, uint32_t first, uint32_t packets, bool print)
+{
+    static uint8_t packet[HOST_MAX_PAYLOAD];
+    uint32_t part = (packets + HOST_PARTS - 1) / HOST_PARTS;
+    uint64_t start = now_us();
+
+    for (uint32_t i = 0; i < packets; i++) {
+        uint32_t n = first + i;
+        uint32_t length = make_packet(n, packet);
+        /* The host waits instead of dropping, so the check can expect every packet */
+        while (!pcap_ring_append(&capture->ring, packet, length, n / 1000, (n % 1000) * 1000)) {
+            if (!capture_write(capture, true)) {
+                return false;
+            }
+        }
+        if ((pcap_ring_pending(&capture->ring) >= HOST_FLUSH_BYTES) && !capture_write(capture, false)) {
+            return false;
+        }
+        if (print && ((((i + 1) % part) == 0) || ((i + 1) == packets))) {
+            uint64_t end = now_us();
+            uint32_t done = (i % part) + 1;
+            printf("ROTATE,%u,%u,%u,%llu,%.0f\n", i / part, done, capture->rotate.files, (unsigned long long)(end - start),
+                   (end > start) ? done * 1e6 / (double)(end - start) : 0.0);
+            start = end;
+        }
+    }
+    return true;
+}
+
+/* Check the files left by both runs, they must hold the packets from some oldest one up to newest */
+static bool check(const pcap_rotate_t *rotate, uint32_t file_size, uint32_t file_count, uint32_t partition, uint32_t newest)
+{
+    static uint8_t packet[HOST_MAX_PAYLOAD];
+    static uint8_t expected[HOST_MAX_PAYLOAD];
+    char path[PCAP_ROTATE_PATH_MAX];
+    uint32_t files = 0;
+    uint64_t bytes = 0;
+    uint32_t oldest = 0;
+    uint32_t next = 0;
+    bool started = false;
+    bool ok = true;
+
+    for (uint32_t number = rotate->first; number != rotate->next; number++) {
+        uint32_t header[6];
+        uint32_t record[4];
+        struct stat st;
+
+        if (!pcap_rotate_path(rotate, number, path, sizeof(path)) || (stat(path, &st) != 0)) {
+            continue;
+        }
+        files++;
+        bytes += st.st_size;
+        if ((uint64_t)st.st_size > file_size) {
+            fprintf(stderr, "%s: %lld bytes, limit %u\n", path, (long long)st.st_size, file_size);
+            ok = false;
+        }
+
+        FILE *file = fopen(path, "rb");
+        if (!file || (fread(header, sizeof(header), 1, file) != 1) || (header[0] != 0xA1B2C3D4) || (header[5] != 1)) {
+            fprintf(stderr, "%s: bad file header\n", path);
+            ok = false;
+        }
+        while (file && (fread(record, sizeof(record), 1, file) == 1)) {
+            uint32_t n;
+            if ((record[2] > HOST_MAX_PAYLOAD) || (fread(packet, 1, record[2], file) != record[2])) {
+                fprintf(stderr, "%s: truncated packet\n", path);
+                ok = false;
+                break;
+            }
+            memcpy(&n, packet, sizeof(n));
+            if (!started) {
+                oldest = n;
+                next = n;
+                started = true;
+            }
+            if ((n != next) || (record[2] != make_packet(n, expected)) || memcmp(packet, expected, record[2]) ||
+                (record[0] != n / 1000) || (record[1] != (n % 1000) * 1000)) {
+                fprintf(stderr, "%s: packet %u, expected %u\n", path, n, next);
+                ok = false;
+                break;
+            }
+            next = n + 1;
+        }
+        if (file) {
+            fclose(file);
+        }
+    }
+    if ((files > file_count) || (bytes > partition) || (next != newest + 1)) {
+        ok = false;
+    }
+    printf("ROTATE_CHECK,%u,%llu,%u,%u,%s\n", files, (unsigned long long)bytes, oldest, next - 1, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-n packets] [-s file_size] [-c file_count] [-p partition_size] [-o directory]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    char directory[] = "/tmp/pcap_rotate_XXXXXX";
+    const char *output = NULL;
+    char path[PCAP_ROTATE_PATH_MAX];
+    uint32_t packets = 20000;
+    uint32_t file_count = 4;
+    uint32_t partition = 0xE8000;
+    host_capture_t capture = {.file_size = 131072};
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:c:p:o:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            packets = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            capture.file_size = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            file_count = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            partition = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if ((packets < 2) || (file_count == 0) || ((uint64_t)capture.file_size * file_count > partition)) {
+        fprintf(stderr, "need at least 2 packets and file_count * file_size <= partition_size\n");
+        return 1;
+    }
+    if (!output) {
+        output = mkdtemp(directory);
+        if (!output) {
+            perror("mkdtemp");
+            return 1;
+        }
+    }
+    snprintf(path, sizeof(path), "%s/capture.pcap", output);
+    const pcap_rotate_config_t config = {.path = path, .file_count = file_count, .link_type = 1};
+
+    /* First run, then a restart continuing the numbering behind the files of the first run */
+    uint32_t first = packets / 2;
+    if (!capture_open(&capture, &config) || !stream(&capture, 0, first, true) || !capture_close(&capture) ||
+        !capture_open(&capture, &config) || !stream(&capture, first, packets - first, true) || !capture_close(&capture)) {
+        fprintf(stderr, "capture failed\n");
+        return 1;
+    }
+
+    bool ok = check(&capture.rotate, capture.file_size, file_count, partition, packets - 1);
+    if (output == directory) {
+        for (uint32_t number = capture.rotate.first; number != capture.rotate.next; number++) {
+            if (pcap_rotate_path(&capture.rotate, number, path, sizeof(path))) {
+                unlink(path);
+            }
+        }
+        rmdir(directory);
+    }
+    return ok ? 0 : 1;
+}
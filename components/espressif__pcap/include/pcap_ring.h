@@ -0,0 +1,154 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Size of the record header in front of every captured packet
+ *
+ */
+#define PCAP_RING_RECORD_HEADER_SIZE 16
+
+/**
+ * @brief Capture counters, all of them wrap around
+ *
+ */
+typedef struct {
+    uint32_t records;        /*!< Packets appended to the ring */
+    uint32_t bytes;          /*!< Bytes appended to the ring (record headers included) */
+    uint32_t drops;          /*!< Packets dropped because the ring was full */
+    uint32_t drop_bytes;     /*!< Bytes of the dropped packets (record headers included) */
+    uint32_t written_bytes;  /*!< Bytes written to the file */
+    uint32_t writes;         /*!< Write calls to the file */
+    uint32_t write_errors;   /*!< Write calls which failed, their bytes are lost */
+    uint32_t syncs;          /*!< Calls of pcap_ring_sync() */
+    uint32_t high_water;     /*!< Maximum number of bytes waiting in the ring */
+} pcap_ring_stats_t;
+
+/**
+ * @brief Ring buffer of pcap records between a capturing task (producer) and a writer task (consumer)
+ *
+ * @note Lock free for one producer and one consumer. Do not access the members directly.
+ */
+typedef struct {
+    uint8_t *buffer;         /*!< Ring memory */
+    uint32_t size;           /*!< Size of the ring memory, power of 2 */
+    uint32_t head;           /*!< Bytes taken from the ring, written by the consumer only */
+    uint32_t tail;           /*!< Bytes put into the ring, written by the producer only */
+    uint32_t block_size;     /*!< Granularity of the writes, the file offset stays a multiple of it */
+    uint32_t file_offset;    /*!< Current offset of the file */
+    uint32_t file_start;     /*!< Offset of the first record in the file */
+    uint32_t file_limit;     /*!< Maximum size of the file, 0: no limit */
+    uint32_t record;         /*!< First record boundary at or behind the head, written by the consumer only */
+    bool file_full;          /*!< The next record does not fit into the file */
+    FILE *file;              /*!< File receiving the records */
+    pcap_ring_stats_t stats; /*!< Counters, producer and consumer update different fields */
+} pcap_ring_t;
+
+/**
+ * @brief Initialize a ring for a pcap file, whose file header was written already (pcap_write_header)
+ *
+ * @note The stdio buffering of the file is disabled, the ring takes its place.
+ *
+ * @param[out] ring Ring to initialize
+ * @param[in] buffer Ring memory
+ * @param[in] size Size of the ring memory, must be a power of 2
+ * @param[in] file File to write to, positioned behind the file header
+ * @param[in] block_size Size of the blocks written by pcap_ring_write(), must be a power of 2 not bigger than size
+ * @return
+ *      - true: Ring initialized
+ *      - false: Invalid argument or the file could not be flushed
+ */
+bool pcap_ring_init(pcap_ring_t *ring, uint8_t *buffer, size_t size, FILE *file, size_t block_size);
+
+/**
+ * @brief Continue writing into another file (consumer)
+ *
+ * @note Used for rotating the capture files. Records are never split between two files.
+ *
+ * @param[in] ring Ring
+ * @param[in] file File to write to, positioned behind the file header
+ * @param[in] limit Maximum size of the file in bytes, 0: no limit. A single record bigger than the whole file is written anyway.
+ * @return
+ *      - true: Records now go to the file
+ *      - false: The file could not be flushed
+ */
+bool pcap_ring_set_file(pcap_ring_t *ring, FILE *file, uint32_t limit);
+
+/**
+ * @brief Check whether the file is full (consumer)
+ *
+ * @param[in] ring Ring
+ * @return true: The next record does not fit into the file, pcap_ring_write() writes nothing until pcap_ring_set_file()
+ */
+bool pcap_ring_file_full(const pcap_ring_t *ring);
+
+/**
+ * @brief Append one packet to the ring (producer)
+ *
+ * @note Never blocks. When the ring is full, the packet is dropped and counted.
+ *
+ * @param[in] ring Ring
+ * @param[in] payload Packet data
+ * @param[in] length Length of the packet
+ * @param[in] seconds Timestamp: seconds since January 1st, 1970
+ * @param[in] microseconds Timestamp: microseconds within the second
+ * @return
+ *      - true: Packet appended
+ *      - false: Packet dropped
+ */
+bool pcap_ring_append(pcap_ring_t *ring, const void *payload, uint32_t length, uint32_t seconds, uint32_t microseconds);
+
+/**
+ * @brief Get the number of bytes waiting in the ring
+ *
+ * @param[in] ring Ring
+ * @return Bytes not yet written to the file
+ */
+size_t pcap_ring_pending(const pcap_ring_t *ring);
+
+/**
+ * @brief Write waiting records to the file (consumer)
+ *
+ * @note When the records do not fit into the file limit, the records which fit are written and the file is full.
+ *
+ * @param[in] ring Ring
+ * @param[in] all false: write whole blocks only, the rest stays in the ring. true: write everything.
+ * @return Bytes taken from the ring
+ */
+size_t pcap_ring_write(pcap_ring_t *ring, bool all);
+
+/**
+ * @brief Write all waiting records and flush the file (consumer)
+ *
+ * @note Records which do not fit into a full file stay in the ring.
+ *
+ * @param[in] ring Ring
+ * @return
+ *      - true: All records are in the file
+ *      - false: Writing or flushing failed
+ */
+bool pcap_ring_sync(pcap_ring_t *ring);
+
+/**
+ * @brief Read the counters of a ring
+ *
+ * @note Every counter is read atomically, the set is not taken at one instant.
+ *
+ * @param[in] ring Ring
+ * @param[out] stats Counters
+ */
+void pcap_ring_get_stats(const pcap_ring_t *ring, pcap_ring_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,102 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Longest path of a capture file
+ *
+ */
+#define PCAP_ROTATE_PATH_MAX 64
+
+/**
+ * @brief Rolling capture configuration
+ *
+ */
+typedef struct {
+    const char *path;        /*!< Capture file, "/spiffs/capture.pcap" becomes "/spiffs/capture.<number>.pcap" when rotating */
+    uint32_t file_count;     /*!< Files kept, the oldest one is deleted first. 0: single file at path, no rotation */
+    uint32_t link_type;      /*!< Link type written into the file headers (pcap_link_type_t) */
+} pcap_rotate_config_t;
+
+/**
+ * @brief Rolling capture state
+ *
+ * @note The members may be read, only the pcap_rotate functions change them.
+ */
+typedef struct {
+    char directory[PCAP_ROTATE_PATH_MAX]; /*!< Directory of the files */
+    char stem[PCAP_ROTATE_PATH_MAX];      /*!< File name up to the number */
+    char extension[16];                   /*!< File name behind the number, including the dot */
+    uint32_t file_count;     /*!< Files kept, 0: single file */
+    uint32_t link_type;      /*!< Link type of the file headers */
+    uint32_t first;          /*!< Number of the oldest file which may exist */
+    uint32_t next;           /*!< Number of the next file */
+    uint32_t files;          /*!< Files opened */
+    uint32_t deleted;        /*!< Files deleted */
+    FILE *file;              /*!< Current file, NULL after pcap_rotate_close() */
+} pcap_rotate_t;
+
+/**
+ * @brief Start a rolling capture
+ *
+ * @note Files of an earlier capture with the same name are kept, numbering continues behind the newest one
+ *       and the oldest ones are deleted until file_count files remain including the new one.
+ *
+ * @param[out] rotate Rolling capture to start
+ * @param[in] config Configuration
+ * @return
+ *      - true: First file opened, its file header is written
+ *      - false: Invalid configuration or the file could not be created
+ */
+bool pcap_rotate_open(pcap_rotate_t *rotate, const pcap_rotate_config_t *config);
+
+/**
+ * @brief Get the current file
+ *
+ * @param[in] rotate Rolling capture
+ * @return File positioned behind the file header (pass to pcap_ring_set_file())
+ */
+FILE *pcap_rotate_file(const pcap_rotate_t *rotate);
+
+/**
+ * @brief Close the current file and continue with the next one, deleting the oldest file if needed
+ *
+ * @param[in] rotate Rolling capture
+ * @return
+ *      - true: Next file opened, its file header is written
+ *      - false: Single file capture or the file could not be created, no file is open anymore
+ */
+bool pcap_rotate_next(pcap_rotate_t *rotate);
+
+/**
+ * @brief Close the current file
+ *
+ * @param[in] rotate Rolling capture
+ */
+void pcap_rotate_close(pcap_rotate_t *rotate);
+
+/**
+ * @brief Get the path of a capture file
+ *
+ * @param[in] rotate Rolling capture
+ * @param[in] number Number of the file (ignored for a single file capture)
+ * @param[out] path Path of the file
+ * @param[in] size Size of path
+ * @return
+ *      - true: Path written
+ *      - false: path is too small
+ */
+bool pcap_rotate_path(const pcap_rotate_t *rotate, uint32_t number, char *path, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,232 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "pcap_ring.h"
+
+/**
+ * @brief Pcap Packet Header, same layout as written by pcap_capture_packet()
+ *
+ */
+typedef struct {
+    uint32_t seconds;        /*!< Number of seconds since January 1st, 1970, 00:00:00 GMT */
+    uint32_t microseconds;   /*!< Number of microseconds when the packet was captured (offset from seconds) */
+    uint32_t capture_length; /*!< Number of bytes of captured data, no longer than packet_length */
+    uint32_t packet_length;  /*!< Actual length of current packet */
+} pcap_ring_record_header_t;
+
+_Static_assert(sizeof(pcap_ring_record_header_t) == PCAP_RING_RECORD_HEADER_SIZE, "pcap record header size");
+
+static inline uint32_t load(const uint32_t *value)
+{
+    return __atomic_load_n(value, __ATOMIC_RELAXED);
+}
+
+static inline void count(uint32_t *counter, uint32_t value)
+{
+    /* Every counter has a single writer, the atomic store only keeps readers from seeing torn values */
+    __atomic_store_n(counter, load(counter) + value, __ATOMIC_RELAXED);
+}
+
+/* Copy into the ring at the given free running position, wrapping at the end of the memory */
+static void ring_put(pcap_ring_t *ring, uint32_t pos, const void *data, uint32_t length)
+{
+    uint32_t offset = pos & (ring->size - 1);
+    uint32_t first = ring->size - offset;
+    if (first > length) {
+        first = length;
+    }
+    memcpy(&ring->buffer[offset], data, first);
+    memcpy(ring->buffer, (const uint8_t *)data + first, length - first);
+}
+
+/* Read the capture length of the record starting at the given free running position */
+static uint32_t ring_record_size(const pcap_ring_t *ring, uint32_t pos)
+{
+    uint32_t length;
+    uint8_t *bytes = (uint8_t *)&length;
+    for (uint32_t i = 0; i < sizeof(length); i++) {
+        bytes[i] = ring->buffer[(pos + offsetof(pcap_ring_record_header_t, capture_length) + i) & (ring->size - 1)];
+    }
+    return PCAP_RING_RECORD_HEADER_SIZE + length;
+}
+
+/* End of the last whole record between the head and the tail which still fits into room bytes */
+static uint32_t ring_fit(const pcap_ring_t *ring, uint32_t head, uint32_t tail, uint32_t room)
+{
+    uint32_t pos = ring->record;
+    if ((pos - head) > room) {
+        return head;
+    }
+    while (pos != tail) {
+        uint32_t end = pos + ring_record_size(ring, pos);
+        if ((end - head) > room) {
+            break;
+        }
+        pos = end;
+    }
+    return pos;
+}
+
+/* Write length bytes starting at the head to the file, returns false if the file refused them */
+static bool ring_out(pcap_ring_t *ring, uint32_t head, uint32_t length)
+{
+    uint32_t offset = head & (ring->size - 1);
+    uint32_t first = ring->size - offset;
+    bool success = true;
+    if (first > length) {
+        first = length;
+    }
+    if (fwrite(&ring->buffer[offset], 1, first, ring->file) != first) {
+        success = false;
+    }
+    count(&ring->stats.writes, 1);
+    if (success && (length > first)) {
+        if (fwrite(ring->buffer, 1, length - first, ring->file) != (length - first)) {
+            success = false;
+        }
+        count(&ring->stats.writes, 1);
+    }
+    return success;
+}
+
+bool pcap_ring_init(pcap_ring_t *ring, uint8_t *buffer, size_t size, FILE *file, size_t block_size)
+{
+    if (!ring || !buffer || !file || (size == 0) || (size & (size - 1)) || (size > 0x80000000u) ||
+        (block_size == 0) || (block_size & (block_size - 1)) || (block_size > size)) {
+        return false;
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->buffer = buffer;
+    ring->size = (uint32_t)size;
+    ring->block_size = (uint32_t)block_size;
+    return pcap_ring_set_file(ring, file, 0);
+}
+
+bool pcap_ring_set_file(pcap_ring_t *ring, FILE *file, uint32_t limit)
+{
+    long offset;
+    /* The file header may still sit in the stdio buffer */
+    if (!file || (fflush(file) != 0)) {
+        return false;
+    }
+    offset = ftell(file);
+    ring->file_offset = (offset > 0) ? (uint32_t)offset : 0;
+    ring->file_start = ring->file_offset;
+    ring->file_limit = limit;
+    ring->file_full = false;
+    ring->file = file;
+    /* Records reach the file in whole blocks, a second copy in the stdio buffer would only cost time */
+    setvbuf(file, NULL, _IONBF, 0);
+    return true;
+}
+
+bool pcap_ring_file_full(const pcap_ring_t *ring)
+{
+    return ring->file_full;
+}
+
+bool pcap_ring_append(pcap_ring_t *ring, const void *payload, uint32_t length, uint32_t seconds, uint32_t microseconds)
+{
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = ring->tail;
+    uint32_t record = PCAP_RING_RECORD_HEADER_SIZE + length;
+    uint32_t used = tail - head;
+    pcap_ring_record_header_t header = {
+        .seconds = seconds,
+        .microseconds = microseconds,
+        .capture_length = length,
+        .packet_length = length
+    };
+
+    if ((length > ring->size) || (record > (ring->size - used))) {
+        count(&ring->stats.drops, 1);
+        count(&ring->stats.drop_bytes, record);
+        return false;
+    }
+    ring_put(ring, tail, &header, sizeof(header));
+    ring_put(ring, tail + sizeof(header), payload, length);
+    /* The record becomes visible to the writer only after it is complete */
+    __atomic_store_n(&ring->tail, tail + record, __ATOMIC_RELEASE);
+
+    count(&ring->stats.records, 1);
+    count(&ring->stats.bytes, record);
+    if ((used + record) > load(&ring->stats.high_water)) {
+        __atomic_store_n(&ring->stats.high_water, used + record, __ATOMIC_RELAXED);
+    }
+    return true;
+}
+
+size_t pcap_ring_pending(const pcap_ring_t *ring)
+{
+    return __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+}
+
+size_t pcap_ring_write(pcap_ring_t *ring, bool all)
+{
+    uint32_t head = ring->head;
+    uint32_t pending = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) - head;
+    uint32_t length = pending;
+    uint32_t room = (ring->file_limit > ring->file_offset) ? (ring->file_limit - ring->file_offset) : 0;
+
+    if (ring->file_full) {
+        return 0;
+    }
+    if (ring->file_limit && (pending > room)) {
+        /* The file ends with the last record which fits, the next one starts the next file */
+        uint32_t end = ring_fit(ring, head, head + pending, room);
+        if ((end == head) && (ring->file_offset == ring->file_start)) {
+            /* Record bigger than the whole file, it gets a file of its own */
+            end = head + ring_record_size(ring, head);
+        }
+        length = end - head;
+        ring->file_full = true;
+    } else if (!all) {
+        /* Stop at the last block boundary of the file, so every write ends aligned */
+        uint32_t end = (ring->file_offset + pending) & ~(ring->block_size - 1);
+        length = (end > ring->file_offset) ? (end - ring->file_offset) : 0;
+    }
+    if (length == 0) {
+        return 0;
+    }
+    if (ring_out(ring, head, length)) {
+        count(&ring->stats.written_bytes, length);
+    } else {
+        count(&ring->stats.write_errors, 1);
+    }
+    /* Bytes the file refused are given up as well, otherwise a full medium would stall the capture */
+    ring->file_offset += length;
+    /* Keep track of the record boundaries, the head itself may stop within a record.
+       The headers are read before the head moves, afterwards the producer may overwrite them */
+    while ((ring->record - head) < length) {
+        ring->record += ring_record_size(ring, ring->record);
+    }
+    __atomic_store_n(&ring->head, head + length, __ATOMIC_RELEASE);
+    return length;
+}
+
+bool pcap_ring_sync(pcap_ring_t *ring)
+{
+    uint32_t errors = load(&ring->stats.write_errors);
+    bool success;
+
+    (void)pcap_ring_write(ring, true);
+    success = (fflush(ring->file) == 0) && (load(&ring->stats.write_errors) == errors);
+    count(&ring->stats.syncs, 1);
+    return success;
+}
+
+void pcap_ring_get_stats(const pcap_ring_t *ring, pcap_ring_stats_t *stats)
+{
+    stats->records = load(&ring->stats.records);
+    stats->bytes = load(&ring->stats.bytes);
+    stats->drops = load(&ring->stats.drops);
+    stats->drop_bytes = load(&ring->stats.drop_bytes);
+    stats->written_bytes = load(&ring->stats.written_bytes);
+    stats->writes = load(&ring->stats.writes);
+    stats->write_errors = load(&ring->stats.write_errors);
+    stats->syncs = load(&ring->stats.syncs);
+    stats->high_water = load(&ring->stats.high_water);
+}
@@ -0,0 +1,188 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <dirent.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "pcap_rotate.h"
+
+#define PCAP_MAGIC_BIG_ENDIAN 0xA1B2C3D4    /*!< Big-Endian */
+
+/**
+ * @brief Pcap File Header, same content as written by pcap_write_header()
+ *
+ */
+typedef struct {
+    uint32_t magic;     /*!< Magic Number */
+    uint16_t major;     /*!< Major Version */
+    uint16_t minor;     /*!< Minor Version */
+    uint32_t zone;      /*!< Time Zone Offset */
+    uint32_t sigfigs;   /*!< Timestamp Accuracy */
+    uint32_t snaplen;   /*!< Max Length to Capture */
+    uint32_t link_type; /*!< Link Layer Type */
+} pcap_rotate_file_header_t;
+
+/* Parse the number of a capture file name "<stem>.<number><extension>" */
+static bool parse_number(const pcap_rotate_t *rotate, const char *name, uint32_t *number)
+{
+    size_t stem = strlen(rotate->stem);
+    size_t extension = strlen(rotate->extension);
+    size_t length = strlen(name);
+    char *end;
+
+    if ((length <= stem + 1 + extension) || strncmp(name, rotate->stem, stem) || (name[stem] != '.') ||
+        strcmp(&name[length - extension], rotate->extension)) {
+        return false;
+    }
+    if ((name[stem + 1] < '0') || (name[stem + 1] > '9')) {
+        return false;
+    }
+    unsigned long value = strtoul(&name[stem + 1], &end, 10);
+    if (end != &name[length - extension]) {
+        return false;
+    }
+    *number = (uint32_t)value;
+    return true;
+}
+
+/* Find the files of an earlier capture, numbering continues behind the newest one */
+static void scan_files(pcap_rotate_t *rotate)
+{
+    DIR *dir = opendir(rotate->directory);
+    struct dirent *entry;
+    bool found = false;
+    uint32_t number;
+
+    rotate->first = 0;
+    rotate->next = 0;
+    if (!dir) {
+        return;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        if (!parse_number(rotate, entry->d_name, &number)) {
+            continue;
+        }
+        if (!found || (number < rotate->first)) {
+            rotate->first = number;
+        }
+        if (!found || (number >= rotate->next)) {
+            rotate->next = number + 1;
+        }
+        found = true;
+    }
+    closedir(dir);
+}
+
+static bool open_file(pcap_rotate_t *rotate)
+{
+    char path[PCAP_ROTATE_PATH_MAX];
+    const pcap_rotate_file_header_t header = {
+        .magic = PCAP_MAGIC_BIG_ENDIAN,
+        .major = 0x02,
+        .minor = 0x04,
+        .zone = 0,
+        .sigfigs = 0,
+        .snaplen = 0x40000,
+        .link_type = rotate->link_type,
+    };
+
+    /* Oldest first, until the new file is the file_count-th one */
+    while (rotate->file_count && ((rotate->next - rotate->first) >= rotate->file_count)) {
+        if (pcap_rotate_path(rotate, rotate->first, path, sizeof(path)) && (unlink(path) == 0)) {
+            rotate->deleted++;
+        }
+        rotate->first++;
+    }
+
+    if (!pcap_rotate_path(rotate, rotate->next, path, sizeof(path))) {
+        return false;
+    }
+    rotate->file = fopen(path, "wb");
+    if (!rotate->file) {
+        return false;
+    }
+    if (fwrite(&header, sizeof(header), 1, rotate->file) != 1) {
+        fclose(rotate->file);
+        rotate->file = NULL;
+        return false;
+    }
+    rotate->next++;
+    rotate->files++;
+    return true;
+}
+
+bool pcap_rotate_open(pcap_rotate_t *rotate, const pcap_rotate_config_t *config)
+{
+    const char *slash;
+    const char *name;
+    const char *dot;
+
+    if (!rotate || !config || !config->path) {
+        return false;
+    }
+    memset(rotate, 0, sizeof(*rotate));
+    rotate->file_count = config->file_count;
+    rotate->link_type = config->link_type;
+
+    slash = strrchr(config->path, '/');
+    name = slash ? slash + 1 : config->path;
+    dot = strrchr(name, '.');
+    if (!dot) {
+        dot = name + strlen(name);
+    }
+    if ((slash && ((size_t)(slash - config->path) >= sizeof(rotate->directory))) ||
+        ((size_t)(dot - name) >= sizeof(rotate->stem)) || (strlen(dot) >= sizeof(rotate->extension))) {
+        return false;
+    }
+    if (slash) {
+        memcpy(rotate->directory, config->path, slash - config->path);
+    }
+    if (!slash || (slash == config->path)) {
+        strcpy(rotate->directory, slash ? "/" : ".");
+    }
+    memcpy(rotate->stem, name, dot - name);
+    strcpy(rotate->extension, dot);
+
+    if (rotate->file_count) {
+        scan_files(rotate);
+    }
+    return open_file(rotate);
+}
+
+FILE *pcap_rotate_file(const pcap_rotate_t *rotate)
+{
+    return rotate->file;
+}
+
+bool pcap_rotate_next(pcap_rotate_t *rotate)
+{
+    pcap_rotate_close(rotate);
+    if (!rotate->file_count) {
+        return false;
+    }
+    return open_file(rotate);
+}
+
+void pcap_rotate_close(pcap_rotate_t *rotate)
+{
+    if (rotate->file) {
+        fclose(rotate->file);
+        rotate->file = NULL;
+    }
+}
+
+bool pcap_rotate_path(const pcap_rotate_t *rotate, uint32_t number, char *path, size_t size)
+{
+    const char *separator = strcmp(rotate->directory, "/") ? "/" : "";
+    int length;
+
+    if (rotate->file_count) {
+        length = snprintf(path, size, "%s%s%s.%" PRIu32 "%s", rotate->directory, separator, rotate->stem, number, rotate->extension);
+    } else {
+        length = snprintf(path, size, "%s%s%s%s", rotate->directory, separator, rotate->stem, rotate->extension);
+    }
+    return (length >= 0) && ((size_t)length < size);
+}
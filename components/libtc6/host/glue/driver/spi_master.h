@@ -0,0 +1 @@
+/* Host build of the glue (main/): no SPI driver, the emulator port (sim/tc6sim-port.c) does the transfers */
@@ -0,0 +1,10 @@
+/* Host build of the glue (main/): ESP-IDF logging is compiled out */
+#ifndef HOST_GLUE_ESP_LOG_H
+#define HOST_GLUE_ESP_LOG_H
+
+#define ESP_LOGE(tag, ...) ((void)(tag))
+#define ESP_LOGW(tag, ...) ((void)(tag))
+#define ESP_LOGI(tag, ...) ((void)(tag))
+#define ESP_LOGD(tag, ...) ((void)(tag))
+
+#endif
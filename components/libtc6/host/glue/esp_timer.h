@@ -0,0 +1,9 @@
+/* Host build of the glue (main/): time in us, provided by the host program */
+#ifndef HOST_GLUE_ESP_TIMER_H
+#define HOST_GLUE_ESP_TIMER_H
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
+
+#endif
@@ -0,0 +1,31 @@
+/* Host build of the glue (main/): the part of the lwIP pbuf used by it, implemented by the host program */
+#ifndef HOST_GLUE_LWIP_PBUF_H
+#define HOST_GLUE_LWIP_PBUF_H
+
+#include <stdint.h>
+
+typedef enum { PBUF_RAW } pbuf_layer;
+typedef enum { PBUF_RAM, PBUF_REF } pbuf_type;
+
+struct pbuf {
+    struct pbuf *next;
+    void *payload;
+    uint16_t tot_len;
+    uint16_t len;
+    uint8_t ref;
+};
+
+typedef void (*pbuf_free_custom_fn)(struct pbuf *p);
+
+struct pbuf_custom {
+    struct pbuf pbuf;
+    pbuf_free_custom_fn custom_free_function;
+};
+
+void pbuf_ref(struct pbuf *p);
+uint8_t pbuf_free(struct pbuf *p);
+uint16_t pbuf_clen(const struct pbuf *p);
+struct pbuf *pbuf_clone(pbuf_layer layer, pbuf_type type, struct pbuf *p);
+struct pbuf *pbuf_alloced_custom(pbuf_layer l, uint16_t length, pbuf_type type, struct pbuf_custom *p, void *payload_mem, uint16_t payload_mem_len);
+
+#endif
@@ -0,0 +1,471 @@
+/*******************************************************************************
+  Chunk Header and Footer Check for libtc6
+
+  File Name:
+    tc6-bits.c
+
+  Summary:
+    Checks and times the data chunk header assembly of process_tx() and
+    the RX footer decoding
+
+  Description:
+    src/tc6.c is compiled into this file, so its static helpers can be
+    called directly. Every combination of the data header fields (SEQ, SV,
+    SWO, EV, EBO, TSC) is assembled once as a 32 bit word (HDR_WORD(),
+    get_parity_word() and value2net(), as process_tx() does) and once
+    field by field in the SPI buffer (CLEAR_HEADER(), SET_VAL() and
+    get_parity(), the former process_tx()). Both must give the same four
+    bytes. Both builders are then timed over the same random field values
+    (prefix "HDR", nanoseconds per header).
+    process_tx() itself is timed by queuing frames of every payload size
+    (-s) and converting them into chunks with mk_data_tx() without any SPI
+    transaction, every chunk header must have odd parity (prefix
+    "PROCESS_TX", nanoseconds per chunk including the payload copy).
+    RX footers are decoded once by the variant selected with
+    TC6_WORD_FOOTER (LOAD_FOOTER(), GET_FTR(), FOOTER_NO_HARDWARE() and
+    FOOTER_PARITY()) and once byte wise (GET_VAL() and get_parity()),
+    get_parity_word() is compared with get_parity() as well. Every field
+    must be equal for the edge patterns (all zero, all one, single bits or
+    bytes set or cleared, alternating bits) and for -r random footers.
+    Both decoders are then timed over the same random footers (prefix
+    "FTR", nanoseconds per footer with all fields).
+    The exit code is 2 on a mismatch.
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../src/tc6.c"
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                            DEFINITIONS                               */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+#define BITS_MAX_SIZES          (8u)
+#define BITS_MAX_FRAME          (1514u)
+#define BITS_RANDOM_FIELDS      (4096u)         /* Power of 2 */
+#define BITS_XACT_CHUNKS        (31u)
+#define BITS_RANDOM_FOOTERS     (4096u)         /* Power of 2 */
+
+typedef struct
+{
+    uint8_t seq;
+    uint8_t sv;
+    uint8_t swo;
+    uint8_t ev;
+    uint8_t ebo;
+    uint8_t tsc;
+} Fields_t;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                          PRIVATE VARIABLES                           */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static Fields_t m_fields[BITS_RANDOM_FIELDS];
+static uint8_t m_frame[BITS_MAX_FRAME];
+static uint8_t m_xact[BITS_XACT_CHUNKS * TC6_CHUNK_BUF_SIZE];
+static uint8_t m_footers[BITS_RANDOM_FOOTERS][TC6_HEADER_SIZE];
+static volatile uint32_t m_sink;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                      PRIVATE FUNCTION PROTOTYPES                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static void HeaderWord(const Fields_t *f, uint8_t *buf) __attribute__((noinline));
+static void HeaderFields(const Fields_t *f, uint8_t *buf) __attribute__((noinline));
+static uint32_t CheckHeaders(void);
+static double TimeHeaders(void (*build)(const Fields_t *f, uint8_t *buf), uint32_t count);
+static double TimeProcessTx(TC6_t *g, uint16_t payload, uint32_t frames, uint32_t *pChunks, uint32_t *pBad);
+static uint32_t DecodeWord(const uint8_t *pFooter) __attribute__((noinline));
+static uint32_t DecodeBytes(const uint8_t *pFooter) __attribute__((noinline));
+static bool CheckFooter(uint32_t value);
+static uint32_t CheckFooters(uint32_t randomCount, uint32_t *pEdgeCount);
+static double TimeFooters(uint32_t (*decode)(const uint8_t *pFooter), uint32_t count);
+static void OnTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag);
+static uint64_t NowNs(void);
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                             MAIN                                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+int main(int argc, char *argv[])
+{
+    uint16_t sizes[BITS_MAX_SIZES];
+    uint8_t sizeCount = 0u;
+    uint32_t count = 10000000u;
+    uint32_t frames = 200000u;
+    uint32_t randomFooters = 1000000u;
+    uint32_t edgeFooters;
+    uint32_t mismatches;
+    double wordNs;
+    double fieldNs;
+    bool checked;
+    TC6_t *g;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:f:s:r:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                count = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'f':
+                frames = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'r':
+                randomFooters = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                if (sizeCount < BITS_MAX_SIZES) {
+                    sizes[sizeCount++] = (uint16_t)atoi(optarg);
+                }
+                break;
+            default:
+                printf("usage: %s [-n headers and footers timed] [-f frames per payload size] [-s payload, repeatable] [-r random footers checked]\n", argv[0]);
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+    if (0u == sizeCount) {
+        sizes[sizeCount++] = 64u;
+        sizes[sizeCount++] = 256u;
+        sizes[sizeCount++] = 1500u;
+    }
+    for (uint8_t i = 0u; i < sizeCount; i++) {
+        if ((sizes[i] < 46u) || (sizes[i] > (BITS_MAX_FRAME - 14u))) {
+            printf("payload must be 46..%u\n", BITS_MAX_FRAME - 14u);
+            return 1;
+        }
+    }
+
+    srand(1u);
+    for (uint32_t i = 0u; i < BITS_RANDOM_FIELDS; i++) {
+        Fields_t *f = &m_fields[i];
+        f->seq = (uint8_t)(rand() & 1);
+        f->sv = (uint8_t)(rand() & 1);
+        f->swo = f->sv ? (uint8_t)(rand() & 0xF) : 0u;
+        f->ev = (uint8_t)(rand() & 1);
+        f->ebo = f->ev ? (uint8_t)(rand() & 0x3F) : 0u;
+        f->tsc = f->sv ? (uint8_t)(rand() & 3) : 0u;
+    }
+
+    mismatches = CheckHeaders();
+    wordNs = TimeHeaders(HeaderWord, count);
+    fieldNs = TimeHeaders(HeaderFields, count);
+    printf("HDR,combinations,mismatches,word_ns,field_ns\n");
+    printf("HDR,%u,%u,%.2f,%.2f\n", 2u * 2u * 16u * 2u * 64u * 4u, mismatches, wordNs, fieldNs);
+    checked = (0u == mismatches);
+
+    g = TC6_Init(NULL);
+    if (NULL == g) {
+        printf("initialization failed\n");
+        return 1;
+    }
+    /* Frames are only converted into chunks, nothing is sent over SPI */
+    g->enableData = true;
+    g->intContext = true;
+    printf("PROCESS_TX,payload,frames,chunks,ns_per_chunk,bad_headers\n");
+    for (uint8_t i = 0u; i < sizeCount; i++) {
+        uint32_t chunks;
+        uint32_t bad;
+        double ns = TimeProcessTx(g, sizes[i], frames, &chunks, &bad);
+        printf("PROCESS_TX,%u,%u,%u,%.2f,%u\n", sizes[i], frames, chunks, ns, bad);
+        checked = checked && (0u == bad);
+    }
+
+    for (uint32_t i = 0u; i < BITS_RANDOM_FOOTERS; i++) {
+        value2net(((uint32_t)rand() << 16) ^ (uint32_t)rand(), m_footers[i]);
+    }
+    mismatches = CheckFooters(randomFooters, &edgeFooters);
+    wordNs = TimeFooters(DecodeWord, count);
+    fieldNs = TimeFooters(DecodeBytes, count);
+    printf("FTR,word_footer,edge_patterns,random_patterns,mismatches,word_ns,byte_ns\n");
+    printf("FTR,%u,%u,%u,%u,%.2f,%.2f\n", (unsigned)TC6_WORD_FOOTER, edgeFooters, randomFooters, mismatches, wordNs, fieldNs);
+    checked = checked && (0u == mismatches);
+    return checked ? 0 : 2;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  CALLBACK FUNCTIONS FROM TC6 STACK                   */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+void TC6_CB_OnNeedService(TC6_t *pInst, void *pGlobalTag)
+{
+    (void)pInst;
+    (void)pGlobalTag;
+}
+
+void TC6_CB_OnRxEthernetSlice(TC6_t *pInst, const uint8_t *pRx, uint16_t offset, uint16_t len, void *pGlobalTag)
+{
+    (void)pInst;
+    (void)pRx;
+    (void)offset;
+    (void)len;
+    (void)pGlobalTag;
+}
+
+void TC6_CB_OnRxEthernetPacket(TC6_t *pInst, bool success, uint16_t len, uint64_t *rxTimestamp, void *pGlobalTag)
+{
+    (void)pInst;
+    (void)success;
+    (void)len;
+    (void)rxTimestamp;
+    (void)pGlobalTag;
+}
+
+void TC6_CB_OnError(TC6_t *pInst, TC6_Error_t err, void *pGlobalTag)
+{
+    (void)pInst;
+    (void)err;
+    (void)pGlobalTag;
+}
+
+void TC6_CB_OnExtendedStatus(TC6_t *pInst, void *pGlobalTag)
+{
+    (void)pInst;
+    (void)pGlobalTag;
+}
+
+bool TC6_CB_OnSpiTransaction(uint8_t tc6instance, uint8_t *pTx, uint8_t *pRx, uint16_t len, void *pGlobalTag)
+{
+    (void)tc6instance;
+    (void)pTx;
+    (void)pRx;
+    (void)len;
+    (void)pGlobalTag;
+    return false;
+}
+
+#if (0u != TC6_PROBES)
+void TC6_CB_OnProbe(uint8_t tc6instance, TC6_Probe_t probe, void *pGlobalTag)
+{
+    (void)tc6instance;
+    (void)probe;
+    (void)pGlobalTag;
+}
+#endif
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  PRIVATE FUNCTION IMPLEMENTATIONS                    */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static void HeaderWord(const Fields_t *f, uint8_t *buf)
+{
+    uint32_t hdr = HDR_DATA_TEMPLATE | HDR_WORD(HDR_SEQ, f->seq);
+    if (0u != f->sv) {
+        hdr |= HDR_WORD(HDR_SV, 1u);
+        hdr |= HDR_WORD(HDR_SWO, f->swo);
+    }
+    if (0u != f->tsc) {
+        hdr |= HDR_WORD(HDR_TSC, f->tsc);
+    }
+    if (0u != f->ev) {
+        hdr |= HDR_WORD(HDR_EV, 1u);
+        hdr |= HDR_WORD(HDR_EBO, f->ebo);
+    }
+    hdr |= HDR_WORD(HDR_P, get_parity_word(hdr));
+    value2net(hdr, buf);
+}
+
+static void HeaderFields(const Fields_t *f, uint8_t *buf)
+{
+    CLEAR_HEADER(buf);
+    SET_VAL(HDR_DNC, 1u, buf);
+    SET_VAL(HDR_DV, 1u, buf);
+    SET_VAL(HDR_SEQ, f->seq, buf);
+    if (0u != f->sv) {
+        SET_VAL(HDR_SV, 1u, buf);
+        SET_VAL(HDR_SWO, f->swo, buf);
+    }
+    if (0u != f->tsc) {
+        SET_VAL(HDR_TSC, f->tsc, buf);
+    }
+    if (0u != f->ev) {
+        SET_VAL(HDR_EV, 1u, buf);
+        SET_VAL(HDR_EBO, f->ebo, buf);
+    }
+    SET_VAL(HDR_P, get_parity(buf), buf);
+}
+
+static uint32_t CheckHeaders(void)
+{
+    uint32_t mismatches = 0u;
+    Fields_t f;
+
+    for (uint32_t i = 0u; i < (2u * 2u * 16u * 2u * 64u * 4u); i++) {
+        uint8_t word[TC6_HEADER_SIZE];
+        uint8_t fields[TC6_HEADER_SIZE];
+
+        f.seq = (uint8_t)(i & 1u);
+        f.sv = (uint8_t)((i >> 1) & 1u);
+        f.swo = (uint8_t)((i >> 2) & 0xFu);
+        f.ev = (uint8_t)((i >> 6) & 1u);
+        f.ebo = (uint8_t)((i >> 7) & 0x3Fu);
+        f.tsc = (uint8_t)((i >> 13) & 3u);
+        HeaderWord(&f, word);
+        HeaderFields(&f, fields);
+        /* Odd parity over all 32 bits */
+        if ((0 != memcmp(word, fields, sizeof(word))) || (1 != __builtin_parity(net2value(word)))) {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static double TimeHeaders(void (*build)(const Fields_t *f, uint8_t *buf), uint32_t count)
+{
+    uint8_t buf[TC6_HEADER_SIZE];
+    uint32_t sum = 0u;
+    uint64_t start = NowNs();
+
+    for (uint32_t i = 0u; i < count; i++) {
+        build(&m_fields[i & (BITS_RANDOM_FIELDS - 1u)], buf);
+        sum += net2value(buf);
+    }
+    m_sink = sum;
+    return (0u != count) ? ((double)(NowNs() - start) / count) : 0.0;
+}
+
+static double TimeProcessTx(TC6_t *g, uint16_t payload, uint32_t frames, uint32_t *pChunks, uint32_t *pBad)
+{
+    uint32_t queued = 0u;
+    uint32_t chunks = 0u;
+    uint32_t bad = 0u;
+    uint64_t start;
+
+    memset(m_frame, 0x5Au, sizeof(m_frame));
+    start = NowNs();
+    while ((queued < frames) || (0u != qtxeth_stage2_convert_cap(&g->eth_q))) {
+        TC6_RawTxSegment *seg;
+        uint16_t len;
+
+        /* Keep the queue filled, so frames below TC6_CONCAT_THRESHOLD get concatenated */
+        while ((queued < frames) && (0u != TC6_GetRawSegments(g, &seg))) {
+            seg[0].pEth = m_frame;
+            seg[0].segLen = (uint16_t)(14u + payload);
+            (void)TC6_SendRawEthernetSegments(g, seg, 1u, seg[0].segLen, 0u, OnTxDone, NULL);
+            queued++;
+        }
+        len = mk_data_tx(g, m_xact, sizeof(m_xact));
+        for (uint16_t pos = 0u; pos < len; pos += TC6_CHUNK_BUF_SIZE) {
+            if (1 != __builtin_parity(net2value(&m_xact[pos]))) {
+                bad++;
+            }
+            chunks++;
+        }
+    }
+    *pChunks = chunks;
+    *pBad = bad;
+    return (0u != chunks) ? ((double)(NowNs() - start) / chunks) : 0.0;
+}
+
+static uint32_t DecodeWord(const uint8_t *pFooter)
+{
+    const Footer_t ftr = LOAD_FOOTER(pFooter);
+    uint32_t sum = FOOTER_NO_HARDWARE(ftr) ? 1u : 0u;
+
+    sum += FOOTER_PARITY(ftr);
+    sum = (sum << 1) ^ GET_FTR(FTR_EXST, ftr);
+    sum = (sum << 1) ^ GET_FTR(FTR_HDRB, ftr);
+    sum = (sum << 1) ^ GET_FTR(FTR_SYNC, ftr);
+    sum = (sum << 1) ^ GET_FTR(FTR_RCA, ftr);
+    sum = (sum << 1) ^ GET_FTR(FTR_DV, ftr);
+    sum = (sum << 1) ^ GET_FTR(FTR_SV, ftr);
+    sum = (sum << 1) ^ GET_FTR(FTR_SWO, ftr);
+    sum = (sum << 1) ^ GET_FTR(FTR_FD, ftr);
+    sum = (sum << 1) ^ GET_FTR(FTR_EV, ftr);
+    sum = (sum << 1) ^ GET_FTR(FTR_EBO, ftr);
+    sum = (sum << 1) ^ GET_FTR(FTR_RTSA, ftr);
+    sum = (sum << 1) ^ GET_FTR(FTR_RTSP, ftr);
+    sum = (sum << 1) ^ GET_FTR(FTR_TXC, ftr);
+    return sum;
+}
+
+static uint32_t DecodeBytes(const uint8_t *pFooter)
+{
+    bool noHardware = ((0x0u == pFooter[0]) && (0x0u == pFooter[1]) && (0x0u == pFooter[2]) && (0x0u == pFooter[3])) ||
+                      ((0xFFu == pFooter[0]) && (0xFFu == pFooter[1]) && (0xFFu == pFooter[2]) && (0xFFu == pFooter[3]));
+    uint32_t sum = noHardware ? 1u : 0u;
+
+    sum += get_parity(pFooter);
+    sum = (sum << 1) ^ GET_VAL(FTR_EXST, pFooter);
+    sum = (sum << 1) ^ GET_VAL(FTR_HDRB, pFooter);
+    sum = (sum << 1) ^ GET_VAL(FTR_SYNC, pFooter);
+    sum = (sum << 1) ^ GET_VAL(FTR_RCA, pFooter);
+    sum = (sum << 1) ^ GET_VAL(FTR_DV, pFooter);
+    sum = (sum << 1) ^ GET_VAL(FTR_SV, pFooter);
+    sum = (sum << 1) ^ GET_VAL(FTR_SWO, pFooter);
+    sum = (sum << 1) ^ GET_VAL(FTR_FD, pFooter);
+    sum = (sum << 1) ^ GET_VAL(FTR_EV, pFooter);
+    sum = (sum << 1) ^ GET_VAL(FTR_EBO, pFooter);
+    sum = (sum << 1) ^ GET_VAL(FTR_RTSA, pFooter);
+    sum = (sum << 1) ^ GET_VAL(FTR_RTSP, pFooter);
+    sum = (sum << 1) ^ GET_VAL(FTR_TXC, pFooter);
+    return sum;
+}
+
+static bool CheckFooter(uint32_t value)
+{
+    uint8_t buf[TC6_HEADER_SIZE];
+
+    value2net(value, buf);
+    /* Both decoders fold the same fields in the same order, as the RX path reads them */
+    return (DecodeWord(buf) == DecodeBytes(buf)) && (get_parity_word(value) == get_parity(buf));
+}
+
+static uint32_t CheckFooters(uint32_t randomCount, uint32_t *pEdgeCount)
+{
+    static const uint32_t PATTERNS[] = { 0x00000000u, 0xFFFFFFFFu, 0xAAAAAAAAu, 0x55555555u, 0x0000FFFFu, 0xFFFF0000u };
+    uint32_t mismatches = 0u;
+    uint32_t edges = 0u;
+
+    for (uint8_t i = 0u; i < (sizeof(PATTERNS) / sizeof(PATTERNS[0])); i++) {
+        mismatches += CheckFooter(PATTERNS[i]) ? 0u : 1u;
+        edges++;
+    }
+    for (uint8_t bit = 0u; bit < 32u; bit++) {
+        mismatches += CheckFooter(1u << bit) ? 0u : 1u;
+        mismatches += CheckFooter(~(1u << bit)) ? 0u : 1u;
+        edges += 2u;
+    }
+    for (uint8_t byte = 0u; byte < 4u; byte++) {
+        mismatches += CheckFooter(0xFFu << (byte * 8u)) ? 0u : 1u;
+        mismatches += CheckFooter(~(0xFFu << (byte * 8u))) ? 0u : 1u;
+        edges += 2u;
+    }
+    for (uint32_t i = 0u; i < randomCount; i++) {
+        mismatches += CheckFooter(((uint32_t)rand() << 16) ^ (uint32_t)rand()) ? 0u : 1u;
+    }
+    *pEdgeCount = edges;
+    return mismatches;
+}
+
+static double TimeFooters(uint32_t (*decode)(const uint8_t *pFooter), uint32_t count)
+{
+    uint32_t sum = 0u;
+    uint64_t start = NowNs();
+
+    for (uint32_t i = 0u; i < count; i++) {
+        sum += decode(m_footers[i & (BITS_RANDOM_FOOTERS - 1u)]);
+    }
+    m_sink = sum;
+    return (0u != count) ? ((double)(NowNs() - start) / count) : 0.0;
+}
+
+static void OnTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag)
+{
+    (void)pInst;
+    (void)pTx;
+    (void)len;
+    (void)pTag;
+    (void)pGlobalTag;
+}
+
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
@@ -0,0 +1,647 @@
+/*******************************************************************************
+  Host Bridge Check for libtc6
+
+  File Name:
+    tc6-bridge.c
+
+  Summary:
+    Forwards frames between two emulated segments with one TX submitter per port
+
+  Description:
+    Two 10BASE-T1S segments of emulated LAN865x (see sim/tc6sim.h): the
+    sources on segment A, the sink on segment B and a bridge node with one
+    libtc6 instance on each segment. The bridge works like the ESP32 glue
+    (main/bridge.c, main/ethernet.c): the service loop plays SyncTask,
+    forwards every frame received on port A to port B from within the RX
+    callback and is the only caller of TC6_SendRawEthernetSegments(). A
+    second thread plays lwIP and sends local frames on port B through a
+    submit queue, which the service loop drains into the libtc6 TX queue
+    before servicing. Both use one buffer pool, allocated lock-free.
+    The sink checks every frame (length, sender, per sender order, payload,
+    FCS) and accounts for the frames the bridge could not queue, the
+    segments gave up (CSMA/CD) and the MACPHYs lost in a full buffer. Prints per payload size the frame rate and latency
+    of forwarded and local frames (prefix "BRIDGE") and the check result
+    (prefix "CHECK"), the exit code is 2 on a lost, duplicated, reordered
+    or corrupted frame.
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "tc6.h"
+#include "tc6-regs.h"
+#include "tc6sim.h"
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                            DEFINITIONS                               */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+#define BRIDGE_ETHERTYPE        (0x88B5u)
+#define BRIDGE_MAGIC            (0x42524447u)
+#define BRIDGE_HEADER_LEN       (14u)
+#define BRIDGE_FCS_LEN          (4u)
+#define BRIDGE_STAMP_LEN        (16u)
+#define BRIDGE_MAX_FRAME        (1514u)
+#define BRIDGE_MAX_FRAMES       (100000u)
+#define BRIDGE_POOL_SIZE        (32u)           /* Frame buffers of the bridge node, like the RX pbuf pool of the glue */
+#define BRIDGE_SUBMIT_QSIZE     (8u)            /* Local frames waiting for the service loop (TX_SUBMIT_QSIZE) */
+#define BRIDGE_STEP_BITS        (100u)          /* Segment time between two service loops */
+#define BRIDGE_DRAIN_BITS       (1000000u)      /* Wait for outstanding frames after the last one was sent (100 ms) */
+#define BRIDGE_BITS_PER_MS      (10000u)
+#define BRIDGE_MAX_SOURCES      (TC6_MAX_INSTANCES - 3u)
+
+typedef struct
+{
+    uint8_t rxBuf[TC6SIM_MAX_FRAME_LEN];
+    uint8_t txFrame[TC6_TX_ETH_QSIZE][BRIDGE_MAX_FRAME];
+    uint8_t txHead;
+    uint8_t txInFlight;
+    uint32_t sent;
+} Station_t;
+
+typedef struct
+{
+    uint32_t received;
+    uint32_t duplicates;        /** Sequence numbers received more than once or after a later one */
+    uint32_t corrupt;           /** Frames with wrong length, sender or content */
+    uint32_t latency[2][BRIDGE_MAX_FRAMES];     /** [0]: forwarded, [1]: local */
+    uint32_t latencyCount[2];
+} Sink_t;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                          PRIVATE VARIABLES                           */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static TC6Sim_Bus_t m_busA;
+static TC6Sim_Bus_t m_busB;
+static TC6_t *m_tc6[TC6_MAX_INSTANCES];
+static Station_t m_station[TC6_MAX_INSTANCES];
+static Sink_t m_sink;
+static uint8_t m_sources = 2u;
+static uint8_t m_portA;
+static uint8_t m_portB;
+static uint8_t m_sinkIdx;
+static uint16_t m_payload;
+static uint32_t m_nextSeq[TC6_MAX_INSTANCES];
+
+/* Buffer pool of the bridge node, a set bit marks a free buffer (allocated by both threads) */
+static uint8_t m_pool[BRIDGE_POOL_SIZE][BRIDGE_MAX_FRAME];
+static uint16_t m_poolLen[BRIDGE_POOL_SIZE];
+static uint32_t m_poolFree;
+static uint32_t m_forwarded;
+static uint32_t m_fwdDrops;
+static uint32_t m_poolDrops;
+
+/* Submit queue from the lwIP thread to the service loop */
+static pthread_mutex_t m_submitLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t m_submitSpace = PTHREAD_COND_INITIALIZER;
+static uint8_t m_submit[BRIDGE_SUBMIT_QSIZE];
+static uint32_t m_submitHead;
+static uint32_t m_submitTail;
+static uint32_t m_localFrames;
+static uint32_t m_localSent;
+static uint64_t m_now;          /* Segment time, written by the service loop only */
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                      PRIVATE FUNCTION PROTOTYPES                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint64_t Now(void);
+static TC6Sim_Node_t *GetNode(uint8_t idx);
+static void RunSegments(uint32_t bitTimes);
+static void ServiceLoop(void);
+static void DrainSubmitQueue(void);
+static bool SendSourceFrame(uint8_t idx, uint32_t seq);
+static void BuildFrame(uint8_t *frame, uint8_t src, uint32_t seq, uint64_t stamp);
+static int AllocBuffer(void);
+static void FreeBuffer(int idx);
+static void *LocalThread(void *arg);
+static void OnSourceTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag);
+static void OnPoolTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag);
+static void Forward(const uint8_t *p, uint16_t len);
+static void CheckFrame(const uint8_t *p, uint16_t len);
+static uint32_t Aborts(void);
+static uint32_t Overruns(void);
+static uint32_t Crc32(const uint8_t *pData, uint16_t len);
+static int CompareLatency(const void *a, const void *b);
+static uint64_t CpuTimeUs(void);
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                             MAIN                                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+int main(int argc, char *argv[])
+{
+    static const uint16_t defaultPayloads[] = { 64u, 512u, 1500u };
+    uint16_t payloads[16];
+    uint8_t payloadCount = 0u;
+    uint32_t frames = 1000u;
+    uint32_t localFrames = 300u;
+    bool plca = false;
+    bool success = true;
+    bool checked = true;
+    TC6Sim_BusConfig_t cfg = { .toTimerBits = 32u, .beaconBits = 20u, .spiClockHz = 0u, .seed = 1u };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:f:l:s:c:ph")) != -1) {
+        switch (opt) {
+            case 'n':
+                m_sources = (uint8_t)atoi(optarg);
+                break;
+            case 'f':
+                frames = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'l':
+                localFrames = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                if (payloadCount < (sizeof(payloads) / sizeof(payloads[0]))) {
+                    payloads[payloadCount++] = (uint16_t)atoi(optarg);
+                }
+                break;
+            case 'c':
+                cfg.spiClockHz = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'p':
+                plca = true;
+                break;
+            default:
+                printf("usage: %s [-n sources] [-f frames] [-l local frames] [-s payload]... [-c spi clock Hz] [-p (PLCA)]\n", argv[0]);
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+    if ((m_sources < 1u) || (m_sources > BRIDGE_MAX_SOURCES) || (frames > BRIDGE_MAX_FRAMES) || (localFrames > BRIDGE_MAX_FRAMES)) {
+        printf("sources must be 1..%u, frames at most %u\n", (unsigned)BRIDGE_MAX_SOURCES, BRIDGE_MAX_FRAMES);
+        return 1;
+    }
+    if (0u == payloadCount) {
+        memcpy(payloads, defaultPayloads, sizeof(defaultPayloads));
+        payloadCount = (uint8_t)(sizeof(defaultPayloads) / sizeof(defaultPayloads[0]));
+    }
+    m_portA = m_sources;
+    m_portB = (uint8_t)(m_sources + 1u);
+    m_sinkIdx = (uint8_t)(m_sources + 2u);
+    m_poolFree = (uint32_t)((1ull << BRIDGE_POOL_SIZE) - 1u);
+
+    /* Segment A: sources and bridge port A, segment B: bridge port B (PLCA coordinator) and sink */
+    TC6Sim_BusInit(&m_busA, &cfg);
+    TC6Sim_BusInit(&m_busB, &cfg);
+    TC6Sim_PortAttach(&m_busA);
+    TC6Sim_PortAttach(&m_busB);
+    for (uint8_t i = 0u; success && (i <= m_sinkIdx); i++) {
+        bool segmentA = (i <= m_portA);
+        uint8_t nodeId = segmentA ? i : (uint8_t)(i - m_portB);
+        uint8_t nodeCount = segmentA ? (uint8_t)(m_sources + 1u) : 2u;
+        uint8_t mac[6] = { 0x00u, 0x04u, 0xA3u, 0x12u, 0x00u, i };
+
+        (void)TC6Sim_AddNode(segmentA ? &m_busA : &m_busB, i);
+        m_tc6[i] = TC6_Init(&m_station[i]);
+        success = (NULL != m_tc6[i]) && TC6Regs_Init(m_tc6[i], &m_station[i], mac, plca, nodeId, nodeCount, 0u, 0x80u, true, false, false);
+    }
+    for (uint32_t k = 0u; success && (k < (100u * BRIDGE_BITS_PER_MS / BRIDGE_STEP_BITS)); k++) {
+        ServiceLoop();
+        RunSegments(BRIDGE_STEP_BITS);
+    }
+    for (uint8_t i = 0u; success && (i <= m_sinkIdx); i++) {
+        success = TC6Regs_GetInitDone(m_tc6[i]);
+    }
+    if (!success) {
+        printf("initialization failed\n");
+        return 1;
+    }
+    for (uint8_t i = 0u; i <= m_sinkIdx; i++) {
+        TC6_EnableData(m_tc6[i], true);
+    }
+
+    printf("BRIDGE,payload,sources,plca,sent,forwarded,fwd_drops,local_sent,received,duration_us,fps,fwd_p50_us,fwd_p99_us,local_p50_us,local_p99_us,cpu_us\n");
+    printf("CHECK,payload,sent,local_sent,received,fwd_drops,aborted,overruns,missing,misordered,corrupt,result\n");
+    for (uint8_t step = 0u; step < payloadCount; step++) {
+        pthread_t thread;
+        uint32_t sent = 0u;
+        uint32_t seq = 0u;
+        uint32_t aborts = Aborts();
+        uint32_t overruns = Overruns();
+        uint32_t fwdDrops = m_fwdDrops + m_poolDrops;
+        uint32_t forwarded = m_forwarded;
+        uint64_t cpuStart = CpuTimeUs();
+        uint64_t start = Now();
+        uint64_t lastRx;
+        uint32_t missing;
+        uint32_t lost;
+        bool ok;
+
+        m_payload = payloads[step];
+        if (m_payload < BRIDGE_STAMP_LEN) {
+            m_payload = BRIDGE_STAMP_LEN;
+        }
+        if (m_payload > (BRIDGE_MAX_FRAME - BRIDGE_HEADER_LEN)) {
+            m_payload = BRIDGE_MAX_FRAME - BRIDGE_HEADER_LEN;
+        }
+        memset(&m_sink, 0, sizeof(m_sink));
+        memset(m_nextSeq, 0, sizeof(m_nextSeq));
+        for (uint8_t i = 0u; i < m_sources; i++) {
+            m_station[i].sent = 0u;
+        }
+        __atomic_store_n(&m_localSent, 0u, __ATOMIC_RELAXED);
+        m_localFrames = localFrames;
+        if (0 != pthread_create(&thread, NULL, LocalThread, NULL)) {
+            printf("cannot start the local sender\n");
+            return 1;
+        }
+
+        /* Sources share the frames, every one fills its TX queue */
+        while (seq < frames) {
+            for (uint8_t i = 0u; (i < m_sources) && (seq < frames); i++) {
+                if (SendSourceFrame(i, m_station[i].sent)) {
+                    seq++;
+                }
+            }
+            ServiceLoop();
+            RunSegments(BRIDGE_STEP_BITS);
+        }
+        /* The local sender finishes as soon as the service loop takes its frames */
+        while (__atomic_load_n(&m_localSent, __ATOMIC_ACQUIRE) < m_localFrames) {
+            ServiceLoop();
+            RunSegments(BRIDGE_STEP_BITS);
+        }
+        (void)pthread_join(thread, NULL);
+        for (uint8_t i = 0u; i < m_sources; i++) {
+            sent += m_station[i].sent;
+        }
+        lastRx = Now();
+        for (uint32_t waited = 0u; waited < BRIDGE_DRAIN_BITS; waited += BRIDGE_STEP_BITS) {
+            lost = (m_fwdDrops + m_poolDrops - fwdDrops) + (Aborts() - aborts) + (Overruns() - overruns);
+            if ((m_sink.received + lost) >= (sent + m_localFrames)) {
+                break;
+            }
+            ServiceLoop();
+            RunSegments(BRIDGE_STEP_BITS);
+            lastRx = Now();
+        }
+
+        aborts = Aborts() - aborts;
+        overruns = Overruns() - overruns;
+        fwdDrops = m_fwdDrops + m_poolDrops - fwdDrops;
+        forwarded = m_forwarded - forwarded;
+        lost = fwdDrops + aborts + overruns;
+        missing = ((m_sink.received + lost) < (sent + m_localFrames)) ? (sent + m_localFrames - m_sink.received - lost) : 0u;
+        uint64_t durationUs = (lastRx - start) / 10u;
+        uint64_t cpuUs = CpuTimeUs() - cpuStart;
+        uint32_t fwdCount = m_sink.latencyCount[0];
+        uint32_t localCount = m_sink.latencyCount[1];
+
+        qsort(m_sink.latency[0], fwdCount, sizeof(uint32_t), CompareLatency);
+        qsort(m_sink.latency[1], localCount, sizeof(uint32_t), CompareLatency);
+        printf("BRIDGE,%u,%u,%u,%u,%u,%u,%u,%u,%llu,%llu,%u,%u,%u,%u,%llu\n",
+               m_payload, m_sources, plca ? 1u : 0u, sent, forwarded, fwdDrops, m_localFrames, m_sink.received,
+               (unsigned long long)durationUs,
+               (unsigned long long)(durationUs ? ((uint64_t)m_sink.received * 1000000u / durationUs) : 0u),
+               fwdCount ? m_sink.latency[0][(fwdCount - 1u) * 50u / 100u] : 0u,
+               fwdCount ? m_sink.latency[0][(fwdCount - 1u) * 99u / 100u] : 0u,
+               localCount ? m_sink.latency[1][(localCount - 1u) * 50u / 100u] : 0u,
+               localCount ? m_sink.latency[1][(localCount - 1u) * 99u / 100u] : 0u,
+               (unsigned long long)cpuUs);
+        ok = (0u == missing) && (0u == m_sink.duplicates) && (0u == m_sink.corrupt);
+        checked = checked && ok;
+        printf("CHECK,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%s\n", m_payload, sent, m_localFrames, m_sink.received, fwdDrops, aborts,
+               overruns, missing, m_sink.duplicates, m_sink.corrupt, ok ? "ok" : "FAIL");
+    }
+    return checked ? 0 : 2;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  CALLBACK FUNCTIONS FROM TC6 STACK                   */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+void TC6_CB_OnNeedService(TC6_t *pInst, void *pGlobalTag)
+{
+    /* Every instance is serviced in each loop anyway */
+    (void)pInst;
+    (void)pGlobalTag;
+}
+
+void TC6_CB_OnRxEthernetSlice(TC6_t *pInst, const uint8_t *pRx, uint16_t offset, uint16_t len, void *pGlobalTag)
+{
+    Station_t *station = (Station_t *)pGlobalTag;
+    (void)pInst;
+    if (((uint32_t)offset + len) <= sizeof(station->rxBuf)) {
+        memcpy(&station->rxBuf[offset], pRx, len);
+    }
+}
+
+void TC6_CB_OnRxEthernetPacket(TC6_t *pInst, bool success, uint16_t len, uint64_t *rxTimestamp, void *pGlobalTag)
+{
+    Station_t *station = (Station_t *)pGlobalTag;
+    uint8_t idx = TC6_GetInstance(pInst);
+    (void)rxTimestamp;
+
+    if (!success || (len < (BRIDGE_HEADER_LEN + BRIDGE_STAMP_LEN + BRIDGE_FCS_LEN)) || (len > sizeof(station->rxBuf))) {
+        /* Not part of the test traffic */
+    } else if (idx == m_portA) {
+        Forward(station->rxBuf, len);
+    } else if (idx == m_sinkIdx) {
+        CheckFrame(station->rxBuf, len);
+    } else {} /* MISRA enforced termination */
+}
+
+void TC6_CB_OnError(TC6_t *pInst, TC6_Error_t err, void *pGlobalTag)
+{
+    (void)pGlobalTag;
+    printf("node %u: error %d\n", TC6_GetInstance(pInst), (int)err);
+}
+
+uint32_t TC6Regs_CB_GetTicksMs(void)
+{
+    return (uint32_t)(Now() / BRIDGE_BITS_PER_MS);
+}
+
+void TC6Regs_CB_OnEvent(TC6_t *pInst, TC6Regs_Event_t event, void *pTag)
+{
+    (void)pInst;
+    (void)event;
+    (void)pTag;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  PRIVATE FUNCTION IMPLEMENTATIONS                    */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint64_t Now(void)
+{
+    TC6Sim_BusStats_t bus;
+    TC6Sim_GetBusStats(&m_busA, &bus);
+    return bus.now;
+}
+
+static TC6Sim_Node_t *GetNode(uint8_t idx)
+{
+    return (idx <= m_portA) ? TC6Sim_GetNode(&m_busA, idx) : TC6Sim_GetNode(&m_busB, idx);
+}
+
+static void RunSegments(uint32_t bitTimes)
+{
+    TC6Sim_BusStats_t a;
+    TC6Sim_BusStats_t b;
+    uint32_t before = TC6Regs_CB_GetTicksMs();
+
+    /* SPI transactions advance only the segment of the addressed MACPHY, the other one catches up */
+    TC6Sim_GetBusStats(&m_busA, &a);
+    TC6Sim_GetBusStats(&m_busB, &b);
+    TC6Sim_BusRun(&m_busA, bitTimes + ((b.now > a.now) ? (uint32_t)(b.now - a.now) : 0u));
+    TC6Sim_BusRun(&m_busB, bitTimes + ((a.now > b.now) ? (uint32_t)(a.now - b.now) : 0u));
+    __atomic_store_n(&m_now, Now(), __ATOMIC_RELEASE);
+    if (TC6Regs_CB_GetTicksMs() != before) {
+        TC6Regs_CheckTimers();
+    }
+}
+
+static void ServiceLoop(void)
+{
+    /* SyncTask: frames of the lwIP thread first, then every instance (forwarding happens in the RX callback) */
+    DrainSubmitQueue();
+    for (uint8_t i = 0u; i <= m_sinkIdx; i++) {
+        TC6_Service(m_tc6[i], !TC6Sim_IrqAsserted(GetNode(i)));
+    }
+}
+
+static void DrainSubmitQueue(void)
+{
+    TC6_RawTxSegment *seg;
+    bool taken = false;
+
+    (void)pthread_mutex_lock(&m_submitLock);
+    while ((m_submitHead != m_submitTail) && (TC6_GetRawSegments(m_tc6[m_portB], &seg) > 0u)) {
+        uint8_t buf = m_submit[m_submitHead % BRIDGE_SUBMIT_QSIZE];
+        m_submitHead++;
+        taken = true;
+        /* libtc6 is called without the lock, the lwIP thread only touches the submit queue */
+        (void)pthread_mutex_unlock(&m_submitLock);
+        seg[0].pEth = m_pool[buf];
+        seg[0].segLen = m_poolLen[buf];
+        if (!TC6_SendRawEthernetSegments(m_tc6[m_portB], seg, 1u, m_poolLen[buf], 0u, OnPoolTxDone, (void *)(uintptr_t)(buf + 1u))) {
+            FreeBuffer(buf);
+        }
+        (void)pthread_mutex_lock(&m_submitLock);
+    }
+    if (taken) {
+        (void)pthread_cond_signal(&m_submitSpace);
+    }
+    (void)pthread_mutex_unlock(&m_submitLock);
+}
+
+static void *LocalThread(void *arg)
+{
+    (void)arg;
+    for (uint32_t seq = 0u; seq < m_localFrames; seq++) {
+        int buf = AllocBuffer();
+        while (buf < 0) {
+            /* Pool taken by forwarded frames, like an lwIP pbuf allocation failing and being retried */
+            (void)usleep(10u);
+            buf = AllocBuffer();
+        }
+        BuildFrame(m_pool[buf], m_portB, seq, __atomic_load_n(&m_now, __ATOMIC_ACQUIRE));
+        m_poolLen[buf] = (uint16_t)(BRIDGE_HEADER_LEN + m_payload);
+
+        /* xQueueSend() with timeout: wait for space in the submit queue */
+        (void)pthread_mutex_lock(&m_submitLock);
+        while ((m_submitTail - m_submitHead) >= BRIDGE_SUBMIT_QSIZE) {
+            (void)pthread_cond_wait(&m_submitSpace, &m_submitLock);
+        }
+        m_submit[m_submitTail % BRIDGE_SUBMIT_QSIZE] = (uint8_t)buf;
+        m_submitTail++;
+        (void)pthread_mutex_unlock(&m_submitLock);
+        __atomic_add_fetch(&m_localSent, 1u, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+static bool SendSourceFrame(uint8_t idx, uint32_t seq)
+{
+    TC6_RawTxSegment *seg;
+    Station_t *station = &m_station[idx];
+    uint8_t *frame = station->txFrame[station->txHead];
+    bool success = false;
+
+    if ((station->txInFlight < TC6_TX_ETH_QSIZE) && (TC6_GetRawSegments(m_tc6[idx], &seg) > 0u)) {
+        BuildFrame(frame, idx, seq, Now());
+        seg[0].pEth = frame;
+        seg[0].segLen = BRIDGE_HEADER_LEN;
+        seg[1].pEth = &frame[BRIDGE_HEADER_LEN];
+        seg[1].segLen = m_payload;
+        success = TC6_SendRawEthernetSegments(m_tc6[idx], seg, 2u, (uint16_t)(BRIDGE_HEADER_LEN + m_payload), 0u, OnSourceTxDone, station);
+        if (success) {
+            station->txHead = (uint8_t)((station->txHead + 1u) % TC6_TX_ETH_QSIZE);
+            station->txInFlight++;
+            station->sent++;
+        }
+    }
+    return success;
+}
+
+static void BuildFrame(uint8_t *frame, uint8_t src, uint32_t seq, uint64_t stamp)
+{
+    uint32_t magic = BRIDGE_MAGIC;
+    memset(frame, 0xFF, 6u);
+    frame[6] = 0x00u; frame[7] = 0x04u; frame[8] = 0xA3u; frame[9] = 0x12u; frame[10] = 0x00u; frame[11] = src;
+    frame[12] = (uint8_t)(BRIDGE_ETHERTYPE >> 8);
+    frame[13] = (uint8_t)BRIDGE_ETHERTYPE;
+    memcpy(&frame[BRIDGE_HEADER_LEN], &magic, sizeof(magic));
+    memcpy(&frame[BRIDGE_HEADER_LEN + 4u], &seq, sizeof(seq));
+    memcpy(&frame[BRIDGE_HEADER_LEN + 8u], &stamp, sizeof(stamp));
+    memset(&frame[BRIDGE_HEADER_LEN + BRIDGE_STAMP_LEN], (uint8_t)(seq + src), m_payload - BRIDGE_STAMP_LEN);
+}
+
+static int AllocBuffer(void)
+{
+    uint32_t freeMask = __atomic_load_n(&m_poolFree, __ATOMIC_ACQUIRE);
+    while (0u != freeMask) {
+        uint32_t idx = (uint32_t)__builtin_ctz(freeMask);
+        if (__atomic_compare_exchange_n(&m_poolFree, &freeMask, freeMask & ~(1u << idx), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return (int)idx;
+        }
+    }
+    return -1;
+}
+
+static void FreeBuffer(int idx)
+{
+    __atomic_fetch_or(&m_poolFree, 1u << idx, __ATOMIC_RELEASE);
+}
+
+static void OnSourceTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag)
+{
+    Station_t *station = (Station_t *)pTag;
+    (void)pInst;
+    (void)pTx;
+    (void)len;
+    (void)pGlobalTag;
+    if (station->txInFlight > 0u) {
+        station->txInFlight--;
+    }
+}
+
+static void OnPoolTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag)
+{
+    (void)pInst;
+    (void)pTx;
+    (void)len;
+    (void)pGlobalTag;
+    FreeBuffer((int)((uintptr_t)pTag - 1u));
+}
+
+static void Forward(const uint8_t *p, uint16_t len)
+{
+    TC6_RawTxSegment *seg;
+    int buf;
+
+    /* BridgeTransmit(): never blocks, a full TX queue of port B drops the frame */
+    if (TC6_GetRawSegments(m_tc6[m_portB], &seg) == 0u) {
+        m_fwdDrops++;
+        return;
+    }
+    buf = AllocBuffer();
+    if (buf < 0) {
+        m_poolDrops++;
+        return;
+    }
+    /* The MACPHY of port B appends its own FCS */
+    m_poolLen[buf] = (uint16_t)(len - BRIDGE_FCS_LEN);
+    memcpy(m_pool[buf], p, m_poolLen[buf]);
+    seg[0].pEth = m_pool[buf];
+    seg[0].segLen = m_poolLen[buf];
+    if (TC6_SendRawEthernetSegments(m_tc6[m_portB], seg, 1u, m_poolLen[buf], 0u, OnPoolTxDone, (void *)(uintptr_t)(buf + 1u))) {
+        m_forwarded++;
+    } else {
+        FreeBuffer(buf);
+        m_fwdDrops++;
+    }
+}
+
+static void CheckFrame(const uint8_t *p, uint16_t len)
+{
+    uint8_t src = p[11];
+    uint32_t magic;
+    uint32_t seq;
+    uint64_t stamp;
+    bool valid;
+
+    memcpy(&magic, &p[BRIDGE_HEADER_LEN], sizeof(magic));
+    memcpy(&seq, &p[BRIDGE_HEADER_LEN + 4u], sizeof(seq));
+    memcpy(&stamp, &p[BRIDGE_HEADER_LEN + 8u], sizeof(stamp));
+    valid = (BRIDGE_MAGIC == magic) && (len == (BRIDGE_HEADER_LEN + m_payload + BRIDGE_FCS_LEN))
+            && ((src < m_sources) || (src == m_portB)) && (((uint32_t)((((uint16_t)p[12]) << 8) | p[13])) == BRIDGE_ETHERTYPE);
+    for (uint16_t i = BRIDGE_HEADER_LEN + BRIDGE_STAMP_LEN; valid && (i < (len - BRIDGE_FCS_LEN)); i++) {
+        valid = (p[i] == (uint8_t)(seq + src));
+    }
+    if (valid) {
+        uint32_t fcs = Crc32(p, (uint16_t)(len - BRIDGE_FCS_LEN));
+        const uint8_t *f = &p[len - BRIDGE_FCS_LEN];
+        valid = (fcs == ((uint32_t)f[0] | ((uint32_t)f[1] << 8) | ((uint32_t)f[2] << 16) | ((uint32_t)f[3] << 24)));
+    }
+    m_sink.received++;
+    if (!valid) {
+        m_sink.corrupt++;
+    } else if (seq < m_nextSeq[src]) {
+        /* Every sender numbers its frames, gaps are lost frames, anything older is duplicated or reordered */
+        m_sink.duplicates++;
+    } else {
+        uint8_t local = (src == m_portB) ? 1u : 0u;
+        m_nextSeq[src] = seq + 1u;
+        if (m_sink.latencyCount[local] < BRIDGE_MAX_FRAMES) {
+            m_sink.latency[local][m_sink.latencyCount[local]++] = (uint32_t)((Now() - stamp) / 10u);
+        }
+    }
+}
+
+static uint32_t Aborts(void)
+{
+    uint32_t aborts = 0u;
+    for (uint8_t i = 0u; i <= m_sinkIdx; i++) {
+        TC6Sim_NodeStats_t stats;
+        TC6Sim_GetNodeStats(GetNode(i), &stats);
+        aborts += stats.txAborts;
+    }
+    return aborts;
+}
+
+static uint32_t Overruns(void)
+{
+    uint32_t overruns = 0u;
+    for (uint8_t i = 0u; i <= m_sinkIdx; i++) {
+        TC6Sim_NodeStats_t stats;
+        TC6Sim_GetNodeStats(GetNode(i), &stats);
+        overruns += stats.rxDrops + stats.txDrops;
+    }
+    return overruns;
+}
+
+static uint32_t Crc32(const uint8_t *pData, uint16_t len)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    for (uint16_t i = 0u; i < len; i++) {
+        crc ^= pData[i];
+        for (uint8_t b = 0u; b < 8u; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+static int CompareLatency(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t CpuTimeUs(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000u) + ((uint64_t)ts.tv_nsec / 1000u);
+}
@@ -0,0 +1,618 @@
+/*******************************************************************************
+  Host Profiling Driver for libtc6
+
+  File Name:
+    tc6-host.c
+
+  Summary:
+    Runs the libtc6 RX and TX paths natively against the MACPHY emulator
+
+  Description:
+    Builds a 10BASE-T1S segment out of emulated LAN865x (see sim/tc6sim.h),
+    initializes every node with TC6Regs_Init() and streams raw Ethernet
+    frames from all nodes except the last one, which acts as sink. Frames
+    are handed over as segments and received as slices, the same way the
+    ESP32 glue does it, so perf, valgrind, sanitizers and gprof see the
+    real library hot paths. Prints one CSV line per payload size in the
+    format of the on-device benchmark (prefix "BENCH"), latencies are in
+    emulated segment time, plus one line with the host CPU time (prefix
+    "HOST"). The register initialization is measured first: SPI
+    transactions (round trips) and bytes per node, emulated and host CPU
+    time until every node is done (prefix "INIT"). The sink checks every frame: length, sender, sequence number
+    (each one exactly once and in order per sender) and payload content.
+    The result is printed per payload size (prefix "CHECK"), the exit code
+    is 2 if any frame got lost or corrupted. Frames the emulated segment
+    gave up after too many collisions are not counted as lost. The SPI
+    transactions of all nodes are counted per payload size as well, per
+    second of segment time and per second of host CPU time, the latter is
+    the transaction rate libtc6 and the emulated SPI backend sustain
+    (prefix "SPI"). With -a the
+    SPI transactions complete deferred (see TC6Sim_PortSetDeferred()), so
+    SPI_FULL_BUFFERS > 1 overlaps RX processing with the next transaction.
+    With -t and TC6_PROBES every payload size is traced: the
+    stage latencies are printed (prefix "TRACE", see trace/tc6trace.h) and
+    the trace of the last payload size is written as Chrome trace JSON.
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "tc6.h"
+#include "tc6-regs.h"
+#include "tc6sim.h"
+#if (0u != TC6_PROBES)
+#include "tc6trace.h"
+#endif
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                            DEFINITIONS                               */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+#define HOST_ETHERTYPE          (0x88B5u)
+#define HOST_MAGIC              (0x42454E43u)
+#define HOST_HEADER_LEN         (14u)
+#define HOST_FCS_LEN            (4u)
+#define HOST_STAMP_LEN          (16u)
+#define HOST_MAX_FRAME          (1514u)
+#define HOST_MAX_FRAMES         (100000u)
+#define HOST_RUN_STEP_BITS      (100u)          /* Segment time between two service calls */
+#define HOST_DRAIN_BITS         (1000000u)      /* Wait for outstanding frames after the last one was sent (100 ms) */
+#define HOST_BITS_PER_MS        (10000u)
+
+typedef struct
+{
+    uint32_t duplicates;        /** Sequence numbers received more than once */
+    uint32_t reordered;         /** Frames received after a later frame of the same sender */
+    uint32_t corrupt;           /** Frames with wrong length, sender or content */
+} HostCheck_t;
+
+typedef struct
+{
+    uint8_t rxBuf[TC6SIM_MAX_FRAME_LEN];
+    uint32_t received;
+    uint32_t rxErrors;
+    uint32_t sent;
+    uint32_t sendErrors;
+    uint8_t txHead;             /* Next TX buffer, buffers are released in order by OnTxDone */
+    uint8_t txInFlight;
+} HostNode_t;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                          PRIVATE VARIABLES                           */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static TC6Sim_Bus_t m_bus;
+static TC6_t *m_tc6[TC6_MAX_INSTANCES];
+static HostNode_t m_node[TC6_MAX_INSTANCES];
+static uint8_t m_txFrame[TC6_MAX_INSTANCES][TC6_TX_ETH_QSIZE][HOST_MAX_FRAME];
+static uint32_t m_latency[HOST_MAX_FRAMES];
+static uint32_t m_latencyCount;
+static uint8_t m_seen[HOST_MAX_FRAMES / 8u];
+static uint32_t m_nextSeq[TC6_MAX_INSTANCES];     /* Lowest sequence number the sink accepts from each sender */
+static HostCheck_t m_check;
+static uint16_t m_payload;
+static uint32_t m_frames;
+static uint8_t m_nodeCount = 3u;
+static uint8_t m_sink;
+static const char *m_traceFile;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                      PRIVATE FUNCTION PROTOTYPES                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint64_t Now(void);
+static void ServiceAll(void);
+static void RunSegment(uint32_t bitTimes);
+static bool SendFrame(uint8_t idx, uint16_t payload, uint32_t seq);
+static void OnTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag);
+static void CheckFrame(const uint8_t *p, uint16_t len);
+static uint32_t SenderAborts(void);
+static uint32_t SpiTransactions(uint32_t *pBytes);
+static uint32_t Crc32(const uint8_t *pData, uint16_t len);
+static int CompareLatency(const void *a, const void *b);
+static uint64_t CpuTimeUs(void);
+static void TraceStart(void);
+static void TraceStop(bool last);
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                             MAIN                                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+int main(int argc, char *argv[])
+{
+    static const uint16_t defaultPayloads[] = { 64u, 128u, 256u, 512u, 1024u, 1500u };
+    uint16_t payloads[16];
+    uint8_t payloadCount = 0u;
+    uint32_t frames = 1000u;
+    bool plca = false;
+    bool deferred = false;
+    bool success = true;
+    bool checked = true;
+    TC6Sim_BusConfig_t cfg = { .toTimerBits = 32u, .beaconBits = 20u, .spiClockHz = 0u, .seed = 1u };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:f:s:c:r:t:aph")) != -1) {
+        switch (opt) {
+            case 'n':
+                m_nodeCount = (uint8_t)atoi(optarg);
+                break;
+            case 'f':
+                frames = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                if (payloadCount < (sizeof(payloads) / sizeof(payloads[0]))) {
+                    payloads[payloadCount++] = (uint16_t)atoi(optarg);
+                }
+                break;
+            case 'c':
+                cfg.spiClockHz = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'r':
+                cfg.seed = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'p':
+                plca = true;
+                break;
+            case 'a':
+                deferred = true;
+                break;
+            case 't':
+                m_traceFile = optarg;
+                break;
+            default:
+                printf("usage: %s [-n nodes] [-f frames] [-s payload]... [-c spi clock Hz, 0: no SPI time] [-r seed] [-p (PLCA)] [-a (deferred SPI completion)] [-t trace.json]\n", argv[0]);
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+    if ((m_nodeCount < 2u) || (m_nodeCount > TC6_MAX_INSTANCES) || (m_nodeCount > TC6SIM_MAX_NODES)) {
+        printf("node count must be 2..%u (TC6_MAX_INSTANCES)\n", (unsigned)TC6_MAX_INSTANCES);
+        return 1;
+    }
+    if ((frames == 0u) || (frames > HOST_MAX_FRAMES)) {
+        printf("frame count must be 1..%u\n", (unsigned)HOST_MAX_FRAMES);
+        return 1;
+    }
+#if (0u == TC6_PROBES)
+    if (NULL != m_traceFile) {
+        printf("tracing needs TC6_PROBES (cmake -DTC6_HOST_PROBES=ON)\n");
+        return 1;
+    }
+#endif
+    if (0u == payloadCount) {
+        memcpy(payloads, defaultPayloads, sizeof(defaultPayloads));
+        payloadCount = (uint8_t)(sizeof(defaultPayloads) / sizeof(defaultPayloads[0]));
+    }
+    m_sink = (uint8_t)(m_nodeCount - 1u);
+
+    TC6Sim_BusInit(&m_bus, &cfg);
+    TC6Sim_PortAttach(&m_bus);
+    for (uint8_t i = 0u; success && (i < m_nodeCount); i++) {
+        uint8_t mac[6] = { 0x00u, 0x04u, 0xA3u, 0x12u, 0x00u, i };
+
+        (void)TC6Sim_AddNode(&m_bus, i);
+        m_tc6[i] = TC6_Init(&m_node[i]);
+        success = (NULL != m_tc6[i]);
+        if (success) {
+            success = TC6Regs_Init(m_tc6[i], &m_node[i], mac, plca, i, m_nodeCount, 0u, 0x80u, false, false, false);
+        }
+    }
+    /* Register initialization, measured until every node is done (at most 100 ms) */
+    if (success) {
+        uint64_t cpuStart = CpuTimeUs();
+        uint64_t start = Now();
+        bool done = false;
+        uint32_t spiTransactions;
+        uint32_t spiBytes;
+
+        while (!done && ((Now() - start) < (100u * HOST_BITS_PER_MS))) {
+            RunSegment(HOST_RUN_STEP_BITS);
+            done = true;
+            for (uint8_t i = 0u; i < m_nodeCount; i++) {
+                done = done && TC6Regs_GetInitDone(m_tc6[i]);
+            }
+        }
+        spiTransactions = SpiTransactions(&spiBytes);
+        printf("INIT,nodes,spi_transactions_per_node,spi_bytes_per_node,duration_us,cpu_us\n");
+        printf("INIT,%u,%u,%u,%llu,%llu\n", m_nodeCount, spiTransactions / m_nodeCount, spiBytes / m_nodeCount,
+               (unsigned long long)((Now() - start) / 10u), (unsigned long long)(CpuTimeUs() - cpuStart));
+        success = done;
+    }
+    if (!success) {
+        printf("initialization failed\n");
+        return 1;
+    }
+    /* TC6_Reset() waits for a running transaction, so the initialization completes them synchronously */
+    TC6Sim_PortSetDeferred(deferred);
+    for (uint8_t i = 0u; i < m_nodeCount; i++) {
+        TC6_EnableData(m_tc6[i], true);
+    }
+
+    printf("CHECK,payload,spi_buffers,deferred,sent,received,aborted,missing,misordered,corrupt,result\n");
+    printf("BENCH,mode,payload,nodes,plca,duty,sent,errors,received,duration_us,fps,goodput_kbps,p50_us,p90_us,p99_us,max_us\n");
+    printf("SPI,payload,spi_buffers,deferred,transactions,bytes,per_segment_s,per_cpu_s,cpu_ns_per_transaction\n");
+    for (uint8_t step = 0u; step < payloadCount; step++) {
+        uint16_t payload = payloads[step];
+        uint32_t sent = 0u;
+        uint32_t errors = 0u;
+        uint32_t seq = 0u;
+        uint64_t cpuStart = CpuTimeUs();
+        uint64_t start = Now();
+        uint64_t lastRx;
+        uint32_t aborts = SenderAborts();
+        uint32_t spiBytes;
+        uint32_t spiTransactions = SpiTransactions(&spiBytes);
+        uint32_t spiBytesStart = spiBytes;
+        uint32_t missing;
+
+        if (payload < HOST_STAMP_LEN) {
+            payload = HOST_STAMP_LEN;
+        }
+        if (payload > (HOST_MAX_FRAME - HOST_HEADER_LEN)) {
+            payload = HOST_MAX_FRAME - HOST_HEADER_LEN;
+        }
+        for (uint8_t i = 0u; i < m_nodeCount; i++) {
+            m_node[i].received = 0u;
+            m_node[i].rxErrors = 0u;
+            m_node[i].sent = 0u;
+            m_node[i].sendErrors = 0u;
+        }
+        m_latencyCount = 0u;
+        m_payload = payload;
+        m_frames = frames;
+        memset(m_seen, 0, sizeof(m_seen));
+        memset(m_nextSeq, 0, sizeof(m_nextSeq));
+        memset(&m_check, 0, sizeof(m_check));
+        TraceStart();
+
+        /* Every sender fills its TX queue, the frames per step are shared by all senders */
+        while (seq < frames) {
+            for (uint8_t i = 0u; (i < m_sink) && (seq < frames); i++) {
+                if (SendFrame(i, payload, seq)) {
+                    seq++;
+                }
+            }
+            RunSegment(HOST_RUN_STEP_BITS);
+        }
+        for (uint8_t i = 0u; i < m_sink; i++) {
+            sent += m_node[i].sent;
+            errors += m_node[i].sendErrors;
+        }
+        lastRx = Now();
+        for (uint32_t waited = 0u; ((m_node[m_sink].received + (SenderAborts() - aborts)) < sent) && (waited < HOST_DRAIN_BITS); waited += HOST_RUN_STEP_BITS) {
+            RunSegment(HOST_RUN_STEP_BITS);
+            lastRx = Now();
+        }
+
+        uint32_t received = m_latencyCount;
+        aborts = SenderAborts() - aborts;
+        missing = ((received + aborts) < sent) ? (sent - received - aborts) : 0u;
+        uint64_t durationUs = (lastRx - start) / 10u;
+        uint64_t cpuUs = CpuTimeUs() - cpuStart;
+        spiTransactions = SpiTransactions(&spiBytes) - spiTransactions;
+        spiBytes -= spiBytesStart;
+        TraceStop((step + 1u) == payloadCount);
+
+        qsort(m_latency, received, sizeof(m_latency[0]), CompareLatency);
+        printf("BENCH,0,%u,%u,%u,100,%u,%u,%u,%llu,%llu,%llu,%u,%u,%u,%u\n",
+               payload, m_nodeCount, plca ? 1u : 0u, sent, errors, received,
+               (unsigned long long)durationUs,
+               (unsigned long long)(durationUs ? ((uint64_t)received * 1000000u / durationUs) : 0u),
+               (unsigned long long)(durationUs ? ((uint64_t)received * payload * 8u * 1000u / durationUs) : 0u),
+               received ? m_latency[(received - 1u) * 50u / 100u] : 0u,
+               received ? m_latency[(received - 1u) * 90u / 100u] : 0u,
+               received ? m_latency[(received - 1u) * 99u / 100u] : 0u,
+               received ? m_latency[received - 1u] : 0u);
+        printf("HOST,%u,%u,%llu,%llu\n", payload, sent, (unsigned long long)cpuUs,
+               (unsigned long long)(sent ? (cpuUs * 1000u / sent) : 0u));
+        printf("SPI,%u,%u,%u,%u,%u,%llu,%llu,%llu\n", payload, (unsigned)SPI_FULL_BUFFERS, deferred ? 1u : 0u,
+               spiTransactions, spiBytes,
+               (unsigned long long)(durationUs ? ((uint64_t)spiTransactions * 1000000u / durationUs) : 0u),
+               (unsigned long long)(cpuUs ? ((uint64_t)spiTransactions * 1000000u / cpuUs) : 0u),
+               (unsigned long long)(spiTransactions ? (cpuUs * 1000u / spiTransactions) : 0u));
+        if ((0u != missing) || (0u != m_check.duplicates) || (0u != m_check.reordered) || (0u != m_check.corrupt)) {
+            checked = false;
+        }
+        printf("CHECK,%u,%u,%u,%u,%u,%u,%u,%u,%u,%s\n", payload, (unsigned)SPI_FULL_BUFFERS, deferred ? 1u : 0u,
+               sent, received, aborts, missing, m_check.duplicates + m_check.reordered, m_check.corrupt,
+               checked ? "ok" : "FAIL");
+#if (0u != TC6_PROBES)
+        if (NULL != m_traceFile) {
+            TC6Trace_PrintStats(stdout);
+        }
+#endif
+    }
+
+    TC6Sim_BusStats_t bus;
+    TC6Sim_GetBusStats(&m_bus, &bus);
+    printf("HOST,segment,%llu,%llu,%u,%u\n", (unsigned long long)bus.now, (unsigned long long)bus.busyBits, bus.cycles, bus.collisions);
+    return checked ? 0 : 2;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  CALLBACK FUNCTIONS FROM TC6 STACK                   */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+void TC6_CB_OnNeedService(TC6_t *pInst, void *pGlobalTag)
+{
+    /* Every node is serviced after each segment step anyway */
+    (void)pInst;
+    (void)pGlobalTag;
+}
+
+void TC6_CB_OnRxEthernetSlice(TC6_t *pInst, const uint8_t *pRx, uint16_t offset, uint16_t len, void *pGlobalTag)
+{
+    HostNode_t *node = (HostNode_t *)pGlobalTag;
+    (void)pInst;
+    if (((uint32_t)offset + len) <= sizeof(node->rxBuf)) {
+        memcpy(&node->rxBuf[offset], pRx, len);
+    }
+}
+
+void TC6_CB_OnRxEthernetPacket(TC6_t *pInst, bool success, uint16_t len, uint64_t *rxTimestamp, void *pGlobalTag)
+{
+    HostNode_t *node = (HostNode_t *)pGlobalTag;
+    const uint8_t *p = node->rxBuf;
+    uint32_t magic;
+    uint64_t stamp;
+    (void)rxTimestamp;
+
+    if (!success || (len < (HOST_HEADER_LEN + HOST_STAMP_LEN)) || (len > sizeof(node->rxBuf))) {
+        node->rxErrors++;
+    } else if ((((uint16_t)p[12] << 8) | p[13]) == HOST_ETHERTYPE) {
+        memcpy(&magic, &p[HOST_HEADER_LEN], sizeof(magic));
+        memcpy(&stamp, &p[HOST_HEADER_LEN + 8u], sizeof(stamp));
+        if (HOST_MAGIC == magic) {
+            node->received++;
+            if (TC6_GetInstance(pInst) == m_sink) {
+                CheckFrame(p, len);
+                if (m_latencyCount < HOST_MAX_FRAMES) {
+                    m_latency[m_latencyCount++] = (uint32_t)((Now() - stamp) / 10u);
+                }
+            }
+        }
+    }
+}
+
+void TC6_CB_OnError(TC6_t *pInst, TC6_Error_t err, void *pGlobalTag)
+{
+    (void)pGlobalTag;
+    printf("node %u: error %d\n", TC6_GetInstance(pInst), (int)err);
+}
+
+uint32_t TC6Regs_CB_GetTicksMs(void)
+{
+    return (uint32_t)(Now() / HOST_BITS_PER_MS);
+}
+
+void TC6Regs_CB_OnEvent(TC6_t *pInst, TC6Regs_Event_t event, void *pTag)
+{
+    (void)pInst;
+    (void)event;
+    (void)pTag;
+}
+
+#if (0u != TC6_PROBES)
+void TC6_CB_OnProbe(uint8_t tc6instance, TC6_Probe_t probe, void *pGlobalTag)
+{
+    (void)pGlobalTag;
+    TC6Trace_Record(tc6instance, (uint8_t)probe);
+}
+
+uint32_t TC6Trace_CB_GetCycles(void)
+{
+    /* Nanoseconds, TC6Trace_Init() gets 1000 cycles per microsecond */
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec);
+}
+
+uint8_t TC6Trace_CB_GetCore(void)
+{
+    return 0u;
+}
+#endif
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  PRIVATE FUNCTION IMPLEMENTATIONS                    */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint64_t Now(void)
+{
+    TC6Sim_BusStats_t bus;
+    TC6Sim_GetBusStats(&m_bus, &bus);
+    return bus.now;
+}
+
+static void ServiceAll(void)
+{
+    for (uint8_t i = 0u; i < m_nodeCount; i++) {
+        bool irq = TC6Sim_IrqAsserted(TC6Sim_GetNode(&m_bus, i));
+#if (0u != TC6_PROBES)
+        if (irq) {
+            TC6Trace_Record(i, TC6TracePoint_Irq);
+        }
+#endif
+        TC6_Service(m_tc6[i], !irq);
+    }
+}
+
+static void RunSegment(uint32_t bitTimes)
+{
+    uint32_t before = TC6Regs_CB_GetTicksMs();
+    ServiceAll();
+    TC6Sim_BusRun(&m_bus, bitTimes);
+    /* Deferred transactions finish while the segment runs, the next ServiceAll() processes them */
+    TC6Sim_PortComplete();
+    if (TC6Regs_CB_GetTicksMs() != before) {
+        TC6Regs_CheckTimers();
+    }
+}
+
+static bool SendFrame(uint8_t idx, uint16_t payload, uint32_t seq)
+{
+    TC6_RawTxSegment *seg;
+    HostNode_t *node = &m_node[idx];
+    uint8_t *frame = m_txFrame[idx][node->txHead];
+    uint32_t magic = HOST_MAGIC;
+    uint64_t stamp = Now();
+    bool success = false;
+
+    /* A frame stays in use until OnTxDone, every queue entry has its own buffer */
+    if ((node->txInFlight < TC6_TX_ETH_QSIZE) && (TC6_GetRawSegments(m_tc6[idx], &seg) > 0u)) {
+        memset(frame, 0xFF, 6u);
+        frame[6] = 0x00u; frame[7] = 0x04u; frame[8] = 0xA3u; frame[9] = 0x12u; frame[10] = 0x00u; frame[11] = idx;
+        frame[12] = (uint8_t)(HOST_ETHERTYPE >> 8);
+        frame[13] = (uint8_t)HOST_ETHERTYPE;
+        memcpy(&frame[HOST_HEADER_LEN], &magic, sizeof(magic));
+        memcpy(&frame[HOST_HEADER_LEN + 4u], &seq, sizeof(seq));
+        memcpy(&frame[HOST_HEADER_LEN + 8u], &stamp, sizeof(stamp));
+        memset(&frame[HOST_HEADER_LEN + HOST_STAMP_LEN], (uint8_t)seq, payload - HOST_STAMP_LEN);
+
+        /* Header and payload as two segments, like an lwIP pbuf chain */
+        seg[0].pEth = frame;
+        seg[0].segLen = HOST_HEADER_LEN;
+        seg[1].pEth = &frame[HOST_HEADER_LEN];
+        seg[1].segLen = payload;
+        success = TC6_SendRawEthernetSegments(m_tc6[idx], seg, 2u, (uint16_t)(HOST_HEADER_LEN + payload), 0u, OnTxDone, node);
+        if (success) {
+            node->txHead = (uint8_t)((node->txHead + 1u) % TC6_TX_ETH_QSIZE);
+            node->txInFlight++;
+            node->sent++;
+        } else {
+            node->sendErrors++;
+        }
+    }
+    return success;
+}
+
+static void OnTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag)
+{
+    HostNode_t *node = (HostNode_t *)pTag;
+    (void)pInst;
+    (void)pTx;
+    (void)len;
+    (void)pGlobalTag;
+    if (node->txInFlight > 0u) {
+        node->txInFlight--;
+    }
+}
+
+static void CheckFrame(const uint8_t *p, uint16_t len)
+{
+    uint8_t src = p[11];
+    uint32_t seq;
+    bool valid;
+
+    memcpy(&seq, &p[HOST_HEADER_LEN + 4u], sizeof(seq));
+    valid = (len == (HOST_HEADER_LEN + m_payload + HOST_FCS_LEN)) && (src < m_sink) && (seq < m_frames);
+    for (uint16_t i = HOST_HEADER_LEN + HOST_STAMP_LEN; valid && (i < (len - HOST_FCS_LEN)); i++) {
+        valid = (p[i] == (uint8_t)seq);
+    }
+    if (valid) {
+        /* The MACPHY passes the FCS on, it covers the header and the stamp as well */
+        uint32_t fcs = Crc32(p, (uint16_t)(len - HOST_FCS_LEN));
+        const uint8_t *f = &p[len - HOST_FCS_LEN];
+        valid = (fcs == ((uint32_t)f[0] | ((uint32_t)f[1] << 8) | ((uint32_t)f[2] << 16) | ((uint32_t)f[3] << 24)));
+    }
+    if (!valid) {
+        m_check.corrupt++;
+    } else if (0u != (m_seen[seq / 8u] & (1u << (seq % 8u)))) {
+        m_check.duplicates++;
+    } else {
+        m_seen[seq / 8u] |= (uint8_t)(1u << (seq % 8u));
+        /* Sequence numbers are shared by all senders, each sender uses an increasing subset */
+        if (seq < m_nextSeq[src]) {
+            m_check.reordered++;
+        } else {
+            m_nextSeq[src] = seq + 1u;
+        }
+    }
+}
+
+static uint32_t SenderAborts(void)
+{
+    uint32_t aborts = 0u;
+    for (uint8_t i = 0u; i < m_sink; i++) {
+        TC6Sim_NodeStats_t stats;
+        TC6Sim_GetNodeStats(TC6Sim_GetNode(&m_bus, i), &stats);
+        aborts += stats.txAborts;
+    }
+    return aborts;
+}
+
+static uint32_t SpiTransactions(uint32_t *pBytes)
+{
+    uint32_t transactions = 0u;
+    *pBytes = 0u;
+    for (uint8_t i = 0u; i < m_nodeCount; i++) {
+        TC6Sim_NodeStats_t stats;
+        TC6Sim_GetNodeStats(TC6Sim_GetNode(&m_bus, i), &stats);
+        transactions += stats.spiTransactions;
+        *pBytes += stats.spiBytes;
+    }
+    return transactions;
+}
+
+static uint32_t Crc32(const uint8_t *pData, uint16_t len)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    for (uint16_t i = 0u; i < len; i++) {
+        crc ^= pData[i];
+        for (uint8_t b = 0u; b < 8u; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+static int CompareLatency(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t CpuTimeUs(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000u) + ((uint64_t)ts.tv_nsec / 1000u);
+}
+
+static void TraceStart(void)
+{
+#if (0u != TC6_PROBES)
+    static bool initialized = false;
+    if (NULL != m_traceFile) {
+        if (!initialized) {
+            TC6Trace_Init(1000u);
+            initialized = true;
+        }
+        TC6Trace_Start();
+    }
+#endif
+}
+
+static void TraceStop(bool last)
+{
+#if (0u != TC6_PROBES)
+    if (NULL != m_traceFile) {
+        TC6Trace_Stop();
+        if (last) {
+            FILE *f = fopen(m_traceFile, "w");
+            if (NULL != f) {
+                TC6Trace_WriteJson(f);
+                (void)fclose(f);
+            } else {
+                printf("cannot write %s\n", m_traceFile);
+            }
+        }
+    }
+#else
+    (void)last;
+#endif
+}
@@ -0,0 +1,497 @@
+/*******************************************************************************
+  Host Interrupt Service Check for libtc6
+
+  File Name:
+    tc6-irq.c
+
+  Summary:
+    Runs the wake up logic of SyncTask against an emulated MACPHY
+
+  Description:
+    Node 0 of an emulated 10BASE-T1S segment (see sim/tc6sim.h) receives
+    the frames of all other nodes and is serviced like SyncTask on the
+    ESP32 (main/lan8651.c): it sleeps until a falling edge of IRQ_N, the
+    end of an SPI transaction (TC6_CB_OnNeedService()) or a timeout counted
+    in FreeRTOS ticks (10 ms). SPI transactions complete deferred, in the
+    next microsecond of segment time, like in the SPI interrupt. Every n-th
+    GPIO interrupt can be dropped (-l) to emulate an interrupt lost before
+    it notified the task. Two policies are compared:
+    - "edge": the interrupt fires on the falling edge of IRQ_N, the return
+      value of TC6_Service() is ignored and SyncTask sleeps
+      SERVICE_TIMEOUT_MS after every loop (the former SyncTask)
+    - "level": the interrupt fires while IRQ_N is low and masks itself,
+      SyncTask unmasks it after TC6_Service() took the work, so an IRQ_N
+      which is still asserted fires again at once, and sleeps one tick at
+      most while TC6_Service() returns false (the current SyncTask)
+    Prints the receive latency, the wake ups and service calls per second
+    (the CPU cost while idle and loaded) and the interrupts found asserted
+    by a timeout instead of the GPIO interrupt (prefix "IRQ"), and checks that every
+    frame arrived once and intact or, with the edge interrupt only, was
+    lost in a full MACPHY buffer (prefix "CHECK", exit code 2 on a failure).
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tc6.h"
+#include "tc6-regs.h"
+#include "tc6sim.h"
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                            DEFINITIONS                               */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+#define IRQ_MAGIC               (0x49525121u)
+#define IRQ_HEADER_LEN          (14u)
+#define IRQ_STAMP_LEN           (16u)
+#define IRQ_FCS_LEN             (4u)
+#define IRQ_MAX_FRAME           (1514u)
+#define IRQ_MAX_FRAMES          (100000u)
+#define IRQ_STEP_BITS           (10u)           /* 1 us */
+#define IRQ_BITS_PER_US         (10u)
+#define IRQ_TICK_BITS           (100000u)       /* CONFIG_FREERTOS_HZ 100 */
+#define IRQ_SERVICE_TIMEOUT     (5u)            /* SERVICE_TIMEOUT_MS 50 in ticks */
+#define IRQ_PENDING_TIMEOUT     (1u)            /* SERVICE_PENDING_TICKS */
+#define IRQ_DRAIN_BITS          (2000000u)
+
+typedef enum
+{
+    Policy_Edge,
+    Policy_Level
+} Policy_t;
+
+typedef struct
+{
+    uint8_t rxBuf[TC6SIM_MAX_FRAME_LEN];
+    uint8_t txFrame[TC6_TX_ETH_QSIZE][IRQ_MAX_FRAME];
+    uint8_t txHead;
+    uint8_t txInFlight;
+    uint32_t sent;
+} Node_t;
+
+typedef struct
+{
+    bool notified;              /** Task notification pending (ulTaskNotifyTake() returns at once) */
+    uint64_t wakeAt;            /** End of the current ulTaskNotifyTake() timeout */
+    bool irqPrev;               /** IRQ_N asserted in the previous microsecond */
+    bool intrMasked;            /** Level interrupt masked by the handler until SyncTask unmasks it */
+    uint32_t interrupts;        /** GPIO interrupts, falling edges or unmasked low levels of IRQ_N */
+    uint32_t lostInterrupts;    /** Interrupts dropped on purpose (-l) */
+    uint32_t wakeups;           /** Loops of the task */
+    uint32_t services;          /** TC6_Service() calls */
+    uint32_t recovered;         /** Loops woken by the timeout which found IRQ_N asserted */
+} Task_t;
+
+typedef struct
+{
+    uint32_t received;
+    uint32_t misordered;
+    uint32_t corrupt;
+    uint32_t nextSeq[TC6_MAX_INSTANCES];
+    uint32_t latency[IRQ_MAX_FRAMES];
+    uint32_t latencyCount;
+} Receiver_t;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                          PRIVATE VARIABLES                           */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static TC6Sim_Bus_t m_bus;
+static TC6_t *m_tc6[TC6_MAX_INSTANCES];
+static Node_t m_node[TC6_MAX_INSTANCES];
+static Task_t m_task;
+static Receiver_t m_rx;
+static uint8_t m_nodeCount = 3u;
+static uint16_t m_payload = 256u;
+static uint32_t m_edgeLoss;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                      PRIVATE FUNCTION PROTOTYPES                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint64_t Now(void);
+static void Step(Policy_t policy);
+static void SyncTaskLoop(Policy_t policy);
+static uint64_t TickTimeout(uint32_t ticks);
+static bool IrqAsserted(uint8_t idx);
+static void SendFrame(uint8_t idx);
+static void OnTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag);
+static void CheckFrame(const uint8_t *p, uint16_t len);
+static uint32_t Lost(void);
+static uint32_t Crc32(const uint8_t *pData, uint16_t len);
+static int CompareLatency(const void *a, const void *b);
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                             MAIN                                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+int main(int argc, char *argv[])
+{
+    static const char *const policyNames[] = { "edge", "level" };
+    uint32_t durationMs = 500u;
+    uint32_t periodUs = 2000u;
+    bool plca = true;
+    bool success = true;
+    bool checked = true;
+    TC6Sim_BusConfig_t cfg = { .toTimerBits = 32u, .beaconBits = 20u, .spiClockHz = 0u, .seed = 1u };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:d:i:s:l:c:xh")) != -1) {
+        switch (opt) {
+            case 'n':
+                m_nodeCount = (uint8_t)atoi(optarg);
+                break;
+            case 'd':
+                durationMs = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'i':
+                periodUs = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                m_payload = (uint16_t)atoi(optarg);
+                break;
+            case 'l':
+                m_edgeLoss = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'c':
+                cfg.spiClockHz = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'x':
+                plca = false;
+                break;
+            default:
+                printf("usage: %s [-n nodes] [-d duration ms] [-i frame period us per sender, 0: idle] [-s payload] [-l drop every n-th GPIO interrupt] [-c spi clock Hz] [-x (CSMA/CD)]\n", argv[0]);
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+    if ((m_nodeCount < 2u) || (m_nodeCount > TC6_MAX_INSTANCES) || (m_payload < IRQ_STAMP_LEN) || (m_payload > (IRQ_MAX_FRAME - IRQ_HEADER_LEN))
+        || ((0u != periodUs) && (((uint64_t)durationMs * 1000u * (m_nodeCount - 1u) / periodUs) > IRQ_MAX_FRAMES))) {
+        printf("nodes must be 2..%u, payload %u..%u, at most %u frames\n", (unsigned)TC6_MAX_INSTANCES, IRQ_STAMP_LEN,
+               IRQ_MAX_FRAME - IRQ_HEADER_LEN, IRQ_MAX_FRAMES);
+        return 1;
+    }
+
+    TC6Sim_BusInit(&m_bus, &cfg);
+    TC6Sim_PortAttach(&m_bus);
+    for (uint8_t i = 0u; success && (i < m_nodeCount); i++) {
+        uint8_t mac[6] = { 0x00u, 0x04u, 0xA3u, 0x12u, 0x00u, i };
+        (void)TC6Sim_AddNode(&m_bus, i);
+        m_tc6[i] = TC6_Init(&m_node[i]);
+        success = (NULL != m_tc6[i]) && TC6Regs_Init(m_tc6[i], &m_node[i], mac, plca, i, m_nodeCount, 0u, 0x80u, false, false, false);
+    }
+    for (uint32_t k = 0u; success && (k < (100000u * IRQ_BITS_PER_US / IRQ_STEP_BITS)); k++) {
+        for (uint8_t i = 0u; i < m_nodeCount; i++) {
+            TC6_Service(m_tc6[i], !IrqAsserted(i));
+        }
+        uint32_t before = TC6Regs_CB_GetTicksMs();
+        TC6Sim_BusRun(&m_bus, IRQ_STEP_BITS);
+        if (TC6Regs_CB_GetTicksMs() != before) {
+            TC6Regs_CheckTimers();
+        }
+    }
+    for (uint8_t i = 0u; success && (i < m_nodeCount); i++) {
+        success = TC6Regs_GetInitDone(m_tc6[i]);
+    }
+    if (!success) {
+        printf("initialization failed\n");
+        return 1;
+    }
+    for (uint8_t i = 0u; i < m_nodeCount; i++) {
+        TC6_EnableData(m_tc6[i], true);
+    }
+    TC6Sim_PortSetDeferred(true);
+
+    printf("IRQ,policy,nodes,period_us,payload,edge_loss,sent,received,p50_us,p99_us,max_us,wakeups_per_s,services_per_s,interrupts,lost_interrupts,recovered\n");
+    printf("CHECK,policy,sent,received,overruns,misordered,corrupt,result\n");
+    for (uint8_t policy = Policy_Edge; policy <= Policy_Level; policy++) {
+        uint64_t start = Now();
+        uint64_t end = start + ((uint64_t)durationMs * 1000u * IRQ_BITS_PER_US);
+        uint64_t nextFrame = start;
+        uint32_t sent = 0u;
+        uint32_t lost = Lost();
+        uint32_t count;
+        uint32_t wakeups;
+        uint32_t services;
+        bool ok;
+
+        memset(&m_task, 0, sizeof(m_task));
+        memset(&m_rx, 0, sizeof(m_rx));
+        m_task.notified = true;
+        for (uint8_t i = 1u; i < m_nodeCount; i++) {
+            m_node[i].sent = 0u;
+        }
+        while (Now() < end) {
+            if ((0u != periodUs) && (Now() >= nextFrame)) {
+                for (uint8_t i = 1u; i < m_nodeCount; i++) {
+                    SendFrame(i);
+                }
+                nextFrame += (uint64_t)periodUs * IRQ_BITS_PER_US;
+            }
+            Step((Policy_t)policy);
+        }
+        for (uint8_t i = 1u; i < m_nodeCount; i++) {
+            sent += m_node[i].sent;
+        }
+        wakeups = m_task.wakeups;
+        services = m_task.services;
+        for (uint32_t waited = 0u; waited < IRQ_DRAIN_BITS; waited += IRQ_STEP_BITS) {
+            /* The next policy starts with the status of the MACPHY cleared */
+            if (((m_rx.received + m_rx.corrupt + (Lost() - lost)) >= sent) && !IrqAsserted(0u)) {
+                break;
+            }
+            Step((Policy_t)policy);
+        }
+
+        lost = Lost() - lost;
+        count = m_rx.latencyCount;
+        qsort(m_rx.latency, count, sizeof(uint32_t), CompareLatency);
+        printf("IRQ,%s,%u,%u,%u,%u,%u,%u,%u,%u,%u,%llu,%llu,%u,%u,%u\n", policyNames[policy], m_nodeCount, periodUs, m_payload, m_edgeLoss,
+               sent, m_rx.received, count ? m_rx.latency[(count - 1u) * 50u / 100u] : 0u, count ? m_rx.latency[(count - 1u) * 99u / 100u] : 0u,
+               count ? m_rx.latency[count - 1u] : 0u,
+               (unsigned long long)((uint64_t)wakeups * 1000u / (durationMs ? durationMs : 1u)),
+               (unsigned long long)((uint64_t)services * 1000u / (durationMs ? durationMs : 1u)),
+               m_task.interrupts, m_task.lostInterrupts, m_task.recovered);
+        /* With the level interrupt no frame may be lost because an interrupt went unnoticed */
+        ok = ((m_rx.received + lost) == sent) && (0u == m_rx.misordered) && (0u == m_rx.corrupt) && ((Policy_Edge == policy) || (0u == lost));
+        checked = checked && ok;
+        printf("CHECK,%s,%u,%u,%u,%u,%u,%s\n", policyNames[policy], sent, m_rx.received, lost, m_rx.misordered, m_rx.corrupt, ok ? "ok" : "FAIL");
+    }
+    return checked ? 0 : 2;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  CALLBACK FUNCTIONS FROM TC6 STACK                   */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+void TC6_CB_OnNeedService(TC6_t *pInst, void *pGlobalTag)
+{
+    (void)pGlobalTag;
+    /* NotifySyncTask(), the senders are serviced every microsecond anyway */
+    if (0u == TC6_GetInstance(pInst)) {
+        m_task.notified = true;
+    }
+}
+
+void TC6_CB_OnRxEthernetSlice(TC6_t *pInst, const uint8_t *pRx, uint16_t offset, uint16_t len, void *pGlobalTag)
+{
+    Node_t *node = (Node_t *)pGlobalTag;
+    (void)pInst;
+    if (((uint32_t)offset + len) <= sizeof(node->rxBuf)) {
+        memcpy(&node->rxBuf[offset], pRx, len);
+    }
+}
+
+void TC6_CB_OnRxEthernetPacket(TC6_t *pInst, bool success, uint16_t len, uint64_t *rxTimestamp, void *pGlobalTag)
+{
+    Node_t *node = (Node_t *)pGlobalTag;
+    (void)rxTimestamp;
+    if (success && (0u == TC6_GetInstance(pInst)) && (len >= (IRQ_HEADER_LEN + IRQ_STAMP_LEN + IRQ_FCS_LEN)) && (len <= sizeof(node->rxBuf))) {
+        CheckFrame(node->rxBuf, len);
+    }
+}
+
+void TC6_CB_OnError(TC6_t *pInst, TC6_Error_t err, void *pGlobalTag)
+{
+    (void)pGlobalTag;
+    printf("node %u: error %d\n", TC6_GetInstance(pInst), (int)err);
+}
+
+uint32_t TC6Regs_CB_GetTicksMs(void)
+{
+    /* Starts at 1 ms, tc6-regs.c takes an extended status locked at 0 ms for no lock and never unlocks it */
+    return (uint32_t)(Now() / (1000u * IRQ_BITS_PER_US)) + 1u;
+}
+
+void TC6Regs_CB_OnEvent(TC6_t *pInst, TC6Regs_Event_t event, void *pTag)
+{
+    (void)pInst;
+    (void)event;
+    (void)pTag;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  PRIVATE FUNCTION IMPLEMENTATIONS                    */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint64_t Now(void)
+{
+    TC6Sim_BusStats_t bus;
+    TC6Sim_GetBusStats(&m_bus, &bus);
+    return bus.now;
+}
+
+static void Step(Policy_t policy)
+{
+    uint32_t before;
+    bool irq;
+
+    /* The SPI interrupt of the previous microsecond, then the GPIO interrupt */
+    TC6Sim_PortComplete();
+    irq = IrqAsserted(0u);
+    if (irq && ((Policy_Edge == policy) ? !m_task.irqPrev : !m_task.intrMasked)) {
+        m_task.interrupts++;
+        if ((0u != m_edgeLoss) && (0u == (m_task.interrupts % m_edgeLoss))) {
+            /* A lost level interrupt fires again in the next microsecond, a lost edge does not */
+            m_task.lostInterrupts++;
+        } else {
+            m_task.intrMasked = true;
+            m_task.notified = true;
+        }
+    }
+    m_task.irqPrev = irq;
+
+    if (m_task.notified || (Now() >= m_task.wakeAt)) {
+        SyncTaskLoop(policy);
+    }
+    for (uint8_t i = 1u; i < m_nodeCount; i++) {
+        TC6_Service(m_tc6[i], !IrqAsserted(i));
+    }
+    before = TC6Regs_CB_GetTicksMs();
+    TC6Sim_BusRun(&m_bus, IRQ_STEP_BITS);
+    if (TC6Regs_CB_GetTicksMs() != before) {
+        TC6Regs_CheckTimers();
+    }
+}
+
+static void SyncTaskLoop(Policy_t policy)
+{
+    bool irq = IrqAsserted(0u);
+    bool serviced;
+
+    m_task.wakeups++;
+    if (irq && !m_task.notified) {
+        m_task.recovered++;
+    }
+    /* ulTaskNotifyTake() returned, it clears the notification */
+    m_task.notified = false;
+    m_task.services++;
+    serviced = TC6_Service(m_tc6[0], !irq);
+    if (Policy_Edge == policy) {
+        m_task.wakeAt = TickTimeout(IRQ_SERVICE_TIMEOUT);
+    } else {
+        /* While the SPI transaction is busy its end notifies the task, the interrupt stays masked until then */
+        if (serviced) {
+            m_task.intrMasked = false;
+        }
+        m_task.wakeAt = TickTimeout(serviced ? IRQ_SERVICE_TIMEOUT : IRQ_PENDING_TIMEOUT);
+    }
+}
+
+static uint64_t TickTimeout(uint32_t ticks)
+{
+    /* The timeout ends with the tick interrupt, not a whole tick after the call */
+    return ((Now() / IRQ_TICK_BITS) + ticks) * IRQ_TICK_BITS;
+}
+
+static bool IrqAsserted(uint8_t idx)
+{
+    return TC6Sim_IrqAsserted(TC6Sim_GetNode(&m_bus, idx));
+}
+
+static void SendFrame(uint8_t idx)
+{
+    TC6_RawTxSegment *seg;
+    Node_t *node = &m_node[idx];
+    uint8_t *frame = node->txFrame[node->txHead];
+    uint32_t magic = IRQ_MAGIC;
+    uint32_t seq = node->sent;
+    uint64_t stamp = Now();
+
+    if ((node->txInFlight >= TC6_TX_ETH_QSIZE) || (TC6_GetRawSegments(m_tc6[idx], &seg) == 0u)) {
+        return;
+    }
+    frame[0] = 0x00u; frame[1] = 0x04u; frame[2] = 0xA3u; frame[3] = 0x12u; frame[4] = 0x00u; frame[5] = 0x00u;
+    frame[6] = 0x00u; frame[7] = 0x04u; frame[8] = 0xA3u; frame[9] = 0x12u; frame[10] = 0x00u; frame[11] = idx;
+    frame[12] = 0x88u;
+    frame[13] = 0xB5u;
+    memcpy(&frame[IRQ_HEADER_LEN], &magic, sizeof(magic));
+    memcpy(&frame[IRQ_HEADER_LEN + 4u], &seq, sizeof(seq));
+    memcpy(&frame[IRQ_HEADER_LEN + 8u], &stamp, sizeof(stamp));
+    memset(&frame[IRQ_HEADER_LEN + IRQ_STAMP_LEN], (uint8_t)(seq + idx), m_payload - IRQ_STAMP_LEN);
+    seg[0].pEth = frame;
+    seg[0].segLen = (uint16_t)(IRQ_HEADER_LEN + m_payload);
+    if (TC6_SendRawEthernetSegments(m_tc6[idx], seg, 1u, seg[0].segLen, 0u, OnTxDone, node)) {
+        node->txHead = (uint8_t)((node->txHead + 1u) % TC6_TX_ETH_QSIZE);
+        node->txInFlight++;
+        node->sent++;
+    }
+}
+
+static void OnTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag)
+{
+    Node_t *node = (Node_t *)pTag;
+    (void)pInst;
+    (void)pTx;
+    (void)len;
+    (void)pGlobalTag;
+    if (node->txInFlight > 0u) {
+        node->txInFlight--;
+    }
+}
+
+static void CheckFrame(const uint8_t *p, uint16_t len)
+{
+    uint8_t src = p[11];
+    uint32_t magic;
+    uint32_t seq;
+    uint64_t stamp;
+    bool valid;
+
+    memcpy(&magic, &p[IRQ_HEADER_LEN], sizeof(magic));
+    memcpy(&seq, &p[IRQ_HEADER_LEN + 4u], sizeof(seq));
+    memcpy(&stamp, &p[IRQ_HEADER_LEN + 8u], sizeof(stamp));
+    valid = (IRQ_MAGIC == magic) && (src > 0u) && (src < m_nodeCount) && (len == (IRQ_HEADER_LEN + m_payload + IRQ_FCS_LEN));
+    for (uint16_t i = IRQ_HEADER_LEN + IRQ_STAMP_LEN; valid && (i < (len - IRQ_FCS_LEN)); i++) {
+        valid = (p[i] == (uint8_t)(seq + src));
+    }
+    if (valid) {
+        const uint8_t *f = &p[len - IRQ_FCS_LEN];
+        valid = (Crc32(p, (uint16_t)(len - IRQ_FCS_LEN)) == ((uint32_t)f[0] | ((uint32_t)f[1] << 8) | ((uint32_t)f[2] << 16) | ((uint32_t)f[3] << 24)));
+    }
+    if (!valid) {
+        m_rx.corrupt++;
+        return;
+    }
+    /* Gaps are frames lost in a full RX buffer of the MACPHY (see Lost()) */
+    if (seq < m_rx.nextSeq[src]) {
+        m_rx.misordered++;
+    }
+    m_rx.nextSeq[src] = seq + 1u;
+    m_rx.received++;
+    if (m_rx.latencyCount < IRQ_MAX_FRAMES) {
+        m_rx.latency[m_rx.latencyCount++] = (uint32_t)((Now() - stamp) / IRQ_BITS_PER_US);
+    }
+}
+
+static uint32_t Lost(void)
+{
+    uint32_t lost = 0u;
+    for (uint8_t i = 0u; i < m_nodeCount; i++) {
+        TC6Sim_NodeStats_t stats;
+        TC6Sim_GetNodeStats(TC6Sim_GetNode(&m_bus, i), &stats);
+        lost += (0u == i) ? stats.rxDrops : (stats.txAborts + stats.txDrops);
+    }
+    return lost;
+}
+
+static uint32_t Crc32(const uint8_t *pData, uint16_t len)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    for (uint16_t i = 0u; i < len; i++) {
+        crc ^= pData[i];
+        for (uint8_t b = 0u; b < 8u; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+static int CompareLatency(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
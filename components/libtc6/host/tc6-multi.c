@@ -0,0 +1,489 @@
+/*******************************************************************************
+  Host Multi Instance Throughput for libtc6
+
+  File Name:
+    tc6-multi.c
+
+  Summary:
+    Aggregate throughput of several MACPHYs driven by one controller
+
+  Description:
+    Up to MULTI_MAX_PORTS emulated LAN865x (see sim/tc6sim.h) driven like
+    the ESP32 glue with LAN8651_COUNT > 1: one service loop services every
+    libtc6 instance. Each of them sits on a 10BASE-T1S segment of its own
+    together with a peer node, which receives the frames and checks them.
+    The SPI transactions take the time of the SPI clock (-c, default the
+    2 MHz of CLOCK_RATE) and are completed in the order of an SPI host:
+      "shared"   all instances on one SPI host with a chip select each
+                 (SPI2_HOST in SPI_HOST_LIST), the transactions take turns
+      "separate" every instance on an SPI host of its own, the
+                 transactions run at the same time
+    Every instance sends -s byte frames as fast as libtc6 takes them, for
+    1 up to -n instances. Prints the aggregate throughput and its scaling
+    against one instance (prefix "MULTI") and checks every frame for
+    order, content and FCS, frames a peer lost in its full RX buffer are
+    accounted for (prefix "CHECK", exit code 2 on a lost, reordered or
+    corrupted frame).
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tc6.h"
+#include "tc6-regs.h"
+#include "tc6sim.h"
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                            DEFINITIONS                               */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+#define MULTI_ETHERTYPE         (0x88B5u)
+#define MULTI_MAGIC             (0x4D554C54u)
+#define MULTI_HEADER_LEN        (14u)
+#define MULTI_FCS_LEN           (4u)
+#define MULTI_STAMP_LEN         (8u)            /* Magic and sequence number */
+#define MULTI_MAX_FRAME         (1514u)
+#define MULTI_MAX_PORTS         (TC6_MAX_INSTANCES / 2u)    /* Every port needs a peer instance as well */
+#define MULTI_STEP_BITS         (100u)          /* Segment time between two service loops (10 us) */
+#define MULTI_DRAIN_BITS        (5000000u)      /* Wait for outstanding frames after the last one was sent (500 ms) */
+#define MULTI_BITS_PER_US       (10u)
+#define MULTI_SEGMENT_BITRATE   (10000000ull)
+
+typedef enum
+{
+    Mode_Shared,
+    Mode_Separate
+} Mode_t;
+
+typedef struct
+{
+    uint8_t rxBuf[TC6SIM_MAX_FRAME_LEN];
+    uint8_t txFrame[TC6_TX_ETH_QSIZE][MULTI_MAX_FRAME];
+    uint8_t txHead;             /* Next TX buffer, buffers are released in order by OnTxDone */
+    uint8_t txInFlight;
+    uint32_t sent;
+    uint32_t received;
+    uint32_t nextSeq;
+    uint32_t misordered;
+    uint32_t corrupt;
+} MultiNode_t;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                          PRIVATE VARIABLES                           */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static TC6Sim_Bus_t m_bus[MULTI_MAX_PORTS];
+static TC6_t *m_tc6[TC6_MAX_INSTANCES];             /* Instance i < m_ports sends, i + m_ports is its peer */
+static MultiNode_t m_node[TC6_MAX_INSTANCES];
+static uint8_t m_ports = 2u;
+static Mode_t m_mode;
+static uint32_t m_spiClockHz = 2000000u;
+static uint16_t m_frameLen;
+static bool m_timed;                                /* false during the initialization: transactions complete at once */
+static uint64_t m_now;                              /* Segment time, every segment is run up to it */
+static uint64_t m_spiFree[TC6_MAX_INSTANCES];       /* Time the SPI host becomes free, indexed by host */
+static uint64_t m_spiDone[TC6_MAX_INSTANCES];       /* Time the running transaction of an instance completes */
+static bool m_spiPending[TC6_MAX_INSTANCES];
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                      PRIVATE FUNCTION PROTOTYPES                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static void RunStep(void);
+static bool SendFrame(uint8_t idx);
+static void OnTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag);
+static void CheckFrame(MultiNode_t *node, const uint8_t *p, uint16_t len);
+static uint8_t SpiHost(uint8_t tc6instance);
+static TC6Sim_Node_t *SimNode(uint8_t tc6instance);
+static bool SpiIdle(void);
+static uint32_t Aborts(uint8_t active, uint32_t *pOverruns);
+static uint32_t Crc32(const uint8_t *pData, uint16_t len);
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                             MAIN                                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+int main(int argc, char *argv[])
+{
+    static const char *const modeNames[] = { "shared", "separate" };
+    uint32_t durationMs = 300u;
+    uint16_t payload = 1500u;
+    bool plca = false;
+    bool success = true;
+    bool checked = true;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:c:s:d:ph")) != -1) {
+        switch (opt) {
+            case 'n':
+                m_ports = (uint8_t)atoi(optarg);
+                break;
+            case 'c':
+                m_spiClockHz = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                payload = (uint16_t)atoi(optarg);
+                break;
+            case 'd':
+                durationMs = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'p':
+                plca = true;
+                break;
+            default:
+                printf("usage: %s [-n instances] [-c SPI clock Hz] [-s payload] [-d duration ms] [-p PLCA]\n", argv[0]);
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+    if ((m_ports < 1u) || (m_ports > MULTI_MAX_PORTS)) {
+        printf("instances must be 1..%u (half of TC6_MAX_INSTANCES)\n", (unsigned)MULTI_MAX_PORTS);
+        return 1;
+    }
+    if ((payload < MULTI_STAMP_LEN) || (payload > (MULTI_MAX_FRAME - MULTI_HEADER_LEN)) || (0u == m_spiClockHz)) {
+        printf("payload must be %u..%u, the SPI clock above 0\n", MULTI_STAMP_LEN, MULTI_MAX_FRAME - MULTI_HEADER_LEN);
+        return 1;
+    }
+    m_frameLen = (uint16_t)(MULTI_HEADER_LEN + payload);
+
+    /* One segment per port with the instance of the controller (PLCA coordinator) and its peer */
+    for (uint8_t p = 0u; p < m_ports; p++) {
+        TC6Sim_BusConfig_t cfg = { .toTimerBits = 32u, .beaconBits = 20u, .spiClockHz = 0u, .seed = 1u + p };
+        TC6Sim_BusInit(&m_bus[p], &cfg);
+    }
+    /* TC6_Init() numbers the instances in order: first the controller's, then the peers */
+    for (uint8_t idx = 0u; success && (idx < (2u * m_ports)); idx++) {
+        uint8_t mac[6] = { 0x00u, 0x04u, 0xA3u, 0x12u, 0x00u, idx };
+        (void)TC6Sim_AddNode(&m_bus[idx % m_ports], idx);
+        m_tc6[idx] = TC6_Init(&m_node[idx]);
+        success = (NULL != m_tc6[idx]) && (TC6_GetInstance(m_tc6[idx]) == idx) &&
+                  TC6Regs_Init(m_tc6[idx], &m_node[idx], mac, plca, idx / m_ports, 2u, 0u, 0x80u, false, false, false);
+    }
+    for (uint32_t k = 0u; success && (k < (100000u * MULTI_BITS_PER_US / MULTI_STEP_BITS)); k++) {
+        RunStep();
+    }
+    for (uint8_t idx = 0u; success && (idx < (2u * m_ports)); idx++) {
+        success = TC6Regs_GetInitDone(m_tc6[idx]);
+    }
+    if (!success) {
+        printf("initialization failed\n");
+        return 1;
+    }
+    /* TC6_Reset() waits for a running transaction, so the initialization completes them at once */
+    m_timed = true;
+    for (uint8_t idx = 0u; idx < (2u * m_ports); idx++) {
+        TC6_EnableData(m_tc6[idx], true);
+    }
+
+    printf("MULTI,spi_hosts,instances,spi_hz,payload,received,duration_us,goodput_kbps,per_instance_kbps,scaling_pct\n");
+    printf("CHECK,spi_hosts,instances,sent,received,aborted,overruns,lost,misordered,corrupt,result\n");
+    for (m_mode = Mode_Shared; m_mode <= Mode_Separate; m_mode++) {
+        uint64_t single = 0u;
+        for (uint8_t active = 1u; active <= m_ports; active++) {
+            uint32_t sent = 0u;
+            uint32_t received = 0u;
+            uint32_t windowReceived = 0u;
+            uint32_t misordered = 0u;
+            uint32_t corrupt = 0u;
+            uint32_t overruns;
+            uint32_t overrunsStart;
+            uint32_t aborts = Aborts(active, &overrunsStart);
+            uint32_t lost;
+            uint64_t start;
+            uint64_t kbps;
+            bool ok;
+
+            for (uint8_t i = 0u; i < TC6_MAX_INSTANCES; i++) {
+                m_node[i].sent = 0u;
+                m_node[i].received = 0u;
+                m_node[i].nextSeq = 0u;
+                m_node[i].misordered = 0u;
+                m_node[i].corrupt = 0u;
+            }
+            /* Every active instance keeps its TX queue full for the duration */
+            start = m_now;
+            while ((m_now - start) < ((uint64_t)durationMs * 1000u * MULTI_BITS_PER_US)) {
+                for (uint8_t i = 0u; i < active; i++) {
+                    while (SendFrame(i)) {
+                    }
+                }
+                RunStep();
+            }
+            for (uint8_t i = 0u; i < active; i++) {
+                windowReceived += m_node[i + m_ports].received;
+            }
+            kbps = (windowReceived * (uint64_t)payload * 8u * 1000u) / ((uint64_t)durationMs * 1000u);
+            if (1u == active) {
+                single = kbps;
+            }
+            /* Drain the queues for the check, not counted in the throughput */
+            for (uint32_t waited = 0u; waited < MULTI_DRAIN_BITS; waited += MULTI_STEP_BITS) {
+                bool drained = SpiIdle();
+                for (uint8_t i = 0u; i < active; i++) {
+                    drained = drained && (0u == m_node[i].txInFlight);
+                }
+                if (drained) {
+                    break;
+                }
+                RunStep();
+            }
+            /* Frames still in the emulated MACPHYs and on the segments */
+            for (uint32_t waited = 0u; waited < (100u * MULTI_BITS_PER_US * 1000u); waited += MULTI_STEP_BITS) {
+                RunStep();
+            }
+            received = 0u;
+            for (uint8_t i = 0u; i < active; i++) {
+                MultiNode_t *peer = &m_node[i + m_ports];
+                sent += m_node[i].sent;
+                received += peer->received;
+                misordered += peer->misordered;
+                corrupt += peer->corrupt;
+            }
+            aborts = Aborts(active, &overruns) - aborts;
+            overruns -= overrunsStart;
+            lost = ((received + aborts + overruns) < sent) ? (sent - received - aborts - overruns) : 0u;
+            /* A frame lost in a full buffer is accounted for, the next one is out of sequence for that reason */
+            ok = (0u == lost) && (misordered <= overruns) && (0u == corrupt);
+            checked = ok && checked;
+
+            printf("MULTI,%s,%u,%u,%u,%u,%u,%llu,%llu,%llu\n", modeNames[m_mode], active, m_spiClockHz, payload,
+                   windowReceived, durationMs * 1000u, (unsigned long long)kbps, (unsigned long long)(kbps / active),
+                   (unsigned long long)(single ? ((kbps * 100u) / single) : 0u));
+            printf("CHECK,%s,%u,%u,%u,%u,%u,%u,%u,%u,%s\n", modeNames[m_mode], active, sent, received, aborts, overruns, lost,
+                   misordered, corrupt, ok ? "ok" : "FAIL");
+        }
+    }
+    return checked ? 0 : 2;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  CALLBACK FUNCTIONS FROM TC6 STACK                   */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+bool TC6_CB_OnSpiTransaction(uint8_t tc6instance, uint8_t *pTx, uint8_t *pRx, uint16_t len, void *pGlobalTag)
+{
+    TC6Sim_Node_t *node = SimNode(tc6instance);
+    bool success = (NULL != node) && TC6Sim_SpiTransaction(node, pTx, pRx, len);
+    (void)pGlobalTag;
+    if (success && !m_timed) {
+        TC6_SpiBufferDone(tc6instance, true);
+    } else if (success) {
+        /* The SPI host runs its transactions one after the other, like the ESP-IDF driver the devices of one bus */
+        uint8_t host = SpiHost(tc6instance);
+        uint64_t begin = (m_spiFree[host] > m_now) ? m_spiFree[host] : m_now;
+        m_spiDone[tc6instance] = begin + (((uint64_t)len * 8u * MULTI_SEGMENT_BITRATE) / m_spiClockHz);
+        m_spiFree[host] = m_spiDone[tc6instance];
+        m_spiPending[tc6instance] = true;
+    } else {
+    } /* MISRA enforced termination */
+    return success;
+}
+
+void TC6_CB_OnNeedService(TC6_t *pInst, void *pGlobalTag)
+{
+    /* Every instance is serviced after each segment step anyway */
+    (void)pInst;
+    (void)pGlobalTag;
+}
+
+void TC6_CB_OnRxEthernetSlice(TC6_t *pInst, const uint8_t *pRx, uint16_t offset, uint16_t len, void *pGlobalTag)
+{
+    MultiNode_t *node = (MultiNode_t *)pGlobalTag;
+    (void)pInst;
+    if (((uint32_t)offset + len) <= sizeof(node->rxBuf)) {
+        memcpy(&node->rxBuf[offset], pRx, len);
+    }
+}
+
+void TC6_CB_OnRxEthernetPacket(TC6_t *pInst, bool success, uint16_t len, uint64_t *rxTimestamp, void *pGlobalTag)
+{
+    MultiNode_t *node = (MultiNode_t *)pGlobalTag;
+    (void)pInst;
+    (void)rxTimestamp;
+    if (!success || (len > sizeof(node->rxBuf))) {
+        node->corrupt++;
+    } else {
+        CheckFrame(node, node->rxBuf, len);
+    }
+}
+
+void TC6_CB_OnError(TC6_t *pInst, TC6_Error_t err, void *pGlobalTag)
+{
+    (void)pGlobalTag;
+    printf("node %u: error %d\n", TC6_GetInstance(pInst), (int)err);
+}
+
+uint32_t TC6Regs_CB_GetTicksMs(void)
+{
+    return (uint32_t)(m_now / (1000u * MULTI_BITS_PER_US));
+}
+
+void TC6Regs_CB_OnEvent(TC6_t *pInst, TC6Regs_Event_t event, void *pTag)
+{
+    (void)pInst;
+    (void)event;
+    (void)pTag;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  PRIVATE FUNCTION IMPLEMENTATIONS                    */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static void RunStep(void)
+{
+    uint32_t before = TC6Regs_CB_GetTicksMs();
+
+    /* The SPI interrupts of the transactions finished by now, then one service loop over every instance */
+    for (uint8_t i = 0u; i < TC6_MAX_INSTANCES; i++) {
+        if (m_spiPending[i] && (m_spiDone[i] <= m_now)) {
+            m_spiPending[i] = false;
+            TC6_SpiBufferDone(i, true);
+        }
+    }
+    for (uint8_t idx = 0u; idx < (2u * m_ports); idx++) {
+        TC6_Service(m_tc6[idx], !TC6Sim_IrqAsserted(SimNode(idx)));
+    }
+    /* A segment may run past the step with a frame, the next step starts it later */
+    m_now += MULTI_STEP_BITS;
+    for (uint8_t p = 0u; p < m_ports; p++) {
+        TC6Sim_BusStats_t bus;
+        TC6Sim_GetBusStats(&m_bus[p], &bus);
+        if (bus.now < m_now) {
+            TC6Sim_BusRun(&m_bus[p], (uint32_t)(m_now - bus.now));
+        }
+    }
+    if (TC6Regs_CB_GetTicksMs() != before) {
+        TC6Regs_CheckTimers();
+    }
+}
+
+static bool SendFrame(uint8_t idx)
+{
+    MultiNode_t *node = &m_node[idx];
+    uint8_t *frame = node->txFrame[node->txHead];
+    TC6_RawTxSegment *seg;
+    uint32_t magic = MULTI_MAGIC;
+    uint32_t seq = node->sent;
+    bool success = false;
+
+    /* A frame stays in use until OnTxDone, every queue entry has its own buffer */
+    if ((node->txInFlight < TC6_TX_ETH_QSIZE) && (TC6_GetRawSegments(m_tc6[idx], &seg) > 0u)) {
+        memset(frame, 0xFF, 6u);
+        frame[6] = 0x00u; frame[7] = 0x04u; frame[8] = 0xA3u; frame[9] = 0x12u; frame[10] = 0x00u; frame[11] = idx;
+        frame[12] = (uint8_t)(MULTI_ETHERTYPE >> 8);
+        frame[13] = (uint8_t)MULTI_ETHERTYPE;
+        memcpy(&frame[MULTI_HEADER_LEN], &magic, sizeof(magic));
+        memcpy(&frame[MULTI_HEADER_LEN + 4u], &seq, sizeof(seq));
+        memset(&frame[MULTI_HEADER_LEN + MULTI_STAMP_LEN], (uint8_t)(seq + idx), m_frameLen - MULTI_HEADER_LEN - MULTI_STAMP_LEN);
+
+        seg[0].pEth = frame;
+        seg[0].segLen = m_frameLen;
+        success = TC6_SendRawEthernetSegments(m_tc6[idx], seg, 1u, m_frameLen, 0u, OnTxDone, node);
+        if (success) {
+            node->txHead = (uint8_t)((node->txHead + 1u) % TC6_TX_ETH_QSIZE);
+            node->txInFlight++;
+            node->sent++;
+        }
+    }
+    return success;
+}
+
+static void OnTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag)
+{
+    MultiNode_t *node = (MultiNode_t *)pTag;
+    (void)pInst;
+    (void)pTx;
+    (void)len;
+    (void)pGlobalTag;
+    if (node->txInFlight > 0u) {
+        node->txInFlight--;
+    }
+}
+
+static void CheckFrame(MultiNode_t *node, const uint8_t *p, uint16_t len)
+{
+    uint8_t src = p[11];
+    uint32_t magic;
+    uint32_t seq;
+    bool valid;
+
+    if ((len < (MULTI_HEADER_LEN + MULTI_STAMP_LEN)) || ((((uint16_t)p[12] << 8) | p[13]) != MULTI_ETHERTYPE)) {
+        return;
+    }
+    memcpy(&magic, &p[MULTI_HEADER_LEN], sizeof(magic));
+    memcpy(&seq, &p[MULTI_HEADER_LEN + 4u], sizeof(seq));
+    /* Only the instance on the same segment sends to this peer */
+    valid = (MULTI_MAGIC == magic) && (len == (m_frameLen + MULTI_FCS_LEN)) && (src < m_ports) && (node == &m_node[src + m_ports]);
+    for (uint16_t i = MULTI_HEADER_LEN + MULTI_STAMP_LEN; valid && (i < (len - MULTI_FCS_LEN)); i++) {
+        valid = (p[i] == (uint8_t)(seq + src));
+    }
+    if (valid) {
+        /* The MACPHY passes the FCS on, it covers the header and the stamp as well */
+        uint32_t fcs = Crc32(p, (uint16_t)(len - MULTI_FCS_LEN));
+        const uint8_t *f = &p[len - MULTI_FCS_LEN];
+        valid = (fcs == ((uint32_t)f[0] | ((uint32_t)f[1] << 8) | ((uint32_t)f[2] << 16) | ((uint32_t)f[3] << 24)));
+    }
+    if (!valid) {
+        node->corrupt++;
+    } else {
+        if (seq != node->nextSeq) {
+            node->misordered++;
+        }
+        node->nextSeq = seq + 1u;
+        node->received++;
+    }
+}
+
+static uint8_t SpiHost(uint8_t tc6instance)
+{
+    /* The peers are separate devices with SPI hosts of their own */
+    uint8_t host = tc6instance;
+    if ((Mode_Shared == m_mode) && (tc6instance < m_ports)) {
+        host = 0u;
+    }
+    return host;
+}
+
+static TC6Sim_Node_t *SimNode(uint8_t tc6instance)
+{
+    return TC6Sim_GetNode(&m_bus[tc6instance % m_ports], tc6instance);
+}
+
+static bool SpiIdle(void)
+{
+    bool idle = true;
+    for (uint8_t i = 0u; i < TC6_MAX_INSTANCES; i++) {
+        idle = idle && !m_spiPending[i];
+    }
+    return idle;
+}
+
+static uint32_t Aborts(uint8_t active, uint32_t *pOverruns)
+{
+    uint32_t aborts = 0u;
+    *pOverruns = 0u;
+    for (uint8_t i = 0u; i < active; i++) {
+        TC6Sim_NodeStats_t stats;
+        TC6Sim_GetNodeStats(SimNode(i), &stats);
+        aborts += stats.txAborts;
+        *pOverruns += stats.txDrops;
+        /* A peer, which does not read its frames fast enough over its SPI, loses them in the full RX buffer */
+        TC6Sim_GetNodeStats(SimNode(i + m_ports), &stats);
+        *pOverruns += stats.rxDrops;
+    }
+    return aborts;
+}
+
+static uint32_t Crc32(const uint8_t *pData, uint16_t len)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    for (uint16_t i = 0u; i < len; i++) {
+        crc ^= pData[i];
+        for (uint8_t b = 0u; b < 8u; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,428 @@
+/*******************************************************************************
+  Register Operation Replay for libtc6
+
+  File Name:
+    tc6-replay.c
+
+  Summary:
+    Shows that coalescing (TC6_REGOP_COALESCE) changes nothing but the merges
+
+  Description:
+    Replays the same register access script against an emulated LAN865x
+    (see sim/tc6sim.h): the register initialization of tc6-regs, the
+    extended status handling and bursts of writes, write 1 to clear writes
+    with different masks and read-modify-writes queued before the first
+    one is sent. Every control transaction on SPI is logged decoded
+    (write/read, protection, address, value), followed by the final value
+    of every register the script touched.
+    Built twice, without and with coalescing. The build without writes the
+    reference log (-w file), the build with coalescing compares its own log
+    against it (-c file). The logs must be identical except for merged
+    operations: a run of writes to one address becomes one write of the
+    last value (ORed for STATUS0 and STATUS1) and a run of read-modify-
+    write pairs becomes one pair writing the same final value. The final
+    register values must be identical. Prints one line (prefix "REPLAY"),
+    the exit code is 2 on a mismatch.
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tc6.h"
+#include "tc6-regs.h"
+#include "tc6sim.h"
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                            DEFINITIONS                               */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+#define REPLAY_MAX_XACTS        (1024u)
+#define REPLAY_MAX_REGS         (256u)
+#define REPLAY_STEP_BITS        (100u)
+#define REPLAY_BITS_PER_MS      (10000u)
+#define REPLAY_IDLE_STEPS       (8u)            /* Service calls without a transaction until a burst counts as done */
+#define REPLAY_MAX_STEPS        (100000u)       /* Service calls until a burst counts as stuck, e.g. a status flag never cleared */
+
+#define REG_STATUS0             (0x00000008u)
+#define REG_STATUS1             (0x00000009u)
+
+typedef struct
+{
+    char op;                    /** 'W': write, 'R': read, 'S': final register value */
+    bool secure;
+    uint32_t addr;
+    uint32_t value;
+} Xact_t;
+
+typedef struct
+{
+    Xact_t entry[REPLAY_MAX_XACTS];
+    uint32_t count;
+} XactLog_t;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                          PRIVATE VARIABLES                           */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static TC6Sim_Bus_t m_bus;
+static TC6_t *m_tc6;
+static XactLog_t m_log;
+static XactLog_t m_ref;
+static uint32_t m_spiCount;
+static uint32_t m_stuck;
+static uint32_t m_failed[(REPLAY_MAX_XACTS + 1u) * (REPLAY_MAX_XACTS + 1u) / 32u + 1u];  /* Align() already failed at (i, j) */
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                      PRIVATE FUNCTION PROTOTYPES                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint64_t Now(void);
+static void Step(void);
+static void RunUntilIdle(void);
+static void RunScript(void);
+static void AppendRegisters(XactLog_t *pLog);
+static bool WriteLog(const char *path, const XactLog_t *pLog);
+static bool ReadLog(const char *path, XactLog_t *pLog);
+static bool SameAccess(const Xact_t *a, const Xact_t *b, char op);
+static bool Align(const XactLog_t *pRef, uint32_t i, const XactLog_t *pLog, uint32_t j, uint32_t *pMerged, uint32_t *pReached);
+static bool CompareLogs(const XactLog_t *pRef, const XactLog_t *pLog, uint32_t *pMerged);
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                             MAIN                                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+int main(int argc, char *argv[])
+{
+    const char *writePath = NULL;
+    const char *comparePath = NULL;
+    TC6_RegOpStats_t stats;
+    uint32_t merged = 0u;
+    bool success = true;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "w:c:h")) != -1) {
+        switch (opt) {
+            case 'w':
+                writePath = optarg;
+                break;
+            case 'c':
+                comparePath = optarg;
+                break;
+            default:
+                printf("usage: %s [-w reference.log] [-c reference.log]\n", argv[0]);
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+
+    RunScript();
+    TC6_GetRegOpStats(m_tc6, &stats, false);
+    AppendRegisters(&m_log);
+    if (0u != m_stuck) {
+        printf("%u bursts did not end, IRQ_N %s\n", m_stuck, TC6Sim_IrqAsserted(TC6Sim_GetNode(&m_bus, 0u)) ? "asserted" : "released");
+        success = false;
+    }
+
+    if (success && (NULL != writePath)) {
+        success = WriteLog(writePath, &m_log);
+    }
+    if (NULL != comparePath) {
+        success = ReadLog(comparePath, &m_ref) && CompareLogs(&m_ref, &m_log, &merged) && success;
+        /* Every merge the library counted has to show up in the log and vice versa */
+        if (success && (merged != (stats.coalescedWrites + stats.coalescedModifies))) {
+            printf("merged %u operations, libtc6 counted %u\n", merged, stats.coalescedWrites + stats.coalescedModifies);
+            success = false;
+        }
+    }
+    printf("REPLAY,coalesce,spi_transactions,control,reference,merged_writes,merged_modifies,result\n");
+    printf("REPLAY,%u,%u,%u,%u,%u,%u,%s\n", (unsigned)TC6_REGOP_COALESCE, m_spiCount, m_log.count, m_ref.count,
+           stats.coalescedWrites, stats.coalescedModifies, success ? "ok" : "FAIL");
+    return success ? 0 : 2;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  CALLBACK FUNCTIONS FROM TC6 STACK                   */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+bool TC6_CB_OnSpiTransaction(uint8_t tc6instance, uint8_t *pTx, uint8_t *pRx, uint16_t len, void *pGlobalTag)
+{
+    bool success = TC6Sim_SpiTransaction(TC6Sim_GetNode(&m_bus, tc6instance), pTx, pRx, len);
+    (void)pGlobalTag;
+    m_spiCount++;
+    if (success && (0u == (pTx[0] & 0x80u)) && (m_log.count < REPLAY_MAX_XACTS)) {
+        /* Control transaction with a single register, see mk_ctrl_req() and mk_secure_ctrl_req() */
+        Xact_t *x = &m_log.entry[m_log.count++];
+        x->op = (0u != (pTx[0] & 0x20u)) ? 'W' : 'R';
+        x->secure = (len > 12u);
+        x->addr = ((uint32_t)(pTx[0] & 0x0Fu) << 16) | ((uint32_t)pTx[1] << 8) | pTx[2];
+        x->value = ('W' == x->op) ? (((uint32_t)pTx[4] << 24) | ((uint32_t)pTx[5] << 16) | ((uint32_t)pTx[6] << 8) | pTx[7]) : 0u;
+    }
+    if (success) {
+        TC6_SpiBufferDone(tc6instance, true);
+    }
+    return success;
+}
+
+void TC6_CB_OnNeedService(TC6_t *pInst, void *pGlobalTag)
+{
+    (void)pInst;
+    (void)pGlobalTag;
+}
+
+void TC6_CB_OnRxEthernetSlice(TC6_t *pInst, const uint8_t *pRx, uint16_t offset, uint16_t len, void *pGlobalTag)
+{
+    (void)pInst;
+    (void)pRx;
+    (void)offset;
+    (void)len;
+    (void)pGlobalTag;
+}
+
+void TC6_CB_OnRxEthernetPacket(TC6_t *pInst, bool success, uint16_t len, uint64_t *rxTimestamp, void *pGlobalTag)
+{
+    (void)pInst;
+    (void)success;
+    (void)len;
+    (void)rxTimestamp;
+    (void)pGlobalTag;
+}
+
+void TC6_CB_OnError(TC6_t *pInst, TC6_Error_t err, void *pGlobalTag)
+{
+    (void)pInst;
+    (void)pGlobalTag;
+    printf("error %d\n", (int)err);
+}
+
+uint32_t TC6Regs_CB_GetTicksMs(void)
+{
+    return (uint32_t)(Now() / REPLAY_BITS_PER_MS);
+}
+
+void TC6Regs_CB_OnEvent(TC6_t *pInst, TC6Regs_Event_t event, void *pTag)
+{
+    (void)pInst;
+    (void)event;
+    (void)pTag;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  PRIVATE FUNCTION IMPLEMENTATIONS                    */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint64_t Now(void)
+{
+    TC6Sim_BusStats_t bus;
+    TC6Sim_GetBusStats(&m_bus, &bus);
+    return bus.now;
+}
+
+static void Step(void)
+{
+    uint32_t before = TC6Regs_CB_GetTicksMs();
+    TC6_Service(m_tc6, !TC6Sim_IrqAsserted(TC6Sim_GetNode(&m_bus, 0u)));
+    TC6Sim_BusRun(&m_bus, REPLAY_STEP_BITS);
+    if (TC6Regs_CB_GetTicksMs() != before) {
+        TC6Regs_CheckTimers();
+    }
+}
+
+static void RunUntilIdle(void)
+{
+    uint32_t idle = 0u;
+    uint32_t steps = 0u;
+    while ((idle < REPLAY_IDLE_STEPS) && (steps < REPLAY_MAX_STEPS)) {
+        uint32_t before = m_spiCount;
+        Step();
+        idle = (m_spiCount == before) ? (idle + 1u) : 0u;
+        steps++;
+    }
+    if (steps == REPLAY_MAX_STEPS) {
+        m_stuck++;
+    }
+}
+
+static void RunScript(void)
+{
+    static const uint8_t mac[6] = { 0x00u, 0x04u, 0xA3u, 0x12u, 0x00u, 0x00u };
+    TC6Sim_Node_t *pNode;
+    TC6Sim_BusConfig_t cfg = { .toTimerBits = 32u, .beaconBits = 20u, .spiClockHz = 0u, .seed = 1u };
+
+    TC6Sim_BusInit(&m_bus, &cfg);
+    pNode = TC6Sim_AddNode(&m_bus, 0u);
+    m_tc6 = TC6_Init(NULL);
+
+    /* Register initialization, the memory map is queued as fast as the queue takes it */
+    (void)TC6Regs_Init(m_tc6, NULL, mac, true, 0u, 2u, 0u, 0x80u, false, false, false);
+    for (uint32_t i = 0u; (i < 1000u) && !TC6Regs_GetInitDone(m_tc6); i++) {
+        Step();
+    }
+    RunUntilIdle();
+
+    /* Status flags cleared by two writes with different masks before the first one is sent */
+    TC6Sim_SetRegister(pNode, REG_STATUS0, 0x00000042u);
+    (void)TC6_WriteRegister(m_tc6, REG_STATUS0, 0x00000040u, true, NULL, NULL);
+    (void)TC6_WriteRegister(m_tc6, REG_STATUS0, 0x00000002u, true, NULL, NULL);
+    RunUntilIdle();
+
+    TC6Sim_SetRegister(pNode, REG_STATUS1, 0x00060003u);
+    (void)TC6_WriteRegister(m_tc6, REG_STATUS1, 0x00000001u, true, NULL, NULL);
+    (void)TC6_WriteRegister(m_tc6, REG_STATUS1, 0x00020000u, true, NULL, NULL);
+    (void)TC6_WriteRegister(m_tc6, REG_STATUS1, 0x00000002u, true, NULL, NULL);
+    RunUntilIdle();
+
+    /* Extended status: two reads of STATUS0 queued, new flags show up between them */
+    TC6Sim_SetRegister(pNode, REG_STATUS0, 0x00000008u);
+    TC6_CB_OnExtendedStatus(m_tc6, NULL);
+    TC6_CB_OnExtendedStatus(m_tc6, NULL);
+    Step();
+    TC6Sim_SetRegister(pNode, REG_STATUS0, TC6Sim_GetRegister(pNode, REG_STATUS0) | 0x00000001u);
+    RunUntilIdle();
+
+    /* Plain register, last write wins */
+    (void)TC6_WriteRegister(m_tc6, 0x00040090u, 0x00000001u, true, NULL, NULL);
+    (void)TC6_WriteRegister(m_tc6, 0x00040090u, 0x00000002u, true, NULL, NULL);
+    (void)TC6_WriteRegister(m_tc6, 0x00040090u, 0x00000003u, true, NULL, NULL);
+    RunUntilIdle();
+
+    /* Read-modify-writes with disjunct masks merge, an overlapping one does not */
+    TC6Sim_SetRegister(pNode, 0x00040091u, 0x0000FF00u);
+    (void)TC6_ReadModifyWriteRegister(m_tc6, 0x00040091u, 0x00000001u, 0x0000000Fu, true, NULL, NULL);
+    (void)TC6_ReadModifyWriteRegister(m_tc6, 0x00040091u, 0x00000020u, 0x000000F0u, true, NULL, NULL);
+    (void)TC6_ReadModifyWriteRegister(m_tc6, 0x00040091u, 0x00000000u, 0x00000F00u, true, NULL, NULL);
+    (void)TC6_ReadModifyWriteRegister(m_tc6, 0x00040091u, 0x00000002u, 0x0000000Fu, true, NULL, NULL);
+    RunUntilIdle();
+
+    /* Unprotected accesses are not merged with protected ones */
+    (void)TC6_WriteRegister(m_tc6, 0x00040092u, 0x00000005u, true, NULL, NULL);
+    (void)TC6_WriteRegister(m_tc6, 0x00040092u, 0x00000006u, false, NULL, NULL);
+    (void)TC6_ReadRegister(m_tc6, 0x00040092u, false, NULL, NULL);
+    RunUntilIdle();
+}
+
+static void AppendRegisters(XactLog_t *pLog)
+{
+    uint32_t addr[REPLAY_MAX_REGS];
+    uint32_t count = 0u;
+    uint32_t xacts = pLog->count;
+    for (uint32_t i = 0u; i < xacts; i++) {
+        uint32_t k = 0u;
+        while ((k < count) && (addr[k] != pLog->entry[i].addr)) {
+            k++;
+        }
+        if ((k == count) && (count < REPLAY_MAX_REGS)) {
+            addr[count++] = pLog->entry[i].addr;
+        }
+    }
+    for (uint32_t k = 0u; (k < count) && (pLog->count < REPLAY_MAX_XACTS); k++) {
+        Xact_t *x = &pLog->entry[pLog->count++];
+        x->op = 'S';
+        x->secure = false;
+        x->addr = addr[k];
+        x->value = TC6Sim_GetRegister(TC6Sim_GetNode(&m_bus, 0u), addr[k]);
+    }
+}
+
+static bool WriteLog(const char *path, const XactLog_t *pLog)
+{
+    FILE *f = fopen(path, "w");
+    if (NULL == f) {
+        printf("cannot write %s\n", path);
+        return false;
+    }
+    for (uint32_t i = 0u; i < pLog->count; i++) {
+        const Xact_t *x = &pLog->entry[i];
+        fprintf(f, "%c %u %08X %08X\n", x->op, x->secure ? 1u : 0u, x->addr, x->value);
+    }
+    return (0 == fclose(f));
+}
+
+static bool ReadLog(const char *path, XactLog_t *pLog)
+{
+    FILE *f = fopen(path, "r");
+    char op;
+    unsigned secure;
+    unsigned addr;
+    unsigned value;
+    if (NULL == f) {
+        printf("cannot read %s\n", path);
+        return false;
+    }
+    pLog->count = 0u;
+    while ((pLog->count < REPLAY_MAX_XACTS) && (4 == fscanf(f, " %c %u %x %x", &op, &secure, &addr, &value))) {
+        Xact_t *x = &pLog->entry[pLog->count++];
+        x->op = op;
+        x->secure = (0u != secure);
+        x->addr = addr;
+        x->value = value;
+    }
+    (void)fclose(f);
+    return true;
+}
+
+static bool SameAccess(const Xact_t *a, const Xact_t *b, char op)
+{
+    return (op == a->op) && (op == b->op) && (a->addr == b->addr) && (a->secure == b->secure);
+}
+
+static bool Align(const XactLog_t *pRef, uint32_t i, const XactLog_t *pLog, uint32_t j, uint32_t *pMerged, uint32_t *pReached)
+{
+    /* Tries every way the own entry j may stand for reference entries from i on, until the rest of both logs aligns */
+    const Xact_t *x;
+    bool success = false;
+    uint32_t run;
+
+    uint32_t bit = (i * (REPLAY_MAX_XACTS + 1u)) + j;
+
+    *pReached = (j > *pReached) ? j : *pReached;
+    if ((i == pRef->count) || (j == pLog->count)) {
+        return (i == pRef->count) && (j == pLog->count);
+    }
+    if (0u != (m_failed[bit / 32u] & (1u << (bit % 32u)))) {
+        return false;
+    }
+    x = &pLog->entry[j];
+    if (('R' == x->op) && ((j + 1u) < pLog->count) && ('W' == pLog->entry[j + 1u].op)
+        && (pLog->entry[j + 1u].addr == x->addr) && (pLog->entry[j + 1u].secure == x->secure)) {
+        /* Read-modify-write: a run of read/write pairs merged into one, the last write has to match */
+        const Xact_t *w = &pLog->entry[j + 1u];
+        for (run = 2u; !success && ((i + run) <= pRef->count) && SameAccess(&pRef->entry[i + run - 2u], x, 'R')
+             && SameAccess(&pRef->entry[i + run - 1u], w, 'W'); run += 2u) {
+            success = (pRef->entry[i + run - 1u].value == w->value) && Align(pRef, i + run, pLog, j + 2u, pMerged, pReached);
+            *pMerged += success ? ((run / 2u) - 1u) : 0u;
+        }
+    }
+    if (!success && ('W' == x->op)) {
+        /* A run of writes to the same address merged into one, STATUS0 and STATUS1 clear the union of their bits */
+        bool w1c = (REG_STATUS0 == x->addr) || (REG_STATUS1 == x->addr);
+        uint32_t value = 0u;
+        for (run = 1u; !success && ((i + run) <= pRef->count) && SameAccess(&pRef->entry[i + run - 1u], x, 'W'); run++) {
+            value = w1c ? (value | pRef->entry[i + run - 1u].value) : pRef->entry[i + run - 1u].value;
+            success = (value == x->value) && Align(pRef, i + run, pLog, j + 1u, pMerged, pReached);
+            *pMerged += success ? (run - 1u) : 0u;
+        }
+    } else if (!success) {
+        const Xact_t *r = &pRef->entry[i];
+        success = (r->op == x->op) && (r->secure == x->secure) && (r->addr == x->addr) && (r->value == x->value)
+                  && Align(pRef, i + 1u, pLog, j + 1u, pMerged, pReached);
+    } else {} /* MISRA enforced termination */
+    if (!success) {
+        m_failed[bit / 32u] |= (1u << (bit % 32u));
+    }
+    return success;
+}
+
+static bool CompareLogs(const XactLog_t *pRef, const XactLog_t *pLog, uint32_t *pMerged)
+{
+    uint32_t reached = 0u;
+    bool success = Align(pRef, 0u, pLog, 0u, pMerged, &reached);
+    if (!success && (reached < pLog->count)) {
+        const Xact_t *x = &pLog->entry[reached];
+        printf("mismatch at transaction %u: %c %u %08X %08X\n", reached, x->op, x->secure ? 1u : 0u, x->addr, x->value);
+    } else if (!success) {
+        printf("reference has more transactions\n");
+    } else {} /* MISRA enforced termination */
+    return success;
+}
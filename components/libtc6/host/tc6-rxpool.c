@@ -0,0 +1,448 @@
+/*******************************************************************************
+  Host RX Pool Benchmark for the ESP32 glue
+
+  File Name:
+    tc6-rxpool.c
+
+  Summary:
+    Allocation latency distribution of the RX pbuf pool
+
+  Description:
+    Builds main/rxpool.c unchanged against the headers in host/glue and
+    times every single allocation, with RX_PBUF_POOL_SIZE - 1 frames in
+    flight and released in order like RxTask and lwIP do it:
+      "timer"     the empty measurement, the overhead of the clock
+      "pool"      RxPoolAlloc(), the custom pbuf of the pool
+      "heap"      a pbuf and MTU sized buffer from malloc(), the former
+                  pbuf_alloc(PBUF_RAW, TC6LwIP_MTU, PBUF_RAM) with the lwIP
+                  heap of ESP-IDF (MEM_LIBC_MALLOC)
+      "heap_busy" the same while other users allocate and free buffers of
+                  random size in between, as the rest of the firmware does
+    Prints the percentiles and the maximum in ns (prefix "POOL", the
+    numbers are only comparable on the same machine, the maximum also
+    catches the scheduler of the host). Then checks that exactly
+    RX_PBUF_POOL_SIZE buffers are handed out before the drop counter
+    counts, and allocates in one thread while two other threads release
+    the buffers, checking that no buffer is ever handed out twice
+    (prefix "CHECK", exit code 2 on a failure).
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include "lwip/pbuf.h"
+#include "rxpool.h"
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                            DEFINITIONS                               */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+#define POOL_IN_FLIGHT          (RX_PBUF_POOL_SIZE - 1u)    /* Frames held by RxTask and lwIP while the next one starts */
+#define POOL_BUSY_SLOTS         (64u)                       /* Buffers of the other heap users in "heap_busy" */
+#define POOL_BUSY_MIN           (16u)
+#define POOL_BUSY_MAX           (2048u)
+#define POOL_RING_SIZE          (64u)                       /* Hand over from the allocating to a releasing thread */
+#define POOL_CONSUMERS          (2u)
+
+typedef enum
+{
+    Mode_Timer,
+    Mode_Pool,
+    Mode_Heap,
+    Mode_HeapBusy
+} Mode_t;
+
+typedef struct
+{
+    struct pbuf *entry[POOL_RING_SIZE];
+    uint32_t head;
+    uint32_t tail;
+    uint32_t released;
+    uint32_t corrupt;
+} Ring_t;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                          PRIVATE VARIABLES                           */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint32_t *m_samples;
+static void *m_busy[POOL_BUSY_SLOTS];
+static uint32_t m_seed = 1u;
+static Ring_t m_ring[POOL_CONSUMERS];
+static struct pbuf *m_known[RX_PBUF_POOL_SIZE];     /* Buffers seen by the allocating thread, index is the slot */
+static uint8_t m_inUse[RX_PBUF_POOL_SIZE];
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                      PRIVATE FUNCTION PROTOTYPES                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint64_t NowNs(void);
+static uint32_t Random(void);
+static void MeasureMode(Mode_t mode, uint32_t allocs);
+static void *AllocFrame(Mode_t mode);
+static void FreeFrame(Mode_t mode, void *p);
+static void BusyHeap(void);
+static int CompareSamples(const void *a, const void *b);
+static bool CheckExhaustion(void);
+static bool CheckThreads(uint32_t allocs);
+static void *ReleaseThread(void *arg);
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                             MAIN                                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+int main(int argc, char *argv[])
+{
+    uint32_t allocs = 200000u;
+    uint32_t threadAllocs = 200000u;
+    bool success = true;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:t:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                allocs = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                threadAllocs = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                printf("usage: %s [-n timed allocations] [-t allocations of the thread check]\n", argv[0]);
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+    if (0u == allocs) {
+        printf("timed allocations must be at least 1\n");
+        return 1;
+    }
+    m_samples = malloc(allocs * sizeof(m_samples[0]));
+    if (NULL == m_samples) {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    printf("POOL,mode,allocs,p50_ns,p90_ns,p99_ns,p999_ns,max_ns\n");
+    for (Mode_t mode = Mode_Timer; mode <= Mode_HeapBusy; mode++) {
+        MeasureMode(mode, allocs);
+    }
+    free(m_samples);
+
+    printf("CHECK,test,allocs,drops,double_handouts,corrupt,result\n");
+    success = CheckExhaustion() && success;
+    success = CheckThreads(threadAllocs) && success;
+    return success ? 0 : 2;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                      GLUE AND LWIP FOR THE HOST                      */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+struct pbuf *pbuf_alloced_custom(pbuf_layer l, uint16_t length, pbuf_type type, struct pbuf_custom *p, void *payload_mem, uint16_t payload_mem_len)
+{
+    (void)l;
+    (void)type;
+    if ((NULL == p) || (length > payload_mem_len)) {
+        return NULL;
+    }
+    p->pbuf.next = NULL;
+    p->pbuf.payload = payload_mem;
+    p->pbuf.tot_len = length;
+    p->pbuf.len = length;
+    p->pbuf.ref = 1u;
+    return &p->pbuf;
+}
+
+uint8_t pbuf_free(struct pbuf *p)
+{
+    uint8_t count = 0u;
+
+    /* Only custom pbufs of the pool reach this, released like lwIP does: down the chain until a pbuf is still referenced */
+    while (NULL != p) {
+        struct pbuf *next = p->next;
+        if (0u != --p->ref) {
+            break;
+        }
+        ((struct pbuf_custom *)p)->custom_free_function(p);
+        count++;
+        p = next;
+    }
+    return count;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  PRIVATE FUNCTION IMPLEMENTATIONS                    */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t Random(void)
+{
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return m_seed;
+}
+
+static void MeasureMode(Mode_t mode, uint32_t allocs)
+{
+    static const char *const modeNames[] = { "timer", "pool", "heap", "heap_busy" };
+    void *inFlight[POOL_IN_FLIGHT + 1u] = { NULL };
+    uint32_t head = 0u;
+    uint32_t failed = 0u;
+
+    m_seed = 1u;
+    for (uint32_t i = 0u; i < allocs; i++) {
+        uint64_t start;
+        void *p;
+
+        /* lwIP releases the oldest frame, the other POOL_IN_FLIGHT ones are still held when the next one starts */
+        FreeFrame(mode, inFlight[head]);
+        if (Mode_HeapBusy == mode) {
+            BusyHeap();
+        }
+        start = NowNs();
+        p = AllocFrame(mode);
+        m_samples[i] = (uint32_t)(NowNs() - start);
+        if ((NULL == p) && (Mode_Timer != mode)) {
+            failed++;
+        }
+        inFlight[head] = p;
+        head = (head + 1u) % (POOL_IN_FLIGHT + 1u);
+    }
+    for (uint32_t i = 0u; i < (POOL_IN_FLIGHT + 1u); i++) {
+        FreeFrame(mode, inFlight[i]);
+    }
+    for (uint32_t i = 0u; i < POOL_BUSY_SLOTS; i++) {
+        free(m_busy[i]);
+        m_busy[i] = NULL;
+    }
+
+    qsort(m_samples, allocs, sizeof(m_samples[0]), CompareSamples);
+    printf("POOL,%s,%u,%u,%u,%u,%u,%u\n", modeNames[mode], allocs - failed,
+           m_samples[(uint64_t)allocs * 50u / 100u],
+           m_samples[(uint64_t)allocs * 90u / 100u],
+           m_samples[(uint64_t)allocs * 99u / 100u],
+           m_samples[(uint64_t)allocs * 999u / 1000u],
+           m_samples[allocs - 1u]);
+}
+
+static void *AllocFrame(Mode_t mode)
+{
+    struct pbuf *p = NULL;
+
+    switch (mode) {
+        case Mode_Pool:
+            p = RxPoolAlloc();
+            break;
+        case Mode_Heap:
+        case Mode_HeapBusy:
+            p = malloc(sizeof(struct pbuf) + RX_POOL_BUF_SIZE);
+            if (NULL != p) {
+                p->next = NULL;
+                p->payload = (uint8_t *)p + sizeof(struct pbuf);
+                p->tot_len = RX_POOL_BUF_SIZE;
+                p->len = RX_POOL_BUF_SIZE;
+                p->ref = 1u;
+            }
+            break;
+        default:
+            break;
+    }
+    return p;
+}
+
+static void FreeFrame(Mode_t mode, void *p)
+{
+    if (NULL == p) {
+        return;
+    }
+    if (Mode_Pool == mode) {
+        (void)pbuf_free(p);
+    } else {
+        free(p);
+    }
+}
+
+static void BusyHeap(void)
+{
+    uint32_t slot = Random() % POOL_BUSY_SLOTS;
+
+    free(m_busy[slot]);
+    m_busy[slot] = malloc(POOL_BUSY_MIN + (Random() % (POOL_BUSY_MAX - POOL_BUSY_MIN)));
+}
+
+static int CompareSamples(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static bool CheckExhaustion(void)
+{
+    struct pbuf *held[RX_PBUF_POOL_SIZE];
+    uint32_t drops = RxPoolGetDrops();
+    uint32_t allocs = 0u;
+    uint32_t doubles = 0u;
+    bool ok;
+
+    for (uint32_t i = 0u; i < RX_PBUF_POOL_SIZE; i++) {
+        held[i] = RxPoolAlloc();
+        if (NULL != held[i]) {
+            allocs++;
+            for (uint32_t k = 0u; k < i; k++) {
+                doubles += (held[k] == held[i]) ? 1u : 0u;
+            }
+        }
+    }
+    /* The pool is empty now: the next frame start is a counted drop, not a failure of somebody else */
+    ok = (NULL == RxPoolAlloc()) && ((drops + 1u) == RxPoolGetDrops());
+    for (uint32_t i = 0u; i < RX_PBUF_POOL_SIZE; i++) {
+        if (NULL != held[i]) {
+            (void)pbuf_free(held[i]);
+        }
+    }
+    /* Every buffer went back, the whole pool can be taken again */
+    for (uint32_t i = 0u; i < RX_PBUF_POOL_SIZE; i++) {
+        held[i] = RxPoolAlloc();
+        ok = ok && (NULL != held[i]);
+    }
+    for (uint32_t i = 0u; i < RX_PBUF_POOL_SIZE; i++) {
+        if (NULL != held[i]) {
+            (void)pbuf_free(held[i]);
+        }
+    }
+    ok = ok && (RX_PBUF_POOL_SIZE == allocs) && (0u == doubles) && ((drops + 1u) == RxPoolGetDrops());
+    printf("CHECK,exhaustion,%u,%u,%u,0,%s\n", allocs, RxPoolGetDrops() - drops, doubles, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static bool CheckThreads(uint32_t allocs)
+{
+    pthread_t threads[POOL_CONSUMERS];
+    uint32_t drops = RxPoolGetDrops();
+    uint32_t doubles = 0u;
+    uint32_t corrupt = 0u;
+    uint32_t released = 0u;
+    uint32_t available = 0u;
+    bool ok = true;
+
+    memset(m_ring, 0, sizeof(m_ring));
+    memset(m_known, 0, sizeof(m_known));
+    memset(m_inUse, 0, sizeof(m_inUse));
+    for (uint32_t c = 0u; c < POOL_CONSUMERS; c++) {
+        if (0 != pthread_create(&threads[c], NULL, ReleaseThread, &m_ring[c])) {
+            printf("pthread_create failed\n");
+            return false;
+        }
+    }
+
+    /* This thread plays the SPI completion context, the release threads RxTask and lwIP */
+    for (uint32_t i = 0u; i < allocs; i++) {
+        Ring_t *ring = &m_ring[i % POOL_CONSUMERS];
+        struct pbuf *p;
+        uint32_t slot = 0u;
+
+        while (NULL == (p = RxPoolAlloc())) {
+            sched_yield();
+        }
+        while ((slot < RX_PBUF_POOL_SIZE) && (NULL != m_known[slot]) && (p != m_known[slot])) {
+            slot++;
+        }
+        if (slot >= RX_PBUF_POOL_SIZE) {
+            doubles++;                              /* More distinct buffers than the pool holds */
+            slot = 0u;
+        } else if (NULL == m_known[slot]) {
+            m_known[slot] = p;
+        }
+        if (0u != __atomic_exchange_n(&m_inUse[slot], 1u, __ATOMIC_ACQ_REL)) {
+            doubles++;
+        }
+        memcpy(p->payload, &i, sizeof(i));
+        memset((uint8_t *)p->payload + sizeof(i), (uint8_t)i, RX_POOL_BUF_SIZE - sizeof(i));
+        while ((__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - ring->tail) >= POOL_RING_SIZE) {
+            sched_yield();
+        }
+        ring->entry[ring->tail % POOL_RING_SIZE] = p;
+        __atomic_store_n(&ring->tail, ring->tail + 1u, __ATOMIC_RELEASE);
+    }
+    for (uint32_t c = 0u; c < POOL_CONSUMERS; c++) {
+        Ring_t *ring = &m_ring[c];
+        while ((__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - ring->tail) >= POOL_RING_SIZE) {
+            sched_yield();
+        }
+        ring->entry[ring->tail % POOL_RING_SIZE] = NULL;
+        __atomic_store_n(&ring->tail, ring->tail + 1u, __ATOMIC_RELEASE);
+    }
+    for (uint32_t c = 0u; c < POOL_CONSUMERS; c++) {
+        (void)pthread_join(threads[c], NULL);
+        released += m_ring[c].released;
+        corrupt += m_ring[c].corrupt;
+    }
+
+    /* All buffers are back in the pool */
+    {
+        struct pbuf *held[RX_PBUF_POOL_SIZE];
+        for (uint32_t i = 0u; i < RX_PBUF_POOL_SIZE; i++) {
+            held[i] = RxPoolAlloc();
+            available += (NULL != held[i]) ? 1u : 0u;
+        }
+        for (uint32_t i = 0u; i < RX_PBUF_POOL_SIZE; i++) {
+            if (NULL != held[i]) {
+                (void)pbuf_free(held[i]);
+            }
+        }
+    }
+
+    ok = (released == allocs) && (0u == doubles) && (0u == corrupt) && (RX_PBUF_POOL_SIZE == available);
+    printf("CHECK,threads,%u,%u,%u,%u,%s\n", released, RxPoolGetDrops() - drops, doubles, corrupt, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static void *ReleaseThread(void *arg)
+{
+    Ring_t *ring = arg;
+
+    for (;;) {
+        struct pbuf *p;
+        uint32_t seq;
+        uint32_t slot = 0u;
+
+        while (__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == ring->head) {
+            sched_yield();
+        }
+        p = ring->entry[ring->head % POOL_RING_SIZE];
+        __atomic_store_n(&ring->head, ring->head + 1u, __ATOMIC_RELEASE);
+        if (NULL == p) {
+            break;
+        }
+        /* A buffer handed out twice would have been overwritten by the next frame */
+        memcpy(&seq, p->payload, sizeof(seq));
+        for (uint32_t i = sizeof(seq); i < RX_POOL_BUF_SIZE; i++) {
+            if (((uint8_t *)p->payload)[i] != (uint8_t)seq) {
+                ring->corrupt++;
+                break;
+            }
+        }
+        while ((slot < RX_PBUF_POOL_SIZE) && (p != m_known[slot])) {
+            slot++;
+        }
+        if (slot < RX_PBUF_POOL_SIZE) {
+            __atomic_store_n(&m_inUse[slot], 0u, __ATOMIC_RELEASE);
+        }
+        ring->released++;
+        (void)pbuf_free(p);
+    }
+    return NULL;
+}
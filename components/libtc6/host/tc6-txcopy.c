@@ -0,0 +1,554 @@
+/*******************************************************************************
+  Host TX Copy Count for libtc6
+
+  File Name:
+    tc6-txcopy.c
+
+  Summary:
+    Counts the bytes the ESP32 glue copies per sent frame
+
+  Description:
+    Builds main/txframe.c unchanged against the headers in host/glue and
+    sends frames from node 0 to node 1 of an emulated 10BASE-T1S segment
+    (see sim/tc6sim.h). Every frame is a pbuf chain shaped like the ones
+    of lwIP: the Ethernet, IPv4 and UDP headers in the first pbuf, the
+    payload spread over the other ones (-g pbufs per frame, repeatable).
+    The frames are handed to libtc6 once the former way, copied into one
+    frame buffer and sent as a single segment ("copy"), and once with
+    TxFrameSegments() as SyncTask does it, the pbufs themselves being the
+    segments and released in the TX callback ("segments"). A chain of
+    more than TC6_TX_ETH_MAX_SEGMENTS pbufs is flattened by pbuf_clone(),
+    the only copy left in the glue. Prints the bytes copied by the glue
+    per frame, the flattened frames and the host time spent in the glue
+    per frame (prefix "TXCOPY", the copy of libtc6 into the SPI chunks is
+    the same for both and not counted). The receiver checks order and
+    content of every frame and the pbufs are counted (prefix "CHECK",
+    exit code 2 on a failure).
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "tc6.h"
+#include "tc6-regs.h"
+#include "tc6sim.h"
+#include "lwip/pbuf.h"
+#include "txframe.h"
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                            DEFINITIONS                               */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+#define COPY_MAGIC              (0x54584350u)
+#define COPY_HEADER_LEN         (42u)           /* Ethernet, IPv4 and UDP header, the first pbuf of a chain */
+#define COPY_STAMP_OFFSET       (COPY_HEADER_LEN)
+#define COPY_PATTERN_OFFSET     (COPY_STAMP_OFFSET + 8u)
+#define COPY_FCS_LEN            (4u)
+#define COPY_MIN_FRAME          (60u)
+#define COPY_MAX_FRAME          (1514u)
+#define COPY_MAX_SHAPES         (8u)
+#define COPY_MAX_PBUFS          (32u)
+#define COPY_STEP_BITS          (100u)
+#define COPY_DRAIN_BITS         (1000000u)
+#define COPY_BITS_PER_US        (10u)
+
+typedef enum
+{
+    Mode_Copy,
+    Mode_Segments
+} Mode_t;
+
+typedef struct
+{
+    uint32_t received;
+    uint32_t nextSeq;
+    uint32_t misordered;
+    uint32_t corrupt;
+} Receiver_t;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                          PRIVATE VARIABLES                           */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static TC6Sim_Bus_t m_bus;
+static TC6_t *m_tc6[2];
+static uint8_t m_rxBuf[TC6SIM_MAX_FRAME_LEN];
+static uint8_t m_copyBuf[TC6_TX_ETH_QSIZE][COPY_MAX_FRAME];    /* Frame buffers of the former copy, one per tc6 queue entry */
+static uint8_t m_copyHead;
+static uint8_t m_copyInFlight;
+static Receiver_t m_rx;
+static uint16_t m_frameLen;
+static int32_t m_pbufs;                     /* pbufs allocated and not freed yet */
+static uint64_t m_copied;                   /* Bytes copied by the glue (former copy or pbuf_clone) */
+static uint32_t m_clones;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                      PRIVATE FUNCTION PROTOTYPES                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint64_t Now(void);
+static uint64_t NowNs(void);
+static void ServiceAll(void);
+static void RunBus(uint32_t bitTimes);
+static bool SendCopy(struct pbuf *p);
+static bool SendSegments(struct pbuf *p);
+static struct pbuf *AllocPbuf(uint16_t len);
+static struct pbuf *BuildChain(uint32_t seq, uint16_t frameLen, uint8_t pbufs);
+static void OnCopyTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag);
+static void OnSegmentsTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag);
+static void CheckFrame(const uint8_t *p, uint16_t len);
+static uint32_t Lost(void);
+static uint32_t Crc32(const uint8_t *pData, uint16_t len);
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                             MAIN                                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+int main(int argc, char *argv[])
+{
+    static const char *const modeNames[] = { "copy", "segments" };
+    static const uint16_t defaultSizes[] = { 60u, 590u, 1514u };
+    static const uint8_t defaultShapes[] = { 1u, 2u, 3u, TC6_TX_ETH_MAX_SEGMENTS + 1u };
+    uint16_t sizes[COPY_MAX_SHAPES];
+    uint8_t shapes[COPY_MAX_SHAPES];
+    uint8_t sizeCount = 0u;
+    uint8_t shapeCount = 0u;
+    uint32_t frames = 2000u;
+    bool success = true;
+    bool checked = true;
+    TC6Sim_BusConfig_t cfg = { .toTimerBits = 32u, .beaconBits = 20u, .spiClockHz = 0u, .seed = 1u };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:s:g:h")) != -1) {
+        switch (opt) {
+            case 'f':
+                frames = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                if (sizeCount < COPY_MAX_SHAPES) {
+                    sizes[sizeCount++] = (uint16_t)atoi(optarg);
+                }
+                break;
+            case 'g':
+                if (shapeCount < COPY_MAX_SHAPES) {
+                    shapes[shapeCount++] = (uint8_t)atoi(optarg);
+                }
+                break;
+            default:
+                printf("usage: %s [-f frames] [-s frame length without FCS]... [-g pbufs per frame]...\n", argv[0]);
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+    if (0u == sizeCount) {
+        memcpy(sizes, defaultSizes, sizeof(defaultSizes));
+        sizeCount = (uint8_t)(sizeof(defaultSizes) / sizeof(defaultSizes[0]));
+    }
+    if (0u == shapeCount) {
+        memcpy(shapes, defaultShapes, sizeof(defaultShapes));
+        shapeCount = (uint8_t)(sizeof(defaultShapes) / sizeof(defaultShapes[0]));
+    }
+    for (uint8_t i = 0u; i < sizeCount; i++) {
+        if ((sizes[i] < COPY_MIN_FRAME) || (sizes[i] > COPY_MAX_FRAME)) {
+            printf("frame length must be %u..%u\n", COPY_MIN_FRAME, COPY_MAX_FRAME);
+            return 1;
+        }
+    }
+    for (uint8_t i = 0u; i < shapeCount; i++) {
+        if ((shapes[i] < 1u) || (shapes[i] > COPY_MAX_PBUFS) || ((COPY_HEADER_LEN + shapes[i]) > COPY_MIN_FRAME)) {
+            printf("pbufs per frame must be 1..%u\n", COPY_MIN_FRAME - COPY_HEADER_LEN);
+            return 1;
+        }
+    }
+
+    TC6Sim_BusInit(&m_bus, &cfg);
+    TC6Sim_PortAttach(&m_bus);
+    for (uint8_t i = 0u; success && (i < 2u); i++) {
+        uint8_t mac[6] = { 0x00u, 0x04u, 0xA3u, 0x12u, 0x00u, i };
+        (void)TC6Sim_AddNode(&m_bus, i);
+        m_tc6[i] = TC6_Init(NULL);
+        success = (NULL != m_tc6[i]) && TC6Regs_Init(m_tc6[i], NULL, mac, false, i, 2u, 0u, 0x80u, false, false, false);
+    }
+    for (uint32_t k = 0u; success && (k < (100000u * COPY_BITS_PER_US / COPY_STEP_BITS)); k++) {
+        ServiceAll();
+        RunBus(COPY_STEP_BITS);
+    }
+    for (uint8_t i = 0u; success && (i < 2u); i++) {
+        success = TC6Regs_GetInitDone(m_tc6[i]);
+    }
+    if (!success) {
+        printf("initialization failed\n");
+        return 1;
+    }
+    for (uint8_t i = 0u; i < 2u; i++) {
+        TC6_EnableData(m_tc6[i], true);
+    }
+
+    printf("TXCOPY,mode,pbufs,frame_len,frames,copied_bytes_per_frame,flattened,glue_ns_per_frame\n");
+    printf("CHECK,mode,pbufs,frame_len,sent,received,lost,misordered,corrupt,pbufs_left,result\n");
+    for (uint8_t s = 0u; s < sizeCount; s++) {
+        for (uint8_t g = 0u; g < shapeCount; g++) {
+            for (uint8_t mode = Mode_Copy; mode <= Mode_Segments; mode++) {
+                struct pbuf *p = NULL;
+                uint32_t seq = 0u;
+                uint32_t lost = Lost();
+                uint64_t glueNs = 0u;
+                bool ok;
+
+                memset(&m_rx, 0, sizeof(m_rx));
+                m_frameLen = sizes[s];
+                m_copied = 0u;
+                m_clones = 0u;
+                while (seq < frames) {
+                    /* lwIP: the next frame is offered until SyncTask has space for it in the tc6 queue */
+                    if (NULL == p) {
+                        p = BuildChain(seq, sizes[s], shapes[g]);
+                    }
+                    while ((NULL != p) && (seq < frames)) {
+                        uint64_t start = NowNs();
+                        bool sent = (Mode_Copy == mode) ? SendCopy(p) : SendSegments(p);
+                        glueNs += NowNs() - start;
+                        if (!sent) {
+                            break;
+                        }
+                        seq++;
+                        p = (seq < frames) ? BuildChain(seq, sizes[s], shapes[g]) : NULL;
+                    }
+                    ServiceAll();
+                    RunBus(COPY_STEP_BITS);
+                }
+                if (NULL != p) {
+                    (void)pbuf_free(p);
+                }
+                for (uint32_t waited = 0u; waited < COPY_DRAIN_BITS; waited += COPY_STEP_BITS) {
+                    if (((m_rx.received + m_rx.corrupt + (Lost() - lost)) >= seq) && (0 == m_pbufs) && (0u == m_copyInFlight)) {
+                        break;
+                    }
+                    ServiceAll();
+                    RunBus(COPY_STEP_BITS);
+                }
+
+                lost = Lost() - lost;
+                printf("TXCOPY,%s,%u,%u,%u,%llu,%u,%llu\n", modeNames[mode], shapes[g], sizes[s], seq,
+                       (unsigned long long)(seq ? (m_copied / seq) : 0u), m_clones,
+                       (unsigned long long)(seq ? (glueNs / seq) : 0u));
+                ok = ((m_rx.received + lost) == seq) && (0u == m_rx.misordered) && (0u == m_rx.corrupt) && (0 == m_pbufs);
+                checked = checked && ok;
+                printf("CHECK,%s,%u,%u,%u,%u,%u,%u,%u,%d,%s\n", modeNames[mode], shapes[g], sizes[s], seq, m_rx.received,
+                       lost, m_rx.misordered, m_rx.corrupt, (int)m_pbufs, ok ? "ok" : "FAIL");
+            }
+        }
+    }
+    return checked ? 0 : 2;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                     GLUE AND LWIP FOR THE HOST                       */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+void pbuf_ref(struct pbuf *p)
+{
+    p->ref++;
+}
+
+uint8_t pbuf_free(struct pbuf *p)
+{
+    uint8_t count = 0u;
+
+    /* Like lwIP: the chain is released up to the first pbuf still referenced elsewhere */
+    while ((NULL != p) && (0u == --p->ref)) {
+        struct pbuf *next = p->next;
+        free(p);
+        m_pbufs--;
+        count++;
+        p = next;
+    }
+    return count;
+}
+
+uint16_t pbuf_clen(const struct pbuf *p)
+{
+    uint16_t len = 0u;
+    for (; NULL != p; p = p->next) {
+        len++;
+    }
+    return len;
+}
+
+struct pbuf *pbuf_clone(pbuf_layer layer, pbuf_type type, struct pbuf *p)
+{
+    struct pbuf *flat = AllocPbuf(p->tot_len);
+    uint16_t offset = 0u;
+
+    (void)layer;
+    (void)type;
+    for (; NULL != p; p = p->next) {
+        memcpy((uint8_t *)flat->payload + offset, p->payload, p->len);
+        offset = (uint16_t)(offset + p->len);
+    }
+    m_copied += offset;
+    m_clones++;
+    return flat;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  CALLBACK FUNCTIONS FROM TC6 STACK                   */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+void TC6_CB_OnNeedService(TC6_t *pInst, void *pGlobalTag)
+{
+    (void)pInst;
+    (void)pGlobalTag;
+}
+
+void TC6_CB_OnRxEthernetSlice(TC6_t *pInst, const uint8_t *pRx, uint16_t offset, uint16_t len, void *pGlobalTag)
+{
+    (void)pGlobalTag;
+    if ((1u == TC6_GetInstance(pInst)) && (((uint32_t)offset + len) <= sizeof(m_rxBuf))) {
+        memcpy(&m_rxBuf[offset], pRx, len);
+    }
+}
+
+void TC6_CB_OnRxEthernetPacket(TC6_t *pInst, bool success, uint16_t len, uint64_t *rxTimestamp, void *pGlobalTag)
+{
+    (void)rxTimestamp;
+    (void)pGlobalTag;
+    if (success && (1u == TC6_GetInstance(pInst)) && (len <= sizeof(m_rxBuf))) {
+        CheckFrame(m_rxBuf, len);
+    }
+}
+
+void TC6_CB_OnError(TC6_t *pInst, TC6_Error_t err, void *pGlobalTag)
+{
+    (void)pGlobalTag;
+    printf("node %u: error %d\n", TC6_GetInstance(pInst), (int)err);
+}
+
+uint32_t TC6Regs_CB_GetTicksMs(void)
+{
+    return (uint32_t)(Now() / (1000u * COPY_BITS_PER_US));
+}
+
+void TC6Regs_CB_OnEvent(TC6_t *pInst, TC6Regs_Event_t event, void *pTag)
+{
+    (void)pInst;
+    (void)event;
+    (void)pTag;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  PRIVATE FUNCTION IMPLEMENTATIONS                    */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint64_t Now(void)
+{
+    TC6Sim_BusStats_t bus;
+    TC6Sim_GetBusStats(&m_bus, &bus);
+    return bus.now;
+}
+
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+static void ServiceAll(void)
+{
+    for (uint8_t i = 0u; i < 2u; i++) {
+        TC6_Service(m_tc6[i], !TC6Sim_IrqAsserted(TC6Sim_GetNode(&m_bus, i)));
+    }
+}
+
+static void RunBus(uint32_t bitTimes)
+{
+    uint32_t before = TC6Regs_CB_GetTicksMs();
+    TC6Sim_BusRun(&m_bus, bitTimes);
+    if (TC6Regs_CB_GetTicksMs() != before) {
+        TC6Regs_CheckTimers();
+    }
+}
+
+static bool SendCopy(struct pbuf *p)
+{
+    TC6_RawTxSegment *seg;
+    uint8_t *frame;
+    uint16_t offset = 0u;
+
+    /* The former low_level_output: the chain is copied into one buffer and released, libtc6 reads the buffer later */
+    if ((m_copyInFlight >= TC6_TX_ETH_QSIZE) || (0u == TC6_GetRawSegments(m_tc6[0], &seg))) {
+        return false;
+    }
+    frame = m_copyBuf[m_copyHead];
+    for (struct pbuf *q = p; NULL != q; q = q->next) {
+        memcpy(&frame[offset], q->payload, q->len);
+        offset = (uint16_t)(offset + q->len);
+    }
+    m_copied += offset;
+    seg[0].pEth = frame;
+    seg[0].segLen = offset;
+    if (!TC6_SendRawEthernetSegments(m_tc6[0], seg, 1u, offset, 0u, OnCopyTxDone, NULL)) {
+        return false;
+    }
+    m_copyHead = (uint8_t)((m_copyHead + 1u) % TC6_TX_ETH_QSIZE);
+    m_copyInFlight++;
+    (void)pbuf_free(p);
+    return true;
+}
+
+static bool SendSegments(struct pbuf *p)
+{
+    TC6_RawTxSegment *seg;
+    uint8_t maxSegments = TC6_GetRawSegments(m_tc6[0], &seg);
+    uint8_t count;
+
+    /* EthernetTxService: the reference of lwIP is held until OnSegmentsTxDone */
+    if (0u == maxSegments) {
+        return false;
+    }
+    count = TxFrameSegments(&p, seg, maxSegments);
+    if ((0u == count) || !TC6_SendRawEthernetSegments(m_tc6[0], seg, count, p->tot_len, 0u, OnSegmentsTxDone, p)) {
+        printf("frame not sent\n");
+        if (NULL != p) {
+            (void)pbuf_free(p);
+        }
+    }
+    return true;
+}
+
+static struct pbuf *AllocPbuf(uint16_t len)
+{
+    struct pbuf *p = (struct pbuf *)malloc(sizeof(struct pbuf) + len);
+
+    p->next = NULL;
+    p->payload = &p[1];
+    p->tot_len = len;
+    p->len = len;
+    p->ref = 1u;
+    m_pbufs++;
+    return p;
+}
+
+static struct pbuf *BuildChain(uint32_t seq, uint16_t frameLen, uint8_t pbufs)
+{
+    uint8_t frame[COPY_MAX_FRAME];
+    uint32_t magic = COPY_MAGIC;
+    struct pbuf *head = NULL;
+    struct pbuf *tail = NULL;
+    uint16_t offset = 0u;
+
+    frame[0] = 0x00u; frame[1] = 0x04u; frame[2] = 0xA3u; frame[3] = 0x12u; frame[4] = 0x00u; frame[5] = 0x01u;
+    frame[6] = 0x00u; frame[7] = 0x04u; frame[8] = 0xA3u; frame[9] = 0x12u; frame[10] = 0x00u; frame[11] = 0x00u;
+    frame[12] = 0x08u;
+    frame[13] = 0x00u;
+    memset(&frame[14], 0, COPY_HEADER_LEN - 14u);
+    memcpy(&frame[COPY_STAMP_OFFSET], &magic, sizeof(magic));
+    memcpy(&frame[COPY_STAMP_OFFSET + 4u], &seq, sizeof(seq));
+    for (uint16_t i = COPY_PATTERN_OFFSET; i < frameLen; i++) {
+        frame[i] = (uint8_t)(seq + i);
+    }
+
+    /* Headers in the first pbuf, the payload split evenly over the others (pbuf_cat(), the head owns the chain) */
+    for (uint8_t i = 0u; i < pbufs; i++) {
+        uint16_t len;
+        struct pbuf *q;
+
+        if (1u == pbufs) {
+            len = frameLen;
+        } else if (0u == i) {
+            len = COPY_HEADER_LEN;
+        } else {
+            uint16_t rest = (uint16_t)(frameLen - offset);
+            len = (uint16_t)(rest / (uint8_t)(pbufs - i));
+        }
+        q = AllocPbuf(len);
+        memcpy(q->payload, &frame[offset], len);
+        q->tot_len = (uint16_t)(frameLen - offset);
+        offset = (uint16_t)(offset + len);
+        if (NULL == head) {
+            head = q;
+        } else {
+            tail->next = q;
+        }
+        tail = q;
+    }
+    return head;
+}
+
+static void OnCopyTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag)
+{
+    (void)pInst;
+    (void)pTx;
+    (void)len;
+    (void)pTag;
+    (void)pGlobalTag;
+    if (m_copyInFlight > 0u) {
+        m_copyInFlight--;
+    }
+}
+
+static void OnSegmentsTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag)
+{
+    (void)pInst;
+    (void)pTx;
+    (void)len;
+    (void)pGlobalTag;
+    (void)pbuf_free((struct pbuf *)pTag);
+}
+
+static void CheckFrame(const uint8_t *p, uint16_t len)
+{
+    uint32_t magic = 0u;
+    uint32_t seq = 0u;
+    bool valid = (len == (m_frameLen + COPY_FCS_LEN));
+
+    if (valid) {
+        memcpy(&magic, &p[COPY_STAMP_OFFSET], sizeof(magic));
+        memcpy(&seq, &p[COPY_STAMP_OFFSET + 4u], sizeof(seq));
+        valid = (COPY_MAGIC == magic);
+    }
+    for (uint16_t i = COPY_PATTERN_OFFSET; valid && (i < m_frameLen); i++) {
+        valid = (p[i] == (uint8_t)(seq + i));
+    }
+    if (valid) {
+        const uint8_t *f = &p[m_frameLen];
+        valid = (Crc32(p, m_frameLen) == ((uint32_t)f[0] | ((uint32_t)f[1] << 8) | ((uint32_t)f[2] << 16) | ((uint32_t)f[3] << 24)));
+    }
+    if (!valid) {
+        m_rx.corrupt++;
+        return;
+    }
+    /* Gaps are frames lost on the segment (see Lost()) */
+    if (seq < m_rx.nextSeq) {
+        m_rx.misordered++;
+    }
+    m_rx.nextSeq = seq + 1u;
+    m_rx.received++;
+}
+
+static uint32_t Lost(void)
+{
+    TC6Sim_NodeStats_t sender;
+    TC6Sim_NodeStats_t receiver;
+
+    /* Frames of node 0 given up after too many collisions or dropped by a full buffer */
+    TC6Sim_GetNodeStats(TC6Sim_GetNode(&m_bus, 0u), &sender);
+    TC6Sim_GetNodeStats(TC6Sim_GetNode(&m_bus, 1u), &receiver);
+    return sender.txAborts + sender.txDrops + receiver.rxDrops;
+}
+
+static uint32_t Crc32(const uint8_t *pData, uint16_t len)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    for (uint16_t i = 0u; i < len; i++) {
+        crc ^= pData[i];
+        for (uint8_t b = 0u; b < 8u; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
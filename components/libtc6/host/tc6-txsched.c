@@ -0,0 +1,570 @@
+/*******************************************************************************
+  Host TX Scheduler Evaluation for libtc6
+
+  File Name:
+    tc6-txsched.c
+
+  Summary:
+    Runs the TX scheduler of the ESP32 glue on an emulated PLCA segment
+
+  Description:
+    Builds main/txsched.c unchanged against the headers in host/glue and
+    drives node 0 of an emulated 10BASE-T1S segment (see sim/tc6sim.h) with
+    it, the other nodes keep their TX queues filled with full size frames.
+    The host program plays lwIP and SyncTask: bulk frames (class 0) are
+    offered as fast as the scheduler takes them, a prioritized frame
+    (class 1, IPv4 DSCP EF) every period, and each service loop calls
+    TxSchedService() before TC6_Service() like SyncTask does. The same
+    traffic runs once through a plain FIFO in front of the tc6 queue
+    (EthernetTxService without scheduler) and once through the scheduler.
+    Prints the latency of the prioritized frames from lwIP to the receiver
+    and the bulk frame rate (prefix "TXSCHED"); the receiver checks both
+    classes for order and content, every frame not received has to be
+    an abort or overrun of the emulator, and the pbuf references are
+    counted (prefix "CHECK", exit code 2 on a failure).
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tc6.h"
+#include "tc6-regs.h"
+#include "tc6sim.h"
+#include "lwip/pbuf.h"
+#include "lan8651.h"
+#include "txsched.h"
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                            DEFINITIONS                               */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+#define SCHED_MAGIC             (0x54585343u)
+#define SCHED_HEADER_LEN        (14u)
+#define SCHED_FCS_LEN           (4u)
+#define SCHED_STAMP_OFFSET      (SCHED_HEADER_LEN + 4u)     /* After the first IPv4 header word (version, TOS, length) */
+#define SCHED_PATTERN_OFFSET    (SCHED_STAMP_OFFSET + 16u)
+#define SCHED_BULK_LEN          (1514u)
+#define SCHED_PRIO_LEN          (128u)
+#define SCHED_TOS_EF            (0xB8u)                     /* DSCP 46, class 1 in ClassifyFrame() */
+#define SCHED_FIFO_LEN          (2u * TX_SCHED_QUEUE_LEN)   /* Frames of the plain FIFO, same as both class queues */
+#define SCHED_MAX_PRIO          (20000u)
+#define SCHED_STEP_BITS         (100u)
+#define SCHED_DRAIN_BITS        (1000000u)
+#define SCHED_BITS_PER_US       (10u)
+
+typedef enum
+{
+    Mode_Fifo,
+    Mode_Sched
+} Mode_t;
+
+typedef struct
+{
+    uint8_t rxBuf[TC6SIM_MAX_FRAME_LEN];
+    uint8_t txFrame[TC6_TX_ETH_QSIZE][SCHED_BULK_LEN];
+    uint8_t txHead;
+    uint8_t txInFlight;
+} Node_t;
+
+typedef struct
+{
+    uint32_t received[TX_SCHED_CLASSES];
+    uint32_t nextSeq[TX_SCHED_CLASSES];
+    uint32_t misordered;
+    uint32_t corrupt;
+    uint32_t latency[SCHED_MAX_PRIO];
+    uint32_t latencyCount;
+} Receiver_t;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                          PRIVATE VARIABLES                           */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+TC6_t *tc6_instance[LAN8651_COUNT];
+
+static TC6Sim_Bus_t m_bus;
+static TC6_t *m_tc6[TC6_MAX_INSTANCES];
+static Node_t m_node[TC6_MAX_INSTANCES];
+static Receiver_t m_rx;
+static uint8_t m_nodeCount = 4u;
+static Mode_t m_mode;
+static int32_t m_pbufs;                     /* pbufs allocated and not freed yet */
+static struct pbuf *m_fifo[SCHED_FIFO_LEN];
+static uint32_t m_fifoHead;
+static uint32_t m_fifoTail;
+static uint32_t m_fifoWaits;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                      PRIVATE FUNCTION PROTOTYPES                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint64_t Now(void);
+static void ServiceLoop(void);
+static void RunBus(uint32_t bitTimes);
+static bool Offer(struct pbuf *p);
+static void FifoService(void);
+static struct pbuf *BuildFrame(uint8_t trafficClass, uint32_t seq);
+static void FillBackground(uint8_t idx);
+static void OnFifoTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag);
+static void OnBackgroundTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag);
+static void CheckFrame(const uint8_t *p, uint16_t len);
+static uint32_t Lost(void);
+static uint32_t Crc32(const uint8_t *pData, uint16_t len);
+static int CompareLatency(const void *a, const void *b);
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                             MAIN                                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+int main(int argc, char *argv[])
+{
+    static const char *const modeNames[] = { "fifo", "sched" };
+    uint32_t durationMs = 500u;
+    uint32_t periodUs = 10000u;
+    uint8_t burstCount = 0u;
+    bool plca = true;
+    bool success = true;
+    bool checked = true;
+    TC6Sim_BusConfig_t cfg = { .toTimerBits = 32u, .beaconBits = 20u, .spiClockHz = 0u, .seed = 1u };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:d:i:b:c:xh")) != -1) {
+        switch (opt) {
+            case 'n':
+                m_nodeCount = (uint8_t)atoi(optarg);
+                break;
+            case 'd':
+                durationMs = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'i':
+                periodUs = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'b':
+                burstCount = (uint8_t)atoi(optarg);
+                break;
+            case 'c':
+                cfg.spiClockHz = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'x':
+                plca = false;
+                break;
+            default:
+                printf("usage: %s [-n nodes] [-d duration ms] [-i prioritized frame period us] [-b burst count] [-c spi clock Hz] [-x (CSMA/CD)]\n", argv[0]);
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+    if ((m_nodeCount < 2u) || (m_nodeCount > TC6_MAX_INSTANCES) || (0u == periodUs) || (((uint64_t)durationMs * 1000u / periodUs) > SCHED_MAX_PRIO)) {
+        printf("nodes must be 2..%u, at most %u prioritized frames\n", (unsigned)TC6_MAX_INSTANCES, SCHED_MAX_PRIO);
+        return 1;
+    }
+
+    /* Node 0 runs the scheduler (port 0 of the glue) and sends to node 1, all others send background traffic nobody receives */
+    TC6Sim_BusInit(&m_bus, &cfg);
+    TC6Sim_PortAttach(&m_bus);
+    for (uint8_t i = 0u; success && (i < m_nodeCount); i++) {
+        uint8_t mac[6] = { 0x00u, 0x04u, 0xA3u, 0x12u, 0x00u, i };
+        (void)TC6Sim_AddNode(&m_bus, i);
+        m_tc6[i] = TC6_Init(&m_node[i]);
+        success = (NULL != m_tc6[i]) && TC6Regs_Init(m_tc6[i], &m_node[i], mac, plca, i, m_nodeCount, (0u == i) ? burstCount : 0u, 0x80u, false, false, false);
+    }
+    for (uint32_t k = 0u; success && (k < (100000u * SCHED_BITS_PER_US / SCHED_STEP_BITS)); k++) {
+        for (uint8_t i = 0u; i < m_nodeCount; i++) {
+            TC6_Service(m_tc6[i], !TC6Sim_IrqAsserted(TC6Sim_GetNode(&m_bus, i)));
+        }
+        RunBus(SCHED_STEP_BITS);
+    }
+    for (uint8_t i = 0u; success && (i < m_nodeCount); i++) {
+        success = TC6Regs_GetInitDone(m_tc6[i]);
+    }
+    if (!success) {
+        printf("initialization failed\n");
+        return 1;
+    }
+    for (uint8_t i = 0u; i < m_nodeCount; i++) {
+        TC6_EnableData(m_tc6[i], true);
+    }
+    tc6_instance[0] = m_tc6[0];
+    InitTxScheduler();
+
+    printf("TXSCHED,mode,nodes,plca,burst,period_us,prio_sent,prio_p50_us,prio_p99_us,prio_max_us,bulk_fps,cycles,waits,in_flight_max,window\n");
+    printf("CHECK,mode,prio_sent,prio_received,bulk_sent,bulk_received,lost,misordered,corrupt,pbufs,result\n");
+    for (uint8_t mode = Mode_Fifo; mode <= Mode_Sched; mode++) {
+        TC6Sim_BusStats_t busStart;
+        TC6Sim_BusStats_t busEnd;
+        TxSchedStats_t stats;
+        struct pbuf *bulk = NULL;
+        uint32_t seq[TX_SCHED_CLASSES] = { 0u, 0u };
+        uint32_t bulkReceived;
+        uint32_t lost = Lost();
+        uint64_t start = Now();
+        uint64_t end = start + ((uint64_t)durationMs * 1000u * SCHED_BITS_PER_US);
+        uint64_t nextPrio = start;
+        uint32_t count;
+        bool ok;
+
+        m_mode = (Mode_t)mode;
+        memset(&m_rx, 0, sizeof(m_rx));
+        m_fifoWaits = 0u;
+        TxSchedGetStats(0u, &stats, true);
+        TC6Sim_GetBusStats(&m_bus, &busStart);
+        while (Now() < end) {
+            /* lwIP: the prioritized frame on time, bulk frames whenever there is space (ERR_MEM is retried) */
+            if (Now() >= nextPrio) {
+                struct pbuf *p = BuildFrame(1u, seq[1]);
+                if (Offer(p)) {
+                    seq[1]++;
+                }
+                (void)pbuf_free(p);
+                nextPrio += (uint64_t)periodUs * SCHED_BITS_PER_US;
+            }
+            if (NULL == bulk) {
+                bulk = BuildFrame(0u, seq[0]);
+            }
+            if (Offer(bulk)) {
+                seq[0]++;
+                (void)pbuf_free(bulk);
+                bulk = NULL;
+            }
+            ServiceLoop();
+            RunBus(SCHED_STEP_BITS);
+        }
+        if (NULL != bulk) {
+            (void)pbuf_free(bulk);
+        }
+        bulkReceived = m_rx.received[0];
+        TC6Sim_GetBusStats(&m_bus, &busEnd);
+        for (uint32_t waited = 0u; waited < SCHED_DRAIN_BITS; waited += SCHED_STEP_BITS) {
+            if (((m_rx.received[0] + m_rx.received[1] + m_rx.corrupt + (Lost() - lost)) >= (seq[0] + seq[1])) && (0 == m_pbufs)) {
+                break;
+            }
+            ServiceLoop();
+            RunBus(SCHED_STEP_BITS);
+        }
+
+        TxSchedGetStats(0u, &stats, false);
+        lost = Lost() - lost;
+        count = m_rx.latencyCount;
+        qsort(m_rx.latency, count, sizeof(uint32_t), CompareLatency);
+        printf("TXSCHED,%s,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n", modeNames[mode], m_nodeCount, plca ? 1u : 0u, burstCount, periodUs,
+               seq[1], count ? m_rx.latency[(count - 1u) * 50u / 100u] : 0u, count ? m_rx.latency[(count - 1u) * 99u / 100u] : 0u,
+               count ? m_rx.latency[count - 1u] : 0u, durationMs ? (bulkReceived * 1000u / durationMs) : 0u,
+               busEnd.cycles - busStart.cycles, (Mode_Sched == m_mode) ? stats.waits : m_fifoWaits,
+               (Mode_Sched == m_mode) ? stats.inFlightMax : 0u, (Mode_Sched == m_mode) ? stats.window : 0u);
+        ok = ((m_rx.received[0] + m_rx.received[1] + lost) == (seq[0] + seq[1])) && (0u == m_rx.misordered) && (0u == m_rx.corrupt) && (0 == m_pbufs);
+        checked = checked && ok;
+        printf("CHECK,%s,%u,%u,%u,%u,%u,%u,%u,%d,%s\n", modeNames[mode], seq[1], m_rx.received[1], seq[0], m_rx.received[0],
+               lost, m_rx.misordered, m_rx.corrupt, (int)m_pbufs, ok ? "ok" : "FAIL");
+    }
+    return checked ? 0 : 2;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                     GLUE AND LWIP FOR THE HOST                       */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+int64_t esp_timer_get_time(void)
+{
+    return (int64_t)(Now() / SCHED_BITS_PER_US);
+}
+
+void NotifySyncTask(void)
+{
+    /* The service loop runs continuously */
+}
+
+void StatsTxFrame(uint8_t instance, uint16_t length)
+{
+    (void)instance;
+    (void)length;
+}
+
+void pbuf_ref(struct pbuf *p)
+{
+    p->ref++;
+}
+
+uint8_t pbuf_free(struct pbuf *p)
+{
+    if (--p->ref == 0u) {
+        free(p);
+        m_pbufs--;
+        return 1u;
+    }
+    return 0u;
+}
+
+uint16_t pbuf_clen(const struct pbuf *p)
+{
+    uint16_t len = 0u;
+    for (; NULL != p; p = p->next) {
+        len++;
+    }
+    return len;
+}
+
+struct pbuf *pbuf_clone(pbuf_layer layer, pbuf_type type, struct pbuf *p)
+{
+    /* The host program builds single pbufs, the glue only clones chains */
+    (void)layer;
+    (void)type;
+    (void)p;
+    return NULL;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  CALLBACK FUNCTIONS FROM TC6 STACK                   */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+void TC6_CB_OnNeedService(TC6_t *pInst, void *pGlobalTag)
+{
+    (void)pInst;
+    (void)pGlobalTag;
+}
+
+void TC6_CB_OnRxEthernetSlice(TC6_t *pInst, const uint8_t *pRx, uint16_t offset, uint16_t len, void *pGlobalTag)
+{
+    Node_t *node = (Node_t *)pGlobalTag;
+    (void)pInst;
+    if (((uint32_t)offset + len) <= sizeof(node->rxBuf)) {
+        memcpy(&node->rxBuf[offset], pRx, len);
+    }
+}
+
+void TC6_CB_OnRxEthernetPacket(TC6_t *pInst, bool success, uint16_t len, uint64_t *rxTimestamp, void *pGlobalTag)
+{
+    Node_t *node = (Node_t *)pGlobalTag;
+    (void)rxTimestamp;
+    if (success && (1u == TC6_GetInstance(pInst)) && (len <= sizeof(node->rxBuf)) && (len >= (SCHED_PATTERN_OFFSET + SCHED_FCS_LEN))
+        && (0u == node->rxBuf[11])) {
+        CheckFrame(node->rxBuf, len);
+    }
+}
+
+void TC6_CB_OnError(TC6_t *pInst, TC6_Error_t err, void *pGlobalTag)
+{
+    (void)pGlobalTag;
+    printf("node %u: error %d\n", TC6_GetInstance(pInst), (int)err);
+}
+
+uint32_t TC6Regs_CB_GetTicksMs(void)
+{
+    return (uint32_t)(Now() / (1000u * SCHED_BITS_PER_US));
+}
+
+void TC6Regs_CB_OnEvent(TC6_t *pInst, TC6Regs_Event_t event, void *pTag)
+{
+    (void)pInst;
+    (void)event;
+    (void)pTag;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  PRIVATE FUNCTION IMPLEMENTATIONS                    */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint64_t Now(void)
+{
+    TC6Sim_BusStats_t bus;
+    TC6Sim_GetBusStats(&m_bus, &bus);
+    return bus.now;
+}
+
+static void ServiceLoop(void)
+{
+    /* SyncTask: the scheduler (or the FIFO of EthernetTxService) fills the tc6 queue of node 0 before servicing */
+    if (Mode_Sched == m_mode) {
+        TxSchedService(0u);
+    } else {
+        FifoService();
+    }
+    for (uint8_t i = 2u; i < m_nodeCount; i++) {
+        FillBackground(i);
+    }
+    for (uint8_t i = 0u; i < m_nodeCount; i++) {
+        TC6_Service(m_tc6[i], !TC6Sim_IrqAsserted(TC6Sim_GetNode(&m_bus, i)));
+    }
+}
+
+static void RunBus(uint32_t bitTimes)
+{
+    uint32_t before = TC6Regs_CB_GetTicksMs();
+    TC6Sim_BusRun(&m_bus, bitTimes);
+    if (TC6Regs_CB_GetTicksMs() != before) {
+        TC6Regs_CheckTimers();
+    }
+}
+
+static bool Offer(struct pbuf *p)
+{
+    if (Mode_Sched == m_mode) {
+        return TxSchedEnqueue(0u, p);
+    }
+    if ((m_fifoTail - m_fifoHead) >= SCHED_FIFO_LEN) {
+        return false;
+    }
+    pbuf_ref(p);
+    m_fifo[m_fifoTail % SCHED_FIFO_LEN] = p;
+    m_fifoTail++;
+    return true;
+}
+
+static void FifoService(void)
+{
+    TC6_RawTxSegment *seg;
+
+    while (m_fifoHead != m_fifoTail) {
+        struct pbuf *p = m_fifo[m_fifoHead % SCHED_FIFO_LEN];
+        if (TC6_GetRawSegments(m_tc6[0], &seg) == 0u) {
+            m_fifoWaits++;
+            return;
+        }
+        seg[0].pEth = p->payload;
+        seg[0].segLen = p->len;
+        if (!TC6_SendRawEthernetSegments(m_tc6[0], seg, 1u, p->tot_len, 0u, OnFifoTxDone, p)) {
+            return;
+        }
+        m_fifoHead++;
+    }
+}
+
+static struct pbuf *BuildFrame(uint8_t trafficClass, uint32_t seq)
+{
+    uint16_t len = (0u != trafficClass) ? SCHED_PRIO_LEN : SCHED_BULK_LEN;
+    struct pbuf *p = (struct pbuf *)malloc(sizeof(struct pbuf) + len);
+    uint8_t *frame = (uint8_t *)&p[1];
+    uint64_t stamp = Now();
+    uint32_t magic = SCHED_MAGIC;
+
+    p->next = NULL;
+    p->payload = frame;
+    p->tot_len = len;
+    p->len = len;
+    p->ref = 1u;
+    m_pbufs++;
+
+    frame[0] = 0x00u; frame[1] = 0x04u; frame[2] = 0xA3u; frame[3] = 0x12u; frame[4] = 0x00u; frame[5] = 0x01u;
+    frame[6] = 0x00u; frame[7] = 0x04u; frame[8] = 0xA3u; frame[9] = 0x12u; frame[10] = 0x00u; frame[11] = 0x00u;
+    frame[12] = 0x08u;
+    frame[13] = 0x00u;
+    frame[14] = 0x45u;
+    frame[15] = (0u != trafficClass) ? SCHED_TOS_EF : 0x00u;
+    frame[16] = (uint8_t)((len - SCHED_HEADER_LEN) >> 8);
+    frame[17] = (uint8_t)(len - SCHED_HEADER_LEN);
+    memcpy(&frame[SCHED_STAMP_OFFSET], &magic, sizeof(magic));
+    memcpy(&frame[SCHED_STAMP_OFFSET + 4u], &seq, sizeof(seq));
+    memcpy(&frame[SCHED_STAMP_OFFSET + 8u], &stamp, sizeof(stamp));
+    memset(&frame[SCHED_PATTERN_OFFSET], (uint8_t)(seq + trafficClass), len - SCHED_PATTERN_OFFSET);
+    return p;
+}
+
+static void FillBackground(uint8_t idx)
+{
+    TC6_RawTxSegment *seg;
+    Node_t *node = &m_node[idx];
+
+    while ((node->txInFlight < TC6_TX_ETH_QSIZE) && (TC6_GetRawSegments(m_tc6[idx], &seg) > 0u)) {
+        uint8_t *frame = node->txFrame[node->txHead];
+        /* Unicast to an address nobody has, only the segment time is taken */
+        frame[0] = 0x02u; frame[1] = 0x00u; frame[2] = 0x00u; frame[3] = 0x00u; frame[4] = 0x00u; frame[5] = 0xFFu;
+        frame[6] = 0x00u; frame[7] = 0x04u; frame[8] = 0xA3u; frame[9] = 0x12u; frame[10] = 0x00u; frame[11] = idx;
+        frame[12] = 0x88u;
+        frame[13] = 0xB5u;
+        seg[0].pEth = frame;
+        seg[0].segLen = SCHED_BULK_LEN;
+        if (!TC6_SendRawEthernetSegments(m_tc6[idx], seg, 1u, SCHED_BULK_LEN, 0u, OnBackgroundTxDone, node)) {
+            break;
+        }
+        node->txHead = (uint8_t)((node->txHead + 1u) % TC6_TX_ETH_QSIZE);
+        node->txInFlight++;
+    }
+}
+
+static void OnFifoTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag)
+{
+    (void)pInst;
+    (void)pTx;
+    (void)len;
+    (void)pGlobalTag;
+    (void)pbuf_free((struct pbuf *)pTag);
+}
+
+static void OnBackgroundTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag)
+{
+    Node_t *node = (Node_t *)pTag;
+    (void)pInst;
+    (void)pTx;
+    (void)len;
+    (void)pGlobalTag;
+    if (node->txInFlight > 0u) {
+        node->txInFlight--;
+    }
+}
+
+static void CheckFrame(const uint8_t *p, uint16_t len)
+{
+    uint8_t trafficClass = (SCHED_TOS_EF == p[15]) ? 1u : 0u;
+    uint16_t expected = (0u != trafficClass) ? SCHED_PRIO_LEN : SCHED_BULK_LEN;
+    uint32_t magic;
+    uint32_t seq;
+    uint64_t stamp;
+    bool valid;
+
+    memcpy(&magic, &p[SCHED_STAMP_OFFSET], sizeof(magic));
+    memcpy(&seq, &p[SCHED_STAMP_OFFSET + 4u], sizeof(seq));
+    memcpy(&stamp, &p[SCHED_STAMP_OFFSET + 8u], sizeof(stamp));
+    valid = (SCHED_MAGIC == magic) && (len == (expected + SCHED_FCS_LEN));
+    for (uint16_t i = SCHED_PATTERN_OFFSET; valid && (i < expected); i++) {
+        valid = (p[i] == (uint8_t)(seq + trafficClass));
+    }
+    if (valid) {
+        const uint8_t *f = &p[expected];
+        valid = (Crc32(p, expected) == ((uint32_t)f[0] | ((uint32_t)f[1] << 8) | ((uint32_t)f[2] << 16) | ((uint32_t)f[3] << 24)));
+    }
+    if (!valid) {
+        m_rx.corrupt++;
+        return;
+    }
+    /* Each class keeps its order, the scheduler only lets prioritized frames overtake bulk frames.
+       Gaps are frames lost on the segment (see Lost()) */
+    if (seq < m_rx.nextSeq[trafficClass]) {
+        m_rx.misordered++;
+    }
+    m_rx.nextSeq[trafficClass] = seq + 1u;
+    m_rx.received[trafficClass]++;
+    if ((0u != trafficClass) && (m_rx.latencyCount < SCHED_MAX_PRIO)) {
+        m_rx.latency[m_rx.latencyCount++] = (uint32_t)((Now() - stamp) / SCHED_BITS_PER_US);
+    }
+}
+
+static uint32_t Lost(void)
+{
+    TC6Sim_NodeStats_t sender;
+    TC6Sim_NodeStats_t receiver;
+
+    /* Frames of node 0 given up after too many collisions (CSMA/CD) or dropped by a full buffer */
+    TC6Sim_GetNodeStats(TC6Sim_GetNode(&m_bus, 0u), &sender);
+    TC6Sim_GetNodeStats(TC6Sim_GetNode(&m_bus, 1u), &receiver);
+    return sender.txAborts + sender.txDrops + receiver.rxDrops;
+}
+
+static uint32_t Crc32(const uint8_t *pData, uint16_t len)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    for (uint16_t i = 0u; i < len; i++) {
+        crc ^= pData[i];
+        for (uint8_t b = 0u; b < 8u; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+static int CompareLatency(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
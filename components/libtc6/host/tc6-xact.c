@@ -0,0 +1,578 @@
+/*******************************************************************************
+  Host Transaction Policy Comparison for libtc6
+
+  File Name:
+    tc6-xact.c
+
+  Summary:
+    Replays a traffic trace once per SPI transaction sizing policy
+
+  Description:
+    Two emulated LAN865x on a 10BASE-T1S segment (see sim/tc6sim.h) with
+    an SPI clock (-c, default 15 MHz), so every SPI transaction takes the
+    time its chunks need on the wire and long bursts delay the next one.
+    A traffic trace is replayed once with TC6XactPolicy_Fixed and once
+    with TC6XactPolicy_Adaptive (TC6_SetTransactionPolicy(), -m chunks at
+    most). Each trace entry sends a frame from one node to the other at
+    its trace time; a frame the TX queue does not take yet waits and its
+    latency counts from the trace time. Without -r three built in traces
+    are replayed:
+      "idle"  64 byte request and response every 1 ms
+      "bulk"  1500 byte frames from both nodes, 9.2 Mbit/s offered, more
+              than the segment and a 15 MHz SPI carry
+      "mixed" 1024 byte bulk from node 0, 64 byte frames from node 1
+    -r replays a CSV file instead, one frame per line: time_us,node,payload
+    (node 0 or 1, lines starting with # are skipped, sorted by time).
+    Prints per trace and policy the throughput and the latency of small
+    (payload up to XACT_SMALL_PAYLOAD) and large frames in segment time,
+    plus the SPI transactions (prefix "XACT"). The receivers check every
+    frame for length, content and FCS and that it arrives once (prefix
+    "CHECK", exit code 2 on a lost, duplicated or corrupted frame).
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tc6.h"
+#include "tc6-regs.h"
+#include "tc6sim.h"
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                            DEFINITIONS                               */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+#define XACT_ETHERTYPE          (0x88B5u)
+#define XACT_MAGIC              (0x58414354u)
+#define XACT_HEADER_LEN         (14u)
+#define XACT_FCS_LEN            (4u)
+#define XACT_STAMP_LEN          (8u)            /* Magic and trace entry */
+#define XACT_MIN_PAYLOAD        (46u)
+#define XACT_MAX_PAYLOAD        (1500u)
+#define XACT_SMALL_PAYLOAD      (256u)          /* Frames up to this payload count as small */
+#define XACT_MAX_FRAMES         (20000u)
+#define XACT_NODES              (2u)
+#define XACT_STEP_BITS          (100u)          /* Segment time between two service loops (10 us) */
+#define XACT_DRAIN_BITS         (2000000u)      /* Wait for outstanding frames after the last trace entry (200 ms) */
+#define XACT_BITS_PER_US        (10u)
+
+typedef struct
+{
+    uint32_t timeUs;
+    uint8_t node;
+    uint16_t payload;
+} TraceEntry_t;
+
+typedef struct
+{
+    uint8_t rxBuf[TC6SIM_MAX_FRAME_LEN];
+    uint8_t txFrame[TC6_TX_ETH_QSIZE][XACT_HEADER_LEN + XACT_MAX_PAYLOAD];
+    uint8_t txHead;             /* Next TX buffer, buffers are released in order by OnTxDone */
+    uint8_t txInFlight;
+    uint32_t cursor;            /* Next trace entry to look at for this node */
+} XactNode_t;
+
+typedef struct
+{
+    uint32_t received;
+    uint32_t duplicates;
+    uint32_t corrupt;
+    uint64_t bytes;             /* Payload received */
+    uint64_t lastRx;
+} XactResult_t;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                          PRIVATE VARIABLES                           */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static TC6Sim_Bus_t m_bus;
+static TC6_t *m_tc6[XACT_NODES];
+static XactNode_t m_node[XACT_NODES];
+static TraceEntry_t m_trace[XACT_MAX_FRAMES];
+static uint32_t m_traceLen;
+static uint64_t m_start;                    /* Segment time of trace time 0 */
+static uint32_t m_smallLatency[XACT_MAX_FRAMES];
+static uint32_t m_largeLatency[XACT_MAX_FRAMES];
+static uint32_t m_smallCount;
+static uint32_t m_largeCount;
+static uint8_t m_seen[XACT_MAX_FRAMES / 8u];
+static XactResult_t m_result;
+static uint32_t m_seed;
+static uint32_t m_spiClockHz;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                      PRIVATE FUNCTION PROTOTYPES                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint64_t Now(void);
+static void RunSegment(uint32_t bitTimes);
+static bool ReplayTrace(const char *name, TC6_XactPolicy_t policy, uint8_t maxChunks);
+static bool SendEntry(uint32_t index);
+static void OnTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag);
+static void CheckFrame(TC6_t *pInst, const uint8_t *p, uint16_t len);
+static void AddEntry(uint32_t timeUs, uint8_t node, uint16_t payload);
+static void AddFlow(uint8_t node, uint16_t payload, uint32_t firstUs, uint32_t intervalUs, uint32_t endUs);
+static void SortTrace(void);
+static bool LoadTrace(const char *file);
+static void BuildTrace(const char *name);
+static uint32_t Random(void);
+static uint32_t Aborts(void);
+static uint32_t SpiTransactions(uint32_t *pBytes);
+static uint32_t Crc32(const uint8_t *pData, uint16_t len);
+static int CompareLatency(const void *a, const void *b);
+static uint32_t Percentile(const uint32_t *pSorted, uint32_t count, uint32_t permille);
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                             MAIN                                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+int main(int argc, char *argv[])
+{
+    static const char *const builtIn[] = { "idle", "bulk", "mixed" };
+    const char *traceFile = NULL;
+    uint8_t maxChunks = TC6_CHUNKS_XACT;
+    bool plca = false;
+    bool success = true;
+    bool checked = true;
+    TC6Sim_BusConfig_t cfg = { .toTimerBits = 32u, .beaconBits = 20u, .spiClockHz = 15000000u, .seed = 1u };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:c:m:ph")) != -1) {
+        switch (opt) {
+            case 'r':
+                traceFile = optarg;
+                break;
+            case 'c':
+                cfg.spiClockHz = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'm':
+                maxChunks = (uint8_t)atoi(optarg);
+                break;
+            case 'p':
+                plca = true;
+                break;
+            default:
+                printf("usage: %s [-r trace.csv] [-c SPI clock Hz, 0 = no SPI time] [-m max chunks per transaction] [-p PLCA]\n", argv[0]);
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+    m_spiClockHz = cfg.spiClockHz;
+    if ((NULL != traceFile) && !LoadTrace(traceFile)) {
+        return 1;
+    }
+
+    TC6Sim_BusInit(&m_bus, &cfg);
+    TC6Sim_PortAttach(&m_bus);
+    for (uint8_t i = 0u; success && (i < XACT_NODES); i++) {
+        uint8_t mac[6] = { 0x00u, 0x04u, 0xA3u, 0x12u, 0x00u, i };
+        (void)TC6Sim_AddNode(&m_bus, i);
+        m_tc6[i] = TC6_Init(&m_node[i]);
+        success = (NULL != m_tc6[i]) && TC6Regs_Init(m_tc6[i], &m_node[i], mac, plca, i, XACT_NODES, 0u, 0x80u, false, false, false);
+    }
+    for (uint32_t k = 0u; success && (k < (100000u * XACT_BITS_PER_US / XACT_STEP_BITS)); k++) {
+        RunSegment(XACT_STEP_BITS);
+    }
+    for (uint8_t i = 0u; success && (i < XACT_NODES); i++) {
+        success = TC6Regs_GetInitDone(m_tc6[i]);
+    }
+    if (!success) {
+        printf("initialization failed\n");
+        return 1;
+    }
+    for (uint8_t i = 0u; i < XACT_NODES; i++) {
+        TC6_EnableData(m_tc6[i], true);
+    }
+
+    printf("XACT,trace,policy,max_chunks,spi_hz,frames,received,duration_us,throughput_kbps,"
+           "small_frames,small_p50_us,small_p99_us,small_max_us,large_frames,large_p50_us,large_p99_us,large_max_us,"
+           "spi_transactions,spi_bytes_per_transaction\n");
+    printf("CHECK,trace,policy,sent,received,aborted,missing,duplicated,corrupt,result\n");
+    for (uint8_t t = 0u; t < ((NULL != traceFile) ? 1u : (sizeof(builtIn) / sizeof(builtIn[0]))); t++) {
+        const char *name = (NULL != traceFile) ? "file" : builtIn[t];
+        if (NULL == traceFile) {
+            BuildTrace(name);
+        }
+        checked = ReplayTrace(name, TC6XactPolicy_Fixed, maxChunks) && checked;
+        checked = ReplayTrace(name, TC6XactPolicy_Adaptive, maxChunks) && checked;
+    }
+    return checked ? 0 : 2;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  CALLBACK FUNCTIONS FROM TC6 STACK                   */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+void TC6_CB_OnNeedService(TC6_t *pInst, void *pGlobalTag)
+{
+    /* Every node is serviced after each segment step anyway */
+    (void)pInst;
+    (void)pGlobalTag;
+}
+
+void TC6_CB_OnRxEthernetSlice(TC6_t *pInst, const uint8_t *pRx, uint16_t offset, uint16_t len, void *pGlobalTag)
+{
+    XactNode_t *node = (XactNode_t *)pGlobalTag;
+    (void)pInst;
+    if (((uint32_t)offset + len) <= sizeof(node->rxBuf)) {
+        memcpy(&node->rxBuf[offset], pRx, len);
+    }
+}
+
+void TC6_CB_OnRxEthernetPacket(TC6_t *pInst, bool success, uint16_t len, uint64_t *rxTimestamp, void *pGlobalTag)
+{
+    XactNode_t *node = (XactNode_t *)pGlobalTag;
+    (void)rxTimestamp;
+    if (!success || (len > sizeof(node->rxBuf))) {
+        m_result.corrupt++;
+    } else {
+        CheckFrame(pInst, node->rxBuf, len);
+    }
+}
+
+void TC6_CB_OnError(TC6_t *pInst, TC6_Error_t err, void *pGlobalTag)
+{
+    (void)pGlobalTag;
+    printf("node %u: error %d\n", TC6_GetInstance(pInst), (int)err);
+}
+
+uint32_t TC6Regs_CB_GetTicksMs(void)
+{
+    return (uint32_t)(Now() / (1000u * XACT_BITS_PER_US));
+}
+
+void TC6Regs_CB_OnEvent(TC6_t *pInst, TC6Regs_Event_t event, void *pTag)
+{
+    (void)pInst;
+    (void)event;
+    (void)pTag;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  PRIVATE FUNCTION IMPLEMENTATIONS                    */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint64_t Now(void)
+{
+    TC6Sim_BusStats_t bus;
+    TC6Sim_GetBusStats(&m_bus, &bus);
+    return bus.now;
+}
+
+static void RunSegment(uint32_t bitTimes)
+{
+    uint32_t before = TC6Regs_CB_GetTicksMs();
+    for (uint8_t i = 0u; i < XACT_NODES; i++) {
+        TC6_Service(m_tc6[i], !TC6Sim_IrqAsserted(TC6Sim_GetNode(&m_bus, i)));
+    }
+    TC6Sim_BusRun(&m_bus, bitTimes);
+    if (TC6Regs_CB_GetTicksMs() != before) {
+        TC6Regs_CheckTimers();
+    }
+}
+
+static bool ReplayTrace(const char *name, TC6_XactPolicy_t policy, uint8_t maxChunks)
+{
+    uint32_t sent = 0u;
+    uint32_t aborts = Aborts();
+    uint32_t missing;
+    uint32_t spiBytes;
+    uint32_t spiTransactions = SpiTransactions(&spiBytes);
+    uint32_t spiBytesStart = spiBytes;
+    uint32_t endUs = m_traceLen ? m_trace[m_traceLen - 1u].timeUs : 0u;
+    uint64_t duration;
+    bool ok;
+
+    for (uint8_t i = 0u; i < XACT_NODES; i++) {
+        TC6_SetTransactionPolicy(m_tc6[i], policy, maxChunks);
+        m_node[i].cursor = 0u;
+    }
+    memset(&m_result, 0, sizeof(m_result));
+    memset(m_seen, 0, sizeof(m_seen));
+    m_smallCount = 0u;
+    m_largeCount = 0u;
+    m_start = Now();
+
+    /* Each node sends its trace entries in order, not before their trace time */
+    while (sent < m_traceLen) {
+        uint64_t nowUs = (Now() - m_start) / XACT_BITS_PER_US;
+        for (uint8_t i = 0u; i < XACT_NODES; i++) {
+            XactNode_t *node = &m_node[i];
+            while ((node->cursor < m_traceLen) && (m_trace[node->cursor].node != i)) {
+                node->cursor++;
+            }
+            while ((node->cursor < m_traceLen) && (m_trace[node->cursor].timeUs <= nowUs) && SendEntry(node->cursor)) {
+                sent++;
+                node->cursor++;
+                while ((node->cursor < m_traceLen) && (m_trace[node->cursor].node != i)) {
+                    node->cursor++;
+                }
+            }
+        }
+        RunSegment(XACT_STEP_BITS);
+    }
+    for (uint32_t waited = 0u; ((m_result.received + (Aborts() - aborts)) < sent) && (waited < XACT_DRAIN_BITS); waited += XACT_STEP_BITS) {
+        RunSegment(XACT_STEP_BITS);
+    }
+
+    aborts = Aborts() - aborts;
+    missing = ((m_result.received + aborts) < sent) ? (sent - m_result.received - aborts) : 0u;
+    spiTransactions = SpiTransactions(&spiBytes) - spiTransactions;
+    spiBytes -= spiBytesStart;
+    /* Throughput over the trace, at least its own length: an idle trace is limited by its offered load */
+    duration = (m_result.lastRx > m_start) ? (m_result.lastRx - m_start) : 0u;
+    if (duration < ((uint64_t)endUs * XACT_BITS_PER_US)) {
+        duration = (uint64_t)endUs * XACT_BITS_PER_US;
+    }
+    qsort(m_smallLatency, m_smallCount, sizeof(m_smallLatency[0]), CompareLatency);
+    qsort(m_largeLatency, m_largeCount, sizeof(m_largeLatency[0]), CompareLatency);
+    printf("XACT,%s,%s,%u,%u,%u,%u,%llu,%llu,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n",
+           name, (TC6XactPolicy_Adaptive == policy) ? "adaptive" : "fixed",
+           ((0u == maxChunks) || (maxChunks > TC6_CHUNKS_XACT)) ? TC6_CHUNKS_XACT : maxChunks,
+           m_spiClockHz, sent, m_result.received,
+           (unsigned long long)(duration / XACT_BITS_PER_US),
+           (unsigned long long)(duration ? ((m_result.bytes * 8u * 1000u * XACT_BITS_PER_US) / duration) : 0u),
+           m_smallCount, Percentile(m_smallLatency, m_smallCount, 500u), Percentile(m_smallLatency, m_smallCount, 990u),
+           Percentile(m_smallLatency, m_smallCount, 1000u),
+           m_largeCount, Percentile(m_largeLatency, m_largeCount, 500u), Percentile(m_largeLatency, m_largeCount, 990u),
+           Percentile(m_largeLatency, m_largeCount, 1000u),
+           spiTransactions, spiTransactions ? (spiBytes / spiTransactions) : 0u);
+
+    ok = (0u == missing) && (0u == m_result.duplicates) && (0u == m_result.corrupt);
+    printf("CHECK,%s,%s,%u,%u,%u,%u,%u,%u,%s\n", name, (TC6XactPolicy_Adaptive == policy) ? "adaptive" : "fixed",
+           sent, m_result.received, aborts, missing, m_result.duplicates, m_result.corrupt, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static bool SendEntry(uint32_t index)
+{
+    const TraceEntry_t *entry = &m_trace[index];
+    XactNode_t *node = &m_node[entry->node];
+    uint8_t *frame = node->txFrame[node->txHead];
+    TC6_RawTxSegment *seg;
+    uint32_t magic = XACT_MAGIC;
+    bool success = false;
+
+    /* A frame stays in use until OnTxDone, every queue entry has its own buffer */
+    if ((node->txInFlight < TC6_TX_ETH_QSIZE) && (TC6_GetRawSegments(m_tc6[entry->node], &seg) > 0u)) {
+        memset(frame, 0xFF, 6u);
+        frame[6] = 0x00u; frame[7] = 0x04u; frame[8] = 0xA3u; frame[9] = 0x12u; frame[10] = 0x00u; frame[11] = entry->node;
+        frame[12] = (uint8_t)(XACT_ETHERTYPE >> 8);
+        frame[13] = (uint8_t)XACT_ETHERTYPE;
+        memcpy(&frame[XACT_HEADER_LEN], &magic, sizeof(magic));
+        memcpy(&frame[XACT_HEADER_LEN + 4u], &index, sizeof(index));
+        memset(&frame[XACT_HEADER_LEN + XACT_STAMP_LEN], (uint8_t)index, entry->payload - XACT_STAMP_LEN);
+
+        seg[0].pEth = frame;
+        seg[0].segLen = (uint16_t)(XACT_HEADER_LEN + entry->payload);
+        success = TC6_SendRawEthernetSegments(m_tc6[entry->node], seg, 1u, seg[0].segLen, 0u, OnTxDone, node);
+        if (success) {
+            node->txHead = (uint8_t)((node->txHead + 1u) % TC6_TX_ETH_QSIZE);
+            node->txInFlight++;
+        }
+    }
+    return success;
+}
+
+static void OnTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag)
+{
+    XactNode_t *node = (XactNode_t *)pTag;
+    (void)pInst;
+    (void)pTx;
+    (void)len;
+    (void)pGlobalTag;
+    if (node->txInFlight > 0u) {
+        node->txInFlight--;
+    }
+}
+
+static void CheckFrame(TC6_t *pInst, const uint8_t *p, uint16_t len)
+{
+    const TraceEntry_t *entry;
+    uint32_t magic;
+    uint32_t index;
+    uint32_t latencyUs;
+    bool valid;
+
+    if ((len < (XACT_HEADER_LEN + XACT_STAMP_LEN + XACT_FCS_LEN)) || ((((uint16_t)p[12] << 8) | p[13]) != XACT_ETHERTYPE)) {
+        return;
+    }
+    memcpy(&magic, &p[XACT_HEADER_LEN], sizeof(magic));
+    memcpy(&index, &p[XACT_HEADER_LEN + 4u], sizeof(index));
+    if ((XACT_MAGIC != magic) || (index >= m_traceLen)) {
+        m_result.corrupt++;
+        return;
+    }
+    entry = &m_trace[index];
+    valid = (len == (XACT_HEADER_LEN + entry->payload + XACT_FCS_LEN)) && (p[11] == entry->node) && (TC6_GetInstance(pInst) != entry->node);
+    for (uint16_t i = XACT_HEADER_LEN + XACT_STAMP_LEN; valid && (i < (len - XACT_FCS_LEN)); i++) {
+        valid = (p[i] == (uint8_t)index);
+    }
+    if (valid) {
+        /* The MACPHY passes the FCS on, it covers the header and the stamp as well */
+        uint32_t fcs = Crc32(p, (uint16_t)(len - XACT_FCS_LEN));
+        const uint8_t *f = &p[len - XACT_FCS_LEN];
+        valid = (fcs == ((uint32_t)f[0] | ((uint32_t)f[1] << 8) | ((uint32_t)f[2] << 16) | ((uint32_t)f[3] << 24)));
+    }
+    if (!valid) {
+        m_result.corrupt++;
+    } else if (0u != (m_seen[index / 8u] & (1u << (index % 8u)))) {
+        m_result.duplicates++;
+    } else {
+        m_seen[index / 8u] |= (uint8_t)(1u << (index % 8u));
+        m_result.received++;
+        m_result.bytes += entry->payload;
+        m_result.lastRx = Now();
+        /* From the trace time, a frame waiting for the TX queue counts as well */
+        latencyUs = (uint32_t)(((Now() - m_start) / XACT_BITS_PER_US) - entry->timeUs);
+        if (entry->payload <= XACT_SMALL_PAYLOAD) {
+            m_smallLatency[m_smallCount++] = latencyUs;
+        } else {
+            m_largeLatency[m_largeCount++] = latencyUs;
+        }
+    }
+}
+
+static void AddEntry(uint32_t timeUs, uint8_t node, uint16_t payload)
+{
+    if (m_traceLen < XACT_MAX_FRAMES) {
+        m_trace[m_traceLen].timeUs = timeUs;
+        m_trace[m_traceLen].node = node;
+        m_trace[m_traceLen].payload = payload;
+        m_traceLen++;
+    }
+}
+
+static void AddFlow(uint8_t node, uint16_t payload, uint32_t firstUs, uint32_t intervalUs, uint32_t endUs)
+{
+    /* Intervals vary by +-25 %, the same for every policy */
+    for (uint32_t t = firstUs; t < endUs; t += (intervalUs * 3u / 4u) + (Random() % ((intervalUs / 2u) + 1u))) {
+        AddEntry(t, node, payload);
+    }
+}
+
+static void SortTrace(void)
+{
+    /* Stable: entries of equal time keep their order */
+    for (uint32_t i = 1u; i < m_traceLen; i++) {
+        TraceEntry_t entry = m_trace[i];
+        uint32_t k = i;
+        while ((k > 0u) && (m_trace[k - 1u].timeUs > entry.timeUs)) {
+            m_trace[k] = m_trace[k - 1u];
+            k--;
+        }
+        m_trace[k] = entry;
+    }
+}
+
+static bool LoadTrace(const char *file)
+{
+    FILE *f = fopen(file, "r");
+    char line[128];
+    uint32_t lineNo = 0u;
+    bool success = (NULL != f);
+
+    m_traceLen = 0u;
+    while (success && (NULL != fgets(line, sizeof(line), f))) {
+        unsigned long timeUs;
+        unsigned node;
+        unsigned payload;
+        lineNo++;
+        if (('#' == line[0]) || ('\n' == line[0])) {
+            continue;
+        }
+        if ((3 != sscanf(line, "%lu,%u,%u", &timeUs, &node, &payload)) || (node >= XACT_NODES) ||
+            (payload < XACT_MIN_PAYLOAD) || (payload > XACT_MAX_PAYLOAD) || (m_traceLen >= XACT_MAX_FRAMES)) {
+            printf("%s:%u: expected time_us,node (0..%u),payload (%u..%u), at most %u lines\n", file, lineNo,
+                   XACT_NODES - 1u, XACT_MIN_PAYLOAD, XACT_MAX_PAYLOAD, XACT_MAX_FRAMES);
+            success = false;
+        } else {
+            AddEntry((uint32_t)timeUs, (uint8_t)node, (uint16_t)payload);
+        }
+    }
+    if (NULL == f) {
+        printf("cannot open %s\n", file);
+    } else {
+        fclose(f);
+    }
+    SortTrace();
+    return success && (0u != m_traceLen);
+}
+
+static void BuildTrace(const char *name)
+{
+    m_traceLen = 0u;
+    m_seed = 1u;
+    if (0 == strcmp(name, "idle")) {
+        for (uint32_t t = 1000u; t < 300000u; t += 1000u) {
+            AddEntry(t, 0u, 64u);
+            AddEntry(t + 200u, 1u, 64u);
+        }
+    } else if (0 == strcmp(name, "bulk")) {
+        /* 2 x 1500 bytes every 2.6 ms, about 9.2 Mbit/s: the queues fill up, the throughput is the limit */
+        AddFlow(0u, 1500u, 0u, 2600u, 500000u);
+        AddFlow(1u, 1500u, 1300u, 2600u, 500000u);
+    } else {
+        /* About 4 Mbit/s bulk, small frames every 0.5 ms in between */
+        AddFlow(0u, 1024u, 0u, 2000u, 500000u);
+        AddFlow(1u, 64u, 250u, 500u, 500000u);
+    }
+    SortTrace();
+}
+
+static uint32_t Random(void)
+{
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return m_seed;
+}
+
+static uint32_t Aborts(void)
+{
+    uint32_t aborts = 0u;
+    for (uint8_t i = 0u; i < XACT_NODES; i++) {
+        TC6Sim_NodeStats_t stats;
+        TC6Sim_GetNodeStats(TC6Sim_GetNode(&m_bus, i), &stats);
+        aborts += stats.txAborts;
+    }
+    return aborts;
+}
+
+static uint32_t SpiTransactions(uint32_t *pBytes)
+{
+    uint32_t transactions = 0u;
+    *pBytes = 0u;
+    for (uint8_t i = 0u; i < XACT_NODES; i++) {
+        TC6Sim_NodeStats_t stats;
+        TC6Sim_GetNodeStats(TC6Sim_GetNode(&m_bus, i), &stats);
+        transactions += stats.spiTransactions;
+        *pBytes += stats.spiBytes;
+    }
+    return transactions;
+}
+
+static uint32_t Crc32(const uint8_t *pData, uint16_t len)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    for (uint16_t i = 0u; i < len; i++) {
+        crc ^= pData[i];
+        for (uint8_t b = 0u; b < 8u; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+static int CompareLatency(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t Percentile(const uint32_t *pSorted, uint32_t count, uint32_t permille)
+{
+    return count ? pSorted[((uint64_t)(count - 1u) * permille) / 1000u] : 0u;
+}
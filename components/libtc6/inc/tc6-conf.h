@@ -93,10 +93,20 @@ extern "C" {
 
 /**
  * \brief Set the queue length for control data
- * \note Given length must be power of 2 (2^n).
+ * \note Given length must be power of 2 (2^n), 128 at most.
  */
 #ifndef REG_OP_ARRAY_SIZE
-#define REG_OP_ARRAY_SIZE   (4u)
+#define REG_OP_ARRAY_SIZE   (16u)
+#endif
+
+/**
+ * \brief Merge register operations with the last queued, not yet sent operation.
+ * \note Writes to the same address collapse into one write, the last value wins. For the write 1 to clear
+ *       registers STATUS0 and STATUS1 the values are ORed instead. Read-modify-writes to the same address with
+ *       disjunct masks collapse into one read-modify-write. Set to 0 to send every operation on its own.
+ */
+#ifndef TC6_REGOP_COALESCE
+#define TC6_REGOP_COALESCE  (1u)
 #endif
 
 /**
@@ -116,14 +126,30 @@ extern "C" {
 
 /**
  * \brief Defines the queue size for holding entire MOSI and MISO data
+ * \note Given length must be power of 2 (2^n). With 2 or more buffers the next SPI transaction is started before the received data of the previous one is processed.
  */
 #ifndef SPI_FULL_BUFFERS
-#define SPI_FULL_BUFFERS    (1u)
+#define SPI_FULL_BUFFERS    (2u)
+#endif
+
+/**
+ * \brief Selects the RX footer decoder. 1 loads every footer once as 32 bit word and extracts all fields with constant masks. 0 uses the byte wise reference implementation.
+ */
+#ifndef TC6_WORD_FOOTER
+#define TC6_WORD_FOOTER     (1u)
+#endif
+
+/**
+ * \brief Enables the hot path probes. 1 calls TC6_CB_OnProbe() on entry and exit of the service, data, SPI and RX stages. 0 removes them at compile time.
+ */
+#ifndef TC6_PROBES
+#define TC6_PROBES          (0u)
 #endif
 
 /**
  * \brief Defines the queue size for holding pointer to Ethernet frames coming out of the TCP/IP stack.
  * \note Only a reference to the payload is stored, not the entire payload it self.
+ * \note Given length must be power of 2 (2^n) and not bigger than 128.
  */
 #ifndef TC6_TX_ETH_QSIZE
 #define TC6_TX_ETH_QSIZE    (4u)
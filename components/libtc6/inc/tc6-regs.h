@@ -42,6 +42,9 @@ Microchip or any third party.
 /*                            DEFINITIONS                               */
 /*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
 
+/** \brief Number of chip specific trim values computed during initialization */
+#define TC6REGS_TRIM_COUNT  (5u)
+
 typedef enum
 {
     TC6Regs_Event_UnknownError = 0,
@@ -91,12 +94,13 @@ typedef enum
  *  \param pInst - The pointer returned by TC6_Init.
  *  \param pTag - This pointer will be returned back with any callback of this component. Maybe set to NULL.
  *  \param mac - The 6 Byte public visible MAC address of the TC6 MAC.
- *  \return True, if initial register settings and given parameters have been written into the LAN865x. false, initialization error, try again later with TC6Regs_Reinit().
+ *  \note Does not wait for the register accesses. The initialization continues from the callbacks of TC6_Service() and from TC6Regs_CheckTimers(), TC6Regs_GetInitDone() reports the end.
+ *  \return True, if the initialization has been started. false, initialization error, try again later with TC6Regs_Reinit().
  */
 bool TC6Regs_Init(TC6_t *pInst, void *pTag, const uint8_t mac[6], bool enablePlca, uint8_t nodeId, uint8_t nodeCount, uint8_t burstCount, uint8_t burstTimer, bool promiscuous, bool txCutThrough, bool rxCutThrough);
 
 /** \brief Checks internal timers and trigger corresponding actions
- *  \note Must be called cyclic (slow delay is fine (< 1 second))
+ *  \note Must be called cyclic (slow delay is fine (< 1 second)). Restarts a failed initialization and retries register accesses the full control queue did not take.
  */
 void TC6Regs_CheckTimers(void);
 
@@ -127,6 +131,25 @@ bool TC6Regs_SetPlca(TC6_t *pInst, bool plcaEnable, uint8_t nodeId, uint8_t node
  */
 uint8_t TC6Regs_GetChipRevision(TC6_t *pInst);
 
+/** \brief Provides trim values stored by a previous boot, so the initialization does not need to read and compute them again.
+ *  \note Must be called before TC6Regs_Init(). The values are only used if PHY ID and chip revision match the attached chip.
+ *  \note The chip checks still run. On TC6Regs_Event_Chip_Error the values are dropped and the restart reads them again.
+ *  \param pInst - The pointer returned by TC6_Init.
+ *  \param phyId - The PHY ID the trim values belong to, as returned by TC6Regs_GetTrim().
+ *  \param chipRev - The chip revision the trim values belong to, as returned by TC6Regs_GetTrim().
+ *  \param trim - The trim values, as returned by TC6Regs_GetTrim().
+ */
+void TC6Regs_SetCachedTrim(TC6_t *pInst, uint32_t phyId, uint8_t chipRev, const uint16_t trim[TC6REGS_TRIM_COUNT]);
+
+/** \brief Returns the trim values written during the initialization.
+ *  \param pInst - The pointer returned by TC6_Init.
+ *  \param pPhyId - Pointer to a variable receiving the PHY ID of the chip.
+ *  \param pChipRev - Pointer to a variable receiving the chip revision.
+ *  \param trim - Array receiving the trim values.
+ *  \return true, if the trim values have been written successfully. false, otherwise and the output parameters are untouched.
+ */
+bool TC6Regs_GetTrim(TC6_t *pInst, uint32_t *pPhyId, uint8_t *pChipRev, uint16_t trim[TC6REGS_TRIM_COUNT]);
+
 /*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
 /*                   Implementation of TC6 Callback                     */
 /*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
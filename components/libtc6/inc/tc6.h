@@ -74,6 +74,43 @@ typedef enum
     TC6Error_ControlTxFail,     /** Control TX failure */
 } TC6_Error_t;
 
+typedef struct
+{
+    uint8_t size;               /** Number of entries of the TX Ethernet queue (TC6_TX_ETH_QSIZE) */
+    uint8_t depth;              /** Ethernet frames currently waiting in the TX queue */
+    uint8_t highWater;          /** Maximum depth seen since TC6_Init() or the last reset of the statistics */
+    uint32_t fullCount;         /** Number of times a frame could not be enqueued because the queue was full */
+} TC6_TxQueueStats_t;
+
+typedef struct
+{
+    uint8_t size;               /** Number of entries of the register operation queue (REG_OP_ARRAY_SIZE) */
+    uint8_t depth;              /** Register operations currently in the queue */
+    uint32_t coalescedWrites;   /** Number of writes merged into an already queued write to the same address */
+    uint32_t coalescedModifies; /** Number of read-modify-writes merged into an already queued read-modify-write to the same address */
+} TC6_RegOpStats_t;
+
+typedef enum
+{
+    TC6XactPolicy_Fixed,        /** Every SPI transaction carries as many chunks as TX credits allow, up to the configured maximum */
+    TC6XactPolicy_Adaptive,     /** Data chunks per SPI transaction start short on an idle link and grow with RX backlog and TX queue depth */
+} TC6_XactPolicy_t;
+
+typedef enum
+{
+    TC6Probe_ServiceBegin,      /** TC6_Service() entered */
+    TC6Probe_ServiceEnd,        /** TC6_Service() left */
+    TC6Probe_DataBegin,         /** Data transaction assembly entered */
+    TC6Probe_DataEnd,           /** Data transaction assembly left */
+    TC6Probe_SpiStart,          /** TC6_CB_OnSpiTransaction() about to be called */
+    TC6Probe_SpiDone,           /** TC6_SpiBufferDone() called by the integrator */
+    TC6Probe_RxChunksBegin,     /** Chunks of a finished SPI transaction are being parsed */
+    TC6Probe_RxChunksEnd,       /** All chunks of the SPI transaction were parsed */
+    TC6Probe_RxPacketBegin,     /** TC6_CB_OnRxEthernetPacket() about to be called */
+    TC6Probe_RxPacketEnd,       /** TC6_CB_OnRxEthernetPacket() returned */
+    TC6Probe_Count,             /** Number of probes, integrators may number their own probes from here on */
+} TC6_Probe_t;
+
 typedef struct
 {
     const uint8_t *pEth;        /** Pointer to the Ethernet packet segment */
@@ -264,6 +301,29 @@ void TC6_Reset(TC6_t *pInst);
  */
 void TC6_GetState(TC6_t *pInst, uint8_t *pTxCredit, uint8_t *pRxCredit, bool *pSynced);
 
+/** \brief Returns the fill level statistics of the TX Ethernet queue.
+ *  \param pInst - The pointer returned by TC6_Init.
+ *  \param pStats - Pointer to the statistics structure, which gets filled by this function.
+ *  \param reset - true, restart high water mark and full counter after reading them.
+ */
+void TC6_GetTxQueueStats(TC6_t *pInst, TC6_TxQueueStats_t *pStats, bool reset);
+
+/** \brief Returns the statistics of the register operation queue.
+ *  \note Coalescing (TC6_REGOP_COALESCE) only modifies operations which were not sent yet. The register access
+ *        functions must therefore be called from the same context as TC6_Service() while it is enabled.
+ *  \param pInst - The pointer returned by TC6_Init.
+ *  \param pStats - Pointer to the statistics structure, which gets filled by this function.
+ *  \param reset - true, restart the coalescing counters after reading them.
+ */
+void TC6_GetRegOpStats(TC6_t *pInst, TC6_RegOpStats_t *pStats, bool reset);
+
+/** \brief Selects how many chunks are transfered within a single SPI transaction.
+ *  \param pInst - The pointer returned by TC6_Init.
+ *  \param policy - TC6XactPolicy_Fixed (default) or TC6XactPolicy_Adaptive.
+ *  \param maxChunks - Upper limit of chunks per SPI transaction. 0 or values above TC6_CHUNKS_XACT select TC6_CHUNKS_XACT.
+ */
+void TC6_SetTransactionPolicy(TC6_t *pInst, TC6_XactPolicy_t policy, uint8_t maxChunks);
+
 /** \brief Returns the current instance number of the given TC6 pointer
  *  \param pInst - The pointer returned by TC6_Init.
  *  \return Instance number, starting with 0 for the first instance
@@ -337,6 +397,17 @@ extern void TC6_CB_OnExtendedStatus(TC6_t *pInst, void *pGlobalTag);
  */
 extern bool TC6_CB_OnSpiTransaction(uint8_t tc6instance, uint8_t *pTx, uint8_t *pRx, uint16_t len, void *pGlobalTag);
 
+/**
+ * \brief Callback when ever the driver passes one of its hot path probes.
+ * \note This function must be implemented by the integrator, if TC6_PROBES is set to 1. It is not called otherwise.
+ * \note Keep it short, it is called several times per SPI transaction. Typically it stores a time stamp (see trace/tc6trace.h).
+ * \warning !! THIS FUNCTION MAY GET CALLED FROM TASK AND INTERRUPT CONTEXT !!
+ * \param tc6instance - The instance number of the hardware. Starting with 0 for the first.
+ * \param probe - The probe, which was passed.
+ * \param pGlobalTag - The exact same pointer, which was given along with the TC6_Init() function.
+ */
+extern void TC6_CB_OnProbe(uint8_t tc6instance, TC6_Probe_t probe, void *pGlobalTag);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,85 @@
+/*******************************************************************************
+  Host Emulator for LAN865x 10BASE-T1S MACPHY and PLCA Multidrop Segment
+
+  File Name:
+    tc6sim-port.c
+
+  Summary:
+    Connects libtc6 to the emulated MACPHYs
+
+  Description:
+    Implements TC6_CB_OnSpiTransaction() on top of the emulator. Every
+    transaction is completed synchronously, the segment of the addressed
+    MACPHY runs for the duration of the transfer when an SPI clock is
+    configured. Several segments may be attached, e.g. for a bridge. In deferred
+    mode TC6_SpiBufferDone() is called from TC6Sim_PortComplete() instead,
+    like an SPI driver finishing the transfer in its interrupt, so the
+    next TC6_Service() call finds the transaction done but not processed.
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "tc6.h"
+#include "tc6sim.h"
+
+/* One bit time of the 10 Mbit/s segment is 100 ns */
+#define SEGMENT_BITRATE     (10000000ull)
+
+#ifndef TC6SIM_PORT_MAX_BUSES
+#define TC6SIM_PORT_MAX_BUSES   (2u)
+#endif
+
+static TC6Sim_Bus_t *m_pBus[TC6SIM_PORT_MAX_BUSES];
+static uint8_t m_busCount = 0u;
+static bool m_deferred = false;
+static bool m_pending[TC6_MAX_INSTANCES];
+
+void TC6Sim_PortAttach(TC6Sim_Bus_t *pBus)
+{
+    if (m_busCount < TC6SIM_PORT_MAX_BUSES) {
+        m_pBus[m_busCount++] = pBus;
+    }
+}
+
+void TC6Sim_PortSetDeferred(bool deferred)
+{
+    TC6Sim_PortComplete();
+    m_deferred = deferred;
+}
+
+void TC6Sim_PortComplete(void)
+{
+    uint8_t i;
+    for (i = 0u; i < TC6_MAX_INSTANCES; i++) {
+        if (m_pending[i]) {
+            m_pending[i] = false;
+            TC6_SpiBufferDone(i, true);
+        }
+    }
+}
+
+bool TC6_CB_OnSpiTransaction(uint8_t tc6instance, uint8_t *pTx, uint8_t *pRx, uint16_t len, void *pGlobalTag)
+{
+    TC6Sim_Node_t *pNode = NULL;
+    TC6Sim_Bus_t *pBus = NULL;
+    bool success;
+    uint8_t i;
+    (void)pGlobalTag;
+    for (i = 0u; (NULL == pNode) && (i < m_busCount); i++) {
+        pBus = m_pBus[i];
+        pNode = TC6Sim_GetNode(pBus, tc6instance);
+    }
+    success = (NULL != pNode) && TC6Sim_SpiTransaction(pNode, pTx, pRx, len);
+    if (success) {
+        if (0u != pBus->cfg.spiClockHz) {
+            TC6Sim_BusRun(pBus, (uint32_t)(((uint64_t)len * 8u * SEGMENT_BITRATE) / pBus->cfg.spiClockHz));
+        }
+        if (m_deferred) {
+            m_pending[tc6instance] = true;
+        } else {
+            TC6_SpiBufferDone(tc6instance, true);
+        }
+    }
+    return success;
+}
@@ -0,0 +1,735 @@
+/*******************************************************************************
+  Host Emulator for LAN865x 10BASE-T1S MACPHY and PLCA Multidrop Segment
+
+  File Name:
+    tc6sim.c
+
+  Summary:
+    OA-TC6 MACPHY emulator for host side testing of libtc6
+
+  Description:
+    This file provides the implementation of the emulated MACPHY and segment
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "tc6sim.h"
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                    INTERNAL DEFINES AND VARIABLES                    */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+#if (TC6SIM_FRAME_QSIZE & (TC6SIM_FRAME_QSIZE - 1u)) != 0u
+#error "TC6SIM_FRAME_QSIZE must be power of 2"
+#endif
+
+/* Registers (MMS << 16 | address) */
+#define REG_PHYID               (0x00000001u)
+#define REG_RESET               (0x00000003u)
+#define REG_CONFIG0             (0x00000004u)
+#define REG_STATUS0             (0x00000008u)
+#define REG_STATUS1             (0x00000009u)
+#define REG_BUFSTS              (0x0000000Bu)
+#define REG_IMASK0              (0x0000000Cu)
+#define REG_NETWORK_CONTROL     (0x00010000u)
+#define REG_NETWORK_CONFIG      (0x00010001u)
+#define REG_SPEC_ADD2_BOTTOM    (0x00010024u)
+#define REG_SPEC_ADD2_TOP       (0x00010025u)
+#define REG_INDIRECT_DATA       (0x000400D9u)
+#define REG_PLCA_CONTROL_0      (0x0004CA01u)
+#define REG_PLCA_CONTROL_1      (0x0004CA02u)
+#define REG_PLCA_BURST_MODE     (0x0004CA05u)
+#define REG_CHIP_REVISION       (0x000A0094u)
+
+/* Register fields */
+#define CONFIG0_SYNC            (0x8000u)
+#define STATUS0_TXBOE           (0x0002u) /* Transmit Buffer Overflow Error */
+#define STATUS0_RXBOE           (0x0008u) /* Receive Buffer Overflow Error */
+#define STATUS0_HDRE            (0x0020u) /* Header Error */
+#define STATUS0_RESETC          (0x0040u) /* Reset Complete */
+#define NETWORK_CONTROL_RXEN    (0x0004u)
+#define NETWORK_CONTROL_TXEN    (0x0008u)
+#define NETWORK_CONFIG_PROMISC  (0x0010u)
+#define PLCA_CONTROL_0_EN       (0x8000u)
+
+/* Reset values, LAN8651 revision B1 */
+#define DEFAULT_PHYID           (0x0007C1B1u) /* OUI 0x1F0, model 0x1B, revision 1 */
+#define DEFAULT_CHIP_REVISION   (0x00000002u)
+#define DEFAULT_IMASK0          (0x00001FBFu)
+#define DEFAULT_INDIRECT_DATA   (0x00000040u) /* Trim values valid */
+
+/* Chunk header and footer bits (32 bit big endian word) */
+#define HDR_DNC                 (1u << 31)
+#define HDR_C_WNR               (1u << 29)
+#define HDR_C_AID               (1u << 28)
+#define HDR_DV                  (1u << 21)
+#define HDR_SV                  (1u << 20)
+#define HDR_EV                  (1u << 14)
+
+#define FTR_EXST                (1u << 31)
+#define FTR_HDRB                (1u << 30)
+#define FTR_SYNC                (1u << 29)
+#define FTR_DV                  (1u << 21)
+#define FTR_SV                  (1u << 20)
+#define FTR_EV                  (1u << 14)
+
+/* Segment timing in bit times */
+#define WIRE_OVERHEAD_BITS      ((8u + 4u + 12u) * 8u)    /* Preamble, FCS, inter packet gap */
+#define MIN_FRAME_LEN           (60u)
+#define SLOT_BITS               (512u)
+#define JAM_BITS                (96u)
+#define MAX_ATTEMPTS            (16u)
+#define MAX_BACKOFF_EXP         (10u)
+
+#define FCS_SIZE                (4u)
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                      PRIVATE FUNCTION PROTOTYPES                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static void ResetNode(TC6Sim_Node_t *pNode);
+static void WriteRegister(TC6Sim_Node_t *pNode, uint32_t addr, uint32_t value);
+static uint32_t ReadRegister(TC6Sim_Node_t *pNode, uint32_t addr);
+static void SetStatus(TC6Sim_Node_t *pNode, uint32_t bits);
+static void ControlTransaction(TC6Sim_Node_t *pNode, const uint8_t *pTx, uint8_t *pRx, uint16_t len);
+static void DataTransaction(TC6Sim_Node_t *pNode, const uint8_t *pTx, uint8_t *pRx, uint16_t len);
+static void ConsumeTxChunk(TC6Sim_Node_t *pNode, uint32_t hdr, const uint8_t *pPayload);
+static void StartTx(TC6Sim_Node_t *pNode);
+static void AppendTx(TC6Sim_Node_t *pNode, const uint8_t *pData, uint16_t len);
+static void FinishTx(TC6Sim_Node_t *pNode);
+static uint32_t ProduceRxChunk(TC6Sim_Node_t *pNode, uint8_t *pPayload);
+static uint8_t GetTxCredits(const TC6Sim_Node_t *pNode);
+static uint8_t GetRxChunksAvailable(const TC6Sim_Node_t *pNode);
+static bool PlcaCoordinatorPresent(const TC6Sim_Bus_t *pBus, uint8_t *pNodeCount);
+static TC6Sim_Node_t *PlcaNodeForTo(TC6Sim_Bus_t *pBus, uint8_t to);
+static bool NodeTxReady(const TC6Sim_Node_t *pNode);
+static void Transmit(TC6Sim_Bus_t *pBus, TC6Sim_Node_t *pSender);
+static void Deliver(TC6Sim_Node_t *pNode, const TC6Sim_Frame_t *pFrame);
+static void RunPlca(TC6Sim_Bus_t *pBus, uint8_t nodeCount);
+static void RunCsma(TC6Sim_Bus_t *pBus, uint64_t end);
+static uint32_t NextRandom(TC6Sim_Bus_t *pBus);
+static uint32_t Crc32(const uint8_t *pData, uint16_t len);
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                         PUBLIC FUNCTIONS                             */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+void TC6Sim_BusInit(TC6Sim_Bus_t *pBus, const TC6Sim_BusConfig_t *pConfig)
+{
+    (void)memset(pBus, 0, sizeof(*pBus));
+    if (NULL != pConfig) {
+        pBus->cfg = *pConfig;
+    }
+    if (0u == pBus->cfg.toTimerBits) {
+        pBus->cfg.toTimerBits = 32u;
+    }
+    if (0u == pBus->cfg.beaconBits) {
+        pBus->cfg.beaconBits = 20u;
+    }
+    pBus->random = (0u != pBus->cfg.seed) ? pBus->cfg.seed : 1u;
+}
+
+TC6Sim_Node_t *TC6Sim_AddNode(TC6Sim_Bus_t *pBus, uint8_t tc6instance)
+{
+    TC6Sim_Node_t *pNode = NULL;
+    if (pBus->nodeCount < TC6SIM_MAX_NODES) {
+        pNode = &pBus->node[pBus->nodeCount++];
+        (void)memset(pNode, 0, sizeof(*pNode));
+        pNode->pBus = pBus;
+        pNode->instance = tc6instance;
+        ResetNode(pNode);
+    }
+    return pNode;
+}
+
+TC6Sim_Node_t *TC6Sim_GetNode(TC6Sim_Bus_t *pBus, uint8_t tc6instance)
+{
+    TC6Sim_Node_t *pNode = NULL;
+    uint8_t i;
+    for (i = 0u; i < pBus->nodeCount; i++) {
+        if (pBus->node[i].instance == tc6instance) {
+            pNode = &pBus->node[i];
+            break;
+        }
+    }
+    return pNode;
+}
+
+void TC6Sim_BusRun(TC6Sim_Bus_t *pBus, uint32_t bitTimes)
+{
+    uint64_t end = pBus->stats.now + bitTimes;
+    uint8_t nodeCount;
+    while (pBus->stats.now < end) {
+        if (PlcaCoordinatorPresent(pBus, &nodeCount)) {
+            RunPlca(pBus, nodeCount);
+        } else {
+            RunCsma(pBus, end);
+        }
+    }
+}
+
+void TC6Sim_GetBusStats(const TC6Sim_Bus_t *pBus, TC6Sim_BusStats_t *pStats)
+{
+    *pStats = pBus->stats;
+}
+
+bool TC6Sim_SpiTransaction(TC6Sim_Node_t *pNode, const uint8_t *pTx, uint8_t *pRx, uint16_t len)
+{
+    bool success = (len >= 8u) && (0u == (len % 4u));
+    if (success) {
+        pNode->stats.spiTransactions++;
+        pNode->stats.spiBytes += len;
+        if (0u != (pTx[0] & 0x80u)) {
+            success = (0u == (len % TC6_CHUNK_BUF_SIZE));
+            if (success) {
+                DataTransaction(pNode, pTx, pRx, len);
+            }
+        } else {
+            ControlTransaction(pNode, pTx, pRx, len);
+        }
+    }
+    return success;
+}
+
+bool TC6Sim_IrqAsserted(const TC6Sim_Node_t *pNode)
+{
+    uint32_t status = ReadRegister((TC6Sim_Node_t *)pNode, REG_STATUS0);
+    uint32_t mask = ReadRegister((TC6Sim_Node_t *)pNode, REG_IMASK0);
+    return (0u != (status & ~mask)) || (0u != GetRxChunksAvailable(pNode)) || pNode->creditIrq;
+}
+
+void TC6Sim_SetRegister(TC6Sim_Node_t *pNode, uint32_t addr, uint32_t value)
+{
+    uint16_t i;
+    for (i = 0u; i < pNode->regCount; i++) {
+        if (pNode->regAddr[i] == addr) {
+            pNode->regValue[i] = value;
+            break;
+        }
+    }
+    if ((i == pNode->regCount) && (pNode->regCount < TC6SIM_MAX_REGS)) {
+        pNode->regAddr[i] = addr;
+        pNode->regValue[i] = value;
+        pNode->regCount++;
+    }
+}
+
+uint32_t TC6Sim_GetRegister(const TC6Sim_Node_t *pNode, uint32_t addr)
+{
+    return ReadRegister((TC6Sim_Node_t *)pNode, addr);
+}
+
+bool TC6Sim_SendFrame(TC6Sim_Node_t *pNode, const uint8_t *pEth, uint16_t len)
+{
+    TC6Sim_FrameQueue_t *q = &pNode->txQ;
+    bool success = (len <= TC6SIM_MAX_FRAME_LEN) && ((uint8_t)(q->tail - q->head) < TC6SIM_FRAME_QSIZE);
+    if (success) {
+        TC6Sim_Frame_t *pFrame = &q->frame[q->tail & (TC6SIM_FRAME_QSIZE - 1u)];
+        (void)memcpy(pFrame->data, pEth, len);
+        pFrame->len = len;
+        pFrame->chunks = (uint16_t)((len + TC6_CHUNK_SIZE - 1u) / TC6_CHUNK_SIZE);
+        pFrame->ready = pNode->pBus->stats.now;
+        q->tail++;
+    }
+    return success;
+}
+
+void TC6Sim_GetNodeStats(const TC6Sim_Node_t *pNode, TC6Sim_NodeStats_t *pStats)
+{
+    *pStats = pNode->stats;
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  PRIVATE FUNCTION IMPLEMENTATIONS                    */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static inline uint32_t net2value(const uint8_t *buf)
+{
+    return ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | ((uint32_t)buf[3]);
+}
+
+static inline void value2net(uint32_t value, uint8_t *buf)
+{
+    buf[0] = (uint8_t)(value >> 24);
+    buf[1] = (uint8_t)(value >> 16);
+    buf[2] = (uint8_t)(value >> 8);
+    buf[3] = (uint8_t)value;
+}
+
+static inline bool parity_ok(uint32_t v)
+{
+    /* Headers and footers use odd parity over all 32 bits */
+    v ^= v >> 16;
+    v ^= v >> 8;
+    v ^= v >> 4;
+    v ^= v >> 2;
+    v ^= v >> 1;
+    return (0u != (v & 1u));
+}
+
+static inline uint32_t add_parity(uint32_t v)
+{
+    return parity_ok(v) ? v : (v | 1u);
+}
+
+static void ResetNode(TC6Sim_Node_t *pNode)
+{
+    pNode->regCount = 0u;
+    (void)memset(&pNode->txQ, 0, sizeof(pNode->txQ));
+    (void)memset(&pNode->rxQ, 0, sizeof(pNode->rxQ));
+    pNode->txAsmActive = false;
+    pNode->rxOffset = 0u;
+    pNode->backoff = 0u;
+    pNode->attempts = 0u;
+    pNode->creditIrq = false;
+    TC6Sim_SetRegister(pNode, REG_PHYID, DEFAULT_PHYID);
+    TC6Sim_SetRegister(pNode, REG_CHIP_REVISION, DEFAULT_CHIP_REVISION);
+    TC6Sim_SetRegister(pNode, REG_IMASK0, DEFAULT_IMASK0);
+    TC6Sim_SetRegister(pNode, REG_INDIRECT_DATA, DEFAULT_INDIRECT_DATA);
+    TC6Sim_SetRegister(pNode, REG_STATUS0, STATUS0_RESETC);
+}
+
+static uint32_t ReadRegister(TC6Sim_Node_t *pNode, uint32_t addr)
+{
+    uint32_t value = 0u;
+    uint16_t i;
+    if (REG_BUFSTS == addr) {
+        value = ((uint32_t)GetTxCredits(pNode) << 8) | GetRxChunksAvailable(pNode);
+    } else {
+        for (i = 0u; i < pNode->regCount; i++) {
+            if (pNode->regAddr[i] == addr) {
+                value = pNode->regValue[i];
+                break;
+            }
+        }
+    }
+    return value;
+}
+
+static void WriteRegister(TC6Sim_Node_t *pNode, uint32_t addr, uint32_t value)
+{
+    switch (addr) {
+    case REG_RESET:
+        if (0u != (value & 1u)) {
+            ResetNode(pNode);
+        }
+        break;
+    case REG_STATUS0:
+    case REG_STATUS1:
+        /* Write 1 to clear */
+        TC6Sim_SetRegister(pNode, addr, ReadRegister(pNode, addr) & ~value);
+        break;
+    case REG_PHYID:
+    case REG_BUFSTS:
+    case REG_CHIP_REVISION:
+        /* Read only */
+        break;
+    default:
+        TC6Sim_SetRegister(pNode, addr, value);
+        break;
+    }
+}
+
+static void SetStatus(TC6Sim_Node_t *pNode, uint32_t bits)
+{
+    TC6Sim_SetRegister(pNode, REG_STATUS0, ReadRegister(pNode, REG_STATUS0) | bits);
+}
+
+static void ControlTransaction(TC6Sim_Node_t *pNode, const uint8_t *pTx, uint8_t *pRx, uint16_t len)
+{
+    uint32_t hdr = net2value(pTx);
+    uint32_t addr = ((hdr >> 8) & 0x000F0000u) | ((hdr >> 8) & 0xFFFFu);
+    uint16_t num = (uint16_t)(((hdr >> 1) & 0x7Fu) + 1u);
+    bool protect = (len == ((num * 8u) + 8u));
+    uint16_t i;
+
+    /* MISO is MOSI delayed by one word, read data replaces the echoed data words */
+    (void)memset(pRx, 0, 4u);
+    (void)memcpy(&pRx[4], pTx, len - 4u);
+    if (!parity_ok(hdr) || (!protect && (len != ((num * 4u) + 8u)))) {
+        SetStatus(pNode, STATUS0_HDRE);
+        (void)memset(pRx, 0, len);
+    } else {
+        uint16_t step = protect ? 8u : 4u;
+        for (i = 0u; i < num; i++) {
+            uint32_t regAddr = (0u != (hdr & HDR_C_AID)) ? addr : (addr + i);
+            uint16_t pos = 4u + (i * step);
+            if (0u != (hdr & HDR_C_WNR)) {
+                uint32_t value = net2value(&pTx[pos]);
+                if (!protect || (value == ~net2value(&pTx[pos + 4u]))) {
+                    WriteRegister(pNode, regAddr, value);
+                }
+            } else {
+                uint32_t value = ReadRegister(pNode, regAddr);
+                value2net(value, &pRx[pos + 4u]);
+                if (protect) {
+                    value2net(~value, &pRx[pos + 8u]);
+                }
+            }
+        }
+    }
+}
+
+static void DataTransaction(TC6Sim_Node_t *pNode, const uint8_t *pTx, uint8_t *pRx, uint16_t len)
+{
+    uint16_t pos;
+    pNode->creditIrq = false;
+    for (pos = 0u; pos < len; pos += TC6_CHUNK_BUF_SIZE) {
+        uint32_t hdr = net2value(&pTx[pos]);
+        uint32_t ftr;
+        bool synced = (0u != (ReadRegister(pNode, REG_CONFIG0) & CONFIG0_SYNC));
+        bool hdrb = !parity_ok(hdr);
+
+        if (!hdrb && synced) {
+            ConsumeTxChunk(pNode, hdr, &pTx[pos + TC6_HEADER_SIZE]);
+        }
+        (void)memset(&pRx[pos], 0, TC6_CHUNK_SIZE);
+        ftr = synced ? ProduceRxChunk(pNode, &pRx[pos]) : 0u;
+        if (hdrb) {
+            ftr |= FTR_HDRB;
+            SetStatus(pNode, STATUS0_HDRE);
+        }
+        if (synced) {
+            ftr |= FTR_SYNC;
+        }
+        if (0u != (ReadRegister(pNode, REG_STATUS0) & ~ReadRegister(pNode, REG_IMASK0))) {
+            ftr |= FTR_EXST;
+        }
+        ftr |= ((uint32_t)GetRxChunksAvailable(pNode) << 24);
+        ftr |= ((uint32_t)GetTxCredits(pNode) << 1);
+        value2net(add_parity(ftr), &pRx[pos + TC6_CHUNK_SIZE]);
+    }
+}
+
+static void ConsumeTxChunk(TC6Sim_Node_t *pNode, uint32_t hdr, const uint8_t *pPayload)
+{
+    uint16_t sbo = (uint16_t)(((hdr >> 16) & 0xFu) * 4u);
+    uint16_t ebo = (uint16_t)(((hdr >> 8) & 0x3Fu) + 1u);
+    bool sv = (0u != (hdr & HDR_SV));
+    bool ev = (0u != (hdr & HDR_EV));
+
+    if (0u == (hdr & HDR_DV)) {
+        /* Empty chunk, only used to fetch RX data */
+    } else if (0u == GetTxCredits(pNode)) {
+        /* Host ignored the credits */
+        SetStatus(pNode, STATUS0_TXBOE);
+        pNode->stats.txDrops++;
+        pNode->txAsmActive = false;
+    } else if (sv && ev && (ebo > sbo)) {
+        /* Complete frame within this chunk */
+        StartTx(pNode);
+        AppendTx(pNode, &pPayload[sbo], ebo - sbo);
+        pNode->txAsm.chunks++;
+        FinishTx(pNode);
+    } else {
+        /* Every chunk takes one chunk of the TX buffer, it is accounted to the frame ending or continuing in it */
+        if (ev) {
+            /* End of the current frame, possibly followed by the start of the next one */
+            AppendTx(pNode, pPayload, ebo);
+            pNode->txAsm.chunks++;
+            FinishTx(pNode);
+        } else if (!sv) {
+            AppendTx(pNode, pPayload, TC6_CHUNK_SIZE);
+            pNode->txAsm.chunks++;
+        } else {} /* MISRA enforced termination */
+        if (sv) {
+            StartTx(pNode);
+            AppendTx(pNode, &pPayload[sbo], TC6_CHUNK_SIZE - sbo);
+            if (!ev) {
+                pNode->txAsm.chunks++;
+            }
+        }
+    }
+}
+
+static void StartTx(TC6Sim_Node_t *pNode)
+{
+    if (pNode->txAsmActive) {
+        /* Start valid without end valid of the previous frame */
+        SetStatus(pNode, STATUS0_HDRE);
+        pNode->stats.txDrops++;
+    }
+    pNode->txAsm.len = 0u;
+    pNode->txAsm.chunks = 0u;
+    pNode->txAsmActive = true;
+}
+
+static void AppendTx(TC6Sim_Node_t *pNode, const uint8_t *pData, uint16_t len)
+{
+    TC6Sim_Frame_t *pAsm = &pNode->txAsm;
+    if (pNode->txAsmActive) {
+        if ((pAsm->len + len) <= TC6SIM_MAX_FRAME_LEN) {
+            (void)memcpy(&pAsm->data[pAsm->len], pData, len);
+            pAsm->len += len;
+        } else {
+            pNode->stats.txDrops++;
+            pNode->txAsmActive = false;
+        }
+    }
+}
+
+static void FinishTx(TC6Sim_Node_t *pNode)
+{
+    if (pNode->txAsmActive) {
+        pNode->txAsmActive = false;
+        if (TC6Sim_SendFrame(pNode, pNode->txAsm.data, pNode->txAsm.len)) {
+            TC6Sim_FrameQueue_t *q = &pNode->txQ;
+            q->frame[(uint8_t)(q->tail - 1u) & (TC6SIM_FRAME_QSIZE - 1u)].chunks = pNode->txAsm.chunks;
+        } else {
+            SetStatus(pNode, STATUS0_TXBOE);
+            pNode->stats.txDrops++;
+        }
+    }
+}
+
+static uint32_t ProduceRxChunk(TC6Sim_Node_t *pNode, uint8_t *pPayload)
+{
+    TC6Sim_FrameQueue_t *q = &pNode->rxQ;
+    uint32_t ftr = 0u;
+    if (q->head != q->tail) {
+        TC6Sim_Frame_t *pFrame = &q->frame[q->head & (TC6SIM_FRAME_QSIZE - 1u)];
+        uint16_t n = pFrame->len - pNode->rxOffset;
+        if (n > TC6_CHUNK_SIZE) {
+            n = TC6_CHUNK_SIZE;
+        }
+        (void)memcpy(pPayload, &pFrame->data[pNode->rxOffset], n);
+        ftr |= FTR_DV;
+        if (0u == pNode->rxOffset) {
+            ftr |= FTR_SV; /* SWO 0 */
+        }
+        pNode->rxOffset += n;
+        if (pNode->rxOffset == pFrame->len) {
+            ftr |= FTR_EV | ((uint32_t)(n - 1u) << 8);
+            pNode->rxOffset = 0u;
+            q->head++;
+            pNode->stats.rxFrames++;
+        }
+    }
+    return ftr;
+}
+
+static uint8_t GetTxCredits(const TC6Sim_Node_t *pNode)
+{
+    const TC6Sim_FrameQueue_t *q = &pNode->txQ;
+    uint32_t used = 0u;
+    uint32_t free;
+    uint8_t i;
+    for (i = q->head; i != q->tail; i++) {
+        used += q->frame[i & (TC6SIM_FRAME_QSIZE - 1u)].chunks;
+    }
+    if (pNode->txAsmActive) {
+        used += pNode->txAsm.chunks;
+    }
+    if (((uint8_t)(q->tail - q->head) >= TC6SIM_FRAME_QSIZE) || (used >= TC6SIM_TX_CHUNKS)) {
+        free = 0u;
+    } else {
+        free = TC6SIM_TX_CHUNKS - used;
+    }
+    /* Every chunk may end a frame (at most one end valid per chunk), each of them needs a frame slot */
+    if (free > (uint32_t)(TC6SIM_FRAME_QSIZE - (uint8_t)(q->tail - q->head))) {
+        free = TC6SIM_FRAME_QSIZE - (uint8_t)(q->tail - q->head);
+    }
+    return (uint8_t)((free > 31u) ? 31u : free);
+}
+
+static uint8_t GetRxChunksAvailable(const TC6Sim_Node_t *pNode)
+{
+    const TC6Sim_FrameQueue_t *q = &pNode->rxQ;
+    uint32_t chunks = 0u;
+    uint8_t i;
+    for (i = q->head; i != q->tail; i++) {
+        uint16_t len = q->frame[i & (TC6SIM_FRAME_QSIZE - 1u)].len;
+        if (i == q->head) {
+            len -= pNode->rxOffset;
+        }
+        chunks += (len + TC6_CHUNK_SIZE - 1u) / TC6_CHUNK_SIZE;
+    }
+    return (uint8_t)((chunks > 31u) ? 31u : chunks);
+}
+
+static bool PlcaCoordinatorPresent(const TC6Sim_Bus_t *pBus, uint8_t *pNodeCount)
+{
+    bool found = false;
+    uint8_t i;
+    for (i = 0u; i < pBus->nodeCount; i++) {
+        TC6Sim_Node_t *pNode = (TC6Sim_Node_t *)&pBus->node[i];
+        uint32_t ctrl1 = ReadRegister(pNode, REG_PLCA_CONTROL_1);
+        if ((0u != (ReadRegister(pNode, REG_PLCA_CONTROL_0) & PLCA_CONTROL_0_EN)) && (0u == (ctrl1 & 0xFFu))) {
+            *pNodeCount = (uint8_t)(ctrl1 >> 8);
+            found = (0u != *pNodeCount);
+            break;
+        }
+    }
+    return found;
+}
+
+static TC6Sim_Node_t *PlcaNodeForTo(TC6Sim_Bus_t *pBus, uint8_t to)
+{
+    TC6Sim_Node_t *pFound = NULL;
+    uint8_t i;
+    for (i = 0u; i < pBus->nodeCount; i++) {
+        TC6Sim_Node_t *pNode = &pBus->node[i];
+        if ((0u != (ReadRegister(pNode, REG_PLCA_CONTROL_0) & PLCA_CONTROL_0_EN))
+            && ((ReadRegister(pNode, REG_PLCA_CONTROL_1) & 0xFFu) == to)) {
+            pFound = pNode;
+            break;
+        }
+    }
+    return pFound;
+}
+
+static bool NodeTxReady(const TC6Sim_Node_t *pNode)
+{
+    return (pNode->txQ.head != pNode->txQ.tail)
+        && (0u != (ReadRegister((TC6Sim_Node_t *)pNode, REG_NETWORK_CONTROL) & NETWORK_CONTROL_TXEN));
+}
+
+static void Transmit(TC6Sim_Bus_t *pBus, TC6Sim_Node_t *pSender)
+{
+    TC6Sim_FrameQueue_t *q = &pSender->txQ;
+    TC6Sim_Frame_t *pFrame = &q->frame[q->head & (TC6SIM_FRAME_QSIZE - 1u)];
+    uint32_t len = (pFrame->len < MIN_FRAME_LEN) ? MIN_FRAME_LEN : pFrame->len;
+    uint32_t duration = (len * 8u) + WIRE_OVERHEAD_BITS;
+    uint8_t i;
+
+    pSender->stats.txLatencyBits += pBus->stats.now - pFrame->ready;
+    pBus->stats.now += duration;
+    pBus->stats.busyBits += duration;
+    for (i = 0u; i < pBus->nodeCount; i++) {
+        if (&pBus->node[i] != pSender) {
+            Deliver(&pBus->node[i], pFrame);
+        }
+    }
+    q->head++;
+    pSender->stats.txFrames++;
+    pSender->attempts = 0u;
+    pSender->creditIrq = true;
+}
+
+static void Deliver(TC6Sim_Node_t *pNode, const TC6Sim_Frame_t *pFrame)
+{
+    TC6Sim_FrameQueue_t *q = &pNode->rxQ;
+    uint32_t bottom = ReadRegister(pNode, REG_SPEC_ADD2_BOTTOM);
+    uint32_t top = ReadRegister(pNode, REG_SPEC_ADD2_TOP);
+    const uint8_t mac[6] = { (uint8_t)bottom, (uint8_t)(bottom >> 8), (uint8_t)(bottom >> 16),
+                             (uint8_t)(bottom >> 24), (uint8_t)top, (uint8_t)(top >> 8) };
+    bool accept = (0u != (ReadRegister(pNode, REG_NETWORK_CONTROL) & NETWORK_CONTROL_RXEN))
+        && ((0u != (ReadRegister(pNode, REG_NETWORK_CONFIG) & NETWORK_CONFIG_PROMISC))
+            || (0u != (pFrame->data[0] & 0x01u))
+            || (0 == memcmp(pFrame->data, mac, sizeof(mac))));
+
+    if (accept) {
+        if (((uint8_t)(q->tail - q->head) < TC6SIM_FRAME_QSIZE) && ((pFrame->len + FCS_SIZE) <= TC6SIM_MAX_FRAME_LEN)) {
+            /* Received frames carry the FCS like on the real MACPHY */
+            TC6Sim_Frame_t *pRxFrame = &q->frame[q->tail & (TC6SIM_FRAME_QSIZE - 1u)];
+            uint32_t fcs = Crc32(pFrame->data, pFrame->len);
+            (void)memcpy(pRxFrame->data, pFrame->data, pFrame->len);
+            pRxFrame->data[pFrame->len] = (uint8_t)fcs;
+            pRxFrame->data[pFrame->len + 1u] = (uint8_t)(fcs >> 8);
+            pRxFrame->data[pFrame->len + 2u] = (uint8_t)(fcs >> 16);
+            pRxFrame->data[pFrame->len + 3u] = (uint8_t)(fcs >> 24);
+            pRxFrame->len = (uint16_t)(pFrame->len + FCS_SIZE);
+            pRxFrame->ready = pNode->pBus->stats.now;
+            q->tail++;
+        } else {
+            SetStatus(pNode, STATUS0_RXBOE);
+            pNode->stats.rxDrops++;
+        }
+    }
+}
+
+static void RunPlca(TC6Sim_Bus_t *pBus, uint8_t nodeCount)
+{
+    TC6Sim_Node_t *pNode;
+
+    if (pBus->plcaTo >= nodeCount) {
+        pBus->plcaTo = 0u;
+    }
+    if (0u == pBus->plcaTo) {
+        pBus->stats.now += pBus->cfg.beaconBits;
+        pBus->stats.cycles++;
+    }
+    pNode = PlcaNodeForTo(pBus, pBus->plcaTo);
+    if ((NULL != pNode) && NodeTxReady(pNode)) {
+        uint8_t burst = (uint8_t)(ReadRegister(pNode, REG_PLCA_BURST_MODE) >> 8);
+        uint8_t sent = 0u;
+        Transmit(pBus, pNode);
+        /* Burst mode keeps the transmit opportunity for further frames already in the buffer */
+        while ((sent < burst) && NodeTxReady(pNode)) {
+            Transmit(pBus, pNode);
+            sent++;
+        }
+    } else {
+        pBus->stats.now += pBus->cfg.toTimerBits;
+    }
+    pBus->plcaTo++;
+}
+
+static void RunCsma(TC6Sim_Bus_t *pBus, uint64_t end)
+{
+    TC6Sim_Node_t *pReady[TC6SIM_MAX_NODES];
+    uint64_t next = end;
+    uint8_t count = 0u;
+    uint8_t i;
+
+    for (i = 0u; i < pBus->nodeCount; i++) {
+        TC6Sim_Node_t *pNode = &pBus->node[i];
+        if (NodeTxReady(pNode)) {
+            if (pNode->backoff <= pBus->stats.now) {
+                pReady[count++] = pNode;
+            } else if (pNode->backoff < next) {
+                next = pNode->backoff;
+            } else {} /* MISRA enforced termination */
+        }
+    }
+    if (0u == count) {
+        /* Idle until the next backoff expires */
+        pBus->stats.now = next;
+    } else if (1u == count) {
+        Transmit(pBus, pReady[0]);
+    } else {
+        pBus->stats.now += JAM_BITS;
+        pBus->stats.collisions++;
+        for (i = 0u; i < count; i++) {
+            TC6Sim_Node_t *pNode = pReady[i];
+            pNode->stats.collisions++;
+            pNode->attempts++;
+            if (pNode->attempts > MAX_ATTEMPTS) {
+                pNode->txQ.head++;
+                pNode->stats.txAborts++;
+                pNode->attempts = 0u;
+                pNode->creditIrq = true;
+            } else {
+                uint8_t exp = (pNode->attempts < MAX_BACKOFF_EXP) ? pNode->attempts : MAX_BACKOFF_EXP;
+                uint32_t slots = NextRandom(pBus) & ((1u << exp) - 1u);
+                pNode->backoff = pBus->stats.now + ((uint64_t)slots * SLOT_BITS);
+            }
+        }
+    }
+}
+
+static uint32_t NextRandom(TC6Sim_Bus_t *pBus)
+{
+    /* xorshift32, same sequence for the same seed */
+    uint32_t x = pBus->random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    pBus->random = x;
+    return x;
+}
+
+static uint32_t Crc32(const uint8_t *pData, uint16_t len)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    uint16_t i;
+    uint8_t b;
+    for (i = 0u; i < len; i++) {
+        crc ^= pData[i];
+        for (b = 0u; b < 8u; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
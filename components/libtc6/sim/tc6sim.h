@@ -0,0 +1,213 @@
+/*******************************************************************************
+  Host Emulator for LAN865x 10BASE-T1S MACPHY and PLCA Multidrop Segment
+
+  File Name:
+    tc6sim.h
+
+  Summary:
+    OA-TC6 MACPHY emulator for host side testing of libtc6
+
+  Description:
+    Emulates the SPI side of a LAN865x (control and data transactions,
+    chunk headers and footers, parity, credits, sync and extended status)
+    and a shared 10BASE-T1S segment connecting several emulated MACPHYs.
+    The segment runs PLCA when a coordinator (node ID 0) has PLCA enabled,
+    otherwise CSMA/CD with collisions and binary exponential backoff.
+    Time is counted in bit times (100 ns at 10 Mbit/s), all random
+    numbers come from a seeded generator, so every run is reproducible.
+*******************************************************************************/
+
+#ifndef TC6_SIM_H_
+#define TC6_SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tc6-conf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                            DEFINITIONS                               */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+/** \brief Maximum number of emulated MACPHYs on one segment */
+#ifndef TC6SIM_MAX_NODES
+#define TC6SIM_MAX_NODES        (8u)
+#endif
+
+/** \brief Number of Ethernet frames each emulated MACPHY buffers in RX and TX direction */
+#ifndef TC6SIM_FRAME_QSIZE
+#define TC6SIM_FRAME_QSIZE      (8u)
+#endif
+
+/** \brief Size of the emulated TX buffer in chunks, limits the reported TX credits */
+#ifndef TC6SIM_TX_CHUNKS
+#define TC6SIM_TX_CHUNKS        (48u)
+#endif
+
+/** \brief Number of emulated registers, which may hold a value different from 0 */
+#ifndef TC6SIM_MAX_REGS
+#define TC6SIM_MAX_REGS         (256u)
+#endif
+
+#define TC6SIM_MAX_FRAME_LEN    (1536u)
+
+typedef struct
+{
+    uint16_t toTimerBits;       /** PLCA transmit opportunity timer in bit times (default 32) */
+    uint16_t beaconBits;        /** Duration of the PLCA beacon in bit times (default 20) */
+    uint32_t spiClockHz;        /** SPI clock, every SPI transaction advances the segment by its duration. 0: SPI takes no time */
+    uint32_t seed;              /** Seed of the random generator used for the CSMA/CD backoff */
+} TC6Sim_BusConfig_t;
+
+typedef struct
+{
+    uint32_t txFrames;          /** Frames sent on the segment */
+    uint32_t txDrops;           /** Frames dropped because of a TX buffer overflow or bad chunk sequence */
+    uint32_t txAborts;          /** Frames given up after too many collisions (CSMA/CD only) */
+    uint32_t rxFrames;          /** Frames received from the segment and passed to the host */
+    uint32_t rxDrops;           /** Frames lost because the RX buffer was full */
+    uint32_t collisions;        /** Collisions this node was involved in */
+    uint32_t spiTransactions;   /** SPI transactions processed */
+    uint32_t spiBytes;          /** Bytes transfered over SPI */
+    uint64_t txLatencyBits;     /** Sum of the times from frame complete in the TX buffer to frame sent */
+} TC6Sim_NodeStats_t;
+
+typedef struct
+{
+    uint64_t now;               /** Current time of the segment in bit times */
+    uint64_t busyBits;          /** Time the segment carried frames */
+    uint32_t cycles;            /** Completed PLCA cycles (beacons) */
+    uint32_t collisions;        /** Collisions on the segment */
+} TC6Sim_BusStats_t;
+
+typedef struct
+{
+    uint16_t len;
+    uint16_t chunks;            /** Chunks of the TX buffer taken by the frame */
+    uint64_t ready;             /** Time the frame was complete in the TX buffer */
+    uint8_t data[TC6SIM_MAX_FRAME_LEN];
+} TC6Sim_Frame_t;
+
+typedef struct
+{
+    TC6Sim_Frame_t frame[TC6SIM_FRAME_QSIZE];
+    uint8_t head;
+    uint8_t tail;
+} TC6Sim_FrameQueue_t;
+
+typedef struct TC6Sim_Bus TC6Sim_Bus_t;
+
+/** Emulated MACPHY. Integrator needs to allocate it (as part of TC6Sim_Bus_t). But the elements must not be accessed. */
+typedef struct
+{
+    TC6Sim_Bus_t *pBus;
+    uint32_t regAddr[TC6SIM_MAX_REGS];
+    uint32_t regValue[TC6SIM_MAX_REGS];
+    uint16_t regCount;
+    TC6Sim_FrameQueue_t txQ;
+    TC6Sim_FrameQueue_t rxQ;
+    TC6Sim_Frame_t txAsm;       /** Frame currently assembled from MOSI chunks */
+    bool txAsmActive;
+    uint16_t rxOffset;          /** Bytes of the head RX frame already sent over MISO */
+    uint64_t backoff;           /** CSMA/CD: earliest time of the next attempt */
+    uint8_t attempts;           /** CSMA/CD: collisions of the current frame */
+    uint8_t instance;
+    bool creditIrq;             /** TX credits became available since the last data transaction */
+    TC6Sim_NodeStats_t stats;
+} TC6Sim_Node_t;
+
+struct TC6Sim_Bus
+{
+    TC6Sim_BusConfig_t cfg;
+    TC6Sim_Node_t node[TC6SIM_MAX_NODES];
+    uint8_t nodeCount;
+    uint8_t plcaTo;             /** Current PLCA transmit opportunity */
+    uint32_t random;
+    TC6Sim_BusStats_t stats;
+};
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                          PUBLIC FUNCTIONS                            */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+/** \brief Initializes an empty segment.
+ *  \param pBus - Segment to initialize.
+ *  \param pConfig - Timing and random seed. NULL selects the defaults.
+ */
+void TC6Sim_BusInit(TC6Sim_Bus_t *pBus, const TC6Sim_BusConfig_t *pConfig);
+
+/** \brief Attaches a new emulated MACPHY in reset default state to the segment.
+ *  \param pBus - The segment.
+ *  \param tc6instance - The libtc6 instance number driving this MACPHY.
+ *  \return Pointer to the node, NULL if TC6SIM_MAX_NODES are attached already.
+ */
+TC6Sim_Node_t *TC6Sim_AddNode(TC6Sim_Bus_t *pBus, uint8_t tc6instance);
+
+/** \brief Returns the node driven by the given libtc6 instance.
+ *  \return Pointer to the node, NULL if unknown.
+ */
+TC6Sim_Node_t *TC6Sim_GetNode(TC6Sim_Bus_t *pBus, uint8_t tc6instance);
+
+/** \brief Runs the segment for the given time. A frame started within this time is completed.
+ *  \param pBus - The segment.
+ *  \param bitTimes - Time to run in bit times.
+ */
+void TC6Sim_BusRun(TC6Sim_Bus_t *pBus, uint32_t bitTimes);
+
+/** \brief Returns the statistics of the segment. */
+void TC6Sim_GetBusStats(const TC6Sim_Bus_t *pBus, TC6Sim_BusStats_t *pStats);
+
+/** \brief Processes a complete SPI transaction of the host.
+ *  \note Call this from TC6_CB_OnSpiTransaction() and TC6_SpiBufferDone() afterwards (see tc6sim-port.c).
+ *  \param pNode - The addressed MACPHY.
+ *  \param pTx - MOSI data.
+ *  \param pRx - Buffer receiving the MISO data.
+ *  \param len - Length of the transaction.
+ *  \return true, if the transaction was processed. false, on invalid length.
+ */
+bool TC6Sim_SpiTransaction(TC6Sim_Node_t *pNode, const uint8_t *pTx, uint8_t *pRx, uint16_t len);
+
+/** \brief Returns the level of the IRQ_N pin.
+ *  \return true, if IRQ_N is asserted (low). Pass the negated value to TC6_Service().
+ */
+bool TC6Sim_IrqAsserted(const TC6Sim_Node_t *pNode);
+
+/** \brief Sets a register without side effects, e.g. to emulate a different chip revision. */
+void TC6Sim_SetRegister(TC6Sim_Node_t *pNode, uint32_t addr, uint32_t value);
+
+/** \brief Returns the current value of a register. */
+uint32_t TC6Sim_GetRegister(const TC6Sim_Node_t *pNode, uint32_t addr);
+
+/** \brief Places a frame directly into the TX buffer, to emulate stations not driven by libtc6.
+ *  \return true, if the frame was queued. false, if the TX buffer is full.
+ */
+bool TC6Sim_SendFrame(TC6Sim_Node_t *pNode, const uint8_t *pEth, uint16_t len);
+
+/** \brief Returns the statistics of a node. */
+void TC6Sim_GetNodeStats(const TC6Sim_Node_t *pNode, TC6Sim_NodeStats_t *pStats);
+
+/** \brief Attaches a segment to the TC6_CB_OnSpiTransaction() implementation of tc6sim-port.c.
+ *  \note Call it once per segment (TC6SIM_PORT_MAX_BUSES, default 2), the libtc6 instance numbers must be unique
+ *        across all segments. Link tc6sim-port.c only if the host application does not implement
+ *        TC6_CB_OnSpiTransaction() itself.
+ */
+void TC6Sim_PortAttach(TC6Sim_Bus_t *pBus);
+
+/** \brief Selects when the TC6_CB_OnSpiTransaction() implementation of tc6sim-port.c calls TC6_SpiBufferDone().
+ *  \param deferred - false: within TC6_CB_OnSpiTransaction() (default). true: from TC6Sim_PortComplete() only,
+ *         so SPI_FULL_BUFFERS > 1 lets libtc6 start the next transaction before the previous one is processed.
+ *  \note TC6_Reset() waits for the running transaction, select deferred mode after the initialization.
+ */
+void TC6Sim_PortSetDeferred(bool deferred);
+
+/** \brief Completes the transactions deferred by TC6Sim_PortSetDeferred(), call it between two TC6_Service() calls. */
+void TC6Sim_PortComplete(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TC6_SIM_H_ */
@@ -49,7 +49,7 @@ struct qtxeth {
 struct qspibuf {
     uint8_t txBuff[TC6_SPI_BUF_SIZE];
     uint8_t rxBuff[TC6_SPI_BUF_SIZE];
-    uint16_t length;
+    uint32_t length; /* 32 bit wide, keeps txBuff / rxBuff of every queue entry word aligned for DMA */
 };
 
 enum register_op_type
@@ -71,6 +71,7 @@ struct register_operation {
     uint32_t modifyMask;
     uint32_t regAddr;
     uint16_t length;
+    uint8_t callbackCount; /* Number of merged operations, the callback is raised once for each of them */
     bool secure;
 };
 
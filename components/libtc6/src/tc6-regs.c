@@ -45,18 +45,72 @@ Microchip or any third party.
 
 #define DELAY_UNLOCK_EXT        (100u)
 #define CONTROL_PROTECTION      (true)
+#define CHIP_READ_MAX           (8u)
 
 /*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
 /*                      DEFINES AND LOCAL VARIABLES                     */
 /*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
 
+/* Steps of the initialization, each one enqueues register accesses. The steps run as far as the control
+ * queue takes them and only wait for results they depend on (chip revision, trim values) */
+typedef enum
+{
+    InitStep_Idle,
+    InitStep_SoftReset,
+    InitStep_SoftResetProtected,
+    InitStep_ReadId1,
+    InitStep_ReadId2,
+    InitStep_MemoryMap,
+    InitStep_Config,
+    InitStep_ConfigRev2,
+    InitStep_MacBottom2,
+    InitStep_MacTop2,
+    InitStep_MacBottom1,
+    InitStep_Promiscuous,
+    InitStep_TrimRead,
+    InitStep_TrimWrite,
+    InitStep_Plca,
+    InitStep_Config0,
+    InitStep_NetworkControl,
+    InitStep_Done
+} InitStep_t;
+
+/* Register accesses of the status flag handling, one at a time. A step the control queue did not take is
+ * retried by TC6Regs_CheckTimers() */
+typedef enum
+{
+    StatusStep_None,
+    StatusStep_ReadStatus0,
+    StatusStep_ClearStatus0,
+    StatusStep_ReadStatus1,
+    StatusStep_ClearStatus1,
+    StatusStep_ReadExtBlock
+} StatusStep_t;
+
 typedef struct
 {
     uint8_t mac[6];
     TC6_t *pTC6;
     void *pTag;
     uint32_t unlockExtTime;
-    uint32_t readResult;
+    uint32_t phyId;
+    uint32_t cachedPhyId;
+    uint16_t trim[TC6REGS_TRIM_COUNT];
+    uint16_t cachedTrim[TC6REGS_TRIM_COUNT];
+    uint8_t cachedRev;
+    bool trimCached;
+    bool trimValid;
+    const MemoryMap_t *pBatch;
+    MemoryMap_t trimMap[TC6REGS_TRIM_COUNT];
+    uint32_t batchResult[CHIP_READ_MAX];
+    uint32_t statusValue;
+    uint16_t batchLength;
+    uint16_t batchQueued;
+    uint16_t batchDone;
+    uint16_t batchReads;
+    InitStep_t initStep;
+    StatusStep_t statusStep;
+    uint8_t plcaStep;
     uint8_t nodeId;
     uint8_t nodeCount;
     uint8_t burstCount;
@@ -80,16 +134,19 @@ static TC6Reg_t m_reg[TC6_MAX_INSTANCES] = { 0 };
 
 static TC6Reg_t *GetContext(TC6_t *pTC6);
 static void DoInitialization(TC6Reg_t *pReg);
-static void HandlePlca(TC6Reg_t *pReg);
+static void AdvanceInit(TC6Reg_t *pReg);
+static bool HandlePlca(TC6Reg_t *pReg);
 static void OnSoftResetCB(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *pTag, void *pGlobalTag);
 static void OnReadId1(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *pTag, void *pGlobalTag);
 static void OnReadId2(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *pTag, void *pGlobalTag);
 static void OnInitialRegCB(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *pTag, void *pGlobalTag);
-static void OnChipResult(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *tag, void *pGlobalTag);
-static bool ReadReg(TC6_t *pInst, uint32_t addr, uint32_t *pVal);
-static bool ReadIndirectReg(TC6_t *pInst, uint32_t addr, uint32_t *pVal, uint32_t mask);
+static void OnBatchCB(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *tag, void *pGlobalTag);
+static bool RunBatch(TC6Reg_t *pReg, const MemoryMap_t *pMap, uint16_t mapLength);
 static int8_t GetSignedVal(uint32_t val);
-static void InitChip(TC6_t *pInst);
+static bool ReadTrim(TC6Reg_t *pReg);
+static bool CheckChip(TC6Reg_t *pReg, int8_t *pOffset1);
+static bool WriteTrim(TC6Reg_t *pReg);
+static void NextStatus(TC6Reg_t *pReg, StatusStep_t step, uint32_t value);
 
 static void OnInitDone(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *pTag, void *pGlobalTag);
 static void OnExtendedBlock(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *tag, void *pGlobalTag);
@@ -127,15 +184,21 @@ void TC6Regs_CheckTimers(void)
     /* Find existing entry */
     for (i = 0u; i < TC6_MAX_INSTANCES; i++) {
         TC6Reg_t *pReg = &m_reg[i];
-        if ((0u != pReg->unlockExtTime) && ((TC6Regs_CB_GetTicksMs() - pReg->unlockExtTime) >= DELAY_UNLOCK_EXT)) {
-            pReg->unlockExtTime = 0;
-            TC6_UnlockExtendedStatus(pReg->pTC6);
-        }
-        DoInitialization(pReg);
+        /* Entries without TC6Regs_Init() call (less chips than TC6_MAX_INSTANCES) are skipped */
+        if (NULL != pReg->pTC6) {
+            if ((0u != pReg->unlockExtTime) && ((TC6Regs_CB_GetTicksMs() - pReg->unlockExtTime) >= DELAY_UNLOCK_EXT)) {
+                pReg->unlockExtTime = 0;
+                TC6_UnlockExtendedStatus(pReg->pTC6);
+            }
+            DoInitialization(pReg);
 
-        if (pReg->plcaChanged) {
-            pReg->plcaChanged = false;
-            HandlePlca(pReg);
+            /* A running initialization writes the PLCA settings itself */
+            if (pReg->plcaChanged && (InitStep_Done == pReg->initStep) && HandlePlca(pReg)) {
+                pReg->plcaChanged = false;
+            }
+            if (StatusStep_None != pReg->statusStep) {
+                NextStatus(pReg, pReg->statusStep, pReg->statusValue);
+            }
         }
     }
 }
@@ -179,6 +242,35 @@ uint8_t TC6Regs_GetChipRevision(TC6_t *pTC6)
     return pReg->chipRev;
 }
 
+void TC6Regs_SetCachedTrim(TC6_t *pTC6, uint32_t phyId, uint8_t chipRev, const uint16_t trim[TC6REGS_TRIM_COUNT])
+{
+    TC6Reg_t *pReg = GetContext(pTC6);
+    if ((NULL != pReg) && (NULL != trim)) {
+        pReg->cachedPhyId = phyId;
+        pReg->cachedRev = chipRev;
+        (void)memcpy(pReg->cachedTrim, trim, sizeof(pReg->cachedTrim));
+        pReg->trimCached = true;
+    }
+}
+
+bool TC6Regs_GetTrim(TC6_t *pTC6, uint32_t *pPhyId, uint8_t *pChipRev, uint16_t trim[TC6REGS_TRIM_COUNT])
+{
+    TC6Reg_t *pReg = GetContext(pTC6);
+    bool valid = ((NULL != pReg) && pReg->trimValid);
+    if (valid) {
+        if (NULL != pPhyId) {
+            *pPhyId = pReg->phyId;
+        }
+        if (NULL != pChipRev) {
+            *pChipRev = pReg->chipRev;
+        }
+        if (NULL != trim) {
+            (void)memcpy(trim, pReg->trim, sizeof(pReg->trim));
+        }
+    }
+    return valid;
+}
+
 /*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
 /*                  CALLBACK FUNCTIONS FROM TC6 STACK                   */
 /*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
@@ -188,9 +280,7 @@ void TC6_CB_OnExtendedStatus(TC6_t *pInst, void *pGlobalTag)
    (void)pGlobalTag;
     TC6Reg_t *pReg = GetContext(pInst);
     pReg->unlockExtTime = TC6Regs_CB_GetTicksMs();
-    while (!TC6_ReadRegister(pInst, 0x00000008, CONTROL_PROTECTION, OnStatus0, NULL)) {
-        TC6_Service(pInst, true);
-    }
+    NextStatus(pReg, StatusStep_ReadStatus0, 0u);
 }
 
 /*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
@@ -218,10 +308,27 @@ static TC6Reg_t *GetContext(TC6_t *pTC6)
 }
 
 static void DoInitialization(TC6Reg_t *pReg)
+{
+    if ((NULL != pReg) && !pReg->initialized) {
+        /* Accesses of a failed attempt are called back as failed by TC6_Reset() and then forgotten */
+        pReg->initStep = InitStep_Idle;
+        TC6_Reset(pReg->pTC6);
+        pReg->initialized = true;
+        pReg->initDone = false;
+        pReg->chipRev = 0xFFu;
+        pReg->pBatch = NULL;
+        pReg->batchQueued = 0u;
+        pReg->plcaStep = 0u;
+        pReg->initStep = InitStep_SoftReset;
+    }
+    AdvanceInit(pReg);
+}
+
+static void AdvanceInit(TC6Reg_t *pReg)
 {
     uint32_t regVal;
-    uint16_t i = 0;
-    
+    bool next = true;
+
     /*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
     /*                          AUTO GENERATED DEFINES                      */
     /*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
@@ -262,111 +369,128 @@ static void DoInitialization(TC6Reg_t *pReg)
         {  .address=0x00040081,  .value=0x000000E0,  .mask=0x00000000,  .op=MemOp_Write,  .secure=true  }, /* DEEP_SLEEP_CTRL_1 */
     };
 
-    static const uint32_t TC6_MEMMAP_LENGTH = (sizeof(TC6_MEMMAP) / sizeof(MemoryMap_t));
-
-    if ((NULL != pReg) && !pReg->initialized) {
-        pReg->initialized = true;
-        TC6_Reset(pReg->pTC6);
-        /* Perform Soft Reset with unprotected call */
-        while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x00000003u /* RESET */, 0x1u, false, OnSoftResetCB, NULL)) {
-            TC6_Service(pReg->pTC6, true);
-        }
-        /* Perform Soft Reset with protected call */
-        while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x00000003u /* RESET */, 0x1u, true, OnSoftResetCB, NULL)) {
-            TC6_Service(pReg->pTC6, true);
-        }
-        while (pReg->initialized && !TC6_ReadRegister(pReg->pTC6, 0x00000001, false, OnReadId1, NULL)) {
-            TC6_Service(pReg->pTC6, true);
-        }
-        pReg->chipRev = 0xFFu;
-        while (pReg->initialized && !TC6_ReadRegister(pReg->pTC6, 0x000A0094, false, OnReadId2, NULL)) {
-            TC6_Service(pReg->pTC6, true);
-        }
-        while (pReg->initialized && (0xFFu == pReg->chipRev)) {
-            /* Wait until Chip Revision is reported back */
-            TC6_Service(pReg->pTC6, true);
-        }
-        /* Start with default settings */
-        while (pReg->initialized && (i < TC6_MEMMAP_LENGTH)) {
-            i += TC6_MultipleRegisterAccess(pReg->pTC6, &TC6_MEMMAP[i], (TC6_MEMMAP_LENGTH - i), OnInitialRegCB, NULL);
-            if (i != TC6_MEMMAP_LENGTH) {
-                TC6_Service(pReg->pTC6, true);
-            }
-        }
-        regVal = (1u == pReg->chipRev) ? 0x5F21ul : 0x3F31ul;
-        while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x000400D0, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL)) {
-            TC6_Service(pReg->pTC6, true);
-        }
-        while (pReg->initialized && (2u == pReg->chipRev) && !TC6_WriteRegister(pReg->pTC6, 0x000400E0, 0x0000C000, CONTROL_PROTECTION, OnInitialRegCB, NULL)) {
-            TC6_Service(pReg->pTC6, true);
-        }
-        /* MAC address setting */
-        regVal = ((uint32_t)pReg->mac[3] << 24) | ((uint32_t)pReg->mac[2] << 16) | ((uint32_t)pReg->mac[1] << 8) | (uint32_t)pReg->mac[0];
-        while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x00010024u /* SPEC_ADD2_BOTTOM */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL)) {
-            TC6_Service(pReg->pTC6, true);
-        }
-        regVal = ((uint32_t)pReg->mac[5] << 8) | (uint32_t)pReg->mac[4];
-        while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x00010025u /* SPEC_ADD2_TOP */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL)) {
-            TC6_Service(pReg->pTC6, true);
-        }
-        /* MAC address setting, setting unique lower MAC address, back off time is generated out of that */
-        regVal = ((uint32_t)pReg->mac[5] << 24) | ((uint32_t)pReg->mac[4] << 16) | ((uint32_t)pReg->mac[3] << 8) | (uint32_t)pReg->mac[2];
-        while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x00010022u /* SPEC_ADD1_BOTTOM */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL)) {
-            TC6_Service(pReg->pTC6, true);
-        }
-
-        /* Promiscuous mode setting */
-        regVal = pReg->promiscuous ? 0x10 : 0x0;
-        while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x00010001 /* NETWORK_CONFIG */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL)) {
-            TC6_Service(pReg->pTC6, true);
-        }
-        if (pReg->initialized) {
-            InitChip(pReg->pTC6);
-        }
-
-        HandlePlca(pReg);
-
-        /* Cut Through / Store and Forward mode */
-        regVal = 0x9026;
-        if (pReg->txCutThrough) {
-            regVal |= 0x200u;
-        }
-        if (pReg->rxCutThrough) {
-            regVal |= 0x100u;
-        }
-        while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x00000004 /* CONFIG0 */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL)) {
-            TC6_Service(pReg->pTC6, true);
+    static const uint16_t TC6_MEMMAP_LENGTH = (sizeof(TC6_MEMMAP) / sizeof(MemoryMap_t));
+
+    /* Enqueues steps until the control queue is full or a step waits for a result, the callbacks of the
+     * enqueued accesses and TC6Regs_CheckTimers() continue from there */
+    while (next && (NULL != pReg) && pReg->initialized && (InitStep_Idle != pReg->initStep) && (InitStep_Done != pReg->initStep)) {
+        switch (pReg->initStep) {
+            case InitStep_SoftReset:
+                /* Perform Soft Reset with unprotected call */
+                next = TC6_WriteRegister(pReg->pTC6, 0x00000003u /* RESET */, 0x1u, false, OnSoftResetCB, NULL);
+                break;
+            case InitStep_SoftResetProtected:
+                /* Perform Soft Reset with protected call */
+                next = TC6_WriteRegister(pReg->pTC6, 0x00000003u /* RESET */, 0x1u, true, OnSoftResetCB, NULL);
+                break;
+            case InitStep_ReadId1:
+                next = TC6_ReadRegister(pReg->pTC6, 0x00000001, false, OnReadId1, NULL);
+                break;
+            case InitStep_ReadId2:
+                next = TC6_ReadRegister(pReg->pTC6, 0x000A0094, false, OnReadId2, NULL);
+                break;
+            case InitStep_MemoryMap:
+                /* Start with default settings, they do not depend on the chip revision read before */
+                pReg->batchQueued += TC6_MultipleRegisterAccess(pReg->pTC6, &TC6_MEMMAP[pReg->batchQueued], (TC6_MEMMAP_LENGTH - pReg->batchQueued), OnInitialRegCB, NULL);
+                next = (pReg->batchQueued == TC6_MEMMAP_LENGTH);
+                break;
+            case InitStep_Config:
+                /* Waits until Chip Revision is reported back */
+                regVal = (1u == pReg->chipRev) ? 0x5F21ul : 0x3F31ul;
+                next = (0xFFu != pReg->chipRev) && TC6_WriteRegister(pReg->pTC6, 0x000400D0, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL);
+                break;
+            case InitStep_ConfigRev2:
+                next = (2u != pReg->chipRev) || TC6_WriteRegister(pReg->pTC6, 0x000400E0, 0x0000C000, CONTROL_PROTECTION, OnInitialRegCB, NULL);
+                break;
+            case InitStep_MacBottom2:
+                /* MAC address setting */
+                regVal = ((uint32_t)pReg->mac[3] << 24) | ((uint32_t)pReg->mac[2] << 16) | ((uint32_t)pReg->mac[1] << 8) | (uint32_t)pReg->mac[0];
+                next = TC6_WriteRegister(pReg->pTC6, 0x00010024u /* SPEC_ADD2_BOTTOM */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL);
+                break;
+            case InitStep_MacTop2:
+                regVal = ((uint32_t)pReg->mac[5] << 8) | (uint32_t)pReg->mac[4];
+                next = TC6_WriteRegister(pReg->pTC6, 0x00010025u /* SPEC_ADD2_TOP */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL);
+                break;
+            case InitStep_MacBottom1:
+                /* MAC address setting, setting unique lower MAC address, back off time is generated out of that */
+                regVal = ((uint32_t)pReg->mac[5] << 24) | ((uint32_t)pReg->mac[4] << 16) | ((uint32_t)pReg->mac[3] << 8) | (uint32_t)pReg->mac[2];
+                next = TC6_WriteRegister(pReg->pTC6, 0x00010022u /* SPEC_ADD1_BOTTOM */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL);
+                break;
+            case InitStep_Promiscuous:
+                /* Promiscuous mode setting */
+                regVal = pReg->promiscuous ? 0x10 : 0x0;
+                next = TC6_WriteRegister(pReg->pTC6, 0x00010001 /* NETWORK_CONFIG */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL);
+                break;
+            case InitStep_TrimRead:
+                next = ReadTrim(pReg);
+                break;
+            case InitStep_TrimWrite:
+                next = WriteTrim(pReg);
+                break;
+            case InitStep_Plca:
+                next = HandlePlca(pReg);
+                break;
+            case InitStep_Config0:
+                /* Cut Through / Store and Forward mode */
+                regVal = 0x9026;
+                if (pReg->txCutThrough) {
+                    regVal |= 0x200u;
+                }
+                if (pReg->rxCutThrough) {
+                    regVal |= 0x100u;
+                }
+                next = TC6_WriteRegister(pReg->pTC6, 0x00000004 /* CONFIG0 */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL);
+                break;
+            case InitStep_NetworkControl:
+                next = TC6_WriteRegister(pReg->pTC6, 0x00010000 /* NETWORK_CONTROL */, 0xCu, CONTROL_PROTECTION, OnInitDone, NULL);
+                break;
+            default:
+                next = false;
+                break;
         }
-        while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x00010000 /* NETWORK_CONTROL */, 0xCu, CONTROL_PROTECTION, OnInitDone, NULL)) {
-            TC6_Service(pReg->pTC6, true);
+        if (next) {
+            pReg->initStep = (InitStep_t)(pReg->initStep + 1u);
+            pReg->batchQueued = 0u;
         }
     }
 }
 
-static void HandlePlca(TC6Reg_t *pReg)
+static bool HandlePlca(TC6Reg_t *pReg)
 {
-    /* Collision Detection */
-    uint32_t regVal = pReg->enablePlca ? 0x0083u : 0x8083u;
-    while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x00040087u /* COL_DET_CTRL0 */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL)) {
-        TC6_Service(pReg->pTC6, true);
-    }
-    if (pReg->initialized && pReg->enablePlca) {
-        /* T1S Phy Node Id and Max Node Count */
-        regVal = ((uint32_t)pReg->nodeCount << 8) | pReg->nodeId;
-        while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x0004CA02 /* PLCA_CONTROL_1_REGISTER */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL)) {
-            TC6_Service(pReg->pTC6, true);
-        }
-        /* PLCA Burst Count and Burst Timer */
-        regVal = ((uint32_t)pReg->burstCount << 8) | pReg->burstTimer;
-        while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x0004CA05 /* PLCA_BURST_MODE_REGISTER */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL)) {
-            TC6_Service(pReg->pTC6, true);
-        }
-        /* Enable PLCA */
-        regVal = ((uint32_t)1u << 15);
-        while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x0004CA01/* PLCA_CONTROL_0_REGISTER */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL)) {
-            TC6_Service(pReg->pTC6, true);
-        }
-    }
+    uint32_t regVal;
+    bool next = true;
+    /* Continues with the access the control queue did not take last time */
+    while (next && (pReg->plcaStep < 4u)) {
+        switch (pReg->plcaStep) {
+            case 0u:
+                /* Collision Detection */
+                regVal = pReg->enablePlca ? 0x0083u : 0x8083u;
+                next = TC6_WriteRegister(pReg->pTC6, 0x00040087u /* COL_DET_CTRL0 */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL);
+                break;
+            case 1u:
+                /* T1S Phy Node Id and Max Node Count */
+                regVal = ((uint32_t)pReg->nodeCount << 8) | pReg->nodeId;
+                next = !pReg->enablePlca || TC6_WriteRegister(pReg->pTC6, 0x0004CA02 /* PLCA_CONTROL_1_REGISTER */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL);
+                break;
+            case 2u:
+                /* PLCA Burst Count and Burst Timer */
+                regVal = ((uint32_t)pReg->burstCount << 8) | pReg->burstTimer;
+                next = !pReg->enablePlca || TC6_WriteRegister(pReg->pTC6, 0x0004CA05 /* PLCA_BURST_MODE_REGISTER */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL);
+                break;
+            default:
+                /* Enable PLCA */
+                regVal = ((uint32_t)1u << 15);
+                next = !pReg->enablePlca || TC6_WriteRegister(pReg->pTC6, 0x0004CA01/* PLCA_CONTROL_0_REGISTER */, regVal, CONTROL_PROTECTION, OnInitialRegCB, NULL);
+                break;
+        }
+        if (next) {
+            pReg->plcaStep++;
+        }
+    }
+    if (next) {
+        pReg->plcaStep = 0u;
+    }
+    return next;
 }
 
 static void OnSoftResetCB(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *pTag, void *pGlobalTag)
@@ -377,7 +501,8 @@ static void OnSoftResetCB(TC6_t *pInst, bool success, uint32_t addr, uint32_t va
     (void)value;
     (void)pTag;
     (void)pGlobalTag;
-    /* Silently ignore anything */
+    /* Silently ignore anything, only continue with the initialization */
+    AdvanceInit(GetContext(pInst));
 }
 
 static void OnReadId1(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *pTag, void *pGlobalTag)
@@ -390,12 +515,14 @@ static void OnReadId1(TC6_t *pInst, bool success, uint32_t addr, uint32_t value,
     pReg->initialized &= success;
     if (success) {
         uint32_t oui = value >> 10;
+        pReg->phyId = value;
         uint32_t model = (value >> 4) & 0x3FFu;
         if ((0x1F0u != oui) || (0x1Bu != model)) {
             TC6Regs_CB_OnEvent(pInst, TC6Regs_Event_Unsupported_Hardware, pReg->pTag);
             pReg->initialized = false;
         }
     }
+    AdvanceInit(pReg);
 }
 
 static void OnReadId2(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *pTag, void *pGlobalTag)
@@ -413,6 +540,7 @@ static void OnReadId2(TC6_t *pInst, bool success, uint32_t addr, uint32_t value,
             pReg->initialized = false;
         }
     }
+    AdvanceInit(pReg);
 }
 
 static void OnInitialRegCB(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *pTag, void *pGlobalTag)
@@ -424,60 +552,42 @@ static void OnInitialRegCB(TC6_t *pInst, bool success, uint32_t addr, uint32_t v
     (void)pTag;
     (void)pGlobalTag;
     pReg->initialized &= success;
+    AdvanceInit(pReg);
 }
 
-static void OnChipResult(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *tag, void *pGlobalTag)
+static void OnBatchCB(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *tag, void *pGlobalTag)
 {
     TC6Reg_t *pReg = GetContext(pInst);
     (void)addr;
-    (void)value;
     (void)tag;
     (void)pGlobalTag;
     pReg->initialized &= success;
-    if (success) {
-        pReg->readResult = value;
-    } else {
-        pReg->readResult = 0xFFFFFFFEu;
-    }
-}
-
-static bool ReadReg(TC6_t *pInst, uint32_t addr, uint32_t *pVal)
-{
-    TC6Reg_t *pReg = GetContext(pInst);
-    pReg->readResult = 0xFFFFFFFFu;
-    while (pReg->initialized && !TC6_ReadRegister(pInst, addr, CONTROL_PROTECTION, OnChipResult, NULL)) {
-        TC6_Service(pInst, true);
-    }
-    while(pReg->initialized && (0xFFFFFFFFu == pReg->readResult)) {
-        TC6_Service(pInst, true);
-    }
-    if (NULL != pVal) {
-        *pVal = pReg->readResult;
+    /* Register operations complete in the order of the map */
+    if ((pReg->batchDone < pReg->batchLength) && (MemOp_Read == pReg->pBatch[pReg->batchDone].op)) {
+        if (pReg->batchReads < CHIP_READ_MAX) {
+            pReg->batchResult[pReg->batchReads] = value;
+        }
+        pReg->batchReads++;
     }
-    return (0xFFFFFFFEu != pReg->readResult);
+    pReg->batchDone++;
+    AdvanceInit(pReg);
 }
 
-static bool ReadIndirectReg(TC6_t *pInst, uint32_t addr, uint32_t *pVal, uint32_t mask)
+static bool RunBatch(TC6Reg_t *pReg, const MemoryMap_t *pMap, uint16_t mapLength)
 {
-    TC6Reg_t *pReg = GetContext(pInst);
-    uint32_t regVal = (addr & 0x000Fu);
-    while (pReg->initialized && !TC6_WriteRegister(pInst, 0x000400D8, regVal, CONTROL_PROTECTION, NULL, NULL)) {
-        TC6_Service(pInst, true);
-    }
-    while (pReg->initialized && !TC6_WriteRegister(pInst, 0x000400DA, 0x0002, CONTROL_PROTECTION, NULL, NULL)) {
-        TC6_Service(pInst, true);
-    }
-    pReg->readResult = 0xFFFFFFFFu;
-    while (pReg->initialized && !TC6_ReadRegister(pInst, 0x000400D9, CONTROL_PROTECTION, OnChipResult, NULL)) {
-        TC6_Service(pInst, true);
-    }
-    while(pReg->initialized && (0xFFFFFFFFu == pReg->readResult)) {
-        TC6_Service(pInst, true);
-    }
-    if (NULL != pVal) {
-        *pVal = (pReg->readResult & mask);
-    }
-    return (0xFFFFFFFEu != pReg->readResult);
+    if (pReg->pBatch != pMap) {
+        pReg->pBatch = pMap;
+        pReg->batchLength = mapLength;
+        pReg->batchQueued = 0u;
+        pReg->batchDone = 0u;
+        pReg->batchReads = 0u;
+    }
+    /* Enqueue the rest of the map, the control queue pipelines it without waiting for single results */
+    if (pReg->batchQueued < mapLength) {
+        pReg->batchQueued += TC6_MultipleRegisterAccess(pReg->pTC6, &pMap[pReg->batchQueued], (mapLength - pReg->batchQueued), OnBatchCB, NULL);
+    }
+    /* Done, once every access was called back (OnBatchCB continues the initialization) */
+    return pReg->initialized && (pReg->batchDone == mapLength);
 }
 
 static int8_t GetSignedVal(uint32_t val)
@@ -493,10 +603,30 @@ static int8_t GetSignedVal(uint32_t val)
     return result;
 }
 
-static void InitChip(TC6_t *pInst)
+static bool ReadTrim(TC6Reg_t *pReg)
 {
-    TC6Reg_t *pReg = GetContext(pInst);
-    uint32_t val;
+    /* All trim values are read with a single pipelined burst. Indirect registers are read by
+     * selecting the address in 0xD8, triggering the read with 0xDA and fetching 0xD9. */
+    static const MemoryMap_t CHIP_READ_MAP[] = {
+        {  .address=0x000400D8,  .value=0x00000005,  .mask=0x00000000,  .op=MemOp_Write,  .secure=CONTROL_PROTECTION },
+        {  .address=0x000400DA,  .value=0x00000002,  .mask=0x00000000,  .op=MemOp_Write,  .secure=CONTROL_PROTECTION },
+        {  .address=0x000400D9,  .value=0x00000000,  .mask=0x00000000,  .op=MemOp_Read,   .secure=CONTROL_PROTECTION }, /* Indirect 0x5 */
+        {  .address=0x000400D8,  .value=0x00000004,  .mask=0x00000000,  .op=MemOp_Write,  .secure=CONTROL_PROTECTION },
+        {  .address=0x000400DA,  .value=0x00000002,  .mask=0x00000000,  .op=MemOp_Write,  .secure=CONTROL_PROTECTION },
+        {  .address=0x000400D9,  .value=0x00000000,  .mask=0x00000000,  .op=MemOp_Read,   .secure=CONTROL_PROTECTION }, /* Indirect 0x4 */
+        {  .address=0x000400D8,  .value=0x00000008,  .mask=0x00000000,  .op=MemOp_Write,  .secure=CONTROL_PROTECTION },
+        {  .address=0x000400DA,  .value=0x00000002,  .mask=0x00000000,  .op=MemOp_Write,  .secure=CONTROL_PROTECTION },
+        {  .address=0x000400D9,  .value=0x00000000,  .mask=0x00000000,  .op=MemOp_Read,   .secure=CONTROL_PROTECTION }, /* Indirect 0x8 */
+        {  .address=0x00040084,  .value=0x00000000,  .mask=0x00000000,  .op=MemOp_Read,   .secure=CONTROL_PROTECTION },
+        {  .address=0x0004008A,  .value=0x00000000,  .mask=0x00000000,  .op=MemOp_Read,   .secure=CONTROL_PROTECTION },
+        {  .address=0x000400AD,  .value=0x00000000,  .mask=0x00000000,  .op=MemOp_Read,   .secure=CONTROL_PROTECTION },
+        {  .address=0x000400AE,  .value=0x00000000,  .mask=0x00000000,  .op=MemOp_Read,   .secure=CONTROL_PROTECTION },
+        {  .address=0x000400AF,  .value=0x00000000,  .mask=0x00000000,  .op=MemOp_Read,   .secure=CONTROL_PROTECTION },
+    };
+    static const uint16_t CHIP_READ_MAP_LENGTH = (sizeof(CHIP_READ_MAP) / sizeof(MemoryMap_t));
+    /* Indirect 0x5 and 0x4 only, the chip checks are done with cached trim values as well */
+    static const uint16_t CHIP_CHECK_MAP_LENGTH = 6u;
+
     int16_t tempParam;
     uint16_t cfgParam;
     int8_t initOffset1 = 0;
@@ -506,95 +636,115 @@ static void InitChip(TC6_t *pInst)
     uint16_t initValue5 = 0u;
     uint16_t initValue6 = 0u;
     uint16_t initValue7 = 0u;
-    if (ReadIndirectReg(pInst, 0x5, &val, 0x40)) {
-        if (0u == val) {
-            TC6Regs_CB_OnEvent(pInst, TC6Regs_Event_Chip_Error, pReg->pTag);
-            pReg->initialized = false;
-        }
-    }
-    if (pReg->initialized && ReadIndirectReg(pInst, 0x4, &val, 0x1F)) {
-        initOffset1 = GetSignedVal(val);
-        if (initOffset1 < -5) {
-            TC6Regs_CB_OnEvent(pInst, TC6Regs_Event_Chip_Error, pReg->pTag);
-            pReg->initialized = false;
-        }
-    }
-    if (pReg->initialized && ReadIndirectReg(pInst, 0x8, &val, 0x1F)) {
-        initOffset2 = GetSignedVal(val);
-    }
-    if (pReg->initialized && ReadReg(pInst, 0x00040084, &val)) {
-        initValue3 = (uint8_t)val;
-    }
-    if (pReg->initialized && ReadReg(pInst, 0x0004008A, &val)) {
-        initValue4 = (uint8_t)val;
-    }
-    if (pReg->initialized && ReadReg(pInst, 0x000400AD, &val)) {
-        initValue5 = (uint8_t)val;
-    }
-    if (pReg->initialized && ReadReg(pInst, 0x000400AE, &val)) {
-        initValue6 = (uint8_t)val;
-    }
-    if (pReg->initialized && ReadReg(pInst, 0x000400AF, &val)) {
-        initValue7 = (uint8_t)val;
-    }
+    bool done = true;
+    bool cached = pReg->trimCached && (pReg->cachedPhyId == pReg->phyId) && (pReg->cachedRev == pReg->chipRev);
+
+    pReg->trimValid = false;
+    if (!RunBatch(pReg, CHIP_READ_MAP, cached ? CHIP_CHECK_MAP_LENGTH : CHIP_READ_MAP_LENGTH)) {
+        /* Burst still running, OnBatchCB continues once all values are read */
+        done = false;
+    } else if (!CheckChip(pReg, &initOffset1)) {
+        /* The cached trim values are dropped as well, the restart reads and computes them again */
+        pReg->trimCached = false;
+    } else if (cached) {
+        /* Same chip as on a previous boot, skip reading and computing the trim values */
+        (void)memcpy(pReg->trim, pReg->cachedTrim, sizeof(pReg->trim));
+    } else {
+        initOffset2 = GetSignedVal(pReg->batchResult[2] & 0x1Fu);
+        initValue3 = (uint8_t)pReg->batchResult[3];
+        initValue4 = (uint8_t)pReg->batchResult[4];
+        initValue5 = (uint8_t)pReg->batchResult[5];
+        initValue6 = (uint8_t)pReg->batchResult[6];
+        initValue7 = (uint8_t)pReg->batchResult[7];
 
-    /* CONFIG PARAMETER 3 */
-    cfgParam = initValue3 & 0x000Fu;
-    tempParam = (int16_t)9 + initOffset1; /* To be MISRA compliant */
-    cfgParam |= (uint16_t)tempParam << 10;
+        /* CONFIG PARAMETER 3 */
+        cfgParam = initValue3 & 0x000Fu;
+        tempParam = (int16_t)9 + initOffset1; /* To be MISRA compliant */
+        cfgParam |= (uint16_t)tempParam << 10;
 
-    tempParam = (int16_t)14 + initOffset1; /* To be MISRA compliant */
-    cfgParam |= (uint16_t)tempParam << 4;
+        tempParam = (int16_t)14 + initOffset1; /* To be MISRA compliant */
+        cfgParam |= (uint16_t)tempParam << 4;
 
-    while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x00040084, cfgParam, CONTROL_PROTECTION, NULL, NULL)) {
-        TC6_Service(pReg->pTC6, true);
-    }
+        pReg->trim[0] = cfgParam;
 
-    /* CONFIG PARAMETER 4 */
-    cfgParam = initValue4 & 0x3FFu;
-    tempParam = (int16_t)40 + initOffset2; /* To be MISRA compliant */
-    cfgParam |= (uint16_t)(tempParam) << 10;
+        /* CONFIG PARAMETER 4 */
+        cfgParam = initValue4 & 0x3FFu;
+        tempParam = (int16_t)40 + initOffset2; /* To be MISRA compliant */
+        cfgParam |= (uint16_t)(tempParam) << 10;
 
-    while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x0004008A, cfgParam, CONTROL_PROTECTION, NULL, NULL)) {
-        TC6_Service(pReg->pTC6, true);
-    }
+        pReg->trim[1] = cfgParam;
 
-    /* CONFIG PARAMETER 5 */
-    cfgParam = initValue5 & 0xC0C0u;
-    tempParam = (int16_t)5 + initOffset1; /* To be MISRA compliant */
-    cfgParam |= (uint16_t)tempParam << 8;
+        /* CONFIG PARAMETER 5 */
+        cfgParam = initValue5 & 0xC0C0u;
+        tempParam = (int16_t)5 + initOffset1; /* To be MISRA compliant */
+        cfgParam |= (uint16_t)tempParam << 8;
 
-    tempParam = (int16_t)9 + initOffset1; /* To be MISRA compliant */
-    cfgParam |= (uint16_t)tempParam;
+        tempParam = (int16_t)9 + initOffset1; /* To be MISRA compliant */
+        cfgParam |= (uint16_t)tempParam;
 
-    while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x000400AD, cfgParam, CONTROL_PROTECTION, NULL, NULL)) {
-        TC6_Service(pReg->pTC6, true);
-    }
+        pReg->trim[2] = cfgParam;
+
+        /* CONFIG PARAMETER 6 */
+        cfgParam = initValue6 & 0xC0C0u;
+        tempParam = (int16_t)9 + initOffset1; /* To be MISRA compliant */
+        cfgParam |= (uint16_t)tempParam << 8;
 
-    /* CONFIG PARAMETER 6 */
-    cfgParam = initValue6 & 0xC0C0u;
-    tempParam = (int16_t)9 + initOffset1; /* To be MISRA compliant */
-    cfgParam |= (uint16_t)tempParam << 8;
+        tempParam = (int16_t)14 + initOffset1; /* To be MISRA compliant */
+        cfgParam |= (uint16_t)tempParam;
 
-    tempParam = (int16_t)14 + initOffset1; /* To be MISRA compliant */
-    cfgParam |= (uint16_t)tempParam;
+        pReg->trim[3] = cfgParam;
 
-    while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x000400AE, cfgParam, CONTROL_PROTECTION, NULL, NULL)) {
-        TC6_Service(pReg->pTC6, true);
+        /* CONFIG PARAMETER 7 */
+        cfgParam = initValue7 & 0xC0C0u;
+
+        tempParam = (int16_t)17 + initOffset1; /* To be MISRA compliant */
+        cfgParam |= (uint16_t)tempParam << 8;
+
+        tempParam = (int16_t)22 + initOffset1; /* To be MISRA compliant */
+        cfgParam |= (uint16_t)tempParam;
+
+        pReg->trim[4] = cfgParam;
     }
+    return done && pReg->initialized;
+}
 
-    /* CONFIG PARAMETER 7 */
-    cfgParam = initValue7 & 0xC0C0u;
+static bool CheckChip(TC6Reg_t *pReg, int8_t *pOffset1)
+{
+    TC6_t *pInst = pReg->pTC6;
 
-    tempParam = (int16_t)17 + initOffset1; /* To be MISRA compliant */
-    cfgParam |= (uint16_t)tempParam << 8;
+    /* Results of the indirect registers 0x5 and 0x4, the first two reads of the trim burst */
+    if (0u == (pReg->batchResult[0] & 0x40u)) {
+        TC6Regs_CB_OnEvent(pInst, TC6Regs_Event_Chip_Error, pReg->pTag);
+        pReg->initialized = false;
+    }
+    if (pReg->initialized) {
+        *pOffset1 = GetSignedVal(pReg->batchResult[1] & 0x1Fu);
+        if (*pOffset1 < -5) {
+            TC6Regs_CB_OnEvent(pInst, TC6Regs_Event_Chip_Error, pReg->pTag);
+            pReg->initialized = false;
+        }
+    }
+    return pReg->initialized;
+}
 
-    tempParam = (int16_t)22 + initOffset1; /* To be MISRA compliant */
-    cfgParam |= (uint16_t)tempParam;
+static bool WriteTrim(TC6Reg_t *pReg)
+{
+    /* Registers receiving the CONFIG PARAMETER 3 to 7 trim values */
+    static const uint32_t TRIM_ADDR[TC6REGS_TRIM_COUNT] = { 0x00040084, 0x0004008A, 0x000400AD, 0x000400AE, 0x000400AF };
+    uint8_t i;
 
-    while (pReg->initialized && !TC6_WriteRegister(pReg->pTC6, 0x000400AF, cfgParam, CONTROL_PROTECTION, NULL, NULL)) {
-        TC6_Service(pReg->pTC6, true);
+    /* All trim values are written with a single burst as well */
+    if (pReg->pBatch != pReg->trimMap) {
+        for (i = 0u; i < TC6REGS_TRIM_COUNT; i++) {
+            pReg->trimMap[i].address = TRIM_ADDR[i];
+            pReg->trimMap[i].value = pReg->trim[i];
+            pReg->trimMap[i].mask = 0u;
+            pReg->trimMap[i].op = MemOp_Write;
+            pReg->trimMap[i].secure = CONTROL_PROTECTION;
+        }
     }
+    pReg->trimValid = RunBatch(pReg, pReg->trimMap, TC6REGS_TRIM_COUNT);
+    return pReg->trimValid;
 }
 
 static void OnInitDone(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *pTag, void *pGlobalTag)
@@ -644,9 +794,7 @@ static void OnClearStatus1(TC6_t *pInst, bool success, uint32_t addr, uint32_t v
     (void)pGlobalTag;
     if (pReg->extBlock) {
         pReg->extBlock = false;
-        while (!TC6_ReadRegister(pInst, 0x000A0087, CONTROL_PROTECTION, OnExtendedBlock, NULL)) {
-            TC6_Service(pInst, true);
-        }
+        NextStatus(pReg, StatusStep_ReadExtBlock, 0u);
     }
 }
 
@@ -685,9 +833,7 @@ static void OnStatus1(TC6_t *pInst, bool success, uint32_t addr, uint32_t value,
         }
         if (0u != value) {
             /* Write to clear pending flags */
-            while (!TC6_WriteRegister(pInst, addr, value, CONTROL_PROTECTION, OnClearStatus1, NULL)) {
-                TC6_Service(pInst, true);
-            }
+            NextStatus(pReg, StatusStep_ClearStatus1, value);
         }
     } else {
         TC6Regs_CB_OnEvent(pInst, TC6Regs_Event_UnknownError, pReg->pTag);
@@ -701,9 +847,7 @@ static void OnClearStatus0(TC6_t *pInst, bool success, uint32_t addr, uint32_t v
     (void)value;
     (void)tag;
     (void)pGlobalTag;
-    while (!TC6_ReadRegister(pInst, 0x00000009u, CONTROL_PROTECTION, OnStatus1, NULL)) {
-        TC6_Service(pInst, true);
-    }
+    NextStatus(GetContext(pInst), StatusStep_ReadStatus1, 0u);
 }
 
 static void OnStatus0(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *tag, void *pGlobalTag)
@@ -735,16 +879,40 @@ static void OnStatus0(TC6_t *pInst, bool success, uint32_t addr, uint32_t value,
             }
         }
         if (0u == value) {
-            while (!TC6_ReadRegister(pInst, 0x00000009, CONTROL_PROTECTION, OnStatus1, NULL)) {
-                TC6_Service(pInst, true);
-            }
+            NextStatus(pReg, StatusStep_ReadStatus1, 0u);
         } else {
             /* Write to clear pending flags */
-            while (!TC6_WriteRegister(pInst, addr, value, CONTROL_PROTECTION, OnClearStatus0, NULL)) {
-                TC6_Service(pInst, true);
-            }
+            NextStatus(pReg, StatusStep_ClearStatus0, value);
         }
     } else {
         TC6Regs_CB_OnEvent(pInst, TC6Regs_Event_UnknownError, pReg->pTag);
     }
 }
+
+static void NextStatus(TC6Reg_t *pReg, StatusStep_t step, uint32_t value)
+{
+    bool queued;
+    switch (step) {
+        case StatusStep_ReadStatus0:
+            queued = TC6_ReadRegister(pReg->pTC6, 0x00000008, CONTROL_PROTECTION, OnStatus0, NULL);
+            break;
+        case StatusStep_ClearStatus0:
+            queued = TC6_WriteRegister(pReg->pTC6, 0x00000008, value, CONTROL_PROTECTION, OnClearStatus0, NULL);
+            break;
+        case StatusStep_ReadStatus1:
+            queued = TC6_ReadRegister(pReg->pTC6, 0x00000009, CONTROL_PROTECTION, OnStatus1, NULL);
+            break;
+        case StatusStep_ClearStatus1:
+            queued = TC6_WriteRegister(pReg->pTC6, 0x00000009, value, CONTROL_PROTECTION, OnClearStatus1, NULL);
+            break;
+        case StatusStep_ReadExtBlock:
+            queued = TC6_ReadRegister(pReg->pTC6, 0x000A0087, CONTROL_PROTECTION, OnExtendedBlock, NULL);
+            break;
+        default:
+            queued = true;
+            break;
+    }
+    /* Control queue full, TC6Regs_CheckTimers() tries again */
+    pReg->statusStep = queued ? StatusStep_None : step;
+    pReg->statusValue = value;
+}
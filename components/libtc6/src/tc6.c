@@ -48,6 +48,7 @@ Microchip or any third party.
 #include "tc6-queue.h"
 
 #include <stdio.h>
+#include <inttypes.h>
 
 /*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
 /*                          USER ADJUSTABLE                             */
@@ -56,12 +57,34 @@ Microchip or any third party.
 #define TC6_MAGIC           (0x48423578ul)
 #define TC6_CHUNKS_PER_ISR  (2u)
 
+#if (SPI_FULL_BUFFERS == 0u) || ((SPI_FULL_BUFFERS & (SPI_FULL_BUFFERS - 1u)) != 0u)
+#error "SPI_FULL_BUFFERS must be power of 2"
+#endif
+
+#if (REG_OP_ARRAY_SIZE < 2u) || (REG_OP_ARRAY_SIZE > 128u) || ((REG_OP_ARRAY_SIZE & (REG_OP_ARRAY_SIZE - 1u)) != 0u)
+#error "REG_OP_ARRAY_SIZE must be power of 2 between 2 and 128"
+#endif
+
+#if (TC6_TX_ETH_QSIZE < 2u) || (TC6_TX_ETH_QSIZE > 128u) || ((TC6_TX_ETH_QSIZE & (TC6_TX_ETH_QSIZE - 1u)) != 0u)
+#error "TC6_TX_ETH_QSIZE must be power of 2 between 2 and 128"
+#endif
+
 /*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
 /*                    INTERNAL DEFINES AND VARIABLES                    */
 /*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
 
 #define FLD(bytePos, bitpos, width)  bytePos, bitpos, width
 
+/* Write 1 to clear registers (MMS 0): STATUS0 and STATUS1 */
+#define REG_STATUS0     (0x00000008u)
+#define REG_STATUS1     (0x00000009u)
+
+#if (0u != TC6_PROBES)
+#define TC6_PROBE(g, probe)     TC6_CB_OnProbe((g)->instance, (probe), (g)->gTag)
+#else
+#define TC6_PROBE(g, probe)
+#endif
+
 /*
  * TX Data Header: 32-bit SPI TX Data Chunk Command Header
  */
@@ -140,6 +163,9 @@ struct TC6_t
     uint64_t ts;
     volatile SpiOp_t currentOp;
     uint32_t magic;
+    uint32_t txQueueFull;
+    uint32_t coalescedWrites;
+    uint32_t coalescedModifies;
     uint16_t buf_len;
     uint16_t offsetEth;
     uint16_t offsetRx;
@@ -149,6 +175,10 @@ struct TC6_t
     uint8_t seq_num;
     uint8_t txc;
     uint8_t rca;
+    uint8_t txQueueHighWater;
+    uint8_t xactMax;
+    uint8_t xactBudget;
+    TC6_XactPolicy_t xactPolicy;
     bool alreadyInControlService;
     bool alreadyInDataService;
     bool enableData;
@@ -170,13 +200,19 @@ static inline uint8_t GET_VAL(uint8_t bytePos, uint8_t bitpos, uint8_t width, co
 static inline void SET_VAL(uint8_t bytePos, uint8_t bitpos, uint8_t width, uint8_t val, uint8_t pOut[4]);
 static void initializeSpiEntry(struct qspibuf *newEntry);
 static uint16_t getTrail(TC6_t *g, bool enqueueEmpty);
-static void addEmptyChunks(TC6_t *g, struct qspibuf *entry, bool enqueueEmpty);
+static void addEmptyChunks(TC6_t *g, struct qspibuf *entry, bool enqueueEmpty, uint16_t maxLen);
+static uint16_t getXactLimit(TC6_t *g);
+static void updateTxQueueStats(TC6_t *g);
 static bool serviceData(TC6_t *g, bool enqueueEmpty);
 static bool serviceControl(TC6_t *g);
 static bool spiTransaction(TC6_t *g, uint8_t *pTx, uint8_t *pRx, uint16_t len, SpiOp_t op);
 static bool modify(TC6_t *g, uint32_t value);
 static bool accessRegisters(TC6_t *g, enum register_op_type op, uint32_t addr, uint32_t value,
                             bool secure, uint32_t modifyMask, TC6_RegCallback_t callback, void *tag);
+#if TC6_REGOP_COALESCE
+static bool coalesceRegisters(TC6_t *g, enum register_op_type op, uint32_t addr, uint32_t value,
+                              bool secure, uint32_t modifyMask, TC6_RegCallback_t callback, void *tag);
+#endif
 static void processDataRx(TC6_t *g);
 
 /* Protocol Implementation */
@@ -204,6 +240,9 @@ TC6_t *TC6_Init(void *pGlobalTag)
             g->instance = i;
             g->magic = TC6_MAGIC;
             g->txc = 24;
+            g->xactPolicy = TC6XactPolicy_Fixed;
+            g->xactMax = TC6_CHUNKS_XACT;
+            g->xactBudget = TC6_CHUNKS_XACT;
             g->gTag = pGlobalTag;
             init_qtxeth_queue(&g->eth_q, g->tx_eth_buffer, TC6_TX_ETH_QSIZE);
             init_qspibuf_queue(&g->qSpi, g->spiBuf, SPI_FULL_BUFFERS);
@@ -264,7 +303,10 @@ void TC6_Reset(TC6_t *g)
     while(regop_stage7_event_ready(qReg)) {
         struct register_operation *entry = regop_stage7_event_ptr(qReg);
         if (NULL != entry->callback) {
-           entry->callback(g, false, entry->regAddr, 0u, entry->tag, g->gTag);
+            uint8_t i;
+            for (i = 0u; i < entry->callbackCount; i++) {
+                entry->callback(g, false, entry->regAddr, 0u, entry->tag, g->gTag);
+            }
         }
         regop_stage7_event_done(qReg);
     }
@@ -274,6 +316,7 @@ void TC6_Reset(TC6_t *g)
 
     /* Set protocol defaults */
     g->txc = 24u;
+    g->xactBudget = g->xactMax;
     g->enableData = false;
     g->synced = false;
 }
@@ -282,13 +325,18 @@ bool TC6_Service(TC6_t *g, bool interruptLevel)
 {
     bool intPending = false;
     TC6_ASSERT(g && (TC6_MAGIC == g->magic));
+    TC6_PROBE(g, TC6Probe_ServiceBegin);
     if (!g->intContext) {
         if (serviceControl(g)) {
            if (!interruptLevel) {
                intPending = true;
            }
         } else if (g->enableData) {
-            processDataRx(g);
+            if (!qspibuf_stage1_transfer_ready(&g->qSpi)) {
+                /* All SPI buffers are in use, free the oldest one before starting the next transfer */
+                processDataRx(g);
+            }
+            /* Start the next transfer first, so RX processing overlaps with it */
             if (!serviceData(g, !interruptLevel)) {
                 if (!interruptLevel) {
                    intPending = true;
@@ -299,6 +347,7 @@ bool TC6_Service(TC6_t *g, bool interruptLevel)
             intPending = true;
         } else {} /* MISRA enforced termination */
     }
+    TC6_PROBE(g, TC6Probe_ServiceEnd);
     return !intPending;
 }
 
@@ -311,6 +360,48 @@ void TC6_EnableData(TC6_t *g, bool enable)
     }
 }
 
+void TC6_GetTxQueueStats(TC6_t *g, TC6_TxQueueStats_t *pStats, bool reset)
+{
+    TC6_ASSERT(g && (TC6_MAGIC == g->magic) && pStats);
+    pStats->size = TC6_TX_ETH_QSIZE;
+    pStats->depth = qtxeth_stage2_convert_cap(&g->eth_q);
+    pStats->highWater = g->txQueueHighWater;
+    pStats->fullCount = g->txQueueFull;
+    if (reset) {
+        g->txQueueHighWater = pStats->depth;
+        g->txQueueFull = 0u;
+    }
+}
+
+void TC6_GetRegOpStats(TC6_t *g, TC6_RegOpStats_t *pStats, bool reset)
+{
+    TC6_ASSERT(g && (TC6_MAGIC == g->magic) && pStats);
+    pStats->size = REG_OP_ARRAY_SIZE;
+    pStats->depth = (uint8_t)(g->regop_q.stage1_enqueue_ - g->regop_q.stage7_event_);
+    pStats->coalescedWrites = g->coalescedWrites;
+    pStats->coalescedModifies = g->coalescedModifies;
+    if (reset) {
+        g->coalescedWrites = 0u;
+        g->coalescedModifies = 0u;
+    }
+}
+
+void TC6_SetTransactionPolicy(TC6_t *g, TC6_XactPolicy_t policy, uint8_t maxChunks)
+{
+    TC6_ASSERT(g && (TC6_MAGIC == g->magic));
+    if ((0u == maxChunks) || (maxChunks > TC6_CHUNKS_XACT)) {
+        maxChunks = TC6_CHUNKS_XACT;
+    }
+    g->xactPolicy = policy;
+    g->xactMax = maxChunks;
+    if (TC6XactPolicy_Adaptive == policy) {
+        /* Start with short bursts, grow on demand */
+        g->xactBudget = (maxChunks < TC6_CHUNKS_PER_ISR) ? maxChunks : TC6_CHUNKS_PER_ISR;
+    } else {
+        g->xactBudget = maxChunks;
+    }
+}
+
 uint8_t TC6_GetInstance(TC6_t *g)
 {
     TC6_ASSERT(g && (TC6_MAGIC == g->magic));
@@ -353,11 +444,14 @@ bool TC6_SendRawEthernetPacket(TC6_t *g, const uint8_t *pTx, uint16_t len, uint8
             entry->txCallback = txCallback;
             entry->priv = pTag;
             qtxeth_stage1_enqueue_done(q);
+            updateTxQueueStats(g);
 
             if (!g->intContext) {
                 (void)serviceData(g, false);
             }
             success = true;
+        } else {
+            g->txQueueFull++;
         }
     } else {
         success = false;
@@ -379,6 +473,8 @@ uint8_t TC6_GetRawSegments(TC6_t *g, TC6_RawTxSegment **pSegments)
 #endif
             *pSegments = entry->ethSegs;
             success = true;
+        } else {
+            g->txQueueFull++;
         }
     }
     return (success ? TC6_TX_ETH_MAX_SEGMENTS : 0u);
@@ -401,6 +497,7 @@ bool TC6_SendRawEthernetSegments(TC6_t *g, const TC6_RawTxSegment *pSegments, ui
         entry->txCallback = txCallback;
         entry->priv = pTag;
         qtxeth_stage1_enqueue_done(q);
+        updateTxQueueStats(g);
         if (!g->intContext) {
             (void)serviceData(g, false);
         }
@@ -423,7 +520,7 @@ bool TC6_ReadRegister(TC6_t *g, uint32_t addr, bool secure, TC6_RegCallback_t rx
 bool TC6_WriteRegister(TC6_t *g, uint32_t addr, uint32_t value, bool secure, TC6_RegCallback_t txCallback, void *tag)
 {
     TC6_ASSERT(g && (TC6_MAGIC == g->magic));
-    printf("TC6_WriteRegister: Writing to register: Address=0x%08lX, Value=0x%08lX, Secure=%s\r\n", addr, value, secure ? "true" : "false");
+    printf("TC6_WriteRegister: Writing to register: Address=0x%08" PRIX32 ", Value=0x%08" PRIX32 ", Secure=%s\r\n", addr, value, secure ? "true" : "false");
     return accessRegisters(g, REGISTER_OP_WRITE, addr
         , value
         , secure
@@ -546,6 +643,9 @@ static void initializeSpiEntry(struct qspibuf *newEntry)
 #endif
 }
 
+/* Empty data chunk: DNC set, everything else zero, parity is already odd */
+static const uint8_t EMPTY_CHUNK[TC6_CHUNK_BUF_SIZE] = { 0x80u };
+
 static uint16_t getTrail(TC6_t *g, bool enqueueEmpty)
 {
     uint16_t  trail = 0;
@@ -562,19 +662,15 @@ static uint16_t getTrail(TC6_t *g, bool enqueueEmpty)
     return trail;
 }
 
-static void addEmptyChunks(TC6_t *g, struct qspibuf *entry, bool enqueueEmpty)
+static void addEmptyChunks(TC6_t *g, struct qspibuf *entry, bool enqueueEmpty, uint16_t maxLen)
 {
     uint16_t trail = getTrail(g, enqueueEmpty);
+    TC6_ASSERT(maxLen <= sizeof(entry->txBuff));
     if (trail > 0u) {
         uint16_t i = 0;
         /* Fill up buffer with empty chunks, so RX gets the opportunity to transmit quicker */
-        for (; (i < trail) && (entry->length < sizeof(entry->txBuff)); i += TC6_CHUNK_SIZE) {
-            uint8_t *p = &entry->txBuff[entry->length];
-            p[0] = 0x80u;
-            p[1] = 0x0u;
-            p[2] = 0x0u;
-            p[3] = 0x0u;
-            (void)memset(&p[4], 0x00, TC6_CHUNK_SIZE);
+        for (; (i < trail) && (entry->length < maxLen); i += TC6_CHUNK_SIZE) {
+            (void)memcpy(&entry->txBuff[entry->length], EMPTY_CHUNK, TC6_CHUNK_BUF_SIZE);
             entry->length += TC6_CHUNK_BUF_SIZE;
         }
     }
@@ -582,6 +678,46 @@ static void addEmptyChunks(TC6_t *g, struct qspibuf *entry, bool enqueueEmpty)
     TC6_ASSERT(entry->length <= sizeof(entry->rxBuff));
 }
 
+/*
+ * Returns the maximum SPI transaction length in bytes. With the adaptive
+ * policy the burst length doubles as long as pending RX chunks or queued TX
+ * data exceed it and halves again once both are drained.
+ */
+static uint16_t getXactLimit(TC6_t *g)
+{
+    uint8_t chunks = g->xactMax;
+    if (TC6XactPolicy_Adaptive == g->xactPolicy) {
+        const struct qtxeth_queue *q = &g->eth_q;
+        uint8_t pending = qtxeth_stage2_convert_cap(q);
+        uint16_t demand = g->rca;
+        if (0u != pending) {
+            const struct qtxeth *entry = qtxeth_stage2_convert_ptr(q);
+            demand += ((entry->totalLen - g->offsetEth) + (TC6_CHUNK_SIZE - 1u)) / TC6_CHUNK_SIZE;
+            if (pending > 1u) {
+                /* More frames waiting behind the current one */
+                demand += g->xactBudget;
+            }
+        }
+        if (demand > g->xactBudget) {
+            g->xactBudget = (g->xactBudget > (g->xactMax / 2u)) ? g->xactMax : (uint8_t)(g->xactBudget * 2u);
+        } else if (0u == demand) {
+            uint8_t minBudget = (g->xactMax < TC6_CHUNKS_PER_ISR) ? g->xactMax : TC6_CHUNKS_PER_ISR;
+            g->xactBudget = ((g->xactBudget / 2u) < minBudget) ? minBudget : (uint8_t)(g->xactBudget / 2u);
+        } else {
+        } /* MISRA enforced termination */
+        chunks = g->xactBudget;
+    }
+    return chunks * TC6_CHUNK_BUF_SIZE;
+}
+
+static void updateTxQueueStats(TC6_t *g)
+{
+    uint8_t depth = qtxeth_stage2_convert_cap(&g->eth_q);
+    if (depth > g->txQueueHighWater) {
+        g->txQueueHighWater = depth;
+    }
+}
+
 static bool serviceData(TC6_t *g, bool sendEmpty)
 {
     bool dataSent = false;
@@ -593,6 +729,8 @@ static bool serviceData(TC6_t *g, bool sendEmpty)
 
         if (g->enableData && (SPI_OP_INVALID == g->currentOp) && (qspibuf_stage1_transfer_ready(&g->qSpi))) {
             uint16_t maxTxLen;
+            uint16_t xactLen = getXactLimit(g);
+            TC6_PROBE(g, TC6Probe_DataBegin);
             /**********************************/
             /* Try to enqueue Ethernet chunks */
             /**********************************/
@@ -603,14 +741,14 @@ static bool serviceData(TC6_t *g, bool sendEmpty)
             /* TX Data is getting generated here: */
             /**************************************/
             maxTxLen = g->txc * TC6_CHUNK_BUF_SIZE;
-            if (maxTxLen > sizeof(entry->txBuff)) {
-                maxTxLen = sizeof(entry->txBuff);
+            if (maxTxLen > xactLen) {
+                maxTxLen = xactLen;
             }
             entry->length = mk_data_tx(g, entry->txBuff, maxTxLen);
             if (0u != entry->length) {
                 enqueueEmpty = false;
             }
-            addEmptyChunks(g, entry, (enqueueEmpty || g->rca));
+            addEmptyChunks(g, entry, (enqueueEmpty || g->rca), xactLen);
 
             if (0u != entry->length) {
                 TC6_ASSERT(0u == (entry->length % TC6_CHUNK_BUF_SIZE));
@@ -623,6 +761,7 @@ static bool serviceData(TC6_t *g, bool sendEmpty)
                     dataSent = false;
                 }
             }
+            TC6_PROBE(g, TC6Probe_DataEnd);
         }
         g->alreadyInDataService = false;
     }
@@ -663,6 +802,7 @@ static bool serviceControl(TC6_t *g)
             uint32_t regVal = 0xFFFFFFFFu;
             uint32_t regAddr;
             uint16_t num;
+            uint8_t count;
             bool success;
 
             reg_op = regop_stage7_event_ptr(&g->regop_q);
@@ -670,10 +810,14 @@ static bool serviceControl(TC6_t *g)
             callback = reg_op->callback;
             regAddr = reg_op->regAddr;
             tag = reg_op->tag;
+            count = reg_op->callbackCount;
             success = (0u != num);
             regop_stage7_event_done(&g->regop_q);
             if (NULL != callback) {
-                reg_op->callback(g, success, regAddr, regVal, tag, g->gTag);
+                /* Every merged operation gets its own callback */
+                for (; count > 0u; count--) {
+                    callback(g, success, regAddr, regVal, tag, g->gTag);
+                }
             } else if (!success) {
                 TC6_CB_OnError(g, TC6Error_NoHardware, g->gTag);
             } else {} /* MISRA enforced termination */
@@ -693,6 +837,7 @@ static bool serviceControl(TC6_t *g)
 
             g->currentOp = SPI_OP_REG;
             sentControl = true;
+            TC6_PROBE(g, TC6Probe_SpiStart);
             if (!TC6_CB_OnSpiTransaction(g->instance, reg_op->tx_buf, reg_op->rx_buf, reg_op->length, g->gTag)) {
                 g->currentOp = SPI_OP_INVALID;
                 sentControl = false;
@@ -711,6 +856,7 @@ static bool serviceControl(TC6_t *g)
             TC6_ASSERT(SPI_OP_INVALID == g->currentOp);
             g->currentOp = SPI_OP_REG;
             sentControl = true;
+            TC6_PROBE(g, TC6Probe_SpiStart);
             if (!TC6_CB_OnSpiTransaction(g->instance, reg_op->tx_buf, reg_op->rx_buf, reg_op->length, g->gTag)) {
                 g->currentOp = SPI_OP_INVALID;
                 sentControl = false;
@@ -727,6 +873,7 @@ static bool spiTransaction(TC6_t *g, uint8_t *pTx, uint8_t *pRx, uint16_t len, S
     bool success = false;
     if (g->currentOp == SPI_OP_INVALID) {
         g->currentOp = op;
+        TC6_PROBE(g, TC6Probe_SpiStart);
         success = TC6_CB_OnSpiTransaction(g->instance, pTx, pRx, len, g->gTag);
         if (!success) {
             g->currentOp = SPI_OP_INVALID;
@@ -765,10 +912,14 @@ static bool accessRegisters(TC6_t *g, enum register_op_type op, uint32_t addr, u
     struct register_operation *reg_op = NULL;
     uint16_t payloadSize = 0;
     bool write = true;
+    bool merged = false;
     bool success = false;
     TC6_ASSERT(g && (TC6_MAGIC == g->magic));
     TC6_ASSERT(REGISTER_OP_INVALLID != op);
-    if (regop_stage1_enqueue_ready(&g->regop_q)) {
+#if TC6_REGOP_COALESCE
+    merged = coalesceRegisters(g, op, addr, value, secure, modifyMask, callback, tag);
+#endif
+    if (!merged && regop_stage1_enqueue_ready(&g->regop_q)) {
         success = true;
         switch(op) {
         case REGISTER_OP_WRITE:
@@ -815,14 +966,82 @@ static bool accessRegisters(TC6_t *g, enum register_op_type op, uint32_t addr, u
         reg_op->secure = secure;
         reg_op->callback = callback;
         reg_op->tag = tag;
+        reg_op->callbackCount = 1u;
         reg_op->modifyValue = value;
         reg_op->modifyMask = modifyMask;
 
         regop_stage1_enqueue_done(&g->regop_q);
         TC6_CB_OnNeedService(g, g->gTag);
     }
+    return (success || merged);
+}
+
+#if TC6_REGOP_COALESCE
+static bool coalesceRegisters(TC6_t *g, enum register_op_type op, uint32_t addr, uint32_t value, bool secure, uint32_t modifyMask, TC6_RegCallback_t callback, void *tag)
+{
+    struct register_operation *reg_op = NULL;
+    uint16_t payloadSize;
+    bool success = false;
+
+    /* Only the last queued operation may be merged and only as long as it was not sent */
+    if (0u != regop_stage2_send_cap(&g->regop_q)) {
+        reg_op = &g->regop_storage[(uint8_t)(g->regop_q.stage1_enqueue_ - 1u) & (REG_OP_ARRAY_SIZE - 1u)];
+        success = (reg_op->op == op)
+            && (reg_op->regAddr == addr)
+            && (reg_op->secure == secure)
+            && (reg_op->callbackCount < UINT8_MAX)
+            /* Callbacks are raised with the tag of the merged entry, so both have to be equal (or one is missing) */
+            && ((NULL == callback) || (NULL == reg_op->callback) || ((reg_op->callback == callback) && (reg_op->tag == tag)));
+    }
+    if (success) {
+        switch(op) {
+        case REGISTER_OP_WRITE:
+            if ((REG_STATUS0 == addr) || (REG_STATUS1 == addr)) {
+                /* Write 1 to clear, both writes together clear the union of their bits */
+                value |= reg_op->modifyValue;
+            } else {
+                /* Last write wins */
+            }
+            (void)memset(reg_op->tx_buf, 0x00, sizeof(reg_op->tx_buf));
+            if (secure) {
+                payloadSize = mk_secure_ctrl_req(true /*write */, false /* autoIncrement */, addr, 1 /* Array Len */, &value, reg_op->tx_buf, sizeof(reg_op->tx_buf));
+            } else {
+                payloadSize = mk_ctrl_req(true /*write */, false /* autoIncrement */, addr, 1 /* Array Len */, &value, reg_op->tx_buf, sizeof(reg_op->tx_buf));
+            }
+            TC6_ASSERT(payloadSize == reg_op->length);
+            (void)payloadSize;
+            reg_op->modifyValue = value;
+            g->coalescedWrites++;
+            break;
+        case REGISTER_OP_READWRITE_STAGE1:
+            if (0u == (reg_op->modifyMask & modifyMask)) {
+                /* Read request stays the same, only the modification grows */
+                reg_op->modifyValue |= value;
+                reg_op->modifyMask |= modifyMask;
+                g->coalescedModifies++;
+            } else {
+                success = false;
+            }
+            break;
+        case REGISTER_OP_READ:
+        case REGISTER_OP_READWRITE_STAGE2:
+        case REGISTER_OP_INVALLID:
+        default:
+            success = false;
+            break;
+        }
+    }
+    if (success && (NULL != callback)) {
+        if (NULL == reg_op->callback) {
+            reg_op->callback = callback;
+            reg_op->tag = tag;
+        } else {
+            reg_op->callbackCount++;
+        }
+    }
     return success;
 }
+#endif
 
 static void processDataRx(TC6_t *g)
 {
@@ -832,7 +1051,9 @@ static void processDataRx(TC6_t *g)
     while (qspibuf_stage3_process_ready(&g->qSpi)) {
         struct qspibuf *entry = qspibuf_stage3_process_ptr(&g->qSpi);
         TC6_ASSERT(0u == (entry->length % TC6_CHUNK_BUF_SIZE));
+        TC6_PROBE(g, TC6Probe_RxChunksBegin);
         enqueue_rx_spi(g, entry->rxBuff, entry->length);
+        TC6_PROBE(g, TC6Probe_RxChunksEnd);
         qspibuf_stage3_process_done(&g->qSpi);
     }
 }
@@ -889,7 +1110,9 @@ static void on_rx_done(TC6_t *g, uint16_t buf_len, bool mfd)
     g->eth_error = false;
     if (success) {
         uint64_t *pTS = (0u != g->ts) ? &g->ts : NULL;
+        TC6_PROBE(g, TC6Probe_RxPacketBegin);
         TC6_CB_OnRxEthernetPacket(g, true, g->buf_len, pTS, g->gTag);
+        TC6_PROBE(g, TC6Probe_RxPacketEnd);
     } else {
         TC6_CB_OnRxEthernetPacket(g, false, 0, NULL, g->gTag);
     }
@@ -947,6 +1170,103 @@ static uint8_t get_parity(const uint8_t *pVal)
     return val;
 }
 
+static inline uint8_t get_parity_word(uint32_t v)
+{
+#if defined(__GNUC__) && (defined(__POPCNT__) || defined(__riscv_zbb) || defined(__ARM_FEATURE_SVE))
+    /* Hardware population count available */
+    return (uint8_t)(~(uint32_t)__builtin_parity(v) & 1u);   /* odd parity */
+#else
+    v ^= v >> 16;
+    v ^= v >> 8;
+    v ^= v >> 4;
+    v ^= v >> 2;
+    v ^= v >> 1;
+    return (uint8_t)(~v & 1u);   /* odd parity */
+#endif
+}
+
+/* RX Footer access {{{ */
+
+/*
+ * The footer is decoded either from a single 32 bit big endian word or byte
+ * wise (reference implementation). Both variants offer the same functions,
+ * so the RX state machine does not depend on the selected one.
+ */
+
+#if TC6_WORD_FOOTER
+typedef uint32_t Footer_t;
+
+static inline Footer_t LOAD_FOOTER(const uint8_t *pFooter)
+{
+    return net2value(pFooter);
+}
+
+static inline uint8_t GET_FTR(uint8_t bytePos, uint8_t bitpos, uint8_t width, Footer_t ftr)
+{
+    TC6_ASSERT(bytePos < 4u);
+    TC6_ASSERT(bitpos < 8u);
+    TC6_ASSERT(width != 0u);
+    TC6_ASSERT(width <= 8u);
+    return (uint8_t)((ftr >> (((3u - bytePos) * 8u) + bitpos)) & ((1u << width) - 1u));
+}
+
+static inline bool FOOTER_NO_HARDWARE(Footer_t ftr)
+{
+    return (0x0u == ftr) || (0xFFFFFFFFu == ftr);
+}
+
+static inline uint8_t FOOTER_PARITY(Footer_t ftr)
+{
+    return get_parity_word(ftr);
+}
+#else
+typedef const uint8_t *Footer_t;
+
+static inline Footer_t LOAD_FOOTER(const uint8_t *pFooter)
+{
+    return pFooter;
+}
+
+static inline uint8_t GET_FTR(uint8_t bytePos, uint8_t bitpos, uint8_t width, Footer_t ftr)
+{
+    return GET_VAL(bytePos, bitpos, width, ftr);
+}
+
+static inline bool FOOTER_NO_HARDWARE(Footer_t ftr)
+{
+    return ((0x0u == ftr[0]) && (0x0u == ftr[1]) && (0x0u == ftr[2]) && (0x0u == ftr[3])) ||
+           ((0xFFu == ftr[0]) && (0xFFu == ftr[1]) && (0xFFu == ftr[2]) && (0xFFu == ftr[3]));
+}
+
+static inline uint8_t FOOTER_PARITY(Footer_t ftr)
+{
+    return get_parity(ftr);
+}
+#endif
+
+/* }}} */
+
+/* TX Header access {{{ */
+
+/*
+ * Data headers are assembled in a 32 bit word and written to the SPI buffer
+ * at once. The field descriptors are the same as used by SET_VAL.
+ */
+
+/* Data chunk header with DNC and DV set, the common part of all data chunks */
+#define HDR_DATA_TEMPLATE   (0x80200000u)
+
+static inline uint32_t HDR_WORD(uint8_t bytePos, uint8_t bitpos, uint8_t width, uint32_t val)
+{
+    TC6_ASSERT(bytePos < 4u);
+    TC6_ASSERT(bitpos < 8u);
+    TC6_ASSERT(width != 0u);
+    TC6_ASSERT(width <= 8u);
+    return (val & ((1u << width) - 1u)) << (((3u - bytePos) * 8u) + bitpos);
+}
+
+/* }}} */
+
 /* Control Transaction API {{{ */
 
 /*
@@ -1117,6 +1437,7 @@ static uint16_t process_tx(TC6_t *g, uint8_t *tx_buf)
     uint16_t padded_len;
     uint16_t retVal = 0u;
     uint16_t copy_pos = 0u;
+    uint32_t hdr;
     bool sv = false;
 
     if (qtxeth_stage2_convert_ready(q)) {
@@ -1124,18 +1445,15 @@ static uint16_t process_tx(TC6_t *g, uint8_t *tx_buf)
 #ifdef DEBUG
         (void)memset(tx_buf, 0xCDu, TC6_CHUNK_BUF_SIZE);
 #endif
-        CLEAR_HEADER(tx_buf);
-        SET_VAL(HDR_DNC, 1u, tx_buf);
-        SET_VAL(HDR_DV, 1u, tx_buf);
+        hdr = HDR_DATA_TEMPLATE;
         TC6_ASSERT(g->offsetEth <= entry->totalLen);
 
-        SET_VAL(HDR_SEQ, g->seq_num++, tx_buf);
+        hdr |= HDR_WORD(HDR_SEQ, g->seq_num++);
         if (!g->offsetEth) {
-            SET_VAL(HDR_SV, 1u, tx_buf);
-            SET_VAL(HDR_SWO, 0u, tx_buf);
+            hdr |= HDR_WORD(HDR_SV, 1u);
             sv = true;
             if (0u != entry->tsc) {
-                SET_VAL(HDR_TSC, entry->tsc, tx_buf);
+                hdr |= HDR_WORD(HDR_TSC, entry->tsc);
             }
         }
         if (0u == g->offsetEth) {
@@ -1171,8 +1489,8 @@ static uint16_t process_tx(TC6_t *g, uint8_t *tx_buf)
         g->offsetEth += tocopy_len;
         TC6_ASSERT(g->offsetEth <= entry->totalLen);
         if (g->offsetEth == entry->totalLen) {
-            SET_VAL(HDR_EV, 1u, tx_buf);
-            SET_VAL(HDR_EBO, (uint8_t)(tocopy_len - 1u), tx_buf);
+            hdr |= HDR_WORD(HDR_EV, 1u);
+            hdr |= HDR_WORD(HDR_EBO, (uint8_t)(tocopy_len - 1u));
             g->offsetEth = 0;
             on_tx_eth_done(g, entry->ethSegs[0].pEth, entry->totalLen, entry->txCallback, entry->priv);
             qtxeth_stage2_convert_done(q);
@@ -1184,10 +1502,10 @@ static uint16_t process_tx(TC6_t *g, uint8_t *tx_buf)
                     uint16_t remaining_len = TC6_CHUNK_SIZE - tocopy_len;
                     /* Make sure, that next packet does not end in the same chunk (TC6 does not support two "end valid") */
                     if (remaining_len && (entry->totalLen > remaining_len)) {
-                        SET_VAL(HDR_SV, 1, tx_buf);
-                        SET_VAL(HDR_SWO, (uint8_t)(tocopy_len / 4u), tx_buf);
+                        hdr |= HDR_WORD(HDR_SV, 1u);
+                        hdr |= HDR_WORD(HDR_SWO, (uint8_t)(tocopy_len / 4u));
                         if (0u != entry->tsc) {
-                            SET_VAL(HDR_TSC, entry->tsc, tx_buf);
+                            hdr |= HDR_WORD(HDR_TSC, entry->tsc);
                         }
                         copy_pos = 0;
                         while(copy_pos < remaining_len) {
@@ -1215,7 +1533,8 @@ static uint16_t process_tx(TC6_t *g, uint8_t *tx_buf)
                 }
             }
         }
-        SET_VAL(HDR_P, get_parity(tx_buf), tx_buf);
+        hdr |= HDR_WORD(HDR_P, get_parity_word(hdr));
+        value2net(hdr, tx_buf);
         retVal = TC6_CHUNK_BUF_SIZE;
     }
     return retVal;
@@ -1247,13 +1566,11 @@ static inline void signal_rx_error(TC6_t *g, TC6_Error_t err)
     TC6_CB_OnError(g, err, g->gTag);
 }
 
-static inline void process_rx(TC6_t *g, const uint8_t *buff, uint16_t buf_len)
+static inline void process_rx(TC6_t *g, const uint8_t *buff, Footer_t fptr)
 {
-    const uint8_t *fptr = &buff[buf_len - TC6_HEADER_SIZE];
-
-    if (GET_VAL(FTR_SV, fptr) ||
-        GET_VAL(FTR_DV, fptr) ||
-        GET_VAL(FTR_EV, fptr))
+    if (GET_FTR(FTR_SV, fptr) ||
+        GET_FTR(FTR_DV, fptr) ||
+        GET_FTR(FTR_EV, fptr))
     {
         uint16_t len;
         uint8_t sv;
@@ -1266,13 +1583,13 @@ static inline void process_rx(TC6_t *g, const uint8_t *buff, uint16_t buf_len)
         bool twoFrames;
         bool success = true;
 
-        sv = GET_VAL(FTR_SV, fptr);
-        sbo = sv ? (GET_VAL(FTR_SWO, fptr) * 4u) : 0u;
+        sv = GET_FTR(FTR_SV, fptr);
+        sbo = sv ? (GET_FTR(FTR_SWO, fptr) * 4u) : 0u;
 
-        ev = GET_VAL(FTR_EV, fptr);
-        ebo = ev ? (GET_VAL(FTR_EBO, fptr) + 1u) : TC6_CHUNK_SIZE;
+        ev = GET_FTR(FTR_EV, fptr);
+        ebo = ev ? (GET_FTR(FTR_EBO, fptr) + 1u) : TC6_CHUNK_SIZE;
 
-        mfd = GET_VAL(FTR_FD, fptr);
+        mfd = GET_FTR(FTR_FD, fptr);
         twoFrames = (ebo <= sbo);
 
         if (twoFrames) {
@@ -1303,8 +1620,8 @@ static inline void process_rx(TC6_t *g, const uint8_t *buff, uint16_t buf_len)
 
         if (success) {
             if (0u != sv) {
-                rtsa = GET_VAL(FTR_RTSA, fptr);
-                rtsp = GET_VAL(FTR_RTSP, fptr);
+                rtsa = GET_FTR(FTR_RTSA, fptr);
+                rtsp = GET_FTR(FTR_RTSP, fptr);
             }
 
             g->eth_started = true;
@@ -1339,39 +1656,37 @@ static void enqueue_rx_spi(TC6_t *g, const uint8_t *buff, uint16_t buf_len)
         success = false;
     }
     for (processed = 0; success && (processed < buf_len); processed += TC6_CHUNK_BUF_SIZE) {
-        const uint8_t *pFooter = &buff[processed + TC6_CHUNK_SIZE];
+        const Footer_t pFooter = LOAD_FOOTER(&buff[processed + TC6_CHUNK_SIZE]);
 
-        if (((0x0u == pFooter[0]) && (0x0u == pFooter[1]) && (0x0u == pFooter[2]) && (0x0u == pFooter[3])) ||
-            ((0xFFu == pFooter[0]) && (0xFFu == pFooter[1]) && (0xFFu == pFooter[2]) && (0xFFu == pFooter[3])))
-        {
+        if (FOOTER_NO_HARDWARE(pFooter)) {
             signal_rx_error(g, TC6Error_NoHardware);
             success = false;
         }
-        if (success && get_parity(pFooter)) {
+        if (success && FOOTER_PARITY(pFooter)) {
             signal_rx_error(g, TC6Error_BadChecksum);
             success = false;
         }
-        if (success && GET_VAL(FTR_HDRB, pFooter)) {
+        if (success && GET_FTR(FTR_HDRB, pFooter)) {
             signal_rx_error(g, TC6Error_BadTxData);
             success = false;
         }
-        g->synced = GET_VAL(FTR_SYNC, pFooter);
+        g->synced = GET_FTR(FTR_SYNC, pFooter);
         if (success && !g->synced) {
             signal_rx_error(g, TC6Error_SyncLost);
             success = false;
         }
-        if (success && GET_VAL(FTR_FD, pFooter)) {
+        if (success && GET_FTR(FTR_FD, pFooter)) {
             TC6_CB_OnRxEthernetPacket(g, false, 0, NULL, g->gTag);
             success = false;
         }
         if (success) {
             if (!g->exst_locked) {
-                if (0u != GET_VAL(FTR_EXST, pFooter)) {
+                if (0u != GET_FTR(FTR_EXST, pFooter)) {
                     g->exst_locked = true;
                     TC6_CB_OnExtendedStatus(g, g->gTag);
                 }
             }
-            process_rx(g, &buff[processed], TC6_CHUNK_BUF_SIZE);
+            process_rx(g, &buff[processed], pFooter);
         } else {
             g->offsetRx = 0;
             g->eth_error = false;
@@ -1381,20 +1696,20 @@ static void enqueue_rx_spi(TC6_t *g, const uint8_t *buff, uint16_t buf_len)
 
 static void update_credit_cnt(TC6_t *g, const uint8_t *buff, uint16_t buf_len)
 {
-    const uint8_t *const pFooter = &buff[buf_len - TC6_HEADER_SIZE];
+    const Footer_t pFooter = LOAD_FOOTER(&buff[buf_len - TC6_HEADER_SIZE]);
     bool success = true;
 
     TC6_ASSERT(buf_len && (0u == (buf_len % TC6_CHUNK_BUF_SIZE)));
 
-    if (success && GET_VAL(FTR_HDRB, pFooter)) {
+    if (success && GET_FTR(FTR_HDRB, pFooter)) {
         success = false;
     }
-    if (success && !GET_VAL(FTR_SYNC, pFooter)) {
+    if (success && !GET_FTR(FTR_SYNC, pFooter)) {
         success = false;
     }
     if (success) {
-        g->txc = GET_VAL(FTR_TXC, pFooter);
-        g->rca = GET_VAL(FTR_RCA, pFooter);
+        g->txc = GET_FTR(FTR_TXC, pFooter);
+        g->rca = GET_FTR(FTR_RCA, pFooter);
     }
 }
 
@@ -1409,6 +1724,7 @@ void TC6_SpiBufferDone(uint8_t tc6instance, bool success)
     if (tc6instance < TC6_MAX_INSTANCES) {
         struct qspibuf *entry;
         g = &m_tc6[tc6instance];
+        TC6_PROBE(g, TC6Probe_SpiDone);
         g->intContext = true;
         if (!success) {
             signal_rx_error(g, TC6Error_SpiError);
@@ -0,0 +1,316 @@
+/*******************************************************************************
+  Hot Path Trace for libtc6
+
+  File Name:
+    tc6trace.c
+
+  Summary:
+    Cycle counter time stamps of the libtc6 probes and of integrator stages
+
+  Description:
+    This file provides the trace buffers, the stage pairing, the histograms
+    and the Chrome trace JSON output
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include "tc6-conf.h"
+#include "tc6trace.h"
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                    INTERNAL DEFINES AND VARIABLES                    */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+#if (TC6TracePoint_Count > 255)
+#error "Trace points must fit into a byte"
+#endif
+
+#define POINT_EMPTY             (0xFFu)
+#define HIST_FIRST_SHIFT        (8u)    /* Bucket 0 ends at 2^8 ns */
+
+typedef struct
+{
+    uint32_t cycles;
+    uint8_t instance;
+    uint8_t point;              /* Written last, POINT_EMPTY until the record is complete */
+} Record_t;
+
+typedef struct
+{
+    Record_t rec[TC6TRACE_BUF_SIZE];
+    uint32_t count;             /* Reserved records, keeps counting when the buffer is full */
+} CoreBuffer_t;
+
+typedef struct
+{
+    const char *name;
+    uint8_t begin;
+    uint8_t end;
+    bool keepFirst;             /* A repeated begin does not restart the stage */
+} StageDef_t;
+
+/* State of TC6Trace_WriteJson() */
+typedef struct
+{
+    FILE *f;
+    bool first;
+    uint32_t epoch[TC6TRACE_MAX_CORES];
+    uint16_t usedStages[TC6_MAX_INSTANCES][TC6TRACE_MAX_CORES];
+} JsonCtx_t;
+
+typedef void (*StageCallback_t)(void *pCtx, uint8_t core, uint8_t instance, TC6Trace_Stage_t stage, uint32_t begin, uint32_t end);
+
+static const StageDef_t m_stage[TC6TraceStage_Count] = {
+    { "irq_to_service", TC6TracePoint_Irq, TC6Probe_ServiceBegin, true },
+    { "service", TC6Probe_ServiceBegin, TC6Probe_ServiceEnd, false },
+    { "data", TC6Probe_DataBegin, TC6Probe_DataEnd, false },
+    { "spi", TC6Probe_SpiStart, TC6Probe_SpiDone, false },
+    { "rx_chunks", TC6Probe_RxChunksBegin, TC6Probe_RxChunksEnd, false },
+    { "rx_packet", TC6Probe_RxPacketBegin, TC6Probe_RxPacketEnd, false },
+    { "input", TC6TracePoint_InputBegin, TC6TracePoint_InputEnd, false },
+    { "consumer", TC6TracePoint_ConsumerBegin, TC6TracePoint_ConsumerEnd, false },
+};
+
+static CoreBuffer_t m_core[TC6TRACE_MAX_CORES];
+static uint32_t m_cyclesPerUs = 1u;
+static bool m_running;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                      PRIVATE FUNCTION PROTOTYPES                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+static uint32_t walkStages(StageCallback_t callback, void *pCtx);
+static uint32_t cyclesToNs(uint32_t cycles);
+static uint8_t getBucket(uint32_t ns);
+static void onStageStats(void *pCtx, uint8_t core, uint8_t instance, TC6Trace_Stage_t stage, uint32_t begin, uint32_t end);
+static void onStageJson(void *pCtx, uint8_t core, uint8_t instance, TC6Trace_Stage_t stage, uint32_t begin, uint32_t end);
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                         PUBLIC FUNCTIONS                             */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+void TC6Trace_Init(uint32_t cyclesPerUs)
+{
+    __atomic_store_n(&m_running, false, __ATOMIC_RELEASE);
+    m_cyclesPerUs = (0u != cyclesPerUs) ? cyclesPerUs : 1u;
+    memset(m_core, POINT_EMPTY, sizeof(m_core));
+    for (uint8_t c = 0u; c < TC6TRACE_MAX_CORES; c++) {
+        m_core[c].count = 0u;
+    }
+}
+
+void TC6Trace_Start(void)
+{
+    __atomic_store_n(&m_running, false, __ATOMIC_RELEASE);
+    for (uint8_t c = 0u; c < TC6TRACE_MAX_CORES; c++) {
+        CoreBuffer_t *pBuf = &m_core[c];
+        uint32_t used = pBuf->count;
+        if (used > TC6TRACE_BUF_SIZE) {
+            used = TC6TRACE_BUF_SIZE;
+        }
+        for (uint32_t i = 0u; i < used; i++) {
+            pBuf->rec[i].point = POINT_EMPTY;
+        }
+        __atomic_store_n(&pBuf->count, 0u, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&m_running, true, __ATOMIC_RELEASE);
+}
+
+void TC6Trace_Stop(void)
+{
+    __atomic_store_n(&m_running, false, __ATOMIC_RELEASE);
+}
+
+bool TC6Trace_IsFull(void)
+{
+    bool full = false;
+    for (uint8_t c = 0u; c < TC6TRACE_MAX_CORES; c++) {
+        if (__atomic_load_n(&m_core[c].count, __ATOMIC_RELAXED) >= TC6TRACE_BUF_SIZE) {
+            full = true;
+        }
+    }
+    return full;
+}
+
+void TC6Trace_Record(uint8_t tc6instance, uint8_t point)
+{
+    if (__atomic_load_n(&m_running, __ATOMIC_ACQUIRE)) {
+        uint8_t core = TC6Trace_CB_GetCore();
+        if (core < TC6TRACE_MAX_CORES) {
+            CoreBuffer_t *pBuf = &m_core[core];
+            /* An interrupt on this core may record in between, the reservation keeps both records apart */
+            uint32_t idx = __atomic_fetch_add(&pBuf->count, 1u, __ATOMIC_RELAXED);
+            if (idx < TC6TRACE_BUF_SIZE) {
+                Record_t *pRec = &pBuf->rec[idx];
+                pRec->cycles = TC6Trace_CB_GetCycles();
+                pRec->instance = tc6instance;
+                __atomic_store_n(&pRec->point, point, __ATOMIC_RELEASE);
+            }
+        }
+    }
+}
+
+uint32_t TC6Trace_GetStats(TC6Trace_StageStats_t *pStats)
+{
+    memset(pStats, 0, sizeof(TC6Trace_StageStats_t) * TC6TraceStage_Count);
+    for (uint8_t s = 0u; s < TC6TraceStage_Count; s++) {
+        pStats[s].minNs = UINT32_MAX;
+    }
+    return walkStages(onStageStats, pStats);
+}
+
+const char *TC6Trace_GetStageName(TC6Trace_Stage_t stage)
+{
+    return (stage < TC6TraceStage_Count) ? m_stage[stage].name : "?";
+}
+
+void TC6Trace_PrintStats(FILE *f)
+{
+    static TC6Trace_StageStats_t stats[TC6TraceStage_Count];
+    uint32_t lost = TC6Trace_GetStats(stats);
+    fprintf(f, "TRACE,stage,count,min_ns,mean_ns,max_ns\n");
+    for (uint8_t s = 0u; s < TC6TraceStage_Count; s++) {
+        const TC6Trace_StageStats_t *pSt = &stats[s];
+        if (0u == pSt->count) {
+            continue;
+        }
+        fprintf(f, "TRACE,%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 "\n", m_stage[s].name, pSt->count,
+            pSt->minNs, (uint32_t)(pSt->sumNs / pSt->count), pSt->maxNs);
+    }
+    fprintf(f, "TRACE_HIST,stage,from_ns,count\n");
+    for (uint8_t s = 0u; s < TC6TraceStage_Count; s++) {
+        for (uint8_t b = 0u; b < TC6TRACE_HIST_BUCKETS; b++) {
+            if (0u != stats[s].hist[b]) {
+                uint32_t from = (0u == b) ? 0u : (1u << (HIST_FIRST_SHIFT + b - 1u));
+                fprintf(f, "TRACE_HIST,%s,%" PRIu32 ",%" PRIu32 "\n", m_stage[s].name, from, stats[s].hist[b]);
+            }
+        }
+    }
+    fprintf(f, "TRACE_LOST,%" PRIu32 "\n", lost);
+}
+
+void TC6Trace_WriteJson(FILE *f)
+{
+    static JsonCtx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.f = f;
+    ctx.first = true;
+    for (uint8_t c = 0u; c < TC6TRACE_MAX_CORES; c++) {
+        /* Time line of every core starts with its first record */
+        if ((0u != m_core[c].count) && (POINT_EMPTY != m_core[c].rec[0].point)) {
+            ctx.epoch[c] = m_core[c].rec[0].cycles;
+        }
+    }
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    (void)walkStages(onStageJson, &ctx);
+    for (uint8_t i = 0u; i < TC6_MAX_INSTANCES; i++) {
+        bool named = false;
+        for (uint8_t c = 0u; c < TC6TRACE_MAX_CORES; c++) {
+            for (uint8_t s = 0u; s < TC6TraceStage_Count; s++) {
+                if (0u == (ctx.usedStages[i][c] & (1u << s))) {
+                    continue;
+                }
+                if (!named) {
+                    fprintf(f, ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":\"tc6 %u\"}}", i, i);
+                    named = true;
+                }
+                fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s (core %u)\"}}",
+                    i, (unsigned)((c * TC6TraceStage_Count) + s), m_stage[s].name, c);
+            }
+        }
+    }
+    fprintf(f, "\n]}\n");
+}
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  PRIVATE FUNCTION IMPLEMENTATIONS                    */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+/*
+ * Walks the records of every core in order and reports each begin/end pair.
+ * Returns the number of records, which did not fit into the buffers.
+ */
+static uint32_t walkStages(StageCallback_t callback, void *pCtx)
+{
+    static uint32_t beginAt[TC6_MAX_INSTANCES][TC6TraceStage_Count];
+    static bool pending[TC6_MAX_INSTANCES][TC6TraceStage_Count];
+    uint32_t lost = 0u;
+    for (uint8_t c = 0u; c < TC6TRACE_MAX_CORES; c++) {
+        const CoreBuffer_t *pBuf = &m_core[c];
+        uint32_t used = __atomic_load_n(&pBuf->count, __ATOMIC_ACQUIRE);
+        if (used > TC6TRACE_BUF_SIZE) {
+            lost += used - TC6TRACE_BUF_SIZE;
+            used = TC6TRACE_BUF_SIZE;
+        }
+        memset(pending, 0, sizeof(pending));
+        for (uint32_t i = 0u; i < used; i++) {
+            const Record_t *pRec = &pBuf->rec[i];
+            uint8_t point = __atomic_load_n(&pRec->point, __ATOMIC_ACQUIRE);
+            uint8_t inst = pRec->instance;
+            if ((POINT_EMPTY == point) || (inst >= TC6_MAX_INSTANCES)) {
+                continue;
+            }
+            for (uint8_t s = 0u; s < TC6TraceStage_Count; s++) {
+                if ((point == m_stage[s].end) && pending[inst][s]) {
+                    pending[inst][s] = false;
+                    callback(pCtx, c, inst, (TC6Trace_Stage_t)s, beginAt[inst][s], pRec->cycles);
+                }
+                if ((point == m_stage[s].begin) && !(m_stage[s].keepFirst && pending[inst][s])) {
+                    pending[inst][s] = true;
+                    beginAt[inst][s] = pRec->cycles;
+                }
+            }
+        }
+    }
+    return lost;
+}
+
+static uint32_t cyclesToNs(uint32_t cycles)
+{
+    uint64_t ns = ((uint64_t)cycles * 1000u) / m_cyclesPerUs;
+    return (ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)ns;
+}
+
+static uint8_t getBucket(uint32_t ns)
+{
+    uint8_t bucket = 0u;
+    uint32_t v = ns >> HIST_FIRST_SHIFT;
+    while ((0u != v) && (bucket < (TC6TRACE_HIST_BUCKETS - 1u))) {
+        bucket++;
+        v >>= 1;
+    }
+    return bucket;
+}
+
+static void onStageStats(void *pCtx, uint8_t core, uint8_t instance, TC6Trace_Stage_t stage, uint32_t begin, uint32_t end)
+{
+    TC6Trace_StageStats_t *pSt = &((TC6Trace_StageStats_t *)pCtx)[stage];
+    uint32_t ns = cyclesToNs(end - begin);
+    (void)core;
+    (void)instance;
+    pSt->count++;
+    pSt->sumNs += ns;
+    if (ns < pSt->minNs) {
+        pSt->minNs = ns;
+    }
+    if (ns > pSt->maxNs) {
+        pSt->maxNs = ns;
+    }
+    pSt->hist[getBucket(ns)]++;
+}
+
+static void onStageJson(void *pCtx, uint8_t core, uint8_t instance, TC6Trace_Stage_t stage, uint32_t begin, uint32_t end)
+{
+    JsonCtx_t *pJ = (JsonCtx_t *)pCtx;
+    uint32_t ts;
+    uint32_t dur = cyclesToNs(end - begin);
+    /* An interrupt may have stored an earlier time stamp behind the first record */
+    ts = ((int32_t)(begin - pJ->epoch[core]) > 0) ? cyclesToNs(begin - pJ->epoch[core]) : 0u;
+    pJ->usedStages[instance][core] |= (uint16_t)(1u << stage);
+    fprintf(pJ->f, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%" PRIu32 ".%03" PRIu32 ",\"dur\":%" PRIu32 ".%03" PRIu32 "}",
+        pJ->first ? "" : ",", m_stage[stage].name, instance, (unsigned)((core * TC6TraceStage_Count) + stage),
+        ts / 1000u, ts % 1000u, dur / 1000u, dur % 1000u);
+    pJ->first = false;
+}
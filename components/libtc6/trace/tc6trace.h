@@ -0,0 +1,146 @@
+/*******************************************************************************
+  Hot Path Trace for libtc6
+
+  File Name:
+    tc6trace.h
+
+  Summary:
+    Cycle counter time stamps of the libtc6 probes and of integrator stages
+
+  Description:
+    Records the probes of libtc6 (TC6_PROBES, see tc6.h) and a few probes
+    placed by the integrator (IRQ, TCP/IP stack input, RX consumer task)
+    into one trace buffer per CPU core. Recording is lock free and may be
+    done from task and interrupt context: every record reserves its entry
+    with an atomic increment, a capture ends when the buffer is full.
+    Afterwards begin/end probes are paired into stages, which are printed
+    as latency histograms or written as Chrome trace JSON (chrome://tracing,
+    ui.perfetto.dev). Stages are only paired within one core, as the cycle
+    counters of different cores are not synchronized.
+*******************************************************************************/
+
+#ifndef TC6_TRACE_H_
+#define TC6_TRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "tc6.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                            DEFINITIONS                               */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+/** \brief Number of CPU cores, every core records into its own buffer */
+#ifndef TC6TRACE_MAX_CORES
+#define TC6TRACE_MAX_CORES      (2u)
+#endif
+
+/** \brief Records per core and capture (8 byte each) */
+#ifndef TC6TRACE_BUF_SIZE
+#define TC6TRACE_BUF_SIZE       (1024u)
+#endif
+
+/** \brief Number of histogram buckets. Bucket 0 holds durations below 256 ns, every further bucket doubles, the last one is open */
+#define TC6TRACE_HIST_BUCKETS   (16u)
+
+typedef enum
+{
+    TC6TracePoint_Irq = TC6Probe_Count, /** IRQ_N interrupt of the MACPHY */
+    TC6TracePoint_InputBegin,           /** Received frame handed to the TCP/IP stack */
+    TC6TracePoint_InputEnd,             /** TCP/IP stack input returned */
+    TC6TracePoint_ConsumerBegin,        /** RX consumer task starts processing a frame */
+    TC6TracePoint_ConsumerEnd,          /** RX consumer task finished the frame */
+    TC6TracePoint_Count,
+} TC6Trace_Point_t;
+
+typedef enum
+{
+    TC6TraceStage_IrqToService,         /** IRQ until the next TC6_Service() */
+    TC6TraceStage_Service,              /** TC6_Service() */
+    TC6TraceStage_Data,                 /** Assembly of a data transaction (serviceData) */
+    TC6TraceStage_Spi,                  /** TC6_CB_OnSpiTransaction() until TC6_SpiBufferDone() */
+    TC6TraceStage_RxChunks,             /** Parsing the chunks of a SPI transaction (enqueue_rx_spi) */
+    TC6TraceStage_RxPacket,             /** TC6_CB_OnRxEthernetPacket() */
+    TC6TraceStage_Input,                /** TCP/IP stack input (netif.input) */
+    TC6TraceStage_Consumer,             /** RX consumer task per frame (RxTask) */
+    TC6TraceStage_Count,
+} TC6Trace_Stage_t;
+
+typedef struct
+{
+    uint32_t count;             /** Paired begin/end probes */
+    uint32_t minNs;
+    uint32_t maxNs;
+    uint64_t sumNs;
+    uint32_t hist[TC6TRACE_HIST_BUCKETS];
+} TC6Trace_StageStats_t;
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                          PUBLIC FUNCTIONS                            */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+/** \brief Initializes the trace, no capture is running afterwards.
+ *  \param cyclesPerUs - Counts of TC6Trace_CB_GetCycles() per microsecond.
+ */
+void TC6Trace_Init(uint32_t cyclesPerUs);
+
+/** \brief Empties the buffers of all cores and starts a new capture. */
+void TC6Trace_Start(void);
+
+/** \brief Ends the capture. Records of other cores, which are just being written, may get lost. */
+void TC6Trace_Stop(void);
+
+/** \brief Returns true, if the buffer of at least one core is full. */
+bool TC6Trace_IsFull(void);
+
+/** \brief Records a probe into the buffer of the calling core.
+ *  \note May be called from task and interrupt context. Does nothing while no capture is running or the buffer is full.
+ *  \param tc6instance - The instance number of the hardware.
+ *  \param point - TC6_Probe_t or TC6Trace_Point_t value.
+ */
+void TC6Trace_Record(uint8_t tc6instance, uint8_t point);
+
+/** \brief Pairs the recorded probes into stages.
+ *  \note Call it after TC6Trace_Stop().
+ *  \param pStats - Array of TC6TraceStage_Count entries receiving the statistics.
+ *  \return Number of records, which did not fit into the buffers.
+ */
+uint32_t TC6Trace_GetStats(TC6Trace_StageStats_t *pStats);
+
+/** \brief Returns the name of a stage. */
+const char *TC6Trace_GetStageName(TC6Trace_Stage_t stage);
+
+/** \brief Prints one line per stage (prefix "TRACE") and one line per used histogram bucket (prefix "TRACE_HIST").
+ *  \note Call it after TC6Trace_Stop().
+ */
+void TC6Trace_PrintStats(FILE *f);
+
+/** \brief Writes the paired stages as Chrome trace JSON (one process per instance, one thread per stage).
+ *  \note Call it after TC6Trace_Stop().
+ */
+void TC6Trace_WriteJson(FILE *f);
+
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+/*                  CALLBACK FUNCTIONS (INTEGRATOR)                     */
+/*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
+
+/** \brief Returns the cycle counter of the calling core.
+ *  \note This function must be implemented by the integrator. It is called from task and interrupt context.
+ */
+extern uint32_t TC6Trace_CB_GetCycles(void);
+
+/** \brief Returns the number of the calling core (0 .. TC6TRACE_MAX_CORES - 1).
+ *  \note This function must be implemented by the integrator. It is called from task and interrupt context.
+ */
+extern uint8_t TC6Trace_CB_GetCore(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TC6_TRACE_H_ */
@@ -0,0 +1,511 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "lwip/pbuf.h"
+#include "lwip/inet.h"
+
+#include "configuration.h"
+#include "main.h"
+#include "lan8651.h"
+#include "ethernet.h"
+#include "encryption.h"
+#include "benchmark.h"
+#include "rxring.h"
+
+static const char *BENCH_TAG = "BENCH";
+
+#define BENCH_MAGIC 0x42454E43u         // "BENC"
+#define BENCH_MAX_FRAME 1514
+
+// Bytes in front of the payload (Ethernet, IPv4 + UDP, DTLS 1.2 record with AES-GCM), used for pacing and the payload limit
+#define BENCH_OVERHEAD_RAW 14
+#define BENCH_OVERHEAD_UDP (14 + 20 + 8)
+#define BENCH_OVERHEAD_DTLS (BENCH_OVERHEAD_UDP + 13 + 8 + 16)
+
+// Preamble, FCS and inter frame gap of every frame on the segment
+#define BENCH_WIRE_EXTRA (8 + 4 + 12)
+
+// Operations per measurement of the RX ring against a FreeRTOS queue
+#define BENCH_QUEUE_OPS 1000
+
+// The reflector gets some time to boot and the segment to synchronize before the first frame
+#define BENCH_START_DELAY_MS 5000
+
+#if BENCH_DUTY_CYCLE < 1 || BENCH_DUTY_CYCLE > 100
+#error "BENCH_DUTY_CYCLE must be between 1 and 100"
+#endif
+
+// Start of the payload of every benchmark frame / datagram / record, echoed unchanged by the reflector
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t step;              // Index into BENCH_PAYLOADS, echoes of earlier steps are ignored
+    uint16_t payload;
+    uint32_t seq;
+    int64_t sent;               // esp_timer time of the sender
+} BenchHeader_t;
+
+// Results of the running payload size, written by RxTask (raw echoes) or the sender task, protected by lock
+typedef struct {
+    uint16_t step;
+    uint32_t received;
+    uint32_t latencyUs[BENCH_FRAMES];
+    uint8_t seen[(BENCH_FRAMES + 7) / 8];       // Echoes are counted once, even with several reflectors
+} BenchResult_t;
+
+static const uint16_t payloads[] = BENCH_PAYLOADS;
+#define BENCH_STEPS (sizeof(payloads) / sizeof(payloads[0]))
+
+static BenchResult_t result;
+static uint8_t frameBuffer[BENCH_MAX_FRAME];
+static uint16_t benchPort;
+
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Ring and cycle samples of BenchQueueCompare, static to keep them off the task stack
+static RxRing_t benchRing;
+static uint32_t pushCycles[BENCH_QUEUE_OPS];
+static uint32_t popCycles[BENCH_QUEUE_OPS];
+
+// Task sending the payload sweep and printing one CSV line per payload size
+static void BenchSenderTask(void *pvParameters);
+
+// Task echoing benchmark datagrams back to the sender (BenchMode_Udp)
+static void BenchReflectorTask(void *pvParameters);
+
+// Function measuring the cost of enqueue and dequeue of the RX ring and a FreeRTOS queue with the same entries
+static void BenchQueueCompare(void);
+
+// Function printing the percentiles of one set of cycle samples
+static void BenchQueueReport(const char *type, const char *op, uint32_t *cycles);
+
+// Function sending one benchmark payload with the configured mode, returns false when the stack refused it
+static bool BenchSend(int sock, const struct sockaddr_in *dest, const uint8_t *data, uint16_t length);
+
+// Function storing the round trip time of an echoed payload
+static void BenchRecordEcho(const uint8_t *data, uint16_t length);
+
+// Function reading all echoes waiting on the UDP socket without blocking
+static void BenchDrainSocket(int sock);
+
+// Function waiting until the given esp_timer time, sleeps as long as at least one tick is left
+static void BenchWait(int64_t until);
+
+// Function returning the bytes in front of the payload for the configured mode
+static uint16_t BenchOverhead(void);
+
+// Functions sampling the run time of all tasks before and after one payload size (needs run time stats in menuconfig)
+static void BenchCpuStart(void);
+static void BenchCpuReport(uint16_t payload);
+
+static int CompareLatency(const void *a, const void *b);
+
+
+
+
+void InitBenchmark(void) {
+    benchPort = (uint16_t)atoi(BENCH_PORT);
+
+    if (BENCH_ROLE == BenchRole_Sender) {
+        xTaskCreate(BenchSenderTask, "BenchSenderTask", 4096, NULL, 4, NULL);
+    } else if (BENCH_MODE == BenchMode_Udp) {
+        xTaskCreate(BenchReflectorTask, "BenchReflectorTask", 4096, NULL, 5, NULL);
+    }
+    ESP_LOGI(BENCH_TAG, "Benchmark initialized: %s, mode %d, %u payload sizes, %d frames each, duty cycle %d%%",
+             BENCH_ROLE == BenchRole_Sender ? "sender" : "reflector", BENCH_MODE, (unsigned)BENCH_STEPS, BENCH_FRAMES, BENCH_DUTY_CYCLE);
+}
+
+bool BenchHandleFrame(uint8_t instance, const uint8_t *data, uint16_t length) {
+    uint16_t type;
+
+    if (length < 14) {
+        return false;
+    }
+
+    type = (data[12] << 8) | data[13];
+    if (type == BENCH_ETHERTYPE) {
+        if (BENCH_ROLE == BenchRole_Reflector) {
+            struct pbuf *p = pbuf_alloc(PBUF_RAW, length, PBUF_RAM);
+            if (p != NULL) {
+                uint8_t *echo = (uint8_t *)p->payload;
+
+                // Back to the source, payload (including the sender timestamp) unchanged
+                memcpy(echo, &data[6], 6);
+                GetMacAddress(instance, &echo[6]);
+                memcpy(&echo[12], &data[12], length - 12);
+                SendEthernetFrame(instance, p);
+                pbuf_free(p);
+            }
+        } else {
+            BenchRecordEcho(&data[14], length - 14);
+        }
+        return true;
+    }
+
+    // UDP from or to the benchmark port, delivered by lwIP to the socket, only kept away from the dump
+    if ((type == 0x0800) && (length >= 42) && (data[23] == 17)) {
+        uint16_t ihl = (data[14] & 0x0F) * 4;
+        if (length >= 14 + ihl + 4) {
+            uint16_t srcPort = (data[14 + ihl] << 8) | data[15 + ihl];
+            uint16_t dstPort = (data[16 + ihl] << 8) | data[17 + ihl];
+            return (srcPort == benchPort) || (dstPort == benchPort);
+        }
+    }
+
+    return false;
+}
+
+
+
+static void BenchSenderTask(void *pvParameters) {
+    (void)pvParameters;
+    struct sockaddr_in dest;
+    int sock = -1;
+    uint16_t overhead = BenchOverhead();
+
+    vTaskDelay(pdMS_TO_TICKS(BENCH_START_DELAY_MS));
+
+    memset(&dest, 0, sizeof(dest));
+    if (BENCH_MODE == BenchMode_Udp) {
+        dest.sin_family = AF_INET;
+        dest.sin_port = htons(benchPort);
+        inet_aton(TARGET_IP, &dest.sin_addr);
+
+        sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (sock < 0) {
+            ESP_LOGE(BENCH_TAG, "Failed to create socket");
+            vTaskDelete(NULL);
+            return;
+        }
+    }
+
+    BenchQueueCompare();
+
+    printf("BENCH,mode,payload,nodes,plca,duty,sent,errors,received,duration_us,fps,goodput_kbps,p50_us,p90_us,p99_us,max_us\n");
+
+    for (uint16_t step = 0; step < BENCH_STEPS; step++) {
+        uint16_t payload = payloads[step];
+        uint32_t sent = 0;
+        uint32_t errors = 0;
+
+        // Payload holds at least the header, frame never exceeds the MTU
+        if (payload < sizeof(BenchHeader_t)) {
+            payload = sizeof(BenchHeader_t);
+        }
+        if (payload > BENCH_MAX_FRAME - overhead) {
+            payload = BENCH_MAX_FRAME - overhead;
+        }
+
+        // Time on the segment of one frame at 10 Mbit/s, stretched to the duty cycle
+        int64_t period = ((int64_t)(overhead + payload + BENCH_WIRE_EXTRA) * 8 / 10) * 100 / BENCH_DUTY_CYCLE;
+
+        taskENTER_CRITICAL(&lock);
+        memset(&result, 0, sizeof(result));
+        result.step = step;
+        taskEXIT_CRITICAL(&lock);
+
+        BenchCpuStart();
+        int64_t start = esp_timer_get_time();
+
+        for (uint32_t seq = 0; seq < BENCH_FRAMES; seq++) {
+            uint8_t *data = (BENCH_MODE == BenchMode_Raw) ? &frameBuffer[14] : frameBuffer;
+            BenchHeader_t header = {
+                .magic = BENCH_MAGIC,
+                .step = step,
+                .payload = payload,
+                .seq = seq,
+            };
+
+            if (BENCH_DUTY_CYCLE < 100) {
+                BenchWait(start + (int64_t)seq * period);
+            }
+
+            header.sent = esp_timer_get_time();
+            memcpy(data, &header, sizeof(header));
+            memset(&data[sizeof(header)], (uint8_t)seq, payload - sizeof(header));
+
+            if (BenchSend(sock, &dest, data, payload)) {
+                sent++;
+
+                // Nothing comes back over DTLS, the latency is the time spent in the stack for one record
+                if (BENCH_MODE == BenchMode_Dtls) {
+                    BenchRecordEcho(data, payload);
+                }
+            } else {
+                errors++;
+            }
+
+            if (BENCH_MODE == BenchMode_Udp) {
+                BenchDrainSocket(sock);
+            }
+        }
+
+        int64_t duration = esp_timer_get_time() - start;
+
+        int64_t settleEnd = esp_timer_get_time() + (int64_t)BENCH_SETTLE_MS * 1000;
+        while (esp_timer_get_time() < settleEnd) {
+            if (BENCH_MODE == BenchMode_Udp) {
+                BenchDrainSocket(sock);
+            }
+            vTaskDelay(1);
+        }
+
+        // Late echoes are dropped from here on
+        taskENTER_CRITICAL(&lock);
+        result.step = UINT16_MAX;
+        taskEXIT_CRITICAL(&lock);
+
+        uint32_t received = result.received;
+        qsort(result.latencyUs, received, sizeof(result.latencyUs[0]), CompareLatency);
+
+        uint32_t fps = duration ? (uint32_t)((int64_t)received * 1000000 / duration) : 0;
+        uint32_t goodput = duration ? (uint32_t)((int64_t)received * payload * 8 * 1000 / duration) : 0;
+        uint32_t p50 = received ? result.latencyUs[(received - 1) * 50 / 100] : 0;
+        uint32_t p90 = received ? result.latencyUs[(received - 1) * 90 / 100] : 0;
+        uint32_t p99 = received ? result.latencyUs[(received - 1) * 99 / 100] : 0;
+        uint32_t max = received ? result.latencyUs[received - 1] : 0;
+
+        printf("BENCH,%d,%u,%d,%d,%d,%lu,%lu,%lu,%lld,%lu,%lu,%lu,%lu,%lu,%lu\n",
+               BENCH_MODE, payload, NODE_COUNT, PLCA_ENABLE ? 1 : 0, BENCH_DUTY_CYCLE,
+               sent, errors, received, duration, fps, goodput, p50, p90, p99, max);
+
+        BenchCpuReport(payload);
+    }
+
+    printf("BENCH,done\n");
+    ESP_LOGI(BENCH_TAG, "Benchmark finished");
+
+    if (sock >= 0) {
+        close(sock);
+    }
+    vTaskDelete(NULL);
+}
+
+static void BenchReflectorTask(void *pvParameters) {
+    (void)pvParameters;
+    struct sockaddr_in addr;
+    struct sockaddr_in source;
+    socklen_t sourceLen;
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        ESP_LOGE(BENCH_TAG, "Failed to create socket");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(benchPort);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        ESP_LOGE(BENCH_TAG, "Failed to bind port %u", benchPort);
+        close(sock);
+        vTaskDelete(NULL);
+        return;
+    }
+
+    while (1) {
+        sourceLen = sizeof(source);
+        int len = recvfrom(sock, frameBuffer, sizeof(frameBuffer), 0, (struct sockaddr *)&source, &sourceLen);
+        if (len > 0) {
+            sendto(sock, frameBuffer, len, 0, (struct sockaddr *)&source, sourceLen);
+        }
+    }
+}
+
+static void BenchQueueCompare(void) {
+    EthernetFrame_t frame = { 0 };
+    EthernetFrame_t out;
+    uint32_t start;
+
+    // Same task for both sides, this is the cost of one call without contention or task switch
+    printf("BENCH_QUEUE,type,op,ops,p50_cycles,p99_cycles,max_cycles\n");
+
+    RxRingInit(&benchRing);
+    for (uint32_t i = 0; i < BENCH_QUEUE_OPS; i++) {
+        frame.length = (uint16_t)i;
+        start = esp_cpu_get_cycle_count();
+        RxRingPush(&benchRing, &frame);
+        pushCycles[i] = esp_cpu_get_cycle_count() - start;
+
+        start = esp_cpu_get_cycle_count();
+        RxRingPop(&benchRing, &out, 1, 0);
+        popCycles[i] = esp_cpu_get_cycle_count() - start;
+    }
+    BenchQueueReport("ring", "enqueue", pushCycles);
+    BenchQueueReport("ring", "dequeue", popCycles);
+
+    QueueHandle_t queue = xQueueCreate(RX_RING_SIZE, sizeof(EthernetFrame_t));
+    if (queue == NULL) {
+        ESP_LOGE(BENCH_TAG, "Failed to create queue");
+        return;
+    }
+    for (uint32_t i = 0; i < BENCH_QUEUE_OPS; i++) {
+        frame.length = (uint16_t)i;
+        start = esp_cpu_get_cycle_count();
+        xQueueSend(queue, &frame, 0);
+        pushCycles[i] = esp_cpu_get_cycle_count() - start;
+
+        start = esp_cpu_get_cycle_count();
+        xQueueReceive(queue, &out, 0);
+        popCycles[i] = esp_cpu_get_cycle_count() - start;
+    }
+    BenchQueueReport("queue", "enqueue", pushCycles);
+    BenchQueueReport("queue", "dequeue", popCycles);
+    vQueueDelete(queue);
+}
+
+static void BenchQueueReport(const char *type, const char *op, uint32_t *cycles) {
+    qsort(cycles, BENCH_QUEUE_OPS, sizeof(cycles[0]), CompareLatency);
+    printf("BENCH_QUEUE,%s,%s,%d,%lu,%lu,%lu\n", type, op, BENCH_QUEUE_OPS,
+           cycles[(BENCH_QUEUE_OPS - 1) * 50 / 100], cycles[(BENCH_QUEUE_OPS - 1) * 99 / 100], cycles[BENCH_QUEUE_OPS - 1]);
+}
+
+static bool BenchSend(int sock, const struct sockaddr_in *dest, const uint8_t *data, uint16_t length) {
+    bool success = false;
+
+    if (BENCH_MODE == BenchMode_Raw) {
+        // Broadcast, every reflector on the segment answers with a unicast echo
+        struct pbuf *p = pbuf_alloc(PBUF_RAW, length + 14, PBUF_RAM);
+        if (p != NULL) {
+            uint8_t *frame = (uint8_t *)p->payload;
+
+            memset(frame, 0xFF, 6);
+            GetMacAddress(0, &frame[6]);
+            frame[12] = BENCH_ETHERTYPE >> 8;
+            frame[13] = BENCH_ETHERTYPE & 0xFF;
+            memcpy(&frame[14], data, length);
+            success = (SendEthernetFrame(0, p) == ERR_OK);
+            pbuf_free(p);
+        }
+    } else if (BENCH_MODE == BenchMode_Udp) {
+        success = (sendto(sock, data, length, 0, (const struct sockaddr *)dest, sizeof(*dest)) == length);
+    } else {
+        success = (WriteEncryptedPacket(data, length) == length);
+    }
+
+    return success;
+}
+
+static void BenchRecordEcho(const uint8_t *data, uint16_t length) {
+    BenchHeader_t header;
+
+    if (length < sizeof(header)) {
+        return;
+    }
+    memcpy(&header, data, sizeof(header));
+    if ((header.magic != BENCH_MAGIC) || (header.seq >= BENCH_FRAMES)) {
+        return;
+    }
+
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - header.sent);
+
+    taskENTER_CRITICAL(&lock);
+    if ((header.step == result.step) && !(result.seen[header.seq / 8] & (1u << (header.seq % 8)))) {
+        result.seen[header.seq / 8] |= (1u << (header.seq % 8));
+        result.latencyUs[result.received++] = latency;
+    }
+    taskEXIT_CRITICAL(&lock);
+}
+
+static void BenchDrainSocket(int sock) {
+    static uint8_t echo[BENCH_MAX_FRAME];
+    int len;
+
+    while ((len = recv(sock, echo, sizeof(echo), MSG_DONTWAIT)) > 0) {
+        BenchRecordEcho(echo, (uint16_t)len);
+    }
+}
+
+static void BenchWait(int64_t until) {
+    int64_t now;
+
+    while ((now = esp_timer_get_time()) < until) {
+        if ((until - now) >= (int64_t)portTICK_PERIOD_MS * 1000) {
+            vTaskDelay(1);
+        } else {
+            taskYIELD();
+        }
+    }
+}
+
+static uint16_t BenchOverhead(void) {
+    if (BENCH_MODE == BenchMode_Udp) {
+        return BENCH_OVERHEAD_UDP;
+    }
+    if (BENCH_MODE == BenchMode_Dtls) {
+        return BENCH_OVERHEAD_DTLS;
+    }
+    return BENCH_OVERHEAD_RAW;
+}
+
+static int CompareLatency(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+
+
+#if (configUSE_TRACE_FACILITY == 1) && (configGENERATE_RUN_TIME_STATS == 1)
+
+#define BENCH_MAX_TASKS 24
+
+static TaskStatus_t cpuBefore[BENCH_MAX_TASKS];
+static TaskStatus_t cpuAfter[BENCH_MAX_TASKS];
+static UBaseType_t cpuBeforeCount;
+static configRUN_TIME_COUNTER_TYPE cpuBeforeTotal;
+
+static void BenchCpuStart(void) {
+    cpuBeforeCount = uxTaskGetSystemState(cpuBefore, BENCH_MAX_TASKS, &cpuBeforeTotal);
+}
+
+static void BenchCpuReport(uint16_t payload) {
+    configRUN_TIME_COUNTER_TYPE total;
+    UBaseType_t count = uxTaskGetSystemState(cpuAfter, BENCH_MAX_TASKS, &total);
+
+    // Total run time counts once, every core adds its own task run times
+    uint64_t elapsed = (uint64_t)(total - cpuBeforeTotal) * portNUM_PROCESSORS;
+    if (elapsed == 0) {
+        return;
+    }
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        configRUN_TIME_COUNTER_TYPE before = 0;
+
+        for (UBaseType_t j = 0; j < cpuBeforeCount; j++) {
+            if (cpuBefore[j].xTaskNumber == cpuAfter[i].xTaskNumber) {
+                before = cpuBefore[j].ulRunTimeCounter;
+                break;
+            }
+        }
+
+        uint32_t permille = (uint32_t)((uint64_t)(cpuAfter[i].ulRunTimeCounter - before) * 1000 / elapsed);
+        printf("BENCH_CPU,%d,%u,%s,%lu.%lu\n", BENCH_MODE, payload, cpuAfter[i].pcTaskName, permille / 10, permille % 10);
+    }
+}
+
+#else
+
+static void BenchCpuStart(void) {
+}
+
+static void BenchCpuReport(uint16_t payload) {
+    static bool reported = false;
+
+    (void)payload;
+    if (!reported) {
+        reported = true;
+        ESP_LOGW(BENCH_TAG, "CPU load per task needs FREERTOS_USE_TRACE_FACILITY and FREERTOS_GENERATE_RUN_TIME_STATS");
+    }
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Traffic used by the benchmark
+typedef enum {
+    BenchMode_Raw,          // Ethernet frames with EtherType BENCH_ETHERTYPE, echoed by the reflector
+    BenchMode_Udp,          // UDP datagrams to TARGET_IP:BENCH_PORT, echoed by the reflector
+    BenchMode_Dtls          // DTLS records over the client connection (ENCRYPTED_CLIENT), one way only
+} BenchMode_t;
+
+// Role of this node in the benchmark
+typedef enum {
+    BenchRole_Sender,       // Runs the payload sweep and prints the results
+    BenchRole_Reflector     // Sends every benchmark frame / datagram back to its source
+} BenchRole_t;
+
+// IEEE 802 local experimental EtherType used by BenchMode_Raw
+#define BENCH_ETHERTYPE 0x88B5
+
+// Initialization function creating the benchmark task of the configured role
+void InitBenchmark(void);
+
+// Function called by RxTask for every received frame, returns true when it was a benchmark frame (consumed)
+bool BenchHandleFrame(uint8_t instance, const uint8_t *data, uint16_t length);
+
+#endif
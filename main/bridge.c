@@ -0,0 +1,235 @@
+#include <string.h>
+#include "esp_log.h"
+
+#include "configuration.h"
+#include "lan8651.h"
+#include "bridge.h"
+#include "txframe.h"
+#include "stats.h"
+
+static const char *BRIDGE_TAG = "BRIDGE";
+
+#if BRIDGE_ENABLE && (LAN8651_COUNT < 2)
+#error "BRIDGE_ENABLE needs at least two LAN8651 (LAN8651_COUNT)"
+#endif
+
+#if (BRIDGE_TABLE_SIZE & (BRIDGE_TABLE_SIZE - 1)) != 0
+#error "BRIDGE_TABLE_SIZE must be power of 2"
+#endif
+
+// Number of table entries checked before a lookup gives up (linear probing)
+#define BRIDGE_MAX_PROBE 8
+
+// Entry of the MAC learning table, lastSeen == 0 marks a free entry
+typedef struct {
+    uint8_t mac[6];
+    uint8_t port;
+    uint32_t lastSeen;
+} BridgeEntry_t;
+
+// MAC learning table, only accessed from SyncTask (all tc6 callbacks run there)
+static BridgeEntry_t macTable[BRIDGE_TABLE_SIZE];
+
+static BridgePortStats_t portStats[LAN8651_COUNT];
+
+// Function for hashing a MAC address into a table index
+static uint32_t HashMac(const uint8_t *mac);
+
+// Function returning the port a MAC address was learned on, -1 when unknown or aged out
+static int LookupMac(const uint8_t *mac, uint32_t now);
+
+// Function for adding or refreshing the port of a source MAC address
+static void LearnMac(const uint8_t *mac, uint8_t port, uint32_t now);
+
+// Function returning true, if the MAC address belongs to one of the local interfaces
+static bool IsLocalMac(const uint8_t *mac);
+
+// Function for queueing the frame on the given port without copying it (holds a reference until OnBridgeTxDone)
+static void BridgeTransmit(uint8_t port, struct pbuf *p);
+
+// Callback from tc6 library when a forwarded frame was moved into SPI chunks
+static void OnBridgeTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag);
+
+
+
+
+void InitBridge(void) {
+    memset(macTable, 0, sizeof(macTable));
+    memset(portStats, 0, sizeof(portStats));
+    ESP_LOGI(BRIDGE_TAG, "Bridge initialized: %d ports, %d table entries", LAN8651_COUNT, BRIDGE_TABLE_SIZE);
+}
+
+bool BridgeInput(uint8_t port, struct pbuf *p) {
+    const uint8_t *dst = (const uint8_t *)p->payload;
+    const uint8_t *src = dst + 6;
+    uint32_t now = esp_log_timestamp();
+    bool deliver = false;
+
+    if (port >= LAN8651_COUNT || p->len < 14) {
+        return true;
+    }
+    portStats[port].rxFrames++;
+
+    // Group bit set in the source address is invalid, never learn it
+    if ((src[0] & 0x01) == 0) {
+        LearnMac(src, port, now);
+    }
+
+    if (dst[0] & 0x01) {
+        // Broadcast or multicast, flood to all other ports and deliver locally. lwIP may change the pbuf in place
+        // (header processing, replies built in the received buffer) while the frame still waits in a tc6 TX queue,
+        // so the forwarded frames share a copy of their own
+        struct pbuf *copy = pbuf_clone(PBUF_RAW, PBUF_RAM, p);
+        for (uint8_t i = 0; i < LAN8651_COUNT; i++) {
+            if (i == port) {
+                continue;
+            }
+            if (copy != NULL) {
+                BridgeTransmit(i, copy);
+            } else {
+                portStats[i].txDrops++;
+            }
+        }
+        if (copy != NULL) {
+            pbuf_free(copy);
+        }
+        portStats[port].flooded++;
+        deliver = true;
+    } else if (IsLocalMac(dst)) {
+        deliver = true;
+    } else {
+        int outPort = LookupMac(dst, now);
+        if (outPort == port) {
+            // Destination lives on the segment the frame came from
+            portStats[port].filtered++;
+        } else if (outPort >= 0) {
+            BridgeTransmit((uint8_t)outPort, p);
+            portStats[port].forwarded++;
+        } else {
+            for (uint8_t i = 0; i < LAN8651_COUNT; i++) {
+                if (i != port) {
+                    BridgeTransmit(i, p);
+                }
+            }
+            portStats[port].flooded++;
+        }
+    }
+
+    if (deliver) {
+        portStats[port].local++;
+    }
+    return deliver;
+}
+
+void BridgeGetPortStats(uint8_t port, BridgePortStats_t *stats) {
+    if (port < LAN8651_COUNT && stats != NULL) {
+        *stats = portStats[port];
+    }
+}
+
+
+
+static uint32_t HashMac(const uint8_t *mac) {
+    // FNV-1a over the 6 address bytes
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < 6; i++) {
+        hash ^= mac[i];
+        hash *= 16777619u;
+    }
+    return hash & (BRIDGE_TABLE_SIZE - 1);
+}
+
+static int LookupMac(const uint8_t *mac, uint32_t now) {
+    uint32_t index = HashMac(mac);
+
+    for (int i = 0; i < BRIDGE_MAX_PROBE; i++) {
+        BridgeEntry_t *entry = &macTable[(index + i) & (BRIDGE_TABLE_SIZE - 1)];
+        if (entry->lastSeen != 0 && memcmp(entry->mac, mac, 6) == 0) {
+            if ((now - entry->lastSeen) > BRIDGE_AGING_MS) {
+                entry->lastSeen = 0;
+                return -1;
+            }
+            return entry->port;
+        }
+    }
+    return -1;
+}
+
+static void LearnMac(const uint8_t *mac, uint8_t port, uint32_t now) {
+    uint32_t index = HashMac(mac);
+    BridgeEntry_t *slot = NULL;
+
+    // 0 marks a free entry, so a learned entry never gets that timestamp
+    if (now == 0) {
+        now = 1;
+    }
+
+    for (int i = 0; i < BRIDGE_MAX_PROBE; i++) {
+        BridgeEntry_t *entry = &macTable[(index + i) & (BRIDGE_TABLE_SIZE - 1)];
+        if (entry->lastSeen != 0 && memcmp(entry->mac, mac, 6) == 0) {
+            if (entry->port != port) {
+                ESP_LOGI(BRIDGE_TAG, "%02X:%02X:%02X:%02X:%02X:%02X moved to port %u", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], port);
+            }
+            entry->port = port;
+            entry->lastSeen = now;
+            return;
+        }
+        // Remember the first free or aged out entry
+        if (slot == NULL && (entry->lastSeen == 0 || (now - entry->lastSeen) > BRIDGE_AGING_MS)) {
+            slot = entry;
+        }
+    }
+
+    if (slot == NULL) {
+        // Probe window full, address is flooded until an entry ages out
+        return;
+    }
+    memcpy(slot->mac, mac, 6);
+    slot->port = port;
+    slot->lastSeen = now;
+}
+
+static bool IsLocalMac(const uint8_t *mac) {
+    uint8_t localMac[6];
+
+    for (uint8_t i = 0; i < LAN8651_COUNT; i++) {
+        GetMacAddress(i, localMac);
+        if (memcmp(localMac, mac, 6) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void BridgeTransmit(uint8_t port, struct pbuf *p) {
+    TC6_RawTxSegment *segments;
+
+    // Never block here, the caller is SyncTask which has to free the TX queue. It is also the only task
+    // filling the tc6 TX queues (lwIP and the TX scheduler hand their frames to it), so no locking is needed
+    uint8_t maxSegments = TC6_GetRawSegments(tc6_instance[port], &segments);
+    if (maxSegments == 0) {
+        portStats[port].txDrops++;
+        return;
+    }
+
+    // Segments point into the pbuf (the RX pbuf or the copy of a group frame),
+    // the extra reference keeps it alive until OnBridgeTxDone
+    pbuf_ref(p);
+    uint8_t count = TxFrameSegments(&p, segments, maxSegments);
+    if (count == 0 || !TC6_SendRawEthernetSegments(tc6_instance[port], segments, count, p->tot_len, 0, OnBridgeTxDone, p)) {
+        if (p != NULL) {
+            pbuf_free(p);
+        }
+        portStats[port].txDrops++;
+    }
+}
+
+static void OnBridgeTxDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag) {
+    uint8_t port = TC6_GetInstance(pInst);
+
+    if (port < LAN8651_COUNT) {
+        portStats[port].txFrames++;
+        StatsTxFrame(port, len);
+    }
+    pbuf_free((struct pbuf *)pTag);
+}
@@ -0,0 +1,29 @@
+#ifndef BRIDGE_H
+#define BRIDGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lwip/pbuf.h"
+
+// Forwarding counters of one bridge port (one LAN8651)
+typedef struct {
+    uint32_t rxFrames;      // Frames received on this port
+    uint32_t forwarded;     // Frames sent to the single port the destination was learned on
+    uint32_t flooded;       // Frames sent to all other ports (group or unknown destination)
+    uint32_t filtered;      // Frames dropped because the destination is on the same segment
+    uint32_t local;         // Frames handed to the local network interface
+    uint32_t txFrames;      // Frames of other ports sent on this port
+    uint32_t txDrops;       // Frames which could not be queued (or copied) for transmission on this port
+} BridgePortStats_t;
+
+// Initialization function clearing the MAC learning table and all counters
+void InitBridge(void);
+
+// Function called for every received frame, forwards it to the other ports and returns true when it must be delivered locally
+bool BridgeInput(uint8_t port, struct pbuf *p);
+
+// Function for reading the forwarding counters of one port
+void BridgeGetPortStats(uint8_t port, BridgePortStats_t *stats);
+
+#endif
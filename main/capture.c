@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "esp_log.h"
+#include "esp_spiffs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "configuration.h"
+#include "capture.h"
+#include "pcap.h"
+#include "pcap_rotate.h"
+
+static const char *PCAP_TAG = "PCAP";
+static const char *Spiffs_TAG = "SPIFFS";
+
+#if (CAPTURE_RING_SIZE & (CAPTURE_RING_SIZE - 1)) != 0 || (CAPTURE_BLOCK_SIZE & (CAPTURE_BLOCK_SIZE - 1)) != 0
+#error "CAPTURE_RING_SIZE and CAPTURE_BLOCK_SIZE must be power of 2"
+#endif
+
+#if CAPTURE_FLUSH_BYTES > CAPTURE_RING_SIZE
+#error "CAPTURE_FLUSH_BYTES must not be bigger than CAPTURE_RING_SIZE"
+#endif
+
+// Records on their way from RxTask (producer) to CaptureTask (consumer)
+static uint8_t ringMemory[CAPTURE_RING_SIZE];
+static pcap_ring_t ring;
+
+// Capture files, only used by CaptureTask after InitCapture
+static pcap_rotate_t rotate;
+
+// Set once the file is open and the ring initialized, frames captured before are ignored
+static bool ready = false;
+
+// Set by CaptureFrame when a stop condition is met (CAPTURE_STOP_PACKETS / _BYTES) or by CaptureTask when
+// the single file is full or no file could be created. CaptureTask writes the rest and closes the file
+static bool stopped = false;
+static bool closed = false;
+
+// Packets and file bytes (record headers included) appended by CaptureFrame (RxTask only)
+static uint32_t capturedPackets = 0;
+static uint32_t capturedBytes = 0;
+
+// Sequence numbers of the last sync requested by CaptureSync and the last one served by CaptureTask, which
+// gives syncDone after writing everything. A give arriving after CaptureSync timed out is recognised by the
+// sequence number and does not confirm the next request
+static uint32_t syncRequested = 0;
+static uint32_t syncServed = 0;
+static bool syncResult = false;
+static SemaphoreHandle_t syncDone = NULL;
+
+static TaskHandle_t captureTaskHandle = NULL;
+
+// Function for initialize SPIFFS filesystem, returns the size of the partition (0 if unknown)
+static size_t InitSPIFFS(void);
+
+// Function writing the ring to the capture files, continues with the next file whenever the current one is full.
+// Returns false when no file is left (single file full or file not created), the capture has to stop then
+static bool CaptureWrite(bool all);
+
+// Function writing everything, closing the file and ending the capture
+static void CaptureStop(void);
+
+// Task writing the captured records in CAPTURE_BLOCK_SIZE blocks once CAPTURE_FLUSH_BYTES are waiting,
+// everything every CAPTURE_FLUSH_MS
+static void CaptureTask(void *pvParameters);
+
+
+
+
+void InitCapture(void) {
+    const pcap_rotate_config_t config = {
+        .path = PCAP_FILENAME,
+        .file_count = CAPTURE_FILE_COUNT,
+        .link_type = PCAP_LINK_TYPE_ETHERNET
+    };
+
+    ESP_LOGI(PCAP_TAG, "Sniffer mode is enabled, writing packet to PCAP file");
+    size_t total = InitSPIFFS();
+
+    // SPIFFS garbage collection gets slow when the partition is almost full, the capture should leave a quarter free
+    if ((CAPTURE_FILE_COUNT > 0) && ((uint64_t)CAPTURE_FILE_COUNT * CAPTURE_FILE_SIZE > total / 4 * 3)) {
+        ESP_LOGW(PCAP_TAG, "%d capture files of %d bytes take more than 75 %% of SPIFFS (%d bytes)", CAPTURE_FILE_COUNT, CAPTURE_FILE_SIZE, total);
+    }
+
+    if (!pcap_rotate_open(&rotate, &config)) {
+        ESP_LOGE(PCAP_TAG, "Failed to create or open PCAP file");
+        return;
+    }
+    if (!pcap_ring_init(&ring, ringMemory, sizeof(ringMemory), pcap_rotate_file(&rotate), CAPTURE_BLOCK_SIZE) ||
+        !pcap_ring_set_file(&ring, pcap_rotate_file(&rotate), CAPTURE_FILE_SIZE)) {
+        ESP_LOGE(PCAP_TAG, "Failed to write PCAP header");
+        pcap_rotate_close(&rotate);
+        return;
+    }
+
+    syncDone = xSemaphoreCreateBinary();
+    xTaskCreate(CaptureTask, "CaptureTask", 4096, NULL, 3, &captureTaskHandle);
+    __atomic_store_n(&ready, true, __ATOMIC_RELEASE);
+
+    char path[PCAP_ROTATE_PATH_MAX];
+    pcap_rotate_path(&rotate, rotate.next - 1, path, sizeof(path));
+    ESP_LOGI(PCAP_TAG, "Capturing into %s, %d files of %d bytes at most", path, CAPTURE_FILE_COUNT ? CAPTURE_FILE_COUNT : 1, CAPTURE_FILE_SIZE);
+    ESP_LOGI(PCAP_TAG, "Capture ring: %d bytes, written in %d byte blocks after %d bytes or %d ms",
+             CAPTURE_RING_SIZE, CAPTURE_BLOCK_SIZE, CAPTURE_FLUSH_BYTES, CAPTURE_FLUSH_MS);
+}
+
+bool CaptureFrame(const uint8_t *data, uint16_t length) {
+    struct timeval tv;
+
+    if (!__atomic_load_n(&ready, __ATOMIC_ACQUIRE) || __atomic_load_n(&stopped, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    // Stop conditions are checked before the packet, the files never hold more than asked for
+    uint32_t record = PCAP_RING_RECORD_HEADER_SIZE + length;
+    if (((CAPTURE_STOP_PACKETS > 0) && (capturedPackets >= CAPTURE_STOP_PACKETS)) ||
+        ((CAPTURE_STOP_BYTES > 0) && ((CAPTURE_STOP_BYTES - capturedBytes) < record))) {
+        __atomic_store_n(&stopped, true, __ATOMIC_RELEASE);
+        xTaskNotifyGive(captureTaskHandle);
+        return false;
+    }
+
+    gettimeofday(&tv, NULL);
+    if (!pcap_ring_append(&ring, data, length, tv.tv_sec, tv.tv_usec)) {
+        return false;
+    }
+    capturedPackets++;
+    capturedBytes += record;
+
+    // Woken once per threshold crossing, not for every frame above it
+    size_t pending = pcap_ring_pending(&ring);
+    if ((pending >= CAPTURE_FLUSH_BYTES) && ((pending - PCAP_RING_RECORD_HEADER_SIZE - length) < CAPTURE_FLUSH_BYTES)) {
+        xTaskNotifyGive(captureTaskHandle);
+    }
+    return true;
+}
+
+bool CaptureSync(TickType_t wait) {
+    if (!__atomic_load_n(&ready, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    // After the stop everything is in the closed file already
+    if (__atomic_load_n(&closed, __ATOMIC_ACQUIRE)) {
+        return true;
+    }
+
+    uint32_t request = __atomic_add_fetch(&syncRequested, 1, __ATOMIC_ACQ_REL);
+    TickType_t start = xTaskGetTickCount();
+    xTaskNotifyGive(captureTaskHandle);
+    while ((int32_t)(__atomic_load_n(&syncServed, __ATOMIC_ACQUIRE) - request) < 0) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if ((elapsed >= wait) || (xSemaphoreTake(syncDone, wait - elapsed) != pdTRUE)) {
+            return false;
+        }
+    }
+    return __atomic_load_n(&syncResult, __ATOMIC_ACQUIRE);
+}
+
+void CaptureGetStats(pcap_ring_stats_t *stats) {
+    pcap_ring_get_stats(&ring, stats);
+}
+
+static size_t InitSPIFFS(void) {
+    esp_vfs_spiffs_conf_t conf = {
+        .base_path = "/spiffs",
+        .partition_label = NULL,
+        .max_files = 5,
+        .format_if_mount_failed = true
+    };
+
+    esp_err_t ret = esp_vfs_spiffs_register(&conf);
+    if (ret != ESP_OK) {
+        ESP_LOGE(Spiffs_TAG, "Failed to initialize SPIFFS (%s)", esp_err_to_name(ret));
+    }
+
+    size_t total = 0, used = 0;
+    ret = esp_spiffs_info(NULL, &total, &used);
+    if (ret == ESP_OK) {
+        ESP_LOGI(Spiffs_TAG, "Partition size: total: %d, used: %d", total, used);
+    } else {
+        ESP_LOGE(Spiffs_TAG, "Failed to get SPIFFS partition information (%s)", esp_err_to_name(ret));
+    }
+
+    return total;
+}
+
+static bool CaptureWrite(bool all) {
+    while (1) {
+        (void)pcap_ring_write(&ring, all);
+        if (!pcap_ring_file_full(&ring)) {
+            return true;
+        }
+
+        // The oldest file is deleted, so the files never take more than CAPTURE_FILE_COUNT * CAPTURE_FILE_SIZE
+        if (!pcap_rotate_next(&rotate) || !pcap_ring_set_file(&ring, pcap_rotate_file(&rotate), CAPTURE_FILE_SIZE)) {
+            return false;
+        }
+        ESP_LOGD(PCAP_TAG, "Next capture file %lu, %lu deleted", rotate.next - 1, rotate.deleted);
+    }
+}
+
+static void CaptureStop(void) {
+    pcap_ring_stats_t stats;
+
+    __atomic_store_n(&stopped, true, __ATOMIC_RELEASE);
+    // CaptureWrite returns false when no file is open anymore, the ring must not touch it then
+    bool synced = CaptureWrite(true) && pcap_ring_sync(&ring) && (fsync(fileno(pcap_rotate_file(&rotate))) == 0);
+    pcap_rotate_close(&rotate);
+    __atomic_store_n(&closed, true, __ATOMIC_RELEASE);
+
+    // A sync requested while stopping is answered here, its notification was taken by the loop which saw the stop
+    uint32_t request = __atomic_load_n(&syncRequested, __ATOMIC_ACQUIRE);
+    if (request != syncServed) {
+        __atomic_store_n(&syncResult, synced, __ATOMIC_RELEASE);
+        __atomic_store_n(&syncServed, request, __ATOMIC_RELEASE);
+        xSemaphoreGive(syncDone);
+    }
+
+    CaptureGetStats(&stats);
+    ESP_LOGI(PCAP_TAG, "Capture stopped after %lu packets (%lu bytes) in %lu files, %lu packets dropped",
+             stats.records, stats.bytes, rotate.files, stats.drops);
+}
+
+static void CaptureTask(void *pvParameters) {
+    while (1) {
+        // Notified by CaptureFrame when CAPTURE_FLUSH_BYTES are waiting or by CaptureSync
+        bool threshold = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CAPTURE_FLUSH_MS)) != 0;
+        bool success = true;
+
+        if (__atomic_load_n(&stopped, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+
+        uint32_t request = __atomic_load_n(&syncRequested, __ATOMIC_ACQUIRE);
+        if (request != syncServed) {
+            success = CaptureWrite(true);
+            bool synced = success && pcap_ring_sync(&ring) && (fsync(fileno(pcap_rotate_file(&rotate))) == 0);
+            __atomic_store_n(&syncResult, synced, __ATOMIC_RELEASE);
+            __atomic_store_n(&syncServed, request, __ATOMIC_RELEASE);
+            xSemaphoreGive(syncDone);
+        } else if (threshold) {
+            // Whole blocks only, the tail of the last block waits for more records
+            success = CaptureWrite(false);
+        } else if (pcap_ring_pending(&ring) > 0) {
+            // Quiet period, everything goes to the file so a reset loses at most CAPTURE_FLUSH_MS of traffic
+            success = CaptureWrite(true);
+            if (success && !pcap_ring_sync(&ring)) {
+                ESP_LOGE(PCAP_TAG, "Failed to write packets to PCAP file");
+            }
+        }
+
+        if (!success) {
+            ESP_LOGW(PCAP_TAG, "%s", CAPTURE_FILE_COUNT ? "Failed to create the next PCAP file" : "PCAP file is full");
+            break;
+        }
+    }
+
+    CaptureStop();
+
+    // Nothing is captured anymore, the task stays for confirming syncs requested after the stop
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint32_t request = __atomic_load_n(&syncRequested, __ATOMIC_ACQUIRE);
+        if (request != syncServed) {
+            __atomic_store_n(&syncResult, true, __ATOMIC_RELEASE);
+            __atomic_store_n(&syncServed, request, __ATOMIC_RELEASE);
+            xSemaphoreGive(syncDone);
+        }
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "pcap_ring.h"
+
+// Initialization function mounting SPIFFS, creating the first capture file (PCAP_FILENAME, numbered when rotating)
+// and starting the capture task
+void InitCapture(void);
+
+// Function appending a frame to the capture ring (RxTask), never blocks, returns false if the frame was dropped
+bool CaptureFrame(const uint8_t *data, uint16_t length);
+
+// Function asking the capture task to write everything captured so far to the files, waits up to wait ticks
+// for it to finish, returns false on timeout or when writing failed
+bool CaptureSync(TickType_t wait);
+
+// Function returning the capture counters (records, drops, written bytes, ...)
+void CaptureGetStats(pcap_ring_stats_t *stats);
+
+#endif
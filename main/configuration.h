@@ -12,6 +12,103 @@
 
 #define CLOCK_RATE 2 * 1000 * 1000 // 2MHz
 
+// Number of LAN8651 attached to the SPI bus, every one gets its own tc6 instance and network interface
+// (TC6_MAX_INSTANCES in menuconfig must be at least this). The lists hold one pin per instance,
+// the reset pin is shared. Additional instances use DEVICE_MAC with the last byte incremented.
+#define LAN8651_COUNT 1
+#define PIN_NUM_CS_LIST {PIN_NUM_CS}
+#define IRQ_PIN_LIST {IRQ_PIN}
+
+// SPI host of every instance (SPI2_HOST or SPI3_HOST) and the bus pins of that host, instances on the same host
+// must list the same pins. Instances sharing a host take turns on its bus, at CLOCK_RATE the bus is the limit,
+// so a host of its own per instance doubles the throughput of two instances (tc6-multi of the host build)
+#define SPI_HOST_LIST {SPI2_HOST}
+#define PIN_NUM_MISO_LIST {PIN_NUM_MISO}
+#define PIN_NUM_MOSI_LIST {PIN_NUM_MOSI}
+#define PIN_NUM_CLK_LIST {PIN_NUM_CLK}
+
+// Software L2 bridge between the LAN8651 segments (needs LAN8651_COUNT >= 2, puts the MAC-PHYs into promiscuous mode)
+#define BRIDGE_ENABLE false
+#define BRIDGE_TABLE_SIZE 64        // MAC learning table entries, power of 2
+#define BRIDGE_AGING_MS 300000      // Learned addresses are forgotten after 5 minutes without traffic
+
+
+// TX scheduler: lwIP frames wait in one queue per traffic class, SyncTask hands TX_SCHED_WINDOW of them at a time
+// to the tc6 library, prioritized traffic first. The MAC-PHY sends BURST_COUNT + 1 frames per PLCA transmit opportunity
+#define TX_SCHED_ENABLE false
+#define TX_SCHED_QUEUE_LEN 16       // Frames waiting per traffic class, power of 2
+#define TX_SCHED_WINDOW 4           // Frames handed to the tc6 library at once, a prioritized frame waits behind at most these
+
+
+// Number of preallocated RX frame buffers (1 - 32), frames are dropped when all of them are in use.
+// Frames RxTask uses (all with the sniffer, every FRAME_DUMP_SAMPLE-th for the dump) take a second one for its copy
+#define RX_PBUF_POOL_SIZE 8
+
+// Chunks per SPI transaction: TC6XactPolicy_Fixed uses up to TC6_XACT_MAX_CHUNKS as far as TX credits allow,
+// TC6XactPolicy_Adaptive starts the data of an idle link with short bursts and grows them while data is pending.
+// At the CLOCK_RATE above both perform the same (tc6-xact of the host build), the adaptive one only pays off at fast SPI clocks
+#define TC6_XACT_POLICY TC6XactPolicy_Fixed
+#define TC6_XACT_MAX_CHUNKS 31
+
+// Fast boot: the end of the PHY reset is detected on IRQ_N instead of fixed delays, lwIP and DTLS are
+// initialized while the LAN8651 leaves reset and the chip trim values are cached in NVS for the next boot
+#define FAST_BOOT false
+#define RESET_PULSE_US 100          // Low time of the reset pin
+#define RESET_RELEASE_US 1000       // Longest low time of the reset pin while an IRQ_N asserted before the reset is released
+#define RESET_TIMEOUT_MS 100        // Maximum wait for IRQ_N after the reset
+
+// Verbosity of the frame path in ethernet.c (ESP_LOG_NONE ... ESP_LOG_VERBOSE), messages above it are not compiled in.
+// Per frame messages are ESP_LOG_DEBUG (slices ESP_LOG_VERBOSE), the sampled frame dump is ESP_LOG_INFO
+#define FRAME_LOG_LEVEL ESP_LOG_INFO
+
+// Every FRAME_DUMP_SAMPLE-th received frame is printed (hex, text and UDP payload) by a lowest priority task,
+// frames are skipped while it is busy. 0 disables the dump
+#define FRAME_DUMP_SAMPLE 10
+#define FRAME_DUMP_MAX_BYTES 128    // Bytes of the frame and of the payload printed at most
+
+// Every 10 s SyncTask also prints the counters of stats.h in binary (hex, prefix "STATS_BIN") for tools
+#define STATS_EXPORT false
+
+// Sniffer capture: RxTask copies frames into a RAM ring, CaptureTask writes them to PCAP_FILENAME in blocks once
+// CAPTURE_FLUSH_BYTES are waiting and everything after CAPTURE_FLUSH_MS. Frames are dropped (counted) while the ring is full
+#define CAPTURE_RING_SIZE 32768             // Bytes, power of 2 (every frame takes 16 bytes plus its length)
+#define CAPTURE_BLOCK_SIZE 4096             // Size of the writes to SPIFFS, power of 2
+#define CAPTURE_FLUSH_BYTES 16384
+#define CAPTURE_FLUSH_MS 1000
+
+// Rolling capture on SPIFFS (0xE8000 bytes in partitions.csv): PCAP_FILENAME "/spiffs/capture.pcap" becomes
+// "/spiffs/capture.<n>.pcap", a new file is started every CAPTURE_FILE_SIZE bytes and the oldest one is deleted, so the
+// most recent CAPTURE_FILE_COUNT files are kept (also across reboots). CAPTURE_FILE_COUNT 0 writes PCAP_FILENAME only
+// and stops when it is full. The capture also stops after CAPTURE_STOP_PACKETS packets or CAPTURE_STOP_BYTES bytes (0: never)
+#define CAPTURE_FILE_SIZE 131072
+#define CAPTURE_FILE_COUNT 4
+#define CAPTURE_STOP_PACKETS 0
+#define CAPTURE_STOP_BYTES 0
+
+
+
+// Throughput / latency benchmark (replaces the periodic MESSAGE). The sender sends BENCH_FRAMES frames for every
+// payload size of BENCH_PAYLOADS and prints one CSV line per size (prefix "BENCH") with frame rate, goodput and
+// round trip latency percentiles, the reflector (second node) echoes the benchmark traffic back.
+// CPU load per task (prefix "BENCH_CPU") needs FREERTOS_USE_TRACE_FACILITY and FREERTOS_GENERATE_RUN_TIME_STATS in menuconfig.
+#define BENCH_ENABLE false
+#define BENCH_ROLE BenchRole_Sender
+#define BENCH_MODE BenchMode_Raw            // BenchMode_Raw, BenchMode_Udp or BenchMode_Dtls (needs ENCRYPTED_CLIENT)
+#define BENCH_PAYLOADS {64, 128, 256, 512, 1024, 1500}
+#define BENCH_FRAMES 1000                   // Frames per payload size (latency samples are kept for all of them)
+#define BENCH_DUTY_CYCLE 50                 // Share of the segment bandwidth (10 Mbit/s) used by this node in %, 100 sends back to back
+#define BENCH_PORT "5001"                   // UDP port of the reflector
+#define BENCH_SETTLE_MS 500                 // Wait for outstanding echoes after the last frame of a payload size
+
+
+// Hot path trace: every TRACE_INTERVAL_MS the stages from the IRQ to RxTask are captured with CPU cycle time stamps
+// until the per core buffers (TC6_TRACE_BUF_SIZE in menuconfig) are full, then one line per stage (prefix "TRACE")
+// and the latency histograms (prefix "TRACE_HIST") are printed. The libtc6 stages need TC6_PROBES in menuconfig.
+#define TRACE_ENABLE false
+#define TRACE_INTERVAL_MS 10000             // Time between two captures
+#define TRACE_WINDOW_MS 1000                // Longest capture
+#define TRACE_JSON false                    // Also print the capture as Chrome trace JSON (between TRACE_JSON_BEGIN and TRACE_JSON_END)
+
 
 // Configuration for different devices
 #define DEVICE 3
@@ -369,6 +369,30 @@ void SendEncryptedPacket(const char *data, uint16_t length, const char *dest_ip,
 
 
 
+int WriteEncryptedPacket(const unsigned char *data, size_t length) {
+    int ret;
+
+    if (!handshake_done) {
+        do {
+            ret = mbedtls_ssl_handshake(&ssl);
+        } while (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+
+        if (ret != 0) {
+            ESP_LOGE(Secure_TAG, "Handshake failed with error: %d", ret);
+            return ret;
+        }
+        handshake_done = 1;
+    }
+
+    do {
+        ret = mbedtls_ssl_write(&ssl, data, length);
+    } while (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+
+    return ret;
+}
+
+
+
 void DTLSDebug(void *ctx, int level, const char *file, int line, const char *str) {
     ((void) level);
     fprintf((FILE *) ctx, "%s:%04d: %s", file, line, str);
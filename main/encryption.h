@@ -1,6 +1,9 @@
 #ifndef ENCRYPTION_H
 #define ENCRYPTION_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 // Initialization functions for DTLS server
 void InitDTLSServer(void);
 
@@ -13,4 +16,7 @@ void ReceiveDecryptedPacket(void);
 // Function for sending encrypted packets
 void SendEncryptedPacket(const char *data, uint16_t length, const char *dest_ip, const char *dest_port);
 
+// Function for sending one encrypted packet over the client connection (handshake first if needed), returns the mbedtls result
+int WriteEncryptedPacket(const unsigned char *data, size_t length);
+
 #endif
\ No newline at end of file
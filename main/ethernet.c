@@ -1,46 +1,86 @@
+#include "configuration.h"
+
+// Per frame messages are ESP_LOGD and compile out unless FRAME_LOG_LEVEL allows them (defined before esp_log.h)
+#define LOG_LOCAL_LEVEL FRAME_LOG_LEVEL
+
 #include <sys/socket.h>
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/queue.h"
 
 #include "lwip/tcpip.h"
 #include "lwip/etharp.h"
 #include "lwip/udp.h"
 
-#include "esp_spiffs.h"
-
-#include "configuration.h"
 #include "main.h"
 #include "lan8651.h"
 #include "ethernet.h"
-#include "pcap.h"
+#include "capture.h"
 #include "encryption.h"
+#include "bridge.h"
+#include "txsched.h"
+#include "txframe.h"
+#include "benchmark.h"
+#include "rxring.h"
+#include "rxpool.h"
+#include "trace.h"
+#include "stats.h"
 
 // Do not change this
-#define TC6LwIP_MTU 1536
+#define TC6LwIP_MTU RX_POOL_BUF_SIZE
 #define MAX_SLICE_SIZE 64
 #define MIN_HEADER_LEN 42
 
+// Frames RxTask takes from the RX ring at once
+#define RX_TASK_BATCH 8
+
+
+// Frames lwIP and the benchmark queue per LAN8651 in front of the tc6 TX queue
+#define TX_SUBMIT_QSIZE 8
+
+// Output buffers of DumpTask, FRAME_DUMP_MAX_BYTES in hex or as text plus terminating zero
+#define DUMP_HEX_SIZE (FRAME_DUMP_MAX_BYTES * 2 + 1)
+#define DUMP_TEXT_SIZE (FRAME_DUMP_MAX_BYTES + 1)
+
 static const char *Ethernet_TAG = "ETHERNET";
 static const char *LWIP_TAG = "LWIP";
 static const char *Queue_TAG = "LWIP";
 static const char *Socket_TAG = "SOCKET";
 static const char *Receive_TAG = "RECEIVE";
-static const char *PCAP_TAG = "PCAP";
 static const char *Payload_TAG = "PAYLOAD";
-static const char *Spiffs_TAG = "SPIFFS";
 
-static EthernetFrame_t currentFrame;
-QueueHandle_t rxQueue = NULL;
-static struct pbuf *rx_pbuf = NULL;
-static uint16_t rx_len = 0;
-static bool rx_invalid = false;
+// Received frames on their way from SyncTask (producer) to RxTask (consumer)
+static RxRing_t rxRing;
+
+// Sampled frame handed from RxTask to DumpTask. Only the printed bytes are copied, the RX pool buffer is released
+// by RxTask at once. While DumpTask still prints the previous frame the slot is busy and the sample is skipped
+typedef struct {
+    uint8_t data[FRAME_DUMP_MAX_BYTES];
+    uint16_t copied;        // Bytes of the frame in data
+    uint16_t length;        // Length of the received frame
+    uint8_t instance;
+    bool busy;              // Set by RxTask when the slot is filled, cleared by DumpTask when the frame is printed
+} DumpSlot_t;
+
+static DumpSlot_t dumpSlot;
+static TaskHandle_t dumpTask;
+static uint32_t dumpSkipped;
+
+// Frames of lwIP and the benchmark on their way to SyncTask, the only task filling the tc6 TX queues (they are not locked)
+static QueueHandle_t txSubmitQueue[LAN8651_COUNT];
 
 uint8_t macAddress[6] = DEVICE_MAC;
 
-// Network interface registered with lwIP
-static struct netif netif;
+// State of one LAN8651, netif->state holds the instance number
+typedef struct {
+    struct netif netif;         // Network interface registered with lwIP
+    struct pbuf *rx_pbuf;       // Frame currently assembled from RX slices
+    uint16_t rx_len;
+    bool rx_invalid;
+} EthernetPort_t;
 
-// Handle for the PCAP file
-pcap_file_handle_t *pcap = NULL;
+// One port per LAN8651, index is the tc6 instance number
+static EthernetPort_t ports[LAN8651_COUNT];
 
 // Function for crate, close and sanding packets using UDP socket
 void SendUDPPacket(const char *data, uint16_t length, const char *dest_ip, const char *dest_port);
@@ -54,69 +94,131 @@ void BinToHex(const uint8_t *data, size_t length, char *output, size_t output_si
 // Function for convert binary recived frames to string
 void BinToString(const uint8_t *data, size_t length, char *output, size_t output_size);
 
-// Function for extract UDP payload from recived frame
-bool ExtractPayload(const uint8_t *frame_data, size_t frame_length, const uint8_t **payload, size_t *payload_length);
+// Function for extract UDP payload from recived frame, only the first available bytes of the frame are in frame_data
+// (headers must lie within them, payload_length is cut to them)
+bool ExtractPayload(const uint8_t *frame_data, size_t frame_length, size_t available, const uint8_t **payload, size_t *payload_length);
+
+// Function deciding whether a frame for lwIP is sampled for the dump (SyncTask only), every FRAME_DUMP_SAMPLE-th is
+static bool IsDumpSample(void);
+
+// Function handing a sampled frame to DumpTask (RxTask only), skips it while DumpTask is busy
+static void DumpFrame(const EthernetFrame_t *frame);
+
+// Callback from tc6 library when a frame was moved into SPI chunks, releases the pbuf chain
+static void OnTxEthernetDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag);
 
-// Function for initialize SPIFFS filesystem
-void InitSPIFFS(void);
+// Function returning the port belonging to a tc6 instance, NULL for unknown instances
+static EthernetPort_t *GetPort(TC6_t *pInst);
 
-// Function for initialize PCAP file for saving recived frames
-void InitPCAP(void);
+// Function logging the time from power up to the first sent or received frame (once)
+static void ReportFirstFrame(const char *direction);
 
 
 
 
 // Callback function for receiving Ethernet packets
 void TC6_CB_OnRxEthernetPacket(TC6_t *pInst, bool success, uint16_t len, uint64_t *rxTimestamp, void *pGlobalTag) {
-    (void)pInst;
     (void)rxTimestamp;
     (void)pGlobalTag;
     bool result = true;
 
-    if (!success || rx_invalid || !rx_pbuf || !rx_len) {
+    EthernetPort_t *port = GetPort(pInst);
+    if (port == NULL) {
+        return;
+    }
+
+    // Frames marked invalid by TC6_CB_OnRxEthernetSlice were counted there already
+    if (!success) {
+        StatsDrop(TC6_GetInstance(pInst), StatsDrop_RxError);
+        result = false;
+    } else if (port->rx_invalid) {
+        result = false;
+    } else if (!port->rx_pbuf || !port->rx_len) {
+        StatsDrop(TC6_GetInstance(pInst), StatsDrop_RxSlice);
         result = false;
     }
-    if (result && (rx_len != len)) {
+    if (result && (port->rx_len != len)) {
         ESP_LOGE(Ethernet_TAG, "OnRxEthernetPacket: Size mischmatch");
+        StatsDrop(TC6_GetInstance(pInst), StatsDrop_RxSizeMismatch);
         result = false;
     }
     if (result && (len < MIN_HEADER_LEN)) {
         ESP_LOGE(Ethernet_TAG, "OnRxEthernetPacket: received invalid small packet len %u", len);
+        StatsDrop(TC6_GetInstance(pInst), StatsDrop_RxTooSmall);
         result = false;
     }
     if (result) {
-        pbuf_realloc(rx_pbuf, len);
-        struct eth_hdr *ethhdr = (struct eth_hdr *)rx_pbuf->payload;
-        uint16_t ethType = htons(ethhdr->type);
-
-        currentFrame.length = len;
-        memcpy(currentFrame.data, rx_pbuf->payload, len > sizeof(currentFrame.data) ? sizeof(currentFrame.data) : len);
-
-        ESP_LOGI(Ethernet_TAG, "Received complete frame: length=%u", currentFrame.length);
-        ESP_LOGI(Ethernet_TAG, "Frame content: %.*s", currentFrame.length, currentFrame.data);
+        struct pbuf *rx_pbuf = port->rx_pbuf;
 
-        if (rxQueue != NULL) {
-            if (xQueueSend(rxQueue, &currentFrame, pdMS_TO_TICKS(100)) != pdTRUE) {
-                ESP_LOGW(Ethernet_TAG, "RX queue is full, dropping frame");
+        pbuf_realloc(rx_pbuf, len);
+        ReportFirstFrame("received");
+
+        ESP_LOGD(Ethernet_TAG, "Received complete frame: instance=%u, length=%u", TC6_GetInstance(pInst), len);
+        StatsRxFrame(TC6_GetInstance(pInst), len);
+
+        // lwIP may change the frame in place (an ICMP echo reply reuses it) while RxTask still reads it, RxTask gets
+        // a copy from the RX pool, but only of the frames it uses: all for the capture, the sampled ones for the dump.
+        // Raw benchmark frames are not for lwIP, RxTask takes them without a copy.
+        // Never blocks, a busy RxTask must not stall the SPI pipeline, the frame is counted as dropped instead
+        const uint8_t *data = (const uint8_t *)rx_pbuf->payload;
+        bool rxTaskOnly = BENCH_ENABLE && (((data[12] << 8) | data[13]) == BENCH_ETHERTYPE);
+        EthernetFrame_t frame = {
+            .instance = TC6_GetInstance(pInst),
+            .length = len,
+            .dump = !rxTaskOnly && IsDumpSample(),
+        };
+
+        if (rxTaskOnly || SNIFFER || frame.dump) {
+            frame.p = rxTaskOnly ? rx_pbuf : RxPoolAlloc();
+            if (frame.p == NULL) {
+                // lwIP still gets the frame below, only RxTask misses it
+                StatsDrop(frame.instance, StatsDrop_RxCopy);
+            } else {
+                if (frame.p != rx_pbuf) {
+                    memcpy(frame.p->payload, data, len);
+                    pbuf_realloc(frame.p, len);
+                }
+                frame.data = frame.p->payload;
+                if (!RxRingPush(&rxRing, &frame)) {
+                    StatsDrop(frame.instance, StatsDrop_RxRingFull);
+                    pbuf_free(frame.p);
+                }
             }
         }
 
-        if (netif.input(rx_pbuf, &netif) == ERR_OK) {
-            rx_pbuf = NULL;
-            rx_len = 0;
-            rx_invalid = false;
+        // With the bridge enabled only frames for this node reach lwIP, all others are just forwarded
+        if (rxTaskOnly) {
+            port->rx_pbuf = NULL;
+            port->rx_len = 0;
+            port->rx_invalid = false;
+        } else if (BRIDGE_ENABLE && !BridgeInput(TC6_GetInstance(pInst), rx_pbuf)) {
+            pbuf_free(rx_pbuf);
+            port->rx_pbuf = NULL;
+            port->rx_len = 0;
+            port->rx_invalid = false;
         } else {
-            ESP_LOGE(Ethernet_TAG, "Wrong IP");
-            result = false;
+            TRACE_PROBE(frame.instance, TC6TracePoint_InputBegin);
+            err_t err = port->netif.input(rx_pbuf, &port->netif);
+            TRACE_PROBE(frame.instance, TC6TracePoint_InputEnd);
+
+            if (err == ERR_OK) {
+                port->rx_pbuf = NULL;
+                port->rx_len = 0;
+                port->rx_invalid = false;
+            } else {
+                ESP_LOGE(Ethernet_TAG, "Wrong IP");
+                StatsDrop(frame.instance, StatsDrop_RxInput);
+                result = false;
+            }
         }
     }
     if (!result) {
-        if (rx_pbuf) {
-            pbuf_free(rx_pbuf);
-            rx_pbuf = NULL;
+        if (port->rx_pbuf) {
+            pbuf_free(port->rx_pbuf);
+            port->rx_pbuf = NULL;
         }
-        rx_len = 0;
-        rx_invalid = false;
+        port->rx_len = 0;
+        port->rx_invalid = false;
     }
 }
 
@@ -124,72 +226,87 @@ void TC6_CB_OnRxEthernetPacket(TC6_t *pInst, bool success, uint16_t len, uint64_
 void TC6_CB_OnRxEthernetSlice(TC6_t *pInst, const uint8_t *pRx, uint16_t offset, uint16_t len, void *pGlobalTag) {
     bool success = true;
 
-    if (rx_invalid) {
+    EthernetPort_t *port = GetPort(pInst);
+    if (port == NULL) {
+        return;
+    }
+
+    if (port->rx_invalid) {
         success = false;
     }
     if (success && ((offset + len) > TC6LwIP_MTU)) {
         ESP_LOGE(Ethernet_TAG, "OnRxEthernetSlice: packet is to large: %u", (offset + len));
-        rx_invalid = true;
+        StatsDrop(TC6_GetInstance(pInst), StatsDrop_RxTooLarge);
+        port->rx_invalid = true;
         success = false;
     }
     if (success && (0u != offset)) {
-        if (!rx_pbuf || !rx_len) {
+        if (!port->rx_pbuf || !port->rx_len) {
             ESP_LOGE(Ethernet_TAG, "OnRxEthernetSlice: missing buffer or length");
-            rx_invalid = true;
+            StatsDrop(TC6_GetInstance(pInst), StatsDrop_RxSlice);
+            port->rx_invalid = true;
             success = false;
         }
     } else {
-        if (success && (rx_pbuf || rx_len)) {
+        if (success && (port->rx_pbuf || port->rx_len)) {
             ESP_LOGE(Ethernet_TAG, "OnRxEthernetSlice: buffer not cleared before new frame");
-            rx_invalid = true;
-            if (rx_pbuf) pbuf_free(rx_pbuf);
-            rx_pbuf = NULL;
+            StatsDrop(TC6_GetInstance(pInst), StatsDrop_RxSlice);
+            port->rx_invalid = true;
+            if (port->rx_pbuf) pbuf_free(port->rx_pbuf);
+            port->rx_pbuf = NULL;
             success = false;
         }
         if (success) {
-            rx_pbuf = pbuf_alloc(PBUF_RAW, TC6LwIP_MTU, PBUF_RAM);
-            if (!rx_pbuf) {
-                rx_invalid = true;
+            port->rx_pbuf = RxPoolAlloc();
+            if (!port->rx_pbuf) {
+                ESP_LOGW(Ethernet_TAG, "OnRxEthernetSlice: RX pbuf pool exhausted, dropping frame");
+                StatsDrop(TC6_GetInstance(pInst), StatsDrop_RxPbufPool);
+                port->rx_invalid = true;
                 success = false;
             }
         }
-        if (success && (rx_pbuf && rx_pbuf->next != NULL)) {
-            ESP_LOGE(Ethernet_TAG, "OnRxEthernetSlice: could not allocate unsegmented memory");
-            rx_invalid = true;
-            pbuf_free(rx_pbuf);
-            rx_pbuf = NULL;
-            success = false;
-        }
-        rx_len = 0;
+        port->rx_len = 0;
     }
     if (success) {
-        memcpy((uint8_t *)rx_pbuf->payload + offset, pRx, len);
-        rx_len += len;
+        memcpy((uint8_t *)port->rx_pbuf->payload + offset, pRx, len);
+        port->rx_len += len;
     }
 
-    if (rxQueue != NULL) {
-        EthernetFrame_t sliceFrame;
-        sliceFrame.length = len;
-        memcpy(sliceFrame.data, pRx, len > sizeof(sliceFrame.data) ? sizeof(sliceFrame.data) : len);
+    ESP_LOGV(Ethernet_TAG, "Slice received: offset=%u, length=%u", offset, len);
+}
 
-        ESP_LOGI(Ethernet_TAG, "Slice received: offset=%u, length=%u", offset, len);
-        ESP_LOGI(Ethernet_TAG, "Slice content: %.*s\n", sliceFrame.length, sliceFrame.data);
 
-        if (xQueueSend(rxQueue, &sliceFrame, pdMS_TO_TICKS(100)) != pdTRUE) {
-            ESP_LOGW(Ethernet_TAG, "RX queue is full, dropping slice");
-        }
+
+uint32_t GetRxRingDrops(void) {
+    return RxRingGetDrops(&rxRing);
+}
+
+static EthernetPort_t *GetPort(TC6_t *pInst) {
+    uint8_t instance = TC6_GetInstance(pInst);
+
+    if (instance >= LAN8651_COUNT) {
+        ESP_LOGE(Ethernet_TAG, "Callback from unknown tc6 instance %u", instance);
+        return NULL;
     }
+    return &ports[instance];
+}
+
+void GetMacAddress(uint8_t instance, uint8_t mac[6]) {
+    memcpy(mac, macAddress, sizeof(macAddress));
+    mac[5] = (uint8_t)(mac[5] + instance);
 }
 
 
 
 void InitQueue(void) {
-    rxQueue = xQueueCreate(50, sizeof(EthernetFrame_t));
-    if (rxQueue == NULL) {
-        ESP_LOGE(Queue_TAG, "Failed to create RX queue");
-    }
-    else {
-        ESP_LOGI(Queue_TAG, "RX queue created successfully");
+    RxRingInit(&rxRing);
+    ESP_LOGI(Queue_TAG, "RX ring created successfully");
+
+    for (int i = 0; i < LAN8651_COUNT; i++) {
+        txSubmitQueue[i] = xQueueCreate(TX_SUBMIT_QSIZE, sizeof(struct pbuf *));
+        if (txSubmitQueue[i] == NULL) {
+            ESP_LOGE(Queue_TAG, "Failed to create TX queue %d", i);
+        }
     }
 }
 
@@ -203,15 +320,28 @@ void InitLWIP(void) {
     ip4addr_aton(DEVICE_NETMASK, &netmask);
     ip4addr_aton(DEVICE_GATEWAY, &gw);
 
-    ESP_LOGI(LWIP_TAG, "Adding network interface...");
-    if (netif_add(&netif, &ipaddr, &netmask, &gw, NULL, InitEthernetif, tcpip_input) == NULL) {
-        ESP_LOGE(LWIP_TAG, "Failed to add network interface");
-        return;
-    }
+    for (int i = 0; i < LAN8651_COUNT; i++) {
+        struct netif *netif = &ports[i].netif;
 
-    netif_set_default(&netif);
-    netif_set_up(&netif);
-    netif_set_link_up(&netif);
+        // Only the first interface gets the configured address, the others start unnumbered
+        if (i > 0) {
+            ip4_addr_set_zero(&ipaddr);
+            ip4_addr_set_zero(&netmask);
+            ip4_addr_set_zero(&gw);
+        }
+
+        ESP_LOGI(LWIP_TAG, "Adding network interface %d...", i);
+        if (netif_add(netif, &ipaddr, &netmask, &gw, (void *)(uintptr_t)i, InitEthernetif, tcpip_input) == NULL) {
+            ESP_LOGE(LWIP_TAG, "Failed to add network interface %d", i);
+            return;
+        }
+
+        if (i == 0) {
+            netif_set_default(netif);
+        }
+        netif_set_up(netif);
+        netif_set_link_up(netif);
+    }
 
     ESP_LOGI(LWIP_TAG, "LWIP initialized successfully");
 }
@@ -280,26 +410,95 @@ void SendUDPPacket(const char *data, uint16_t length, const char *dest_ip, const
 
 // Callback function for sending Ethernet frames
 err_t low_level_output(struct netif *netif, struct pbuf *p) {
-    struct pbuf *q;
-    uint8_t buffer[1500];
-    uint16_t length = 0;
+    uint8_t instance = (uint8_t)(uintptr_t)netif->state;
 
-    for (q = p; q != NULL; q = q->next) {
-        memcpy(&buffer[length], q->payload, q->len);
-        length += q->len;
+    // With FAST_BOOT lwIP is up before the MAC-PHY, frames sent until then are dropped
+    if (tc6_instance[instance] == NULL || txSubmitQueue[instance] == NULL) {
+        return ERR_IF;
     }
 
-    bool success = TC6_SendRawEthernetPacket(tc6_instance, buffer, length, 0, NULL, NULL);
-    if (!success) {
-        ESP_LOGE(Ethernet_TAG, "Failed to send Ethernet frame");
-        return ERR_IF;
+    // Scheduler decides when the frame goes to the MAC-PHY, full class queue means ERR_MEM as well
+    if (TX_SCHED_ENABLE) {
+        return TxSchedEnqueue(instance, p) ? ERR_OK : ERR_MEM;
     }
 
+    // SyncTask moves the frame into the tc6 TX queue. Never waits, lwIP calls this in the tcpip thread and
+    // a wait would stall the whole stack, a full queue gives ERR_MEM at once (TCP retransmits, UDP drops)
+    pbuf_ref(p);
+    if (xQueueSend(txSubmitQueue[instance], &p, 0) != pdTRUE) {
+        pbuf_free(p);
+        ESP_LOGW(Ethernet_TAG, "TX queue full, frame not sent");
+        StatsDrop(instance, StatsDrop_TxQueueFull);
+        return ERR_MEM;
+    }
+    NotifySyncTask();
+
     return ERR_OK;
 }
 
+void EthernetTxService(uint8_t instance) {
+    TC6_t *tc6 = tc6_instance[instance];
+    TC6_RawTxSegment *segments;
+    struct pbuf *p;
+
+    if (tc6 == NULL || txSubmitQueue[instance] == NULL) {
+        return;
+    }
+
+    // Frames stay in the submit queue while the tc6 TX queue is full, OnTxEthernetDone wakes SyncTask again
+    while (xQueuePeek(txSubmitQueue[instance], &p, 0) == pdTRUE) {
+        uint8_t maxSegments = TC6_GetRawSegments(tc6, &segments);
+        if (maxSegments == 0) {
+            break;
+        }
+        xQueueReceive(txSubmitQueue[instance], &p, 0);
+
+        // Segments point directly into the pbufs, the reference taken by low_level_output is held until OnTxEthernetDone
+        uint8_t count = TxFrameSegments(&p, segments, maxSegments);
+        if (count == 0) {
+            ESP_LOGE(Ethernet_TAG, "Failed to flatten Ethernet frame");
+            StatsDrop(instance, StatsDrop_TxNoMem);
+            continue;
+        }
+
+        if (!TC6_SendRawEthernetSegments(tc6, segments, count, p->tot_len, 0, OnTxEthernetDone, p)) {
+            pbuf_free(p);
+            ESP_LOGE(Ethernet_TAG, "Failed to send Ethernet frame");
+            StatsDrop(instance, StatsDrop_TxError);
+        }
+    }
+}
+
+err_t SendEthernetFrame(uint8_t instance, struct pbuf *p) {
+    if (instance >= LAN8651_COUNT) {
+        return ERR_ARG;
+    }
+    return low_level_output(&ports[instance].netif, p);
+}
+
+static void OnTxEthernetDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag) {
+    StatsTxFrame(TC6_GetInstance(pInst), len);
+    pbuf_free((struct pbuf *)pTag);
+    ReportFirstFrame("sent");
+
+    // A queue entry became free, frames waiting in the submit queue follow in the next SyncTask round
+    if (uxQueueMessagesWaiting(txSubmitQueue[TC6_GetInstance(pInst)]) > 0) {
+        NotifySyncTask();
+    }
+}
+
+static void ReportFirstFrame(const char *direction) {
+    static bool reported = false;
+
+    // Called by the tc6 callbacks of every instance, the exchange lets exactly one caller report even if they
+    // ever run in different tasks (today all of them run in SyncTask)
+    if (!__atomic_exchange_n(&reported, true, __ATOMIC_RELAXED)) {
+        ESP_LOGI(Ethernet_TAG, "Time to first frame: %lld ms (first frame %s)", esp_timer_get_time() / 1000, direction);
+    }
+}
+
 err_t InitEthernetif(struct netif *netif) {
-    memcpy(netif->hwaddr, macAddress, sizeof(macAddress));
+    GetMacAddress((uint8_t)(uintptr_t)netif->state, netif->hwaddr);
     netif->hwaddr_len = 6;
 
     netif->mtu = 1500;
@@ -315,64 +514,126 @@ err_t InitEthernetif(struct netif *netif) {
 
 
 void RxTask(void *pvParameters) {
+    EthernetFrame_t batch[RX_TASK_BATCH];
     EthernetFrame_t frame;
-    const uint8_t *payload = NULL;
-    size_t payload_length = 0;
-    struct timeval tv;
 
     if (SNIFFER) {
-        InitPCAP();
+        InitCapture();
     }
 
     while (1) {
-        if (xQueueReceive(rxQueue, &frame, portMAX_DELAY) == pdTRUE) {
-            printf("\n");
-            ESP_LOGI(Receive_TAG, "Received frame: length=%u", frame.length);
-
-            char hex_output[frame.length * 2 + 1];
-            BinToHex(frame.data, frame.length, hex_output, sizeof(hex_output));
-            ESP_LOGI(Receive_TAG, "Frame content (hex): %s", hex_output);
-
-            char string_output[frame.length + 1];
-            BinToString(frame.data, frame.length, string_output, sizeof(string_output));
-            ESP_LOGI(Receive_TAG, "Frame content (string): %s", string_output);
-
-            if (ExtractPayload(frame.data, frame.length, &payload, &payload_length)) {
-                char payload_hex_output[payload_length * 2 + 1];
-                BinToHex(payload, payload_length, payload_hex_output, sizeof(payload_hex_output));
-                ESP_LOGI(Receive_TAG, "Payload content (hex): %s", payload_hex_output);
-
-                char string_output[payload_length + 1];
-                BinToString(payload, payload_length, string_output, sizeof(string_output));
-                ESP_LOGI(Receive_TAG, "Payload content (string): %s\n", string_output);
-            } else {
-                ESP_LOGW(Receive_TAG, "Failed to extract payload\n");
+        uint32_t count = RxRingPop(&rxRing, batch, RX_TASK_BATCH, portMAX_DELAY);
+        for (uint32_t i = 0; i < count; i++) {
+            frame = batch[i];
+            TRACE_PROBE(frame.instance, TC6TracePoint_ConsumerBegin);
+
+            // Benchmark traffic is neither printed nor captured, the dump would dominate the measurement
+            if (BENCH_ENABLE && BenchHandleFrame(frame.instance, frame.data, frame.length)) {
+                pbuf_free(frame.p);
+                TRACE_PROBE(frame.instance, TC6TracePoint_ConsumerEnd);
+                continue;
             }
 
-            if (SNIFFER) {
-                if (pcap == NULL) {
-                    ESP_LOGE(PCAP_TAG, "Invalid arguments to WritePacketToPCAP");
-                    return;
-                }
+            ESP_LOGD(Receive_TAG, "Received frame: instance=%u, length=%u", frame.instance, frame.length);
 
-                gettimeofday(&tv, NULL);
+            // Copied into the capture ring, CaptureTask writes it to the file later (drops are counted there)
+            if (SNIFFER) {
+                (void)CaptureFrame(frame.data, frame.length);
+            }
 
-                esp_err_t err = pcap_capture_packet(pcap, frame.data, frame.length, tv.tv_sec, tv.tv_usec);
-                if (err != ESP_OK) {
-                    ESP_LOGE(PCAP_TAG, "Failed to write packet to PCAP file");
-                } else {
-                    ESP_LOGI(PCAP_TAG, "Packet written to PCAP file: length=%u", frame.length);
-                }                    
+            // Frames sampled in TC6_CB_OnRxEthernetPacket are formatted by DumpTask from its own copy
+            if (frame.dump) {
+                DumpFrame(&frame);
             }
+
+            pbuf_free(frame.p);
+            TRACE_PROBE(frame.instance, TC6TracePoint_ConsumerEnd);
         }
     }
 }
 
+static bool IsDumpSample(void) {
+    static uint32_t received = 0;
+
+    if (FRAME_DUMP_SAMPLE == 0) {
+        return false;
+    }
+    received++;
+    return (received % FRAME_DUMP_SAMPLE) == 0;
+}
+
+static void DumpFrame(const EthernetFrame_t *frame) {
+    if (__atomic_load_n(&dumpSlot.busy, __ATOMIC_ACQUIRE)) {
+        __atomic_fetch_add(&dumpSkipped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    dumpSlot.copied = frame->length < FRAME_DUMP_MAX_BYTES ? frame->length : FRAME_DUMP_MAX_BYTES;
+    dumpSlot.length = frame->length;
+    dumpSlot.instance = frame->instance;
+    memcpy(dumpSlot.data, frame->data, dumpSlot.copied);
+
+    // Slot is complete before DumpTask can see it busy
+    __atomic_store_n(&dumpSlot.busy, true, __ATOMIC_RELEASE);
+
+    TaskHandle_t task = __atomic_load_n(&dumpTask, __ATOMIC_ACQUIRE);
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+    }
+}
+
+void DumpTask(void *pvParameters) {
+    // Static buffers, only this task formats frames
+    static char hex_output[DUMP_HEX_SIZE];
+    static char string_output[DUMP_TEXT_SIZE];
+    const uint8_t *payload = NULL;
+    size_t payload_length = 0;
+
+    __atomic_store_n(&dumpTask, xTaskGetCurrentTaskHandle(), __ATOMIC_RELEASE);
+
+    while (1) {
+        // A frame handed over before the task handle was known is found by the check without a notification
+        if (!__atomic_load_n(&dumpSlot.busy, __ATOMIC_ACQUIRE)) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        size_t length = dumpSlot.copied;
+
+        printf("\n");
+        ESP_LOGI(Receive_TAG, "Received frame: instance=%u, length=%u (frames skipped by the dump: %lu)",
+                 dumpSlot.instance, dumpSlot.length, __atomic_load_n(&dumpSkipped, __ATOMIC_RELAXED));
+
+        BinToHex(dumpSlot.data, length, hex_output, sizeof(hex_output));
+        ESP_LOGI(Receive_TAG, "Frame content (hex): %s", hex_output);
+
+        BinToString(dumpSlot.data, length, string_output, sizeof(string_output));
+        ESP_LOGI(Receive_TAG, "Frame content (string): %s", string_output);
+
+        if (ExtractPayload(dumpSlot.data, dumpSlot.length, dumpSlot.copied, &payload, &payload_length)) {
+            length = payload_length < FRAME_DUMP_MAX_BYTES ? payload_length : FRAME_DUMP_MAX_BYTES;
+
+            BinToHex(payload, length, hex_output, sizeof(hex_output));
+            ESP_LOGI(Receive_TAG, "Payload content (hex): %s", hex_output);
+
+            BinToString(payload, length, string_output, sizeof(string_output));
+            ESP_LOGI(Receive_TAG, "Payload content (string): %s\n", string_output);
+        } else {
+            ESP_LOGW(Receive_TAG, "Failed to extract payload\n");
+        }
+
+        // RxTask may fill the slot again
+        __atomic_store_n(&dumpSlot.busy, false, __ATOMIC_RELEASE);
+    }
+}
+
 
 void BinToHex(const uint8_t *data, size_t length, char *output, size_t output_size) {
+    static const char digits[] = "0123456789ABCDEF";
     size_t i;
-    for (i = 0; i < length && (i * 2 + 1) < output_size; i++) {
-        sprintf(&output[i * 2], "%02X", data[i]);
+    for (i = 0; i < length && (i * 2 + 2) < output_size; i++) {
+        output[i * 2] = digits[data[i] >> 4];
+        output[i * 2 + 1] = digits[data[i] & 0x0F];
     }
 
     output[i * 2] = '\0';
@@ -391,8 +652,8 @@ void BinToString(const uint8_t *data, size_t length, char *output, size_t output
     output[i] = '\0';
 }
 
-bool ExtractPayload(const uint8_t *frame_data, size_t frame_length, const uint8_t **payload, size_t *payload_length) {
-    if (frame_length < 42) {
+bool ExtractPayload(const uint8_t *frame_data, size_t frame_length, size_t available, const uint8_t **payload, size_t *payload_length) {
+    if (frame_length < 42 || available < 42) {
         ESP_LOGW(Payload_TAG, "Frame too short to contain payload");
         return false;
     }
@@ -405,6 +666,11 @@ bool ExtractPayload(const uint8_t *frame_data, size_t frame_length, const uint8_
         return false;
     }
 
+    if ((14 + ip_header_length + sizeof(struct udp_hdr)) > available) {
+        ESP_LOGW(Payload_TAG, "UDP header not in the copied part of the frame");
+        return false;
+    }
+
     struct udp_hdr *udphdr = (struct udp_hdr *)((uint8_t *)iphdr + ip_header_length);
 
     uint16_t udp_length = ntohs(udphdr->len);
@@ -423,67 +689,14 @@ bool ExtractPayload(const uint8_t *frame_data, size_t frame_length, const uint8_
         return false;
     }
 
-    return true;
-}
-
-
-
-void InitSPIFFS(void) {
-    esp_vfs_spiffs_conf_t conf = {
-        .base_path = "/spiffs",
-        .partition_label = NULL,
-        .max_files = 5,
-        .format_if_mount_failed = true
-    };
-
-    esp_err_t ret = esp_vfs_spiffs_register(&conf);
-    if (ret != ESP_OK) {
-        ESP_LOGE(Spiffs_TAG, "Failed to initialize SPIFFS (%s)", esp_err_to_name(ret));
-    }
-
-    size_t total = 0, used = 0;
-    ret = esp_spiffs_info(NULL, &total, &used);
-    if (ret == ESP_OK) {
-        ESP_LOGI(Spiffs_TAG, "Partition size: total: %d, used: %d", total, used);
-    } else {
-        ESP_LOGE(Spiffs_TAG, "Failed to get SPIFFS partition information (%s)", esp_err_to_name(ret));
+    // Payload bytes behind the copied part of the frame are not there
+    if (((uint8_t *)*payload - frame_data + *payload_length) > available) {
+        *payload_length = available - ((uint8_t *)*payload - frame_data);
     }
 
+    return true;
 }
 
-void InitPCAP(void) {
-    ESP_LOGI(PCAP_TAG, "Sniffer mode is enabled, writing packet to PCAP file");
-    InitSPIFFS();
-
-    FILE *file = fopen(PCAP_FILENAME, "wb");
-    if (file == NULL) {
-        ESP_LOGE(PCAP_TAG, "Failed to create or open PCAP file");
-    }
-
-    pcap_config_t config = {
-        .fp = file,
-        .major_version = PCAP_DEFAULT_VERSION_MAJOR,
-        .minor_version = PCAP_DEFAULT_VERSION_MINOR,
-        .time_zone = PCAP_DEFAULT_TIME_ZONE_GMT,
-        .flags = { .little_endian = 0 }
-    };
-
-    esp_err_t err = pcap_new_session(&config, &pcap);
-    if (err != ESP_OK) {
-        ESP_LOGE(PCAP_TAG, "Failed to create PCAP session");
-        fclose(file);
-    }
-
-    // Write PCAP header
-    if (pcap != NULL) {
-        esp_err_t err = pcap_write_header(pcap, PCAP_LINK_TYPE_ETHERNET);
-        if (err != ESP_OK) {
-            ESP_LOGE(PCAP_TAG, "Failed to write PCAP header");
-            pcap_del_session(pcap);
-            fclose(file);
-        }
-    }
-}
 
 
 void EncryptedClientTask(void *pvParameters) {
@@ -1,24 +1,38 @@
 #ifndef ETHERNET_H
 #define ETHERNET_H
 
-// Structure for Ethernet frame
+#include "lwip/pbuf.h"
+
+// Structure for received Ethernet frame, the frame bytes are owned by the reference counted pbuf
 typedef struct {
-    uint8_t data[1500]; 
-    uint16_t length; 
+    struct pbuf *p;         // Reference held by the consumer, must be released with pbuf_free (never shared with lwIP)
+    const uint8_t *data;    // Start of the Ethernet frame inside of the pbuf
+    uint16_t length;
+    uint8_t instance;       // tc6 instance the frame was received on
+    bool dump;              // Sampled for DumpTask (FRAME_DUMP_SAMPLE)
 } EthernetFrame_t;
 
-// Queue for received frames
-extern QueueHandle_t rxQueue;
-
 // Initialization functions for save received frames
 void InitQueue(void);
 
 // Initialization functions for lwIP stack
 void InitLWIP(void);
 
+// Function sending a complete Ethernet frame on the given LAN8651 without lwIP, the caller keeps its pbuf reference
+err_t SendEthernetFrame(uint8_t instance, struct pbuf *p);
+
+// Function moving the frames queued by lwIP and SendEthernetFrame into the tc6 TX queue (SyncTask only)
+void EthernetTxService(uint8_t instance);
+
+// Function returning how many received frames were dropped because RxTask did not keep up (RX ring full)
+uint32_t GetRxRingDrops(void);
+
 // Fucntion called by task to display/save received packets
 void RxTask(void *pvParameters);
 
+// Function called by the lowest priority task to print the frames sampled by RxTask (FRAME_DUMP_SAMPLE)
+void DumpTask(void *pvParameters);
+
 // Funkcion called by task to send UDP packet
 void SendPacketUnencrypted(void *pvParameters);
 
@@ -1,23 +1,109 @@
+#include <stdio.h>
+#include <string.h>
 #include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_attr.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
 #include "driver/gpio.h"
 
 #include "lan8651.h"
 #include "configuration.h"
 #include "main.h"
 #include "spi.h"
+#include "ethernet.h"
+#include "bridge.h"
+#include "txsched.h"
+#include "trace.h"
+#include "stats.h"
+#include "capture.h"
+#include "rxpool.h"
+#include "tc6-regs.h"
 
 static const char *PHY_TAG = "LAN8651";
 static const char *TC6_TAG = "TC6";
 
-TC6_t *tc6_instance = NULL;
-static bool serviceNeeded = false;
-static uint32_t g_chipIdValue = 0;
+// Maximum time the service task sleeps without IRQ_N or service request (keeps TC6Regs timers running)
+#define SERVICE_TIMEOUT_MS 50
+// Sleep of SyncTask while TC6_Service could not take the pending work yet (FreeRTOS ticks)
+#define SERVICE_PENDING_TICKS 1
+// Maximum wait of WaitTc6Init for the register initialization SyncTask runs
+#define INIT_TIMEOUT_MS 1000
 
-// Function for reading MAC register
-static void onReadMAC(TC6_t *pInst, bool success, uint32_t addr, uint32_t regValue, void *pTag, void *pGlobalTag);
+// Register reads of other tasks waiting for SyncTask
+#define REGISTER_REQUEST_QSIZE 4
 
-// Helper function to process TC6 service requests when needed
-static void HandleTc6Service(void);
+// NVS namespace holding the trim values of every instance (key "trim<instance>")
+#define TRIM_NVS_NAMESPACE "lan8651"
+
+#if defined(CONFIG_TC6_MAX_INSTANCES) && (LAN8651_COUNT > CONFIG_TC6_MAX_INSTANCES)
+#error "LAN8651_COUNT exceeds TC6_MAX_INSTANCES, raise it in menuconfig"
+#endif
+
+TC6_t *tc6_instance[LAN8651_COUNT] = { NULL };
+
+// IRQ_N pin of every LAN8651
+static const int irqPins[LAN8651_COUNT] = IRQ_PIN_LIST;
+
+// IRQ_N went high during the reset pulse (StartPhyReset), only then a low level marks the end of the reset
+static bool irqReleased[LAN8651_COUNT];
+
+// Handle of the task servicing the tc6 library, notified by IRQ_N and TC6_CB_OnNeedService
+static TaskHandle_t syncTaskHandle = NULL;
+
+// Trim values of one LAN8651 as stored in NVS, only valid for the same PHY ID and chip revision
+typedef struct {
+    uint32_t phyId;
+    uint8_t chipRev;
+    uint16_t trim[TC6REGS_TRIM_COUNT];
+} TrimCache_t;
+
+// Trim values loaded by initTc6, WaitTc6Init stores them again only when the chip returned different ones
+static TrimCache_t trimCache[LAN8651_COUNT];
+static bool trimCached[LAN8651_COUNT];
+
+// Completion of a register access, filled by the tc6 callback in SyncTask and awaited by the caller
+typedef struct {
+    SemaphoreHandle_t done;
+    StaticSemaphore_t doneBuffer;
+    uint32_t value;
+    bool success;
+} RegisterFuture_t;
+
+// Register read of another task, SyncTask enqueues it as the only producer of the tc6 register queue
+typedef struct {
+    TC6_t *tc6;
+    uint32_t address;
+    bool secure;
+    RegisterFuture_t *future;
+} RegisterRequest_t;
+
+static QueueHandle_t registerRequests = NULL;
+static StaticQueue_t registerRequestsBuffer;
+static uint8_t registerRequestsStorage[REGISTER_REQUEST_QSIZE * sizeof(RegisterRequest_t)];
+
+// Passes the register reads of other tasks to the tc6 library (SyncTask only)
+static void ServiceRegisterRequests(void);
+
+// Callback completing a RegisterFuture_t
+static void OnRegisterDone(TC6_t *pInst, bool success, uint32_t addr, uint32_t regValue, void *pTag, void *pGlobalTag);
+
+// Function logging the IRQ_N level of every LAN8651
+static void LogIrqLevels(const char *phase);
+
+// Function for configuring IRQ_N pins as low level interrupt waking the service task, each masked by its handler
+// until SyncTask serviced the instance
+static void InitIrqPins(void);
+
+// Functions for loading and storing the trim values of an instance in NVS
+static bool LoadTrimCache(int instance, TrimCache_t *cache);
+static void StoreTrimCache(int instance, const TrimCache_t *cache);
+
+// Interrupt handler of the IRQ_N pin
+static void IrqPinHandler(void *arg);
 
 
 
@@ -32,136 +118,501 @@ void initPhyResetPin(void) {
     };
 
     vTaskDelay(pdMS_TO_TICKS(1000));
-    ESP_LOGI(PHY_TAG, "IRQ_PIN level: %d", gpio_get_level(IRQ_PIN));
+    LogIrqLevels("before reset");
 
     gpio_config(&io_conf);
 
     gpio_set_level(PIN_NUM_RESET, 0);
-    ESP_LOGI(PHY_TAG, "IRQ_PIN level: %d", gpio_get_level(IRQ_PIN));
+    LogIrqLevels("in reset");
 
     vTaskDelay(pdMS_TO_TICKS(100));
     gpio_set_level(PIN_NUM_RESET, 1);
 
-    ESP_LOGI(PHY_TAG, "IRQ_PIN level: %d", gpio_get_level(IRQ_PIN));
+    LogIrqLevels("after reset");
     vTaskDelay(pdMS_TO_TICKS(100));
 
-    ESP_LOGI(PHY_TAG, "IRQ_PIN level: %d", gpio_get_level(IRQ_PIN));
+    // Reset line is shared, every LAN8651 signals the end of its reset on its own IRQ_N
+    for (int i = 0; i < LAN8651_COUNT; i++) {
+        int irqState = gpio_get_level(irqPins[i]);
+        if (irqState == 0) {
+            ESP_LOGI(PHY_TAG, "LAN8651 %d: IRQ_N asserted, reset completed", i);
+        } else {
+            ESP_LOGW(PHY_TAG, "LAN8651 %d: IRQ_N not asserted, reset may have failed", i);
+        }
+    }
+}
 
-    int irqState = gpio_get_level(IRQ_PIN);
-    if (irqState == 0) {
-        ESP_LOGI(PHY_TAG, "IRQ_N asserted, reset completed");
-    } else {
-        ESP_LOGW(PHY_TAG, "IRQ_N not asserted, reset may have failed");
+void StartPhyReset(void) {
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << PIN_NUM_RESET),
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE
+    };
+
+    gpio_config(&io_conf);
+
+    // IRQ_N is read before InitIrqPins, the internal pull up keeps the level defined
+    for (int i = 0; i < LAN8651_COUNT; i++) {
+        gpio_set_direction(irqPins[i], GPIO_MODE_INPUT);
+        gpio_set_pull_mode(irqPins[i], GPIO_PULLUP_ONLY);
+    }
+
+    // Short pulse is enough, the end of the reset is signaled by IRQ_N (WaitPhyReset). An IRQ_N still asserted
+    // from before (e.g. after a restart of the ESP32 only) is released in reset, the pulse lasts until it is high
+    gpio_set_level(PIN_NUM_RESET, 0);
+    esp_rom_delay_us(RESET_PULSE_US);
+    for (uint32_t waited = RESET_PULSE_US; ; waited += 10) {
+        bool released = true;
+
+        for (int i = 0; i < LAN8651_COUNT; i++) {
+            irqReleased[i] = gpio_get_level(irqPins[i]) != 0;
+            released = released && irqReleased[i];
+        }
+        if (released || (waited >= RESET_RELEASE_US)) {
+            break;
+        }
+        esp_rom_delay_us(10);
     }
+    gpio_set_level(PIN_NUM_RESET, 1);
+}
+
+bool WaitPhyReset(void) {
+    TickType_t start = xTaskGetTickCount();
+    bool done = true;
+
+    for (int i = 0; i < LAN8651_COUNT; i++) {
+        // A level which never went high may still be the old interrupt, the whole timeout is waited instead
+        if (!irqReleased[i]) {
+            ESP_LOGW(PHY_TAG, "LAN8651 %d: IRQ_N not released during the reset, waiting %d ms", i, RESET_TIMEOUT_MS);
+            while ((xTaskGetTickCount() - start) < pdMS_TO_TICKS(RESET_TIMEOUT_MS)) {
+                vTaskDelay(1);
+            }
+            done = false;
+            continue;
+        }
+
+        while (gpio_get_level(irqPins[i]) != 0) {
+            if ((xTaskGetTickCount() - start) >= pdMS_TO_TICKS(RESET_TIMEOUT_MS)) {
+                break;
+            }
+            vTaskDelay(1);
+        }
+
+        if (gpio_get_level(irqPins[i]) == 0) {
+            ESP_LOGI(PHY_TAG, "LAN8651 %d: IRQ_N asserted after %lu ms, reset completed", i, pdTICKS_TO_MS(xTaskGetTickCount() - start));
+        } else {
+            ESP_LOGW(PHY_TAG, "LAN8651 %d: IRQ_N not asserted, reset may have failed", i);
+            done = false;
+        }
+    }
+
+    return done;
 }
 
 void initTc6(void) {
     ESP_LOGI(TC6_TAG, "Initializing TC6...");
 
+    registerRequests = xQueueCreateStatic(REGISTER_REQUEST_QSIZE, sizeof(RegisterRequest_t), registerRequestsStorage, &registerRequestsBuffer);
+
     bool promiscuous_mode = SNIFFER ? true : false;
 
-    tc6_instance = TC6_Init((void *)spi_handle);
-    if (tc6_instance == NULL) {
-        ESP_LOGE(TC6_TAG, "Failed to initialize TC6!");
+    for (int i = 0; i < LAN8651_COUNT; i++) {
+        uint8_t mac[6];
+
+        // Instances are numbered in order of TC6_Init, same index as spi_handle and the pin lists
+        tc6_instance[i] = TC6_Init((void *)spi_handle[i]);
+        if (tc6_instance[i] == NULL) {
+            ESP_LOGE(TC6_TAG, "Failed to initialize TC6 %d!", i);
+            return;
+        }
+
+        ESP_LOGI(TC6_TAG, "TC6 %d initialized successfully!", i);
+
+        TC6_SetTransactionPolicy(tc6_instance[i], TC6_XACT_POLICY, TC6_XACT_MAX_CHUNKS);
+
+        // Trim values of the previous boot spare the indirect reads of the chip initialization
+        trimCached[i] = FAST_BOOT && LoadTrimCache(i, &trimCache[i]);
+        if (trimCached[i]) {
+            TC6Regs_SetCachedTrim(tc6_instance[i], trimCache[i].phyId, trimCache[i].chipRev, trimCache[i].trim);
+        }
+
+        // Inicilization of the LAN8651 registers, started here and finished by SyncTask (WaitTc6Init)
+        GetMacAddress(i, mac);
+        bool regs_init_ok = TC6Regs_Init(tc6_instance[i], NULL, mac,
+                                         PLCA_ENABLE, // PLCA enable
+                                         NODE_ID,     // nodeId
+                                         NODE_COUNT,     // nodeCount
+                                         BURST_COUNT,     // burstCount
+                                         BURST_TIMER,     // burstTimer
+                                         SNIFFER || BRIDGE_ENABLE, // promiscuous mode
+                                         TX_CUT_THROUHG, // txCutThrough
+                                         RX_CUT_THROUGH);// rxCutThrough
+
+        if (!regs_init_ok) {
+            ESP_LOGE(TC6_TAG, "Failed to start the initialization of TC6 %d registers!", i);
+        }
+    }
+}
+
+bool WaitTc6Init(void) {
+    TickType_t start = xTaskGetTickCount();
+    bool done = true;
+
+    for (int i = 0; i < LAN8651_COUNT; i++) {
+        if (tc6_instance[i] == NULL) {
+            done = false;
+            continue;
+        }
+
+        // SyncTask drives the initialization from the tc6 callbacks (and restarts it after a failure), this only watches it
+        while (!TC6Regs_GetInitDone(tc6_instance[i]) && ((xTaskGetTickCount() - start) < pdMS_TO_TICKS(INIT_TIMEOUT_MS))) {
+            vTaskDelay(1);
+        }
+        if (!TC6Regs_GetInitDone(tc6_instance[i])) {
+            ESP_LOGE(TC6_TAG, "Failed to initialize TC6 %d registers!", i);
+            done = false;
+            continue;
+        }
+        ESP_LOGI(TC6_TAG, "TC6 %d registers initialized successfully!", i);
+
+        if (FAST_BOOT) {
+            TrimCache_t current;
+            memset(&current, 0, sizeof(current));
+
+            // Only written when the chip or its trim values changed, saves flash wear
+            if (TC6Regs_GetTrim(tc6_instance[i], &current.phyId, &current.chipRev, current.trim) &&
+                (!trimCached[i] || (memcmp(&current, &trimCache[i], sizeof(current)) != 0))) {
+                StoreTrimCache(i, &current);
+            }
+        }
+    }
+
+    // OnInitDone of tc6-regs enabled the data path already, from SyncTask as the tc6 library is not locked
+    if (!FAST_BOOT) {
+        vTaskDelay(pdMS_TO_TICKS(200));
+    }
+
+    return done;
+}
+
+static bool LoadTrimCache(int instance, TrimCache_t *cache) {
+    nvs_handle_t handle;
+    char key[8];
+    size_t length = sizeof(*cache);
+
+    if (nvs_open(TRIM_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+
+    snprintf(key, sizeof(key), "trim%d", instance);
+    memset(cache, 0, sizeof(*cache));
+    esp_err_t ret = nvs_get_blob(handle, key, cache, &length);
+    nvs_close(handle);
+
+    if (ret != ESP_OK || length != sizeof(*cache)) {
+        return false;
+    }
+
+    ESP_LOGI(PHY_TAG, "LAN8651 %d: using cached trim values (PHY ID 0x%08lX, revision %u)", instance, cache->phyId, cache->chipRev);
+    return true;
+}
+
+static void StoreTrimCache(int instance, const TrimCache_t *cache) {
+    nvs_handle_t handle;
+    char key[8];
+
+    esp_err_t ret = nvs_open(TRIM_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGW(PHY_TAG, "Could not open NVS for trim values: %s", esp_err_to_name(ret));
         return;
     }
 
-    ESP_LOGI(TC6_TAG, "TC6 initialized successfully!");
-    
-    // Inicilization of the LAN8651 registers
-    bool regs_init_ok = TC6Regs_Init(tc6_instance, NULL, macAddress, 
-                                     PLCA_ENABLE, // PLCA enable
-                                     NODE_ID,     // nodeId
-                                     NODE_COUNT,     // nodeCount
-                                     BURST_COUNT,     // burstCount
-                                     BURST_TIMER,     // burstTimer
-                                     SNIFFER, // promiscuous mode
-                                     TX_CUT_THROUHG, // txCutThrough
-                                     RX_CUT_THROUGH);// rxCutThrough
-                                     
-    if (!regs_init_ok) {
-        ESP_LOGE(TC6_TAG, "Failed to initialize TC6 registers!");
-    } else {
-        ESP_LOGI(TC6_TAG, "TC6 registers initialized successfully!");
+    snprintf(key, sizeof(key), "trim%d", instance);
+    ret = nvs_set_blob(handle, key, cache, sizeof(*cache));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
     }
-    
-    vTaskDelay(pdMS_TO_TICKS(100));
-    
-    TC6_EnableData(tc6_instance, true);
+    nvs_close(handle);
 
-    vTaskDelay(pdMS_TO_TICKS(100));
+    if (ret != ESP_OK) {
+        ESP_LOGW(PHY_TAG, "Could not store trim values of LAN8651 %d: %s", instance, esp_err_to_name(ret));
+    } else {
+        ESP_LOGI(PHY_TAG, "LAN8651 %d: trim values stored", instance);
+    }
 }
 
 void SyncTask(void *pvParameters) {
-    TC6_t *tc6_instance = (TC6_t *)pvParameters;
+    (void)pvParameters;
 
     static uint32_t last_check = 0;
+    bool notified = true;
 
-    while (1) {
-        HandleTc6Service();
+    syncTaskHandle = xTaskGetCurrentTaskHandle();
+    InitIrqPins();
 
-        TC6_Service(tc6_instance, true);
+    while (1) {
+        ServiceRegisterRequests();
+
+        // One task services all instances, IRQ_N is active low, TC6_Service expects false while the interrupt is asserted.
+        // It is also the only task filling the tc6 TX queues, frames of other tasks wait in front of them
+        bool pending = false;
+        for (int i = 0; i < LAN8651_COUNT; i++) {
+            bool irqActive = gpio_get_level(irqPins[i]) == 0;
+
+            if (TX_SCHED_ENABLE) {
+                TxSchedService(i);
+            }
+            EthernetTxService(i);
+            if (irqActive && !notified) {
+                StatsIrqRecovered(i);
+            }
+            // The level interrupt stays masked until the work is taken, an IRQ_N still asserted then fires again at once.
+            // While the SPI transaction is busy TC6_Service returns false and the end of the transaction wakes the task
+            if (TC6_Service(tc6_instance[i], !irqActive)) {
+                gpio_intr_enable(irqPins[i]);
+            } else {
+                pending = true;
+            }
+            StatsCheckCredit(i, tc6_instance[i]);
+        }
 
         // Every 10 seconds, chack synchronization status of the LAN8651
         uint32_t now = esp_log_timestamp();
         if ((now - last_check) > 10000) {
-            bool synced;
-            uint8_t txCredit, rxCredit;
-
-            TC6_GetState(tc6_instance, &txCredit, &rxCredit, &synced);
             printf("\n");
-            ESP_LOGI(PHY_TAG, "LAN8651 status - Synced: %s, TX Credit: %u, RX Credit: %u\n", synced ? "YES" : "NO", txCredit, rxCredit);
+            for (int i = 0; i < LAN8651_COUNT; i++) {
+                bool synced;
+                uint8_t txCredit, rxCredit;
+                TC6_TxQueueStats_t txQueue;
+                TC6_RegOpStats_t regOps;
+
+                TC6_GetState(tc6_instance[i], &txCredit, &rxCredit, &synced);
+                TC6_GetTxQueueStats(tc6_instance[i], &txQueue, true);
+                TC6_GetRegOpStats(tc6_instance[i], &regOps, true);
+                ESP_LOGI(PHY_TAG, "LAN8651 %d status - Synced: %s, TX Credit: %u, RX Credit: %u\n", i, synced ? "YES" : "NO", txCredit, rxCredit);
+                ESP_LOGI(PHY_TAG, "LAN8651 %d TX queue - Depth: %u/%u, High water: %u, Full: %lu\n", i, txQueue.depth, txQueue.size, txQueue.highWater, txQueue.fullCount);
+                ESP_LOGI(PHY_TAG, "LAN8651 %d register queue - Depth: %u/%u, Coalesced writes: %lu, Coalesced modifies: %lu\n", i, regOps.depth, regOps.size, regOps.coalescedWrites, regOps.coalescedModifies);
+            }
+            ESP_LOGI(PHY_TAG, "RX pool drops: %lu, RX ring drops: %lu\n", RxPoolGetDrops(), GetRxRingDrops());
+
+            for (int i = 0; i < LAN8651_COUNT; i++) {
+                StatsCounters_t stats;
+
+                // The answer arrives with one of the next service calls and is shown in the next period
+                StatsReadPlcaStatus(i, tc6_instance[i]);
+
+                StatsSnapshot(i, &stats);
+                ESP_LOGI(PHY_TAG, "LAN8651 %d traffic - RX: %lu frames / %lu bytes, TX: %lu frames / %lu bytes, PLCA: %s (%lu changes)\n",
+                         i, stats.rxFrames, stats.rxBytes, stats.txFrames, stats.txBytes,
+                         (stats.plcaStatus & STATS_PLCA_STATUS_PST) ? "active" : "inactive", stats.plcaChanges);
+                ESP_LOGI(PHY_TAG, "LAN8651 %d SPI - Transactions: %lu, Failed: %lu, Avg: %lu us, Max: %lu us, Credit starved: %lu, IRQ recovered: %lu\n",
+                         i, stats.spiTransactions, stats.spiFailures, stats.spiTransactions ? stats.spiBusyUs / stats.spiTransactions : 0,
+                         stats.spiMaxUs, stats.creditStarved, stats.irqRecovered);
+                ESP_LOGI(PHY_TAG, "LAN8651 %d drops - RX error: %lu, Pool: %lu, Copy: %lu, Ring: %lu, Size: %lu/%lu/%lu, Slice: %lu, Input: %lu, TX full: %lu, TX mem: %lu, TX error: %lu\n",
+                         i, stats.drops[StatsDrop_RxError], stats.drops[StatsDrop_RxPbufPool], stats.drops[StatsDrop_RxCopy],
+                         stats.drops[StatsDrop_RxRingFull],
+                         stats.drops[StatsDrop_RxTooLarge], stats.drops[StatsDrop_RxTooSmall], stats.drops[StatsDrop_RxSizeMismatch],
+                         stats.drops[StatsDrop_RxSlice], stats.drops[StatsDrop_RxInput], stats.drops[StatsDrop_TxQueueFull],
+                         stats.drops[StatsDrop_TxNoMem], stats.drops[StatsDrop_TxError]);
+                ESP_LOGI(PHY_TAG, "LAN8651 %d errors - No hardware: %lu, SV: %lu, DV/EV: %lu, Parity: %lu, Ctrl: %lu, Bad TX: %lu, Sync lost: %lu, SPI: %lu, Ctrl TX: %lu\n",
+                         i, stats.errors[TC6Error_NoHardware], stats.errors[TC6Error_UnexpectedSv], stats.errors[TC6Error_UnexpectedDvEv],
+                         stats.errors[TC6Error_BadChecksum], stats.errors[TC6Error_UnexpectedCtrl], stats.errors[TC6Error_BadTxData],
+                         stats.errors[TC6Error_SyncLost], stats.errors[TC6Error_SpiError], stats.errors[TC6Error_ControlTxFail]);
+
+                // Same counters for tools, one hex line per instance (format in stats.h)
+                if (STATS_EXPORT) {
+                    uint8_t export[STATS_EXPORT_SIZE];
+                    size_t length = StatsExport(i, export, sizeof(export));
+
+                    printf("STATS_BIN,");
+                    for (size_t k = 0; k < length; k++) {
+                        printf("%02x", export[k]);
+                    }
+                    printf("\n");
+                }
+            }
+
+            if (SNIFFER) {
+                pcap_ring_stats_t capture;
+
+                CaptureGetStats(&capture);
+                ESP_LOGI(PHY_TAG, "Capture - Packets: %lu, Drops: %lu (%lu bytes), Written: %lu bytes in %lu writes, Write errors: %lu, Ring high water: %lu/%d\n",
+                         capture.records, capture.drops, capture.drop_bytes, capture.written_bytes, capture.writes,
+                         capture.write_errors, capture.high_water, CAPTURE_RING_SIZE);
+            }
+
+            if (TX_SCHED_ENABLE) {
+                for (int i = 0; i < LAN8651_COUNT; i++) {
+                    TxSchedStats_t stats;
+
+                    TxSchedGetStats(i, &stats, true);
+                    ESP_LOGI(PHY_TAG, "LAN8651 %d TX scheduler - In flight: %u/%u, Waits: %lu, Frames: %lu/%lu, Drops: %lu/%lu, Max latency: %lu/%lu us\n",
+                             i, stats.inFlightMax, stats.window, stats.waits, stats.frames[1], stats.frames[0],
+                             stats.drops[1], stats.drops[0], stats.maxLatencyUs[1], stats.maxLatencyUs[0]);
+                }
+            }
+
+            if (BRIDGE_ENABLE) {
+                for (int i = 0; i < LAN8651_COUNT; i++) {
+                    BridgePortStats_t stats;
+
+                    BridgeGetPortStats(i, &stats);
+                    ESP_LOGI(PHY_TAG, "Bridge port %d - RX: %lu, Forwarded: %lu, Flooded: %lu, Filtered: %lu, Local: %lu, TX: %lu, TX drops: %lu\n",
+                             i, stats.rxFrames, stats.forwarded, stats.flooded, stats.filtered, stats.local, stats.txFrames, stats.txDrops);
+                }
+            }
 
             last_check = now;
         }
 
         TC6Regs_CheckTimers();
 
+        // Sleep until IRQ_N is asserted, SPI transaction finishes or library requests service, shortly while work is pending
+        notified = ulTaskNotifyTake(pdTRUE, pending ? SERVICE_PENDING_TICKS : pdMS_TO_TICKS(SERVICE_TIMEOUT_MS)) != 0;
+    }
+}
+
+static void LogIrqLevels(const char *phase) {
+    for (int i = 0; i < LAN8651_COUNT; i++) {
+        ESP_LOGI(PHY_TAG, "LAN8651 %d: IRQ_N (GPIO %d) level %s: %d", i, irqPins[i], phase, gpio_get_level(irqPins[i]));
     }
 }
 
+static void InitIrqPins(void) {
+    uint64_t pinMask = 0;
 
+    for (int i = 0; i < LAN8651_COUNT; i++) {
+        pinMask |= (1ULL << irqPins[i]);
+    }
 
-void ReadMacControlRegister(TC6_t *tc6_instance) {
-    g_chipIdValue = 0;
-    uint32_t address = 0x00000000;
+    gpio_config_t io_conf = {
+        .pin_bit_mask = pinMask,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_LOW_LEVEL
+    };
+
+    gpio_config(&io_conf);
 
-    bool ok = TC6_ReadRegister(tc6_instance, address, false, onReadMAC, NULL);
-    if (!ok) {
-        ESP_LOGE(PHY_TAG, "Could not begin read of Chip ID register!");
+    esp_err_t ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(PHY_TAG, "Failed to install GPIO ISR service: %s", esp_err_to_name(ret));
+        return;
     }
 
-    // Wait for callback function to set g_chipIdValue
-    while (g_chipIdValue == 0) {
-        (void)TC6_Service(tc6_instance, false);
-        vTaskDelay(pdMS_TO_TICKS(10));
+    // All instances are serviced by the same task, so every IRQ_N just wakes it. The interrupt is level triggered
+    // as TC6_Service expects, an edge would not fire again for an interrupt still asserted after the service
+    for (int i = 0; i < LAN8651_COUNT; i++) {
+        ret = gpio_isr_handler_add(irqPins[i], IrqPinHandler, (void *)(uintptr_t)i);
+        if (ret != ESP_OK) {
+            ESP_LOGE(PHY_TAG, "Failed to add IRQ_N handler for LAN8651 %d: %s", i, esp_err_to_name(ret));
+        }
     }
+}
 
-    ESP_LOGI(PHY_TAG, "LAN8651 Chip ID: 0x%08lX", g_chipIdValue);
+static void IrqPinHandler(void *arg) {
+    TRACE_PROBE((uint8_t)(uintptr_t)arg, TC6TracePoint_Irq);
+    // Masked until SyncTask took the work, otherwise the low level would fire continuously
+    gpio_intr_disable(irqPins[(uintptr_t)arg]);
+    NotifySyncTask();
 }
 
-static void onReadMAC(TC6_t *pInst, bool success, uint32_t addr, uint32_t regValue, void *pTag, void *pGlobalTag) {
-    if (success) {
-        g_chipIdValue = regValue;
+void IRAM_ATTR NotifySyncTask(void) {
+    if (syncTaskHandle == NULL) {
+        return;
+    }
+
+    if (xPortInIsrContext()) {
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(syncTaskHandle, &higherPriorityTaskWoken);
+        portYIELD_FROM_ISR(higherPriorityTaskWoken);
+    } else {
+        xTaskNotifyGive(syncTaskHandle);
     }
 }
 
 
 
-void HandleTc6Service(void) {
-    if (serviceNeeded) {
-        serviceNeeded = false;
-        TC6_Service(tc6_instance, false);
+static void ServiceRegisterRequests(void) {
+    static RegisterRequest_t request;
+    static bool pending = false;
+
+    while (pending || (xQueueReceive(registerRequests, &request, 0) == pdTRUE)) {
+        pending = true;
+
+        // Register queue full, retried after the next service call
+        if (!TC6_ReadRegister(request.tc6, request.address, request.secure, OnRegisterDone, request.future)) {
+            break;
+        }
+        pending = false;
     }
 }
 
-// Callback for indicating that the TC6 service needs to be called
-void TC6_CB_OnNeedService(TC6_t *pInst, void *pGlobalTag) {
-    serviceNeeded = true;
+bool ReadRegisterWait(TC6_t *tc6_instance, uint32_t address, bool secure, uint32_t *value) {
+    RegisterFuture_t future;
+    RegisterRequest_t request = {
+        .tc6 = tc6_instance,
+        .address = address,
+        .secure = secure,
+        .future = &future
+    };
+
+    // SyncTask would wait for itself
+    if ((registerRequests == NULL) || (xTaskGetCurrentTaskHandle() == syncTaskHandle)) {
+        ESP_LOGE(PHY_TAG, "ReadRegisterWait must be called after initTc6 and outside of SyncTask");
+        return false;
+    }
+
+    future.done = xSemaphoreCreateBinaryStatic(&future.doneBuffer);
+    future.value = 0;
+    future.success = false;
+
+    // The tc6 register queue is not locked, only SyncTask enqueues, the callback completes the future
+    xQueueSend(registerRequests, &request, portMAX_DELAY);
+    NotifySyncTask();
+
+    // The tc6 library calls back in any case, also when the access fails or the instance is reset
+    xSemaphoreTake(future.done, portMAX_DELAY);
+    vSemaphoreDelete(future.done);
+
+    if (value != NULL) {
+        *value = future.value;
+    }
+    return future.success;
+}
+
+void ReadMacControlRegister(TC6_t *tc6_instance) {
+    uint32_t chipId = 0;
+
+    if (!ReadRegisterWait(tc6_instance, 0x00000000, false, &chipId)) {
+        ESP_LOGE(PHY_TAG, "Could not read Chip ID register!");
+        return;
+    }
+
+    ESP_LOGI(PHY_TAG, "LAN8651 Chip ID: 0x%08lX", chipId);
+}
+
+static void OnRegisterDone(TC6_t *pInst, bool success, uint32_t addr, uint32_t regValue, void *pTag, void *pGlobalTag) {
+    RegisterFuture_t *future = (RegisterFuture_t *)pTag;
+
+    future->value = regValue;
+    future->success = success;
+    xSemaphoreGive(future->done);
+}
+
+
+
+// Callback for indicating that the TC6 service needs to be called (task or SPI interrupt context, so in IRAM)
+void IRAM_ATTR TC6_CB_OnNeedService(TC6_t *pInst, void *pGlobalTag) {
+    NotifySyncTask();
 }
 
 // Callback for handling errors
 void TC6_CB_OnError(TC6_t *pInst, TC6_Error_t err, void *pGlobalTag) {
+    StatsError(TC6_GetInstance(pInst), err);
     ESP_LOGE(TC6_TAG, "TC6 error occurred: %d", err);
 }
 
@@ -3,22 +3,40 @@
 
 #include "driver/spi_master.h"
 #include "tc6.h"
+#include "configuration.h"
 
-// Global pointer to the tc6 instance
-extern TC6_t *tc6_instance;
+// Global pointers to the tc6 instances, index is the tc6 instance number
+extern TC6_t *tc6_instance[LAN8651_COUNT];
 
 // Global variable for the MAC address
 extern uint8_t macAddress[6];
 
+// Function returning the MAC address of the given instance (macAddress with the last byte increased by the instance)
+void GetMacAddress(uint8_t instance, uint8_t mac[6]);
+
 // Function for hardware reset of the PHY
 void initPhyResetPin(void);
 
-// Iniscialization of the tc6 library
+// Functions for fast hardware reset of the PHY, StartPhyReset only pulses the reset pin (until every IRQ_N is released),
+// WaitPhyReset blocks until every IRQ_N signals the end of the reset (RESET_TIMEOUT_MS at most)
+void StartPhyReset(void);
+bool WaitPhyReset(void);
+
+// Iniscialization of the tc6 library, starts the register initialization of every LAN8651 (finished by SyncTask)
 void initTc6(void);
 
-// Function to chack synchronization status of the PHY
+// Function waiting until SyncTask has finished the register initialization (INIT_TIMEOUT_MS at most), stores the trim values (FAST_BOOT)
+bool WaitTc6Init(void);
+
+// Function to chack synchronization status of the PHYs and service all tc6 instances
 void SyncTask(void *pvParameters);
 
+// Function waking SyncTask from task or interrupt context, e.g. after queueing a frame for transmission
+void NotifySyncTask(void);
+
+// Function for reading a register from any task except SyncTask, blocks until SyncTask has finished the access
+bool ReadRegisterWait(TC6_t *tc6_instance, uint32_t address, bool secure, uint32_t *value);
+
 // Function for chack MAC Network Control Register (Is transmit and receive enabled?)
 void ReadMacControlRegister(TC6_t *tc6_instance);
 
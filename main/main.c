@@ -1,5 +1,6 @@
 #include <string.h>
 #include "esp_log.h"
+#include "nvs_flash.h"
 #include "driver/spi_master.h"
 
 #include "configuration.h"
@@ -8,20 +9,45 @@
 #include "lan8651.h"
 #include "ethernet.h"
 #include "encryption.h"
+#include "bridge.h"
+#include "txsched.h"
+#include "benchmark.h"
+#include "trace.h"
+#include "stats.h"
 
 
 
 
 void app_main(void) {
 
+    // NVS holds the cached trim values of the LAN8651 (FAST_BOOT)
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        nvs_flash_erase();
+        nvs_flash_init();
+    }
+
     InitSpi();
 
-    initPhyResetPin();
+    if (FAST_BOOT) {
+        // LAN8651 leaves reset while lwIP and DTLS are initialized, frames sent before initTc6 are dropped
+        StartPhyReset();
+    } else {
+        initPhyResetPin();
 
-    initTc6();
+        initTc6();
+    }
 
     InitQueue();
 
+    if (BRIDGE_ENABLE) {
+        InitBridge();
+    }
+
+    if (TX_SCHED_ENABLE) {
+        InitTxScheduler();
+    }
+
     InitLWIP();
 
     if (ENCRYPTED_SERVER) {
@@ -30,22 +56,49 @@ void app_main(void) {
         InitDTLSClient();
     }
 
-    xTaskCreate(SyncTask, "TC6Task", 4096, (void *)tc6_instance, 5, NULL);
+    if (FAST_BOOT) {
+        WaitPhyReset();
+
+        initTc6();
+    }
+
+    xTaskCreate(SyncTask, "TC6Task", 4096, NULL, 5, NULL);
+
+    WaitTc6Init();
+
+    for (int i = 0; i < LAN8651_COUNT; i++) {
+        ReadMacControlRegister(tc6_instance[i]);
 
-    ReadMacControlRegister(tc6_instance);
-    
-    uint8_t chipRev1 = TC6Regs_GetChipRevision(tc6_instance);
-    ESP_LOGI("LAN8651", "LAN8651 Chip Revision: %u", chipRev1);
+        // The chip ID read is queued behind the register initialization, so all of it is counted here
+        StatsCounters_t stats;
+        StatsSnapshot(i, &stats);
+        ESP_LOGI("LAN8651", "LAN8651 %d initialized with %lu SPI transactions (%lu us busy)", i, stats.spiTransactions, stats.spiBusyUs);
+
+        uint8_t chipRev1 = TC6Regs_GetChipRevision(tc6_instance[i]);
+        ESP_LOGI("LAN8651", "LAN8651 %d Chip Revision: %u", i, chipRev1);
+    }
 
     xTaskCreate(RxTask, "RxTask", 8192, NULL, 5, NULL);
 
+    // Formatting is the most expensive part of a frame, it runs only when nothing else has to
+    if (FRAME_DUMP_SAMPLE > 0) {
+        xTaskCreate(DumpTask, "DumpTask", 4096, NULL, tskIDLE_PRIORITY + 1, NULL);
+    }
+
+    if (TRACE_ENABLE) {
+        InitTrace();
+    }
+
+    // The benchmark replaces the periodic messages, a DTLS server keeps receiving the benchmark records
+    if (BENCH_ENABLE) {
+        InitBenchmark();
+    }
+
     if (ENCRYPTED_SERVER) {
         xTaskCreate(EncryptedServerTask, "EncryptedServerTask", 8192, NULL, 5, NULL);
-    } else if (ENCRYPTED_CLIENT) {
+    } else if (ENCRYPTED_CLIENT && !BENCH_ENABLE) {
         xTaskCreate(EncryptedClientTask, "EncryptedClientTask", 8192, NULL, 5, NULL);
-    }
-
-    if (!SNIFFER && !ENCRYPTED_SERVER && !ENCRYPTED_CLIENT) {
+    } else if (!SNIFFER && !ENCRYPTED_CLIENT && !BENCH_ENABLE) {
         xTaskCreate(SendPacketUnencrypted, "AppSendPacketTask", 4096, NULL, 5, NULL);
     }
 }
\ No newline at end of file
@@ -6,7 +6,4 @@
 
 #include "tc6-regs.h"
 
-// Queue for received frames
-extern QueueHandle_t rxQueue;
-
 #endif
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "rxpool.h"
+
+#if RX_PBUF_POOL_SIZE < 1 || RX_PBUF_POOL_SIZE > 32
+#error "RX_PBUF_POOL_SIZE must be between 1 and 32"
+#endif
+
+// Preallocated RX frame buffer, handed to lwIP as custom pbuf
+typedef struct {
+    struct pbuf_custom pbuf;
+    uint8_t payload[RX_POOL_BUF_SIZE];
+} RxPbuf_t;
+
+// Pool of RX frame buffers, a set bit in poolFree marks a free entry
+static RxPbuf_t pool[RX_PBUF_POOL_SIZE];
+static uint32_t poolFree = (uint32_t)((1ULL << RX_PBUF_POOL_SIZE) - 1u);
+static uint32_t poolDrops = 0;
+
+// Callback from lwIP when the last reference of a pool buffer is released
+static void RxPoolFree(struct pbuf *p);
+
+
+
+
+struct pbuf *RxPoolAlloc(void) {
+    uint32_t freeMask = __atomic_load_n(&poolFree, __ATOMIC_ACQUIRE);
+
+    while (freeMask != 0) {
+        uint32_t index = __builtin_ctz(freeMask);
+        if (__atomic_compare_exchange_n(&poolFree, &freeMask, freeMask & ~(1u << index), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            RxPbuf_t *entry = &pool[index];
+            entry->pbuf.custom_free_function = RxPoolFree;
+            return pbuf_alloced_custom(PBUF_RAW, RX_POOL_BUF_SIZE, PBUF_REF, &entry->pbuf, entry->payload, sizeof(entry->payload));
+        }
+    }
+
+    __atomic_fetch_add(&poolDrops, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+uint32_t RxPoolGetDrops(void) {
+    return __atomic_load_n(&poolDrops, __ATOMIC_RELAXED);
+}
+
+static void RxPoolFree(struct pbuf *p) {
+    RxPbuf_t *entry = (RxPbuf_t *)p;
+    uint32_t index = (uint32_t)(entry - pool);
+
+    __atomic_fetch_or(&poolFree, 1u << index, __ATOMIC_RELEASE);
+}
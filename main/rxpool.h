@@ -0,0 +1,21 @@
+#ifndef RXPOOL_H
+#define RXPOOL_H
+
+#include <stdint.h>
+
+#include "lwip/pbuf.h"
+
+#include "configuration.h"
+
+// Size of one RX frame buffer, the largest frame handed over by the tc6 library fits
+#define RX_POOL_BUF_SIZE 1536
+
+// Function taking a buffer of the pool as custom pbuf of RX_POOL_BUF_SIZE bytes, never chained. Lock free and O(1),
+// callable from any task. Returns NULL and counts a drop when all RX_PBUF_POOL_SIZE buffers are in use.
+// The buffer returns to the pool when lwIP or RxTask releases the last reference
+struct pbuf *RxPoolAlloc(void);
+
+// Function returning how many allocations found the pool empty
+uint32_t RxPoolGetDrops(void);
+
+#endif
@@ -0,0 +1,70 @@
+#include <string.h>
+
+#include "rxring.h"
+
+#if (RX_RING_SIZE & (RX_RING_SIZE - 1)) != 0
+#error "RX_RING_SIZE must be power of 2"
+#endif
+
+
+
+
+void RxRingInit(RxRing_t *ring) {
+    memset(ring, 0, sizeof(*ring));
+}
+
+bool RxRingPush(RxRing_t *ring, const EthernetFrame_t *frame) {
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    if ((uint32_t)(tail - head) >= RX_RING_SIZE) {
+        __atomic_fetch_add(&ring->drops, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    // Entry is complete before the consumer can see the new tail
+    ring->entry[tail & (RX_RING_SIZE - 1)] = *frame;
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+
+    TaskHandle_t consumer = __atomic_load_n(&ring->consumer, __ATOMIC_ACQUIRE);
+    if (consumer != NULL) {
+        xTaskNotifyGive(consumer);
+    }
+    return true;
+}
+
+uint32_t RxRingPop(RxRing_t *ring, EthernetFrame_t *frames, uint32_t max, TickType_t wait) {
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    if (__atomic_load_n(&ring->consumer, __ATOMIC_RELAXED) == NULL) {
+        __atomic_store_n(&ring->consumer, xTaskGetCurrentTaskHandle(), __ATOMIC_RELEASE);
+    }
+
+    // Notifications given for frames taken by an earlier batch just end the wait early, the ring is checked again
+    while ((tail == head) && (wait > 0)) {
+        TickType_t start = xTaskGetTickCount();
+
+        ulTaskNotifyTake(pdTRUE, wait);
+        tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+        TickType_t waited = xTaskGetTickCount() - start;
+        wait = (wait == portMAX_DELAY) ? wait : ((waited < wait) ? (wait - waited) : 0);
+    }
+
+    uint32_t count = (uint32_t)(tail - head);
+    if (count > max) {
+        count = max;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        frames[i] = ring->entry[(head + i) & (RX_RING_SIZE - 1)];
+    }
+
+    // Entries are copied out before the producer may overwrite them
+    __atomic_store_n(&ring->head, head + count, __ATOMIC_RELEASE);
+    return count;
+}
+
+uint32_t RxRingGetDrops(RxRing_t *ring) {
+    return __atomic_load_n(&ring->drops, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,38 @@
+#ifndef RXRING_H
+#define RXRING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "ethernet.h"
+
+// Entries of a ring, power of 2. Every received frame holds a buffer of the RX pool (RX_PBUF_POOL_SIZE <= 32),
+// so the ring of the RX path only overflows if frames are queued from elsewhere
+#define RX_RING_SIZE 32
+
+// Single producer / single consumer ring of received frames, lock free. The producer never blocks,
+// the consumer sleeps on its task notification until the producer has queued a frame
+typedef struct {
+    EthernetFrame_t entry[RX_RING_SIZE];
+    uint32_t head;                      // Next entry to read, written by the consumer only
+    uint32_t tail;                      // Next entry to write, written by the producer only
+    uint32_t drops;                     // Frames not queued because the ring was full
+    TaskHandle_t consumer;              // Task waiting in RxRingPop, set by its first call
+} RxRing_t;
+
+// Initialization function emptying the ring and clearing its counters
+void RxRingInit(RxRing_t *ring);
+
+// Function queueing a frame (producer), never blocks, returns false and counts a drop when the ring is full
+bool RxRingPush(RxRing_t *ring, const EthernetFrame_t *frame);
+
+// Function taking up to max frames at once (consumer), waits up to wait ticks while the ring is empty, returns the number of frames
+uint32_t RxRingPop(RxRing_t *ring, EthernetFrame_t *frames, uint32_t max, TickType_t wait);
+
+// Function returning the number of dropped frames
+uint32_t RxRingGetDrops(RxRing_t *ring);
+
+#endif
@@ -1,51 +1,85 @@
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
 
 #include "spi.h"
 #include "configuration.h"
 #include "main.h"
+#include "stats.h"
 
 static const char *SPI_TAG = "SPI";
 
-spi_device_handle_t spi_handle;
+spi_device_handle_t spi_handle[LAN8651_COUNT];
 
+// SPI host, bus pins and chip select of every LAN8651, devices on the same host share its bus
+static const spi_host_device_t spiHosts[LAN8651_COUNT] = SPI_HOST_LIST;
+static const int misoPins[LAN8651_COUNT] = PIN_NUM_MISO_LIST;
+static const int mosiPins[LAN8651_COUNT] = PIN_NUM_MOSI_LIST;
+static const int clkPins[LAN8651_COUNT] = PIN_NUM_CLK_LIST;
+static const int csPins[LAN8651_COUNT] = PIN_NUM_CS_LIST;
 
+// Transaction descriptor handed to the SPI driver, libtc6 keeps only one transaction in flight per instance
+static spi_transaction_t spiTransaction[LAN8651_COUNT];
 
+// Time the transaction of every instance was queued, for the SPI duration statistics
+static int64_t spiStart[LAN8651_COUNT];
 
-esp_err_t InitSpi(void) {
-    esp_err_t ret;
+// Callback from SPI driver (interrupt context) when the queued transaction is finished,
+// in IRAM like the SPI interrupt (CONFIG_SPI_MASTER_ISR_IN_IRAM), so it also runs while flash is written
+static void IRAM_ATTR SpiPostTransaction(spi_transaction_t *transaction);
 
-    ESP_LOGI(SPI_TAG, "Initializing SPI...");
 
-    // SPI configuraton
-    spi_bus_config_t buscfg = {
-        .miso_io_num = PIN_NUM_MISO,
-        .mosi_io_num = PIN_NUM_MOSI,
-        .sclk_io_num = PIN_NUM_CLK,
-        .quadwp_io_num = -1,
-        .quadhd_io_num = -1,
-        .max_transfer_sz = 4096,
-    };
 
-    // SPI init
-    ret = spi_bus_initialize(SPI2_HOST, &buscfg, SPI_DMA_CH_AUTO);
-    if (ret != ESP_OK) {
-        ESP_LOGE(SPI_TAG, "Failed to initialize SPI bus: %s", esp_err_to_name(ret));
-        return ret;
-    }
 
-    // SPI device configuration
-    spi_device_interface_config_t devcfg = {
-        .clock_speed_hz = CLOCK_RATE,
-        .mode = 0,                         // SPI mode
-        .spics_io_num = PIN_NUM_CS,        // CS pin
-        .queue_size = 7,
-    };
+esp_err_t InitSpi(void) {
+    esp_err_t ret;
 
-    // Add device to SPI interface
-    ret = spi_bus_add_device(SPI2_HOST, &devcfg, &spi_handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(SPI_TAG, "Failed to add SPI device: %s", esp_err_to_name(ret));
-        return ret;
+    ESP_LOGI(SPI_TAG, "Initializing SPI...");
+
+    for (int i = 0; i < LAN8651_COUNT; i++) {
+        int first = 0;
+
+        // The bus of every host is initialized by its first instance, the others must use the same pins
+        while (spiHosts[first] != spiHosts[i]) {
+            first++;
+        }
+        if (first == i) {
+            // SPI configuraton
+            spi_bus_config_t buscfg = {
+                .miso_io_num = misoPins[i],
+                .mosi_io_num = mosiPins[i],
+                .sclk_io_num = clkPins[i],
+                .quadwp_io_num = -1,
+                .quadhd_io_num = -1,
+                .max_transfer_sz = 4096,
+            };
+
+            // SPI init
+            ret = spi_bus_initialize(spiHosts[i], &buscfg, SPI_DMA_CH_AUTO);
+            if (ret != ESP_OK) {
+                ESP_LOGE(SPI_TAG, "Failed to initialize SPI bus %d: %s", (int)spiHosts[i], esp_err_to_name(ret));
+                return ret;
+            }
+        } else if ((misoPins[i] != misoPins[first]) || (mosiPins[i] != mosiPins[first]) || (clkPins[i] != clkPins[first])) {
+            ESP_LOGE(SPI_TAG, "SPI device %d uses other bus pins than device %d on the same host", i, first);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        // SPI device configuration
+        spi_device_interface_config_t devcfg = {
+            .clock_speed_hz = CLOCK_RATE,
+            .mode = 0,                         // SPI mode
+            .spics_io_num = csPins[i],         // CS pin
+            .queue_size = 7,
+            .post_cb = SpiPostTransaction,     // Completes the transaction towards tc6 library
+        };
+
+        // Add device to SPI interface
+        ret = spi_bus_add_device(spiHosts[i], &devcfg, &spi_handle[i]);
+        if (ret != ESP_OK) {
+            ESP_LOGE(SPI_TAG, "Failed to add SPI device %d: %s", i, esp_err_to_name(ret));
+            return ret;
+        }
     }
 
     ESP_LOGI(SPI_TAG, "SPI initialized successfully");
@@ -54,23 +88,40 @@ esp_err_t InitSpi(void) {
 
 // Callback from tc6 library to transfer spi data to LAN8651
 bool TC6_CB_OnSpiTransaction(uint8_t instance, uint8_t *pTx, uint8_t *pRx, uint16_t len, void *pGlobalTag) {
-    
-    spi_transaction_t transaction = {
+    spi_device_handle_t devHandle = (spi_device_handle_t)pGlobalTag;
+    spi_transaction_t *finished;
+
+    if (instance >= LAN8651_COUNT) {
+        ESP_LOGE(SPI_TAG, "SPI transaction for unknown instance %u", instance);
+        return false;
+    }
+
+    // Collect results of already finished transactions, so the driver queue never fills up
+    while (spi_device_get_trans_result(devHandle, &finished, 0) == ESP_OK) {
+    }
+
+    spiTransaction[instance] = (spi_transaction_t) {
         .length = len * 8,
         .tx_buffer = pTx,
         .rx_buffer = pRx,
+        .user = (void *)(uintptr_t)instance,
     };
 
-    spi_device_handle_t devHandle = (spi_device_handle_t)pGlobalTag;
-    esp_err_t ret = spi_device_transmit(devHandle, &transaction);
+    // Transaction is finished in SpiPostTransaction, tc6 library keeps the buffers valid until then
+    spiStart[instance] = esp_timer_get_time();
+    esp_err_t ret = spi_device_queue_trans(devHandle, &spiTransaction[instance], 0);
     if (ret != ESP_OK) {
         ESP_LOGE(SPI_TAG, "SPI transaction failed: %s", esp_err_to_name(ret));
-        TC6_SpiBufferDone(instance, false);
+        StatsSpiFailure(instance);
         return false;
     }
 
-    TC6_SpiBufferDone(instance, true);
-
-    vTaskDelay(pdMS_TO_TICKS(100));
     return true;
-}
\ No newline at end of file
+}
+
+static void IRAM_ATTR SpiPostTransaction(spi_transaction_t *transaction) {
+    uint8_t instance = (uint8_t)(uintptr_t)transaction->user;
+
+    StatsSpiTransaction(instance, (uint32_t)(esp_timer_get_time() - spiStart[instance]));
+    TC6_SpiBufferDone(instance, true);
+}
@@ -4,8 +4,10 @@
 #include "esp_err.h"
 #include "driver/spi_master.h"
 
-// Global handle for the SPI device
-extern spi_device_handle_t spi_handle;
+#include "configuration.h"
+
+// Global handles for the SPI devices, one per LAN8651 instance
+extern spi_device_handle_t spi_handle[LAN8651_COUNT];
 
 // Iniscialization of the spi interface 
 esp_err_t InitSpi(void);
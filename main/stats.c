@@ -0,0 +1,167 @@
+#include <string.h>
+#include "esp_log.h"
+#include "esp_attr.h"
+
+#include "configuration.h"
+#include "stats.h"
+
+// Counters of all LAN8651, only changed by atomic operations
+static StatsCounters_t counters[LAN8651_COUNT];
+
+// TX credit starvation in progress (SyncTask only)
+static bool starved[LAN8651_COUNT];
+
+// Function adding to one counter of an instance, always inlined as it is also used from the SPI interrupt in IRAM
+static inline __attribute__((always_inline)) void StatsAdd(uint32_t *counter, uint32_t value);
+
+// Callback from tc6 library with the PLCA status register
+static void OnPlcaStatus(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *pTag, void *pGlobalTag);
+
+// Function writing a little endian uint32
+static void PutLe32(uint8_t *buffer, uint32_t value);
+
+
+
+
+void StatsRxFrame(uint8_t instance, uint16_t length) {
+    if (instance < LAN8651_COUNT) {
+        StatsAdd(&counters[instance].rxFrames, 1);
+        StatsAdd(&counters[instance].rxBytes, length);
+    }
+}
+
+void StatsTxFrame(uint8_t instance, uint16_t length) {
+    if (instance < LAN8651_COUNT) {
+        StatsAdd(&counters[instance].txFrames, 1);
+        StatsAdd(&counters[instance].txBytes, length);
+    }
+}
+
+void StatsDrop(uint8_t instance, StatsDrop_t reason) {
+    if ((instance < LAN8651_COUNT) && (reason < StatsDrop_Count)) {
+        StatsAdd(&counters[instance].drops[reason], 1);
+    }
+}
+
+void StatsError(uint8_t instance, TC6_Error_t err) {
+    if ((instance < LAN8651_COUNT) && ((int)err < STATS_TC6_ERRORS)) {
+        StatsAdd(&counters[instance].errors[err], 1);
+    }
+}
+
+void IRAM_ATTR StatsSpiTransaction(uint8_t instance, uint32_t durationUs) {
+    if (instance < LAN8651_COUNT) {
+        StatsCounters_t *c = &counters[instance];
+        uint32_t max = __atomic_load_n(&c->spiMaxUs, __ATOMIC_RELAXED);
+
+        StatsAdd(&c->spiTransactions, 1);
+        StatsAdd(&c->spiBusyUs, durationUs);
+
+        // Retried only when another context raised the maximum in between
+        while ((durationUs > max) && !__atomic_compare_exchange_n(&c->spiMaxUs, &max, durationUs, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
+    }
+}
+
+void StatsSpiFailure(uint8_t instance) {
+    if (instance < LAN8651_COUNT) {
+        StatsAdd(&counters[instance].spiFailures, 1);
+    }
+}
+
+void StatsIrqRecovered(uint8_t instance) {
+    if (instance < LAN8651_COUNT) {
+        StatsAdd(&counters[instance].irqRecovered, 1);
+    }
+}
+
+void StatsCheckCredit(uint8_t instance, TC6_t *tc6) {
+    uint8_t txCredit;
+    TC6_TxQueueStats_t txQueue;
+
+    if ((instance >= LAN8651_COUNT) || (tc6 == NULL)) {
+        return;
+    }
+
+    TC6_GetState(tc6, &txCredit, NULL, NULL);
+    TC6_GetTxQueueStats(tc6, &txQueue, false);
+
+    // Counted once per starvation, not for every service call while it lasts
+    bool now = (txCredit == 0) && (txQueue.depth > 0);
+    if (now && !starved[instance]) {
+        StatsAdd(&counters[instance].creditStarved, 1);
+    }
+    starved[instance] = now;
+}
+
+void StatsReadPlcaStatus(uint8_t instance, TC6_t *tc6) {
+    if ((instance >= LAN8651_COUNT) || (tc6 == NULL)) {
+        return;
+    }
+
+    // Queue full is not counted, the next period asks again
+    (void)TC6_ReadRegister(tc6, STATS_PLCA_STATUS_REG, true, OnPlcaStatus, (void *)(uintptr_t)instance);
+}
+
+void StatsSnapshot(uint8_t instance, StatsCounters_t *snapshot) {
+    const uint32_t *src = (const uint32_t *)&counters[instance < LAN8651_COUNT ? instance : 0];
+    uint32_t *dst = (uint32_t *)snapshot;
+
+    // StatsCounters_t holds uint32_t only, every one is read atomically
+    for (size_t i = 0; i < sizeof(StatsCounters_t) / sizeof(uint32_t); i++) {
+        dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
+}
+
+size_t StatsExport(uint8_t instance, uint8_t *buffer, size_t size) {
+    StatsCounters_t snapshot;
+    const uint32_t *values = (const uint32_t *)&snapshot;
+    const size_t count = sizeof(StatsCounters_t) / sizeof(uint32_t);
+
+    if ((buffer == NULL) || (size < STATS_EXPORT_SIZE) || (instance >= LAN8651_COUNT)) {
+        return 0;
+    }
+
+    StatsSnapshot(instance, &snapshot);
+
+    PutLe32(&buffer[0], STATS_EXPORT_MAGIC);
+    buffer[4] = STATS_EXPORT_VERSION;
+    buffer[5] = instance;
+    buffer[6] = (uint8_t)count;
+    buffer[7] = (uint8_t)(count >> 8);
+    PutLe32(&buffer[8], esp_log_timestamp());
+    for (size_t i = 0; i < count; i++) {
+        PutLe32(&buffer[STATS_EXPORT_HEADER_SIZE + i * 4], values[i]);
+    }
+    return STATS_EXPORT_SIZE;
+}
+
+static inline void StatsAdd(uint32_t *counter, uint32_t value) {
+    __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+}
+
+static void OnPlcaStatus(TC6_t *pInst, bool success, uint32_t addr, uint32_t value, void *pTag, void *pGlobalTag) {
+    uint8_t instance = (uint8_t)(uintptr_t)pTag;
+
+    if (instance >= LAN8651_COUNT) {
+        return;
+    }
+
+    StatsCounters_t *c = &counters[instance];
+    if (!success) {
+        StatsAdd(&c->plcaReadFailures, 1);
+        return;
+    }
+
+    uint32_t previous = __atomic_exchange_n(&c->plcaStatus, value, __ATOMIC_RELAXED);
+    if ((previous ^ value) & STATS_PLCA_STATUS_PST) {
+        StatsAdd(&c->plcaChanges, 1);
+    }
+}
+
+static void PutLe32(uint8_t *buffer, uint32_t value) {
+    buffer[0] = (uint8_t)value;
+    buffer[1] = (uint8_t)(value >> 8);
+    buffer[2] = (uint8_t)(value >> 16);
+    buffer[3] = (uint8_t)(value >> 24);
+}
@@ -0,0 +1,80 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tc6.h"
+
+// Number of TC6_Error_t codes counted per instance
+#define STATS_TC6_ERRORS (TC6Error_ControlTxFail + 1)
+
+// Reasons for frames not being received or sent
+typedef enum {
+    StatsDrop_RxError,          // Frame reported as failed by the tc6 library (e.g. frame drop flag)
+    StatsDrop_RxPbufPool,       // No free buffer in the RX pbuf pool
+    StatsDrop_RxCopy,           // No RX pool buffer for the copy of RxTask, lwIP still got the frame
+    StatsDrop_RxRingFull,       // RxTask did not keep up, RX ring full
+    StatsDrop_RxTooLarge,       // Frame longer than the MTU
+    StatsDrop_RxTooSmall,       // Frame shorter than an Ethernet / IP header
+    StatsDrop_RxSizeMismatch,   // Received bytes differ from the frame length reported by the tc6 library
+    StatsDrop_RxSlice,          // Slices out of order (missing start or start without finished frame)
+    StatsDrop_RxInput,          // lwIP refused the frame
+    StatsDrop_TxQueueFull,      // TX submit queue full, lwIP got ERR_MEM
+    StatsDrop_TxNoMem,          // No memory for flattening a long pbuf chain
+    StatsDrop_TxError,          // Frame not accepted by the tc6 library
+    StatsDrop_Count
+} StatsDrop_t;
+
+// Counters of one LAN8651, all counters wrap around (use differences of two snapshots)
+typedef struct {
+    uint32_t rxFrames;                      // Frames handed to RxTask / lwIP
+    uint32_t rxBytes;
+    uint32_t txFrames;                      // Frames moved into SPI chunks
+    uint32_t txBytes;
+    uint32_t drops[StatsDrop_Count];
+    uint32_t errors[STATS_TC6_ERRORS];      // TC6_CB_OnError per code, parity errors are TC6Error_BadChecksum, sync loss TC6Error_SyncLost
+    uint32_t spiTransactions;               // Finished SPI transactions
+    uint32_t spiFailures;                   // Transactions the SPI driver did not accept
+    uint32_t spiBusyUs;                     // Sum of the transaction durations (queued until finished)
+    uint32_t spiMaxUs;                      // Longest transaction
+    uint32_t creditStarved;                 // Times frames were waiting while the MAC-PHY had no TX credit
+    uint32_t plcaStatus;                    // Last PLCA status register value (bit 15: PLCA active, beacons seen)
+    uint32_t plcaChanges;                   // Changes of the PLCA active bit
+    uint32_t plcaReadFailures;              // Failed reads of the PLCA status register
+    uint32_t irqRecovered;                  // IRQ_N found asserted by the SyncTask timeout, not by the GPIO interrupt
+} StatsCounters_t;
+
+// Binary export: header followed by the counters of StatsCounters_t as little endian uint32 in declaration order
+#define STATS_EXPORT_MAGIC 0x54533654       // "T6ST" as little endian uint32
+#define STATS_EXPORT_VERSION 3
+#define STATS_EXPORT_HEADER_SIZE 12         // magic (4), version (1), instance (1), counter count (2), timestamp in ms (4)
+#define STATS_EXPORT_SIZE (STATS_EXPORT_HEADER_SIZE + sizeof(StatsCounters_t))
+
+// PLCA status register (MMS 4), bit 15 is set while PLCA is active
+#define STATS_PLCA_STATUS_REG 0x0004CA03
+#define STATS_PLCA_STATUS_PST 0x8000
+
+// Functions counting events, lock free and callable from task and interrupt context
+void StatsRxFrame(uint8_t instance, uint16_t length);
+void StatsTxFrame(uint8_t instance, uint16_t length);
+void StatsDrop(uint8_t instance, StatsDrop_t reason);
+void StatsError(uint8_t instance, TC6_Error_t err);
+void StatsSpiTransaction(uint8_t instance, uint32_t durationUs);
+void StatsSpiFailure(uint8_t instance);
+void StatsIrqRecovered(uint8_t instance);
+
+// Function called by SyncTask after servicing an instance, counts the start of every TX credit starvation
+void StatsCheckCredit(uint8_t instance, TC6_t *tc6);
+
+// Function requesting the PLCA status register, the value is stored by the register callback (call from SyncTask)
+void StatsReadPlcaStatus(uint8_t instance, TC6_t *tc6);
+
+// Function copying all counters of an instance without locking, single counters are exact, the set is not taken at one instant
+void StatsSnapshot(uint8_t instance, StatsCounters_t *snapshot);
+
+// Function writing a snapshot in the binary export format, returns the number of bytes (0 if the buffer is too small)
+size_t StatsExport(uint8_t instance, uint8_t *buffer, size_t size);
+
+#endif
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "configuration.h"
+#include "trace.h"
+
+static const char *TRACE_TAG = "TRACE";
+
+// Task capturing the hot path every TRACE_INTERVAL_MS and printing the stage latencies (and the Chrome trace)
+static void TraceTask(void *pvParameters);
+
+
+
+
+void InitTrace(void) {
+    TC6Trace_Init(CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+    xTaskCreate(TraceTask, "TraceTask", 4096, NULL, tskIDLE_PRIORITY + 1, NULL);
+
+    if (TC6_PROBES == 0) {
+        ESP_LOGW(TRACE_TAG, "TC6 probes are disabled in menuconfig, only the stages of the glue are traced");
+    }
+    ESP_LOGI(TRACE_TAG, "Trace initialized: %u records per core, capture of at most %d ms every %d ms",
+             (unsigned)TC6TRACE_BUF_SIZE, TRACE_WINDOW_MS, TRACE_INTERVAL_MS);
+}
+
+static void TraceTask(void *pvParameters) {
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(TRACE_INTERVAL_MS));
+
+        // Capture until one of the core buffers is full or the window is over
+        TC6Trace_Start();
+        for (int waited = 0; (waited < TRACE_WINDOW_MS) && !TC6Trace_IsFull(); waited += 10) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        TC6Trace_Stop();
+
+        // Stages are paired per core, SyncTask and the SPI interrupt may run on different cores
+        TC6Trace_PrintStats(stdout);
+
+        // Copy the lines between the markers into a .json file and open it in ui.perfetto.dev or chrome://tracing
+        if (TRACE_JSON) {
+            printf("TRACE_JSON_BEGIN\n");
+            TC6Trace_WriteJson(stdout);
+            printf("TRACE_JSON_END\n");
+        }
+        fflush(stdout);
+    }
+}
+
+#if (0u != TC6_PROBES)
+// Callback function of the libtc6 probes, runs in SyncTask and in the SPI interrupt
+void IRAM_ATTR TC6_CB_OnProbe(uint8_t tc6instance, TC6_Probe_t probe, void *pGlobalTag) {
+    TRACE_PROBE(tc6instance, (uint8_t)probe);
+}
+#endif
+
+uint32_t IRAM_ATTR TC6Trace_CB_GetCycles(void) {
+    return esp_cpu_get_cycle_count();
+}
+
+uint8_t IRAM_ATTR TC6Trace_CB_GetCore(void) {
+    return (uint8_t)esp_cpu_get_core_id();
+}
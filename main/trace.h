@@ -0,0 +1,16 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#include "configuration.h"
+#include "tc6trace.h"
+
+// Records a probe of the glue (TC6TracePoint_Irq, _InputBegin, ...) into the trace of the calling core,
+// compiles to nothing with TRACE_ENABLE false. May be used in interrupt handlers
+#define TRACE_PROBE(instance, point) do { if (TRACE_ENABLE) { TC6Trace_Record((instance), (point)); } } while (0)
+
+// Initialization function preparing the trace buffers and creating the trace task
+void InitTrace(void);
+
+#endif
@@ -0,0 +1,36 @@
+#include <stddef.h>
+
+#include "txframe.h"
+
+
+
+
+uint8_t TxFrameSegments(struct pbuf **p, TC6_RawTxSegment *segments, uint8_t maxSegments) {
+    struct pbuf *q;
+    uint8_t count = 0;
+
+    if (pbuf_clen(*p) > maxSegments) {
+        // Chain is longer than the segment array, fall back to a single copy
+        struct pbuf *flat = pbuf_clone(PBUF_RAW, PBUF_RAM, *p);
+        pbuf_free(*p);
+        *p = flat;
+        if (flat == NULL) {
+            return 0;
+        }
+    }
+
+    // Segments point directly into the pbufs, the caller holds the reference until the tc6 TX callback
+    for (q = *p; q != NULL; q = q->next) {
+        if (q->len == 0) {
+            continue;
+        }
+        segments[count].pEth = q->payload;
+        segments[count].segLen = q->len;
+        count++;
+    }
+    if (count == 0) {
+        pbuf_free(*p);
+        *p = NULL;
+    }
+    return count;
+}
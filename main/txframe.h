@@ -0,0 +1,15 @@
+#ifndef TXFRAME_H
+#define TXFRAME_H
+
+#include <stdint.h>
+
+#include "lwip/pbuf.h"
+#include "tc6.h"
+
+// Function pointing the tc6 TX segments at the pbufs of a frame, nothing is copied. A chain of more pbufs than
+// segments is flattened into one pbuf first (the only copy on the TX path), *p then is the copy and the chain is
+// released. Returns the number of segments, 0 when there was no memory for the copy or the frame is empty,
+// the frame is released and *p is NULL then
+uint8_t TxFrameSegments(struct pbuf **p, TC6_RawTxSegment *segments, uint8_t maxSegments);
+
+#endif
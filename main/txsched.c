@@ -0,0 +1,227 @@
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+#include "configuration.h"
+#include "lan8651.h"
+#include "txsched.h"
+#include "txframe.h"
+#include "stats.h"
+
+static const char *TXSCHED_TAG = "TXSCHED";
+
+#if (TX_SCHED_QUEUE_LEN & (TX_SCHED_QUEUE_LEN - 1)) != 0
+#error "TX_SCHED_QUEUE_LEN must be power of 2"
+#endif
+
+#if TX_SCHED_WINDOW < 1 || TX_SCHED_WINDOW > 255
+#error "TX_SCHED_WINDOW must be between 1 and 255"
+#endif
+
+// Frame waiting in the scheduler or handed to the tc6 library
+typedef struct {
+    struct pbuf *p;
+    int64_t enqueued;
+    uint8_t trafficClass;
+} TxSchedFrame_t;
+
+// Scheduler state of one LAN8651, accessed from the lwIP thread and SyncTask (protected by lock).
+// The tc6 library completes frames in order, so the frames in flight are a ring starting at windowHead
+typedef struct {
+    TxSchedFrame_t queue[TX_SCHED_CLASSES][TX_SCHED_QUEUE_LEN];
+    uint8_t head[TX_SCHED_CLASSES];
+    uint8_t tail[TX_SCHED_CLASSES];
+    TxSchedFrame_t window[TX_SCHED_WINDOW];
+    uint8_t windowHead;
+    uint8_t inFlight;
+    TxSchedStats_t stats;
+} TxSchedPort_t;
+
+static TxSchedPort_t ports[LAN8651_COUNT];
+
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Function returning the traffic class of an Ethernet frame
+static uint8_t ClassifyFrame(const struct pbuf *p);
+
+// Callback from tc6 library when a scheduled frame was moved into SPI chunks
+static void OnTxSchedDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag);
+
+
+
+
+void InitTxScheduler(void) {
+    memset(ports, 0, sizeof(ports));
+    ESP_LOGI(TXSCHED_TAG, "TX scheduler initialized: %d frames per class", TX_SCHED_QUEUE_LEN);
+}
+
+bool TxSchedEnqueue(uint8_t port, struct pbuf *p) {
+    TxSchedPort_t *sched = &ports[port];
+    uint8_t trafficClass = ClassifyFrame(p);
+    bool queued = false;
+
+    // Reference is released in OnTxSchedDone (or when the frame is dropped), a full class queue gives lwIP ERR_MEM
+    pbuf_ref(p);
+
+    taskENTER_CRITICAL(&lock);
+    if ((uint8_t)(sched->tail[trafficClass] - sched->head[trafficClass]) < TX_SCHED_QUEUE_LEN) {
+        TxSchedFrame_t *frame = &sched->queue[trafficClass][sched->tail[trafficClass] & (TX_SCHED_QUEUE_LEN - 1)];
+        frame->p = p;
+        frame->enqueued = esp_timer_get_time();
+        frame->trafficClass = trafficClass;
+        sched->tail[trafficClass]++;
+        queued = true;
+    } else {
+        sched->stats.drops[trafficClass]++;
+    }
+    taskEXIT_CRITICAL(&lock);
+
+    if (!queued) {
+        pbuf_free(p);
+        return false;
+    }
+
+    // Called by lwIP, only SyncTask hands frames to the tc6 library
+    NotifySyncTask();
+    return true;
+}
+
+void TxSchedGetStats(uint8_t port, TxSchedStats_t *stats, bool reset) {
+    if (port >= LAN8651_COUNT || stats == NULL) {
+        return;
+    }
+
+    taskENTER_CRITICAL(&lock);
+    *stats = ports[port].stats;
+    if (reset) {
+        uint8_t window = ports[port].stats.window;
+        memset(&ports[port].stats, 0, sizeof(ports[port].stats));
+        ports[port].stats.window = window;
+    }
+    taskEXIT_CRITICAL(&lock);
+}
+
+
+
+static uint8_t ClassifyFrame(const struct pbuf *p) {
+    const uint8_t *frame = (const uint8_t *)p->payload;
+
+    if (p->len < 16) {
+        return 0;
+    }
+
+    uint16_t type = (frame[12] << 8) | frame[13];
+    if (type == 0x0806) {
+        // ARP, address resolution delays every other frame
+        return 1;
+    }
+    if (type == 0x8100) {
+        // VLAN tag, priority code point 4 - 7
+        return (frame[14] >> 5) >= 4 ? 1 : 0;
+    }
+    if (type == 0x0800) {
+        // IPv4, DSCP class selector 4 and above (includes EF)
+        return (frame[15] >> 2) >= 32 ? 1 : 0;
+    }
+    return 0;
+}
+
+void TxSchedService(uint8_t port) {
+    TxSchedPort_t *sched = &ports[port];
+    TC6_t *tc6 = tc6_instance[port];
+
+    if (tc6 == NULL) {
+        return;
+    }
+
+    if (sched->stats.window == 0) {
+        TC6_TxQueueStats_t txQueue;
+        TC6_GetTxQueueStats(tc6, &txQueue, false);
+        // The TX queue of the tc6 library (TC6_TX_ETH_QSIZE) is usually deeper, filling it would put a prioritized
+        // frame behind all of its bulk frames again
+        sched->stats.window = txQueue.size < TX_SCHED_WINDOW ? txQueue.size : TX_SCHED_WINDOW;
+    }
+
+    // Keeps the window filled, prioritized frames first. The MAC-PHY sends the frames of its buffer in the
+    // transmit opportunities (BURST_COUNT + 1 frames each), the host only sees a frame leave the tc6 queue.
+    // A frame stays in its class queue while the tc6 queue is full (shared with the bridge), OnTxSchedDone wakes SyncTask
+    while (1) {
+        TC6_RawTxSegment *segments;
+        TxSchedFrame_t *frame = NULL;
+        uint8_t segCount;
+
+        // SyncTask is the only producer of the tc6 queue, free entries can only grow until the frame is sent
+        uint8_t maxSegments = TC6_GetRawSegments(tc6, &segments);
+
+        taskENTER_CRITICAL(&lock);
+        for (int c = TX_SCHED_CLASSES - 1; c >= 0 && frame == NULL; c--) {
+            if (sched->head[c] == sched->tail[c]) {
+                continue;
+            }
+            if (maxSegments == 0 || sched->inFlight >= sched->stats.window) {
+                sched->stats.waits++;
+                break;
+            }
+            frame = &sched->window[(uint8_t)(sched->windowHead + sched->inFlight) % TX_SCHED_WINDOW];
+            *frame = sched->queue[c][sched->head[c] & (TX_SCHED_QUEUE_LEN - 1)];
+            sched->head[c]++;
+            sched->inFlight++;
+            if (sched->inFlight > sched->stats.inFlightMax) {
+                sched->stats.inFlightMax = sched->inFlight;
+            }
+        }
+        taskEXIT_CRITICAL(&lock);
+
+        if (frame == NULL) {
+            return;
+        }
+
+        segCount = TxFrameSegments(&frame->p, segments, maxSegments);
+        if (segCount > 0) {
+            if (TC6_SendRawEthernetSegments(tc6, segments, segCount, frame->p->tot_len, 0, OnTxSchedDone, frame)) {
+                continue;
+            }
+        }
+
+        // No memory for the copy, the frame is lost
+        ESP_LOGW(TXSCHED_TAG, "Failed to send scheduled frame on LAN8651 %u", port);
+        if (frame->p != NULL) {
+            pbuf_free(frame->p);
+            frame->p = NULL;
+        }
+        taskENTER_CRITICAL(&lock);
+        sched->stats.drops[frame->trafficClass]++;
+        sched->inFlight--;
+        taskEXIT_CRITICAL(&lock);
+    }
+}
+
+static void OnTxSchedDone(TC6_t *pInst, const uint8_t *pTx, uint16_t len, void *pTag, void *pGlobalTag) {
+    TxSchedFrame_t *frame = (TxSchedFrame_t *)pTag;
+    uint8_t port = TC6_GetInstance(pInst);
+    TxSchedPort_t *sched = &ports[port];
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - frame->enqueued);
+
+    if (frame->p != NULL) {
+        pbuf_free(frame->p);
+        frame->p = NULL;
+    }
+
+    taskENTER_CRITICAL(&lock);
+    if (pTx != NULL) {
+        StatsTxFrame(port, len);
+        sched->stats.frames[frame->trafficClass]++;
+        if (latency > sched->stats.maxLatencyUs[frame->trafficClass]) {
+            sched->stats.maxLatencyUs[frame->trafficClass] = latency;
+        }
+    } else {
+        sched->stats.drops[frame->trafficClass]++;
+    }
+    sched->windowHead = (uint8_t)(sched->windowHead + 1) % TX_SCHED_WINDOW;
+    sched->inFlight--;
+    taskEXIT_CRITICAL(&lock);
+
+    // Called within TC6_Service, SyncTask refills the window in its next loop
+    NotifySyncTask();
+}
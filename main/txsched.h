@@ -0,0 +1,34 @@
+#ifndef TXSCHED_H
+#define TXSCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lwip/pbuf.h"
+
+// Number of traffic classes, 0 is best effort, 1 is prioritized (ARP, VLAN PCP >= 4, IPv4 DSCP >= CS4)
+#define TX_SCHED_CLASSES 2
+
+// Counters of the TX scheduler of one LAN8651
+typedef struct {
+    uint32_t frames[TX_SCHED_CLASSES];          // Frames sent per traffic class
+    uint32_t drops[TX_SCHED_CLASSES];           // Frames dropped per traffic class (queue full, lwIP got ERR_MEM, or no memory)
+    uint32_t maxLatencyUs[TX_SCHED_CLASSES];    // Longest time from lwIP to the MAC-PHY per traffic class
+    uint32_t waits;                             // Services which left frames queued because the window or the tc6 queue was full
+    uint8_t window;                             // Frames handed to the tc6 library at most (TX_SCHED_WINDOW or its TX queue size)
+    uint8_t inFlightMax;                        // Most frames handed to the tc6 library at once
+} TxSchedStats_t;
+
+// Initialization function clearing all queues and counters
+void InitTxScheduler(void);
+
+// Function queueing a frame for transmission on the given LAN8651, returns false when the queue of its class is full
+bool TxSchedEnqueue(uint8_t port, struct pbuf *p);
+
+// Function handing queued frames to the tc6 library, prioritized first, until the window is full (SyncTask only)
+void TxSchedService(uint8_t port);
+
+// Function for reading (and optionally clearing) the counters of one LAN8651
+void TxSchedGetStats(uint8_t port, TxSchedStats_t *stats, bool reset);
+
+#endif